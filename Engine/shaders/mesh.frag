@@ -0,0 +1,14 @@
+#version 450
+
+layout(location = 0) in vec4 in_color;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+    // Tint shaded by a fixed light in object space, enough to read the shape without a lighting setup
+    const vec3 light = normalize(vec3(0.3, 0.8, 0.5));
+    const float shade = 0.6 + 0.4 * max(dot(in_normal, light), 0.0);
+    out_color = vec4(in_color.rgb * shade, in_color.a);
+}
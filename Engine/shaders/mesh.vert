@@ -0,0 +1,23 @@
+#version 450
+
+// Per-vertex input: one Sparkle::MeshVertex (core/asset_format.h)
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec2 in_uv;
+
+// The head of Sparkle::MeshDraw (renderer/mesh_draw.h)
+layout(push_constant) uniform Push {
+    mat4 transform; // Object to clip space
+    uint color;     // RGBA8 tint
+} pc;
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec3 out_normal;
+layout(location = 2) out vec2 out_uv;
+
+void main() {
+    gl_Position = pc.transform * vec4(in_position, 1.0);
+    out_color = unpackUnorm4x8(pc.color);
+    out_normal = in_normal;
+    out_uv = in_uv;
+}
@@ -0,0 +1,11 @@
+#version 450
+
+layout(location = 0) in vec4 in_color;
+layout(location = 1) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+    // Quads without a texture, or whose texture has no resident mips yet (sprite_textured.frag otherwise)
+    out_color = in_color;
+}
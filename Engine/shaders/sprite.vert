@@ -0,0 +1,28 @@
+#version 450
+
+// Per-instance input: one Sparkle::Quad (renderer/sprite_batch.h)
+layout(location = 0) in vec4 in_rect;      // center xy, size zw in pixels
+layout(location = 1) in vec4 in_uv;        // u0 v0 u1 v1
+layout(location = 2) in vec4 in_color;
+layout(location = 3) in float in_rotation;
+
+layout(push_constant) uniform Push {
+    vec2 scale; // 2 / framebuffer size
+} pc;
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec2 out_uv;
+
+void main() {
+    // Triangle strip over the four corners
+    const vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    const vec2 local = (corner - 0.5) * in_rect.zw;
+
+    const float s = sin(in_rotation);
+    const float c = cos(in_rotation);
+    const vec2 pixel = in_rect.xy + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    gl_Position = vec4(pixel * pc.scale - 1.0, 0.0, 1.0);
+    out_uv = mix(in_uv.xy, in_uv.zw, corner);
+    out_color = in_color;
+}
@@ -7,6 +7,10 @@
 #include "core/application.h"
 #include "game_type.h"
 #include "core/spa_assert.h"
+#include "core/profiler.h"
+#include "core/actions.h"
+#include "core/ecs.h"
+#include "core/assets.h"
 
 // main entry point
 extern Sparkle::Game *createGame();
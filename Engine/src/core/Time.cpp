@@ -3,6 +3,7 @@
 //
 #include "spa_pch.h"
 #include "Time.h"
+#include <thread>
 
 void Time::tick() {
     uint64_t now = SDL_GetTicksNS(); // nanoseconds
@@ -18,9 +19,17 @@ void Time::tick() {
     uint64_t diff_ns = now - s_last_ns;
     s_unscaled = diff_ns / 1'000'000'000.0f;
     s_delta = (s_unscaled > MAX_DELTA) ? MAX_DELTA : s_unscaled;
-    s_fps = 1.0f / (s_unscaled > 0.0f ? s_unscaled : 0.0001f);
+    s_frame_stats.push(diff_ns);
+    const float mean_ms = s_frame_stats.get_mean_ms();
+    s_fps = 1000.0f / (mean_ms > 0.0f ? mean_ms : 0.1f);
     s_last_ns = now;
     s_frame++;
+
+    if (s_fixed_step_ns > 0) {
+        s_fixed_accumulator_ns += std::min<uint64_t>(diff_ns, static_cast<uint64_t>(MAX_DELTA * 1'000'000'000.0f));
+        s_fixed_steps = 0;
+        s_fixed_debt_ns = 0;
+    }
 }
 
 float Time::time() {
@@ -32,3 +41,85 @@ float Time::unscaled_delta() { return s_unscaled; }
 float Time::fps() { return s_fps; }
 uint64_t Time::frame() { return s_frame; }
 
+Sparkle::FrameStats Time::frame_stats() { return s_frame_stats.get_stats(); }
+
+void Time::set_hitch_threshold_ms(float threshold_ms) { s_frame_stats.set_hitch_threshold_ms(threshold_ms); }
+
+void Time::set_fixed_step(uint32_t hz, uint32_t max_steps) {
+    s_fixed_step_ns = hz > 0 ? 1'000'000'000ull / hz : 0;
+    s_max_fixed_steps = std::max(max_steps, 1u);
+    s_fixed_accumulator_ns = 0;
+    s_fixed_steps = 0;
+    s_fixed_debt_ns = 0;
+}
+
+bool Time::fixed_step_enabled() { return s_fixed_step_ns > 0; }
+float Time::fixed_delta() { return s_fixed_step_ns / 1'000'000'000.0f; }
+
+bool Time::consume_fixed_step() {
+    if (s_fixed_step_ns == 0 || s_fixed_accumulator_ns < s_fixed_step_ns) return false;
+
+    if (s_fixed_steps >= s_max_fixed_steps) {
+        // Spiral-of-death guard: drop the whole steps this frame can't afford, keep the remainder for alpha
+        const uint64_t excess = s_fixed_accumulator_ns - s_fixed_accumulator_ns % s_fixed_step_ns;
+        s_fixed_debt_ns = excess;
+        s_fixed_dropped_ns += excess;
+        s_fixed_capped_frames++;
+        s_fixed_accumulator_ns -= excess;
+        return false;
+    }
+
+    s_fixed_accumulator_ns -= s_fixed_step_ns;
+    s_fixed_step_end_ns = s_last_ns - s_fixed_accumulator_ns;
+    s_fixed_steps++;
+    return true;
+}
+
+float Time::interpolation_alpha() {
+    if (s_fixed_step_ns == 0) return 0.0f;
+    return static_cast<float>(s_fixed_accumulator_ns % s_fixed_step_ns) / static_cast<float>(s_fixed_step_ns);
+}
+
+uint64_t Time::fixed_step_end_ns() { return s_fixed_step_end_ns; }
+uint32_t Time::fixed_steps() { return s_fixed_steps; }
+float Time::fixed_debt() { return s_fixed_debt_ns / 1'000'000'000.0f; }
+float Time::fixed_time_dropped() { return s_fixed_dropped_ns / 1'000'000'000.0f; }
+uint64_t Time::fixed_capped_frames() { return s_fixed_capped_frames; }
+
+void Time::set_target_fps(uint32_t fps) {
+    s_frame_period_ns = fps > 0 ? 1'000'000'000ull / fps : 0;
+    s_next_frame_ns = 0;
+}
+
+uint32_t Time::target_fps() {
+    return s_frame_period_ns > 0 ? static_cast<uint32_t>(1'000'000'000ull / s_frame_period_ns) : 0;
+}
+
+void Time::wait_for_next_frame() {
+    if (s_frame_period_ns == 0) return;
+
+    uint64_t now = SDL_GetTicksNS();
+    if (s_next_frame_ns == 0 || now > s_next_frame_ns + s_frame_period_ns) {
+        // First frame, or more than a frame behind (hitch, breakpoint): restart the cadence instead of catching up
+        s_next_frame_ns = now;
+    }
+
+    if (s_next_frame_ns > now + SPIN_THRESHOLD_NS) {
+        SDL_DelayNS(s_next_frame_ns - now - SPIN_THRESHOLD_NS);
+    }
+    while (SDL_GetTicksNS() < s_next_frame_ns) {
+        std::this_thread::yield();
+    }
+
+    // Deadlines advance by whole periods so sleep overshoot doesn't accumulate into drift
+    s_next_frame_ns += s_frame_period_ns;
+}
+
+void Time::report_present(uint64_t input_sample_ns) {
+    const uint64_t now = SDL_GetTicksNS();
+    if (input_sample_ns == 0 || now < input_sample_ns) return;
+    s_input_latency_ms.store((now - input_sample_ns) / 1'000'000.0f, std::memory_order_relaxed);
+}
+
+float Time::input_latency_ms() { return s_input_latency_ms.load(std::memory_order_relaxed); }
+
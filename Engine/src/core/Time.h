@@ -4,7 +4,9 @@
 
 #pragma once
 #include "defines.h"
+#include "frame_stats.h"
 #include <SDL3/SDL.h>
+#include <atomic>
 
 class Time {
 public:
@@ -13,9 +15,41 @@ public:
     static float time();            // Seconds since start
     static float delta_time();      // Delta time (clamped)
     static float unscaled_delta();  // Raw delta time
-    static float fps();             // Frames per second
+    static float fps();             // Frames per second over the rolling frame window
     static uint64_t frame();        // Frame count
 
+    // Frame limiter: wait_for_next_frame() blocks until the next frame boundary (0 fps = unlimited)
+    static void set_target_fps(uint32_t fps);
+    static uint32_t target_fps();
+    static void wait_for_next_frame();
+
+    // Rolling statistics over the last FrameStatsWindow::WINDOW frame times (unclamped).
+    // Cheap enough to read every frame, e.g. to drive dynamic resolution.
+    static Sparkle::FrameStats frame_stats();
+    static void set_hitch_threshold_ms(float threshold_ms); // Default 33.3 ms
+
+    // Fixed-step simulation. tick() adds each frame's (clamped) delta to an accumulator that is drained
+    // one fixed_delta() at a time with consume_fixed_step(), at most max_steps per frame; 0 hz disables it.
+    static void set_fixed_step(uint32_t hz, uint32_t max_steps);
+    static bool fixed_step_enabled();
+    static float fixed_delta();
+    static bool consume_fixed_step();    // True if another step is due this frame
+    static float interpolation_alpha();  // Leftover accumulator / fixed_delta, in [0, 1)
+    // Real time (SDL_GetTicksNS clock) the current step simulates up to; the step covers
+    // [end - fixed_delta, end), e.g. for Input::events_between
+    static uint64_t fixed_step_end_ns();
+
+    // Catch-up instrumentation
+    static uint32_t fixed_steps();       // Steps run this frame
+    static float fixed_debt();           // Seconds the simulation was behind when this frame hit max_steps (dropped)
+    static float fixed_time_dropped();   // Total seconds dropped that way
+    static uint64_t fixed_capped_frames(); // Frames that hit max_steps
+
+    // Input-to-present latency: from polling a frame's input to handing that frame to the presentation engine.
+    // report_present may be called from the render thread.
+    static void report_present(uint64_t input_sample_ns);
+    static float input_latency_ms(); // Most recently presented frame
+
 private:
     static inline uint64_t s_start_ns = 0;
     static inline uint64_t s_last_ns = 0;
@@ -23,6 +57,22 @@ private:
     static inline float s_unscaled = 0.0f;
     static inline float s_fps = 0.0f;
     static inline uint64_t s_frame = 0;
+    static inline Sparkle::FrameStatsWindow s_frame_stats;
+
+    static inline uint64_t s_fixed_step_ns = 0;
+    static inline uint32_t s_max_fixed_steps = 0;
+    static inline uint64_t s_fixed_accumulator_ns = 0;
+    static inline uint64_t s_fixed_step_end_ns = 0;
+    static inline uint32_t s_fixed_steps = 0;
+    static inline uint64_t s_fixed_debt_ns = 0;
+    static inline uint64_t s_fixed_dropped_ns = 0;
+    static inline uint64_t s_fixed_capped_frames = 0;
+
+    static inline uint64_t s_frame_period_ns = 0;
+    static inline uint64_t s_next_frame_ns = 0;
+    static inline std::atomic<float> s_input_latency_ms = 0.0f;
 
     static constexpr float MAX_DELTA = 0.25f; // seconds
+    // OS sleeps overshoot by up to a scheduler tick, so the limiter spins for the last stretch
+    static constexpr uint64_t SPIN_THRESHOLD_NS = 2'000'000;
 };
@@ -0,0 +1,222 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "actions.h"
+#include "input.h"
+#include "spa_assert.h"
+#include <cmath>
+
+namespace Sparkle {
+    std::vector<Actions::ActionInfo> Actions::s_actions;
+    std::vector<Actions::ActionState> Actions::s_states;
+
+    namespace {
+        struct CompiledBinding {
+            u16 action;
+            u16 code;
+            f32 scale;
+            u8 gamepad;
+        };
+
+        // Per-action scratch filled while the tables are evaluated
+        struct Accumulator {
+            f32 sum = 0.0f;
+            f32 analog = 0.0f; // Strongest analog contribution, for Button actions
+            bool active = false;
+            bool tapped = false; // A source went down and up (or up and down) within the frame
+            bool held = false;   // A source stayed down the whole frame
+        };
+
+        struct CompiledTables {
+            std::vector<CompiledBinding> keys;
+            std::vector<CompiledBinding> mouse_buttons;
+            std::vector<CompiledBinding> gamepad_buttons;
+            std::vector<CompiledBinding> gamepad_axes;
+            std::vector<Accumulator> scratch;
+            std::vector<ActionType> types;
+            std::vector<f32> deadzones;
+            bool dirty = true;
+        };
+    }
+
+    static CompiledTables s_tables;
+
+    ActionId Actions::register_action(const std::string& name, ActionType type, f32 deadzone) {
+        const ActionId existing = find(name);
+        if (existing != INVALID_ACTION) return existing;
+
+        SPA_ASSERT_MSG(s_actions.size() < INVALID_ACTION, "Too many actions");
+        s_actions.push_back({name, type, deadzone, {}});
+        s_states.emplace_back();
+        s_tables.dirty = true;
+        return static_cast<ActionId>(s_actions.size() - 1);
+    }
+
+    ActionId Actions::find(const std::string& name) {
+        for (size_t i = 0; i < s_actions.size(); ++i) {
+            if (s_actions[i].name == name) return static_cast<ActionId>(i);
+        }
+        return INVALID_ACTION;
+    }
+
+    void Actions::bind(ActionId action, const Binding& binding) {
+        SPA_ASSERT(action < s_actions.size());
+        s_actions[action].bindings.push_back(binding);
+        s_tables.dirty = true;
+    }
+
+    void Actions::clear_bindings(ActionId action) {
+        SPA_ASSERT(action < s_actions.size());
+        s_actions[action].bindings.clear();
+        s_tables.dirty = true;
+    }
+
+    const std::vector<Binding>& Actions::get_bindings(ActionId action) {
+        SPA_ASSERT(action < s_actions.size());
+        return s_actions[action].bindings;
+    }
+
+    void Actions::reset() {
+        s_actions.clear();
+        s_states.clear();
+        s_tables = CompiledTables{};
+    }
+
+    void Actions::compile() {
+        CompiledTables& tables = s_tables;
+        tables.keys.clear();
+        tables.mouse_buttons.clear();
+        tables.gamepad_buttons.clear();
+        tables.gamepad_axes.clear();
+        tables.types.clear();
+        tables.deadzones.clear();
+
+        for (size_t i = 0; i < s_actions.size(); ++i) {
+            const ActionInfo& info = s_actions[i];
+            tables.types.push_back(info.type);
+            tables.deadzones.push_back(std::clamp(info.deadzone, 0.0f, 0.99f));
+
+            for (const Binding& binding : info.bindings) {
+                const CompiledBinding compiled = {static_cast<u16>(i), binding.code, binding.scale, binding.gamepad};
+                switch (binding.source) {
+                    case BindingSource::Key: tables.keys.push_back(compiled); break;
+                    case BindingSource::MouseButton: tables.mouse_buttons.push_back(compiled); break;
+                    case BindingSource::GamepadButton: tables.gamepad_buttons.push_back(compiled); break;
+                    case BindingSource::GamepadAxis: tables.gamepad_axes.push_back(compiled); break;
+                }
+            }
+        }
+
+        tables.scratch.assign(s_actions.size(), Accumulator{});
+        tables.dirty = false;
+    }
+
+    // Rescales so output starts at 0 just past the deadzone and still reaches 1 at full deflection
+    static f32 apply_deadzone(f32 value, f32 deadzone) {
+        const f32 magnitude = std::fabs(value);
+        if (magnitude <= deadzone) return 0.0f;
+        return std::copysign((magnitude - deadzone) / (1.0f - deadzone), value);
+    }
+
+    // Pads a binding reads from: one slot, or every slot for ANY_GAMEPAD
+    template<typename F>
+    static void for_each_pad(u8 gamepad, F&& fn) {
+        if (gamepad != ANY_GAMEPAD) {
+            if (Input::gamepad_connected(gamepad)) fn(gamepad);
+            return;
+        }
+        for (u32 pad = 0; pad < Input::MAX_GAMEPADS; ++pad) {
+            if (Input::gamepad_connected(pad)) fn(pad);
+        }
+    }
+
+    // Only sub-frame taps are taken per source; the action's own edges come from its combined down state
+    static void accumulate_edges(Accumulator& acc, bool down, bool pressed, bool released) {
+        acc.tapped |= pressed && released;
+        acc.held |= down && !pressed && !released;
+    }
+
+    void Actions::update() {
+        if (s_tables.dirty) compile();
+        CompiledTables& tables = s_tables;
+        for (Accumulator& acc : tables.scratch) acc = Accumulator{};
+
+        for (const CompiledBinding& b : tables.keys) {
+            Accumulator& acc = tables.scratch[b.action];
+            const Key key = static_cast<Key>(b.code);
+            if (Input::key_down(key)) {
+                acc.sum += b.scale;
+                acc.active = true;
+            }
+            accumulate_edges(acc, Input::key_down(key), Input::key_pressed(key), Input::key_released(key));
+        }
+
+        for (const CompiledBinding& b : tables.mouse_buttons) {
+            Accumulator& acc = tables.scratch[b.action];
+            const MouseButton button = static_cast<MouseButton>(b.code);
+            if (Input::mouse_down(button)) {
+                acc.sum += b.scale;
+                acc.active = true;
+            }
+            accumulate_edges(acc, Input::mouse_down(button), Input::mouse_pressed(button),
+                             Input::mouse_released(button));
+        }
+
+        for (const CompiledBinding& b : tables.gamepad_buttons) {
+            Accumulator& acc = tables.scratch[b.action];
+            const GamepadButton button = static_cast<GamepadButton>(b.code);
+            bool down = false;
+            for_each_pad(b.gamepad, [&](u32 pad) {
+                const bool pad_down = Input::gamepad_down(button, pad);
+                down |= pad_down;
+                accumulate_edges(acc, pad_down, Input::gamepad_pressed(button, pad),
+                                 Input::gamepad_released(button, pad));
+            });
+            if (down) {
+                acc.sum += b.scale;
+                acc.active = true;
+            }
+        }
+
+        for (const CompiledBinding& b : tables.gamepad_axes) {
+            Accumulator& acc = tables.scratch[b.action];
+            const GamepadAxis axis = static_cast<GamepadAxis>(b.code);
+            const f32 deadzone = tables.deadzones[b.action];
+
+            // With several pads on one binding the most deflected one wins rather than the sum
+            f32 strongest = 0.0f;
+            for_each_pad(b.gamepad, [&](u32 pad) {
+                const f32 v = apply_deadzone(Input::gamepad_axis(axis, pad), deadzone);
+                if (std::fabs(v) > std::fabs(strongest)) strongest = v;
+            });
+
+            const f32 v = strongest * b.scale;
+            acc.sum += v;
+            acc.analog = std::max(acc.analog, v);
+        }
+
+        for (size_t i = 0; i < tables.scratch.size(); ++i) {
+            const Accumulator& acc = tables.scratch[i];
+            ActionState& state = s_states[i];
+            const bool was_down = state.flags & FLAG_DOWN;
+
+            bool is_down;
+            if (tables.types[i] == ActionType::Axis) {
+                state.value = std::clamp(acc.sum, -1.0f, 1.0f);
+                is_down = state.value != 0.0f;
+            } else {
+                is_down = acc.active || acc.analog >= PRESS_THRESHOLD;
+                state.value = is_down ? 1.0f : 0.0f;
+            }
+
+            // Edges follow the combined state, so releasing one of two held bindings reports nothing.
+            // A tap that started and ended within the frame counts unless another source held the action.
+            const bool tap = is_down == was_down && acc.tapped && !acc.held;
+            u8 flags = is_down ? FLAG_DOWN : 0;
+            if ((is_down && !was_down) || tap) flags |= FLAG_PRESSED;
+            if ((!is_down && was_down) || tap) flags |= FLAG_RELEASED;
+            state.flags = flags;
+        }
+    }
+}
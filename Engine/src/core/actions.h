@@ -0,0 +1,104 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include "key_codes.h"
+#include <string>
+#include <vector>
+
+namespace Sparkle {
+    using ActionId = u16;
+    static constexpr ActionId INVALID_ACTION = 0xFFFF;
+    static constexpr u8 ANY_GAMEPAD = 0xFF;
+
+    enum class ActionType : u8 {
+        Button, // down / pressed / released; value is 0 or 1 (analog sources count past PRESS_THRESHOLD)
+        Axis,   // value is the clamped sum of every bound source, -1..1
+    };
+
+    enum class BindingSource : u8 {
+        Key,
+        MouseButton,
+        GamepadButton,
+        GamepadAxis,
+    };
+
+    // One physical input feeding an action. scale lets two keys drive one axis (-1 / +1)
+    // or flips a stick axis.
+    struct Binding {
+        BindingSource source = BindingSource::Key;
+        u16 code = 0;
+        f32 scale = 1.0f;
+        u8 gamepad = ANY_GAMEPAD;
+
+        static Binding key(Key key, f32 scale = 1.0f) {
+            return {BindingSource::Key, static_cast<u16>(key), scale};
+        }
+        static Binding mouse(MouseButton button) {
+            return {BindingSource::MouseButton, static_cast<u16>(button)};
+        }
+        static Binding gamepad_button(GamepadButton button, f32 scale = 1.0f, u8 pad = ANY_GAMEPAD) {
+            return {BindingSource::GamepadButton, static_cast<u16>(button), scale, pad};
+        }
+        static Binding gamepad_axis(GamepadAxis axis, f32 scale = 1.0f, u8 pad = ANY_GAMEPAD) {
+            return {BindingSource::GamepadAxis, static_cast<u16>(axis), scale, pad};
+        }
+    };
+
+    // Named actions and axes on top of Input. Bindings are compiled into one flat table per source
+    // kind, the tables are evaluated once per frame by update(), and every query is an array read.
+    // Registration and rebinding may happen at any time; the tables are rebuilt on the next update.
+    class Actions {
+    public:
+        static constexpr f32 DEFAULT_DEADZONE = 0.15f;
+        static constexpr f32 PRESS_THRESHOLD = 0.5f; // Analog value at which a Button action goes down
+
+        // Returns the existing id if name is already registered
+        static ActionId register_action(const std::string& name, ActionType type = ActionType::Button,
+                                        f32 deadzone = DEFAULT_DEADZONE);
+        static ActionId find(const std::string& name);
+
+        static void bind(ActionId action, const Binding& binding);
+        static void clear_bindings(ActionId action);
+        static const std::vector<Binding>& get_bindings(ActionId action);
+
+        // Evaluate every binding against this frame's Input state (Application calls it after polling)
+        static void update();
+        // Drop all actions and bindings
+        static void reset();
+
+        static bool down(ActionId action) { return state(action).flags & FLAG_DOWN; }
+        static bool pressed(ActionId action) { return state(action).flags & FLAG_PRESSED; }
+        static bool released(ActionId action) { return state(action).flags & FLAG_RELEASED; }
+        static f32 value(ActionId action) { return state(action).value; }
+
+    private:
+        static constexpr u8 FLAG_DOWN = 1;
+        static constexpr u8 FLAG_PRESSED = 2;
+        static constexpr u8 FLAG_RELEASED = 4;
+
+        struct ActionState {
+            f32 value = 0.0f;
+            u8 flags = 0;
+        };
+
+        struct ActionInfo {
+            std::string name;
+            ActionType type = ActionType::Button;
+            f32 deadzone = DEFAULT_DEADZONE;
+            std::vector<Binding> bindings;
+        };
+
+        static void compile();
+        // Unknown ids (INVALID_ACTION included) read as an idle action
+        static const ActionState& state(ActionId action) {
+            static constexpr ActionState idle{};
+            return action < s_states.size() ? s_states[action] : idle;
+        }
+
+        static std::vector<ActionInfo> s_actions;
+        static std::vector<ActionState> s_states;
+    };
+}
@@ -7,25 +7,61 @@
 #include "logger.h"
 #include "spa_assert.h"
 #include "renderer/renderer.h"
+#include "renderer/render_thread.h"
+#include "job_system.h"
+#include "frame_arena.h"
+#include "profiler.h"
+#include "actions.h"
+#include "assets.h"
 
 namespace Sparkle {
     bool Application::_internal_init() {
         Logger::init();
-        if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD)) {
+        SPA_ASSERT(m_game_inst->init());
+        Logger::configure(m_game_inst->engine_config.log);
+
+        // Before any engine thread starts, so every thread's zones are captured
+        const ProfilerConfig& profiler = m_game_inst->engine_config.profiler;
+        Profiler::init(profiler.events_per_thread);
+        Profiler::set_thread_name("Main thread");
+        Profiler::set_enabled(profiler.enabled);
+
+        // Headless runs have no display, so only the event subsystem is brought up
+        const bool headless = m_game_inst->engine_config.headless;
+        const SDL_InitFlags sdl_flags = headless ? SDL_INIT_EVENTS : (SDL_INIT_VIDEO | SDL_INIT_GAMEPAD);
+        if (!SDL_Init(sdl_flags)) {
             SPA_LOG_ERROR("Failed to initialize SDL: {}", SDL_GetError());
             return false;
         }
 
-        SPA_ASSERT(m_game_inst->init());
-        m_window = SDL_CreateWindow(
-            m_game_inst->config.title,
-            m_game_inst->config.width,
-            m_game_inst->config.height,
-            flagToInt(m_game_inst->config.flags));
-
-        if (!m_window) {
-            SPA_LOG_ERROR("Failed to create SDL window: {}", SDL_GetError());
-            SDL_Quit();
+        if (!headless) {
+            m_window = SDL_CreateWindow(
+                m_game_inst->config.title,
+                m_game_inst->config.width,
+                m_game_inst->config.height,
+                flagToInt(m_game_inst->config.flags));
+
+            if (!m_window) {
+                SPA_LOG_ERROR("Failed to create SDL window: {}", SDL_GetError());
+                SDL_Quit();
+                return false;
+            }
+
+            int width = 0;
+            int height = 0;
+            if (SDL_GetWindowSizeInPixels(m_window, &width, &height)) {
+                m_pixel_width = static_cast<u32>(width);
+                m_pixel_height = static_cast<u32>(height);
+            }
+        }
+
+        // Up before the renderer so it can record in parallel, and before the first Game::update
+        JobSystem::init(m_game_inst->engine_config.job_workers);
+
+        // Mounting reads the archive index only, so this costs the same for any archive size
+        const AssetConfig& assets = m_game_inst->engine_config.assets;
+        Assets::init(assets.io_threads, assets.verify);
+        if (assets.archive && !Assets::mount(assets.archive)) {
             return false;
         }
 
@@ -35,6 +71,22 @@ namespace Sparkle {
         }
 
 
+        // Enough slots for every frame the GPU and a pipelined render thread can hold, plus the one being simulated
+        const u32 arena_slots = Renderer::get_backend()->get_max_frames_in_flight() + 2;
+        if (!FrameArena::init(arena_slots, m_game_inst->engine_config.frame_arena_size)) {
+            return false;
+        }
+
+        if (m_game_inst->engine_config.pipelined_render) {
+            RenderThread::start();
+            if (m_game_inst->engine_config.low_latency) {
+                SPA_LOG_WARN("low_latency has no effect with pipelined_render.");
+            }
+        }
+
+        Time::set_target_fps(m_game_inst->engine_config.target_fps);
+        Time::set_fixed_step(m_game_inst->engine_config.fixed_update_hz, m_game_inst->engine_config.max_fixed_steps);
+
         m_running = true;
         m_suspended = false;
 
@@ -43,13 +95,33 @@ namespace Sparkle {
     }
 
     void Application::_internal_shutdown() {
+        if (Time::fixed_capped_frames() > 0) {
+            SPA_LOG_WARN("Fixed update could not keep up on {} frames; {:.3f} s of simulation time dropped.",
+                         Time::fixed_capped_frames(), Time::fixed_time_dropped());
+        }
+
+        // The render thread may still be acquiring or presenting on the window's surface
+        RenderThread::stop();
+
         if (m_window) {
             SDL_DestroyWindow(m_window);
             m_window = nullptr;
         }
 
+        const ProfilerConfig& profiler = m_game_inst->engine_config.profiler;
+        if (Profiler::is_enabled() && profiler.trace_path) {
+            Profiler::write_chrome_trace(profiler.trace_path);
+        }
+
+        m_world.clear_systems();
+        m_world.clear();
         Renderer::shutdown();
+        Assets::shutdown();
+        FrameArena::shutdown();
+        JobSystem::shutdown();
+        Profiler::shutdown();
 
+        Input::shutdown();
         SDL_Quit();
         Logger::shutdown();
     }
@@ -58,35 +130,109 @@ namespace Sparkle {
 
 
         RenderPacket packet = {.clearColor = {0.0f, 0.0f, 1.0f, 1.0f}};
+        const bool low_latency = m_game_inst->engine_config.low_latency && !RenderThread::is_running();
 
 
         while (m_running) {
+            SPA_PROFILE_SCOPE("Frame");
+            {
+                SPA_PROFILE_SCOPE("Frame limiter");
+                Time::wait_for_next_frame();
+            }
+
+            // Take the GPU wait here rather than in draw_frame, so the input polled below is
+            // as fresh as possible when the frame is recorded
+            if (low_latency && !m_suspended) {
+                Renderer::get_backend()->wait_for_frame_slot();
+            }
+
             Time::tick();
 
             Input::begin_frame();
 
-            SDL_Event event;
-            while (SDL_PollEvent(&event)) {
-                Input::process_event(event);
-                if (event.type == SDL_EVENT_QUIT) {
-                    m_running = false;
+            {
+                SPA_PROFILE_SCOPE("Poll events");
+                SDL_Event event;
+                while (SDL_PollEvent(&event)) {
+                    Input::process_event(event);
+                    if (event.type == SDL_EVENT_QUIT) {
+                        m_running = false;
+                    } else if (event.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED) {
+                        m_pixel_width = static_cast<u32>(event.window.data1);
+                        m_pixel_height = static_cast<u32>(event.window.data2);
+                    }
                 }
             }
+            Actions::update();
+            // Callbacks of loads that finished in the background, ahead of the update that may use them
+            Assets::update();
+            const u64 input_sample = SDL_GetTicksNS();
 
 
             if (!m_suspended) {
+                const u64 sim_start = SDL_GetTicksNS();
+                const u64 frame = Time::frame();
+                FrameArena::begin_frame(frame);
+
                 const f32 dt = Time::delta_time();
-                if(!m_game_inst->update(dt)) {
-                    SPA_LOG_ERROR("Failed to update");
-                    m_running = false;
+                if (Time::fixed_step_enabled()) {
+                    SPA_PROFILE_SCOPE("Game::fixed_update");
+                    while (m_running && Time::consume_fixed_step()) {
+                        if (!m_game_inst->fixed_update(Time::fixed_delta())) {
+                            SPA_LOG_ERROR("Failed to run fixed update");
+                            m_running = false;
+                        }
+                        m_world.run_systems(SystemPhase::FixedUpdate, Time::fixed_delta());
+                    }
+                }
+
+                {
+                    SPA_PROFILE_SCOPE("Game::update");
+                    if(!m_game_inst->update(dt)) {
+                        SPA_LOG_ERROR("Failed to update");
+                        m_running = false;
+                    }
+                }
+                {
+                    SPA_PROFILE_SCOPE("Systems");
+                    m_world.run_systems(SystemPhase::Update, dt);
                 }
 
                 packet.deltaTime = dt;
+                packet.simStartNs = sim_start;
+                packet.frameNumber = frame;
+                packet.inputSampleNs = input_sample;
+                packet.interpolationAlpha = Time::interpolation_alpha();
+                packet.windowWidth = m_pixel_width;
+                packet.windowHeight = m_pixel_height;
+
+                if (RenderThread::is_running()) {
+                    // The game fills its half of the double buffer, then the render thread takes it
+                    // while the next update runs here
+                    {
+                        SPA_PROFILE_SCOPE("Game::render");
+                        if (!m_game_inst->render()) {
+                            SPA_LOG_ERROR("Failed to render");
+                            m_running = false;
+                        }
+                    }
+                    Renderer::flush_quads(&packet);
 
-                if (Renderer::draw_frame(&packet)) {
-                    if (!m_game_inst->render()) {
-                        SPA_LOG_ERROR("Failed to render");
-                        m_running = false;
+                    // A failed draw only drops that frame; the render thread keeps taking new packets
+                    SPA_PROFILE_SCOPE("Hand off to render thread");
+                    *RenderThread::get_write_packet() = packet;
+                    if (!RenderThread::submit()) {
+                        SPA_LOG_DEBUG("Render thread failed to draw the previous frame.");
+                    }
+                } else {
+                    // Draws the quads submitted by the previous render and this update
+                    Renderer::flush_quads(&packet);
+                    if (Renderer::draw_frame(&packet)) {
+                        SPA_PROFILE_SCOPE("Game::render");
+                        if (!m_game_inst->render()) {
+                            SPA_LOG_ERROR("Failed to render");
+                            m_running = false;
+                        }
                     }
                 }
 
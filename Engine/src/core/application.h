@@ -9,6 +9,7 @@
 #include <SDL3/SDL.h>
 #include "input.h"
 #include "Time.h"
+#include "ecs.h"
 namespace Sparkle {
     class Application {
     public:
@@ -24,9 +25,14 @@ namespace Sparkle {
         static const char* GetName(){return GetInstance().m_game_inst->config.title;}
         static i32 GetWidth() {return GetInstance().m_game_inst->config.width;}
         static i32 GetHeight() {return GetInstance().m_game_inst->config.height;}
+        static const EngineConfig& GetEngineConfig() {return GetInstance().m_game_inst->engine_config;}
+        static bool IsHeadless() {return GetEngineConfig().headless;}
 
         static void SetGameInst(Game *game) { GetInstance().m_game_inst = game; }
 
+        // Entities and systems; systems run after Game::fixed_update / Game::update
+        static World& GetWorld() { return GetInstance().m_world; }
+
     private:
         // Singleton access
         static Application& GetInstance();
@@ -47,8 +53,12 @@ namespace Sparkle {
     private:
         Game *m_game_inst = nullptr;
         SDL_Window* m_window = nullptr;
+        World m_world;
         bool m_running = false;
         bool m_suspended = false;
+        // Pixel size of the window, kept current from SDL events (SDL video calls stay on the main thread)
+        u32 m_pixel_width = 0;
+        u32 m_pixel_height = 0;
     };
 
 } // namespace Sparkle
@@ -0,0 +1,133 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include <cstring>
+#include <string_view>
+
+// On-disk layout of packed asset archives (.spak), shared by the runtime and the tools that write them.
+// All values are little-endian.
+//
+//   ArchiveHeader
+//   ArchiveEntry[entry_count]      sorted by name_hash, so lookups are a binary search
+//   blobs                          each starting on an ARCHIVE_ALIGNMENT boundary
+//
+// Blobs are cooked into the layout the renderer hands to Vulkan, so loading one is a copy into
+// a staging buffer with no transcoding on the CPU:
+//   Texture  TextureHeader, TextureMip[mip_count], then the block-compressed mips, largest first
+//   Mesh     MeshHeader, then the interleaved MeshVertex array and the index array
+//   Shader   SPIR-V words (ArchiveEntry::flags holds the ShaderStage)
+//   Raw      the source file as is
+namespace Sparkle {
+    static constexpr u32 ARCHIVE_MAGIC = 0x4B415053; // "SPAK"
+    static constexpr u32 ARCHIVE_VERSION = 1;
+    // Blob alignment; enough for any buffer copy offset, so mapped blobs can be staged as they are
+    static constexpr u64 ARCHIVE_ALIGNMENT = 256;
+
+    enum class AssetType : u32 {
+        Raw = 0,
+        Texture,
+        Mesh,
+        Shader,
+    };
+
+    struct ArchiveHeader {
+        u32 magic = ARCHIVE_MAGIC;
+        u32 version = ARCHIVE_VERSION;
+        u32 entry_count = 0;
+        u32 reserved = 0;
+        u64 file_size = 0; // Catches truncated files before any entry is trusted
+    };
+    static_assert(sizeof(ArchiveHeader) == 24);
+
+    struct ArchiveEntry {
+        u64 name_hash = 0;    // hash_name of the asset path
+        u64 content_hash = 0; // hash_content of the blob
+        u64 offset = 0;       // From the start of the file
+        u64 size = 0;
+        AssetType type = AssetType::Raw;
+        u32 flags = 0;
+    };
+    static_assert(sizeof(ArchiveEntry) == 40);
+
+    enum class TextureFormat : u32 {
+        RGBA8 = 0, // Uncompressed fallback
+        BC1,       // 4 bpp; opaque images
+        BC3,       // 8 bpp; images with alpha
+    };
+
+    static constexpr u32 TEXTURE_SRGB = 1 << 0; // Color data; sample through an _SRGB format
+
+    struct TextureMip {
+        u32 width = 0;
+        u32 height = 0;
+        u64 offset = 0; // From the start of the blob; 16-byte aligned
+        u64 size = 0;
+    };
+    static_assert(sizeof(TextureMip) == 24);
+
+    struct TextureHeader {
+        u32 width = 0;
+        u32 height = 0;
+        u32 mip_count = 0;
+        TextureFormat format = TextureFormat::RGBA8;
+        u32 flags = 0;
+        u32 reserved = 0;
+        // TextureMip mips[mip_count] follow
+    };
+    static_assert(sizeof(TextureHeader) == 24);
+
+    struct MeshVertex {
+        f32 position[3];
+        f32 normal[3];
+        f32 uv[2];
+    };
+    static_assert(sizeof(MeshVertex) == 32);
+
+    struct MeshHeader {
+        u32 vertex_count = 0;
+        u32 index_count = 0;
+        u32 vertex_stride = sizeof(MeshVertex);
+        u32 index_size = 2;    // 2 (uint16) when every vertex fits, else 4
+        u64 vertex_offset = 0; // From the start of the blob
+        u64 index_offset = 0;
+        f32 bounds_min[3] = {};
+        f32 bounds_max[3] = {};
+    };
+    static_assert(sizeof(MeshHeader) == 56);
+
+    enum class ShaderStage : u32 {
+        Vertex = 0,
+        Fragment,
+        Compute,
+    };
+
+    // FNV-1a over the path with '\\' folded to '/', so names match whichever separator the tools saw
+    inline u64 hash_name(std::string_view name) {
+        u64 hash = 14695981039346656037ull;
+        for (char c : name) {
+            hash ^= static_cast<u8>(c == '\\' ? '/' : c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // FNV-1a style, a word at a time: cheap enough to verify every blob as it is paged in
+    inline u64 hash_content(const void* data, u64 size) {
+        const u8* bytes = static_cast<const u8*>(data);
+        u64 hash = 14695981039346656037ull ^ size;
+        u64 i = 0;
+        for (; i + 8 <= size; i += 8) {
+            u64 word;
+            std::memcpy(&word, bytes + i, 8);
+            hash = (hash ^ word) * 1099511628211ull;
+            hash ^= hash >> 29;
+        }
+        for (; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,519 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "assets.h"
+#include "logger.h"
+#include "profiler.h"
+#include "spa_assert.h"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#if defined(SPA_PLATFORM_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Sparkle {
+    static constexpr u32 ENTRY_BITS = 24;
+    static constexpr u32 MAX_ARCHIVES = 16;
+    static constexpr u64 MAPPING_PAGE_SIZE = 4096;
+
+    struct AssetSlot {
+        AssetState state = AssetState::Unloaded; // Guarded by s_mutex; I/O threads only read archive bytes
+        u32 refs = 0;
+    };
+
+    struct Archive {
+        std::string path;
+        const u8* base = nullptr;
+        u64 size = 0;
+        const ArchiveEntry* entries = nullptr;
+        u32 entry_count = 0;
+        std::unique_ptr<AssetSlot[]> slots;
+#if defined(SPA_PLATFORM_WINDOWS)
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+    };
+
+    struct Completion {
+        AssetHandle handle;
+        AssetCallback callback;
+        bool range = false; // From prefetch(): delivered whatever the asset's state
+    };
+
+    // A whole-asset load, or (callback set) a prefetch() of part of one
+    struct Request {
+        AssetHandle handle;
+        u64 offset = 0;
+        u64 size = 0;
+        AssetCallback callback;
+    };
+
+    // Archives are only added (by mount) and removed at shutdown, so I/O threads index them without locking
+    static std::array<std::unique_ptr<Archive>, MAX_ARCHIVES> s_archives;
+    static std::atomic<u32> s_archive_count = 0;
+
+    static std::mutex s_mutex;
+    static std::condition_variable s_queue_cv; // I/O threads: a request arrived or shutdown
+    static std::condition_variable s_done_cv;  // wait(): an asset left the queue
+    static std::deque<Request> s_queue;
+    static std::unordered_map<u32, std::vector<AssetCallback>> s_waiting; // Callbacks of queued assets
+    static std::vector<Completion> s_completions;
+    static u32 s_loaded = 0;
+    static u32 s_pending = 0;
+
+    static std::vector<std::thread> s_threads;
+    static bool s_running = false;
+    static bool s_verify = true;
+
+    static std::atomic<u64> s_bytes_paged = 0;
+    static std::atomic<u64> s_loads = 0;
+    static std::atomic<u64> s_failures = 0;
+    static std::atomic<u64> s_prefetches = 0;
+    static std::atomic<u64> s_io_ns = 0;
+
+    static Archive* archive_of(AssetHandle handle) {
+        const u32 index = handle.id >> ENTRY_BITS;
+        return index < s_archive_count.load(std::memory_order_acquire) ? s_archives[index].get() : nullptr;
+    }
+
+    static AssetSlot* slot_of(AssetHandle handle, const ArchiveEntry** entry = nullptr) {
+        Archive* archive = archive_of(handle);
+        const u32 index = handle.id & ((1u << ENTRY_BITS) - 1);
+        if (!archive || index >= archive->entry_count) return nullptr;
+        if (entry) *entry = &archive->entries[index];
+        return &archive->slots[index];
+    }
+
+    // Whole pages inside [data, data + size), so hints never reach a neighbouring asset
+    static bool inner_pages(const void* data, u64 size, u8*& begin, u64& length) {
+        constexpr uintptr_t MASK = ~(MAPPING_PAGE_SIZE - 1);
+        const uintptr_t start = (reinterpret_cast<uintptr_t>(data) + MAPPING_PAGE_SIZE - 1) & MASK;
+        const uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & MASK;
+        if (end <= start) return false;
+        begin = reinterpret_cast<u8*>(start);
+        length = end - start;
+        return true;
+    }
+
+    static void prefetch(const u8* data, u64 size) {
+        // Round outward here: reading a neighbour's edge page early costs nothing
+        const uintptr_t start = reinterpret_cast<uintptr_t>(data) & ~(MAPPING_PAGE_SIZE - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+#if defined(SPA_PLATFORM_WINDOWS)
+        WIN32_MEMORY_RANGE_ENTRY range = {reinterpret_cast<void*>(start), static_cast<SIZE_T>(end - start)};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+        madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+#endif
+    }
+
+    static void drop_pages(const u8* data, u64 size) {
+        u8* begin;
+        u64 length;
+        if (!inner_pages(data, size, begin, length)) return;
+#if defined(SPA_PLATFORM_WINDOWS)
+        // Unlocking pages that aren't locked removes them from the working set
+        VirtualUnlock(begin, static_cast<SIZE_T>(length));
+#else
+        // Read-only file pages: dropped now, faulted back in from the file on the next load
+        madvise(begin, length, MADV_DONTNEED);
+#endif
+    }
+
+    static void unmap(Archive& archive) {
+#if defined(SPA_PLATFORM_WINDOWS)
+        if (archive.base) UnmapViewOfFile(archive.base);
+        if (archive.mapping) CloseHandle(archive.mapping);
+        if (archive.file != INVALID_HANDLE_VALUE) CloseHandle(archive.file);
+        archive.mapping = nullptr;
+        archive.file = INVALID_HANDLE_VALUE;
+#else
+        if (archive.base) munmap(const_cast<u8*>(archive.base), archive.size);
+#endif
+        archive.base = nullptr;
+    }
+
+    static bool map(Archive& archive) {
+#if defined(SPA_PLATFORM_WINDOWS)
+        archive.file = CreateFileA(archive.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (archive.file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(archive.file, &size) || size.QuadPart == 0) return false;
+        archive.size = static_cast<u64>(size.QuadPart);
+        archive.mapping = CreateFileMappingA(archive.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!archive.mapping) return false;
+        archive.base = static_cast<const u8*>(MapViewOfFile(archive.mapping, FILE_MAP_READ, 0, 0, 0));
+        return archive.base != nullptr;
+#else
+        const int fd = open(archive.path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st = {};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        archive.size = static_cast<u64>(st.st_size);
+        void* base = mmap(nullptr, archive.size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // The mapping keeps the file open
+        if (base == MAP_FAILED) return false;
+        archive.base = static_cast<const u8*>(base);
+        return true;
+#endif
+    }
+
+    // Header and index only: asset data is not touched until it is loaded
+    static bool validate(const Archive& archive) {
+        if (archive.size < sizeof(ArchiveHeader)) return false;
+        const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(archive.base);
+        if (header->magic != ARCHIVE_MAGIC) {
+            SPA_LOG_ERROR("{} is not an asset archive.", archive.path);
+            return false;
+        }
+        if (header->version != ARCHIVE_VERSION) {
+            SPA_LOG_ERROR("{} has archive version {}, expected {}; re-cook it.", archive.path, header->version,
+                          ARCHIVE_VERSION);
+            return false;
+        }
+        if (header->file_size != archive.size) {
+            SPA_LOG_ERROR("{} is {} bytes, its header says {}; the file is truncated.", archive.path,
+                          archive.size, header->file_size);
+            return false;
+        }
+        if (header->entry_count >= (1u << ENTRY_BITS)) return false;
+
+        const u64 index_end = sizeof(ArchiveHeader) + static_cast<u64>(header->entry_count) * sizeof(ArchiveEntry);
+        if (index_end > archive.size) return false;
+        const ArchiveEntry* entries = reinterpret_cast<const ArchiveEntry*>(archive.base + sizeof(ArchiveHeader));
+        for (u32 i = 0; i < header->entry_count; ++i) {
+            const ArchiveEntry& entry = entries[i];
+            if (entry.offset < index_end || entry.offset > archive.size || entry.size > archive.size - entry.offset ||
+                (i > 0 && entries[i - 1].name_hash >= entry.name_hash)) {
+                SPA_LOG_ERROR("{} has a corrupt index (entry {}).", archive.path, i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void io_loop(u32 index) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "Asset I/O %u", index);
+        Profiler::set_thread_name(name);
+
+        std::unique_lock lock(s_mutex);
+        while (true) {
+            s_queue_cv.wait(lock, [] { return !s_queue.empty() || !s_running; });
+            if (!s_running) return;
+
+            Request request = std::move(s_queue.front());
+            s_queue.pop_front();
+            const AssetHandle handle = request.handle;
+            const ArchiveEntry* entry = nullptr;
+            AssetSlot* slot = slot_of(handle, &entry);
+
+            if (request.callback) {
+                // Ranges only warm the page cache: no state, no hash (it covers the whole asset)
+                lock.unlock();
+                const u64 start = Profiler::now_ns();
+                {
+                    SPA_PROFILE_SCOPE("Assets::prefetch");
+                    const u8* data = archive_of(handle)->base + entry->offset + request.offset;
+                    prefetch(data, request.size);
+                    u8 sum = 0;
+                    for (u64 i = 0; i < request.size; i += MAPPING_PAGE_SIZE) {
+                        sum += reinterpret_cast<const volatile u8*>(data)[i];
+                    }
+                    (void)sum;
+                }
+                s_io_ns.fetch_add(Profiler::now_ns() - start, std::memory_order_relaxed);
+                s_bytes_paged.fetch_add(request.size, std::memory_order_relaxed);
+                s_prefetches.fetch_add(1, std::memory_order_relaxed);
+                lock.lock();
+                s_completions.push_back({handle, std::move(request.callback), true});
+                continue;
+            }
+            // Released before it got here
+            if (!slot || slot->state != AssetState::Queued) continue;
+            lock.unlock();
+
+            const u64 start = Profiler::now_ns();
+            bool ok = true;
+            {
+                SPA_PROFILE_SCOPE("Assets::page_in");
+                const u8* data = archive_of(handle)->base + entry->offset;
+                prefetch(data, entry->size);
+                if (s_verify) {
+                    ok = hash_content(data, entry->size) == entry->content_hash;
+                } else {
+                    // Fault every page in here rather than on whichever thread touches it first
+                    u8 sum = 0;
+                    for (u64 i = 0; i < entry->size; i += MAPPING_PAGE_SIZE) {
+                        sum += reinterpret_cast<const volatile u8*>(data)[i];
+                    }
+                    (void)sum;
+                }
+            }
+            s_io_ns.fetch_add(Profiler::now_ns() - start, std::memory_order_relaxed);
+            s_bytes_paged.fetch_add(entry->size, std::memory_order_relaxed);
+
+            lock.lock();
+            if (slot->state != AssetState::Queued) continue; // Released while paging in
+
+            slot->state = ok ? AssetState::Ready : AssetState::Failed;
+            s_pending--;
+            if (ok) {
+                s_loaded++;
+                s_loads.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                s_failures.fetch_add(1, std::memory_order_relaxed);
+                SPA_LOG_ERROR("Asset {:016x} in {} failed its content check.", entry->name_hash,
+                              archive_of(handle)->path);
+            }
+            if (auto it = s_waiting.find(handle.id); it != s_waiting.end()) {
+                for (AssetCallback& callback : it->second) {
+                    s_completions.push_back({handle, std::move(callback)});
+                }
+                s_waiting.erase(it);
+            }
+            s_done_cv.notify_all();
+        }
+    }
+
+    bool Assets::init(u32 io_threads, bool verify) {
+        SPA_ASSERT_MSG(s_threads.empty(), "Assets already initialized");
+        s_verify = verify;
+        s_running = true;
+        io_threads = std::max(io_threads, 1u);
+        for (u32 i = 0; i < io_threads; ++i) {
+            s_threads.emplace_back(io_loop, i);
+        }
+        SPA_LOG_INFO("Asset system started with {} I/O thread(s).", io_threads);
+        return true;
+    }
+
+    void Assets::shutdown() {
+        {
+            std::lock_guard lock(s_mutex);
+            s_running = false;
+        }
+        s_queue_cv.notify_all();
+        for (std::thread& thread : s_threads) {
+            thread.join();
+        }
+        s_threads.clear();
+
+        const u32 count = s_archive_count.exchange(0);
+        for (u32 i = 0; i < count; ++i) {
+            unmap(*s_archives[i]);
+            s_archives[i].reset();
+        }
+        s_queue.clear();
+        s_waiting.clear();
+        s_completions.clear();
+        s_loaded = 0;
+        s_pending = 0;
+        s_bytes_paged = 0;
+        s_loads = 0;
+        s_failures = 0;
+        s_prefetches = 0;
+        s_io_ns = 0;
+    }
+
+    bool Assets::is_initialized() {
+        return !s_threads.empty();
+    }
+
+    bool Assets::mount(const char* path) {
+        SPA_PROFILE_SCOPE("Assets::mount");
+        const u32 count = s_archive_count.load(std::memory_order_relaxed);
+        if (count == MAX_ARCHIVES) {
+            SPA_LOG_ERROR("Cannot mount {}: {} archives already mounted.", path, MAX_ARCHIVES);
+            return false;
+        }
+
+        auto archive = std::make_unique<Archive>();
+        archive->path = path;
+        if (!map(*archive)) {
+            SPA_LOG_ERROR("Failed to map asset archive {}.", path);
+            unmap(*archive);
+            return false;
+        }
+        if (!validate(*archive)) {
+            unmap(*archive);
+            return false;
+        }
+
+        const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(archive->base);
+        archive->entries = reinterpret_cast<const ArchiveEntry*>(archive->base + sizeof(ArchiveHeader));
+        archive->entry_count = header->entry_count;
+        archive->slots = std::make_unique<AssetSlot[]>(archive->entry_count);
+        SPA_LOG_INFO("Mounted {} ({} assets, {:.1f} MiB).", path, archive->entry_count,
+                     static_cast<f64>(archive->size) / (1024.0 * 1024.0));
+
+        s_archives[count] = std::move(archive);
+        s_archive_count.store(count + 1, std::memory_order_release);
+        return true;
+    }
+
+    AssetHandle Assets::find(std::string_view name) {
+        const u64 hash = hash_name(name);
+        for (u32 a = s_archive_count.load(std::memory_order_acquire); a-- > 0;) {
+            const Archive& archive = *s_archives[a];
+            const ArchiveEntry* end = archive.entries + archive.entry_count;
+            const ArchiveEntry* it = std::lower_bound(archive.entries, end, hash,
+                [](const ArchiveEntry& entry, u64 h) { return entry.name_hash < h; });
+            if (it != end && it->name_hash == hash) {
+                return {a << ENTRY_BITS | static_cast<u32>(it - archive.entries)};
+            }
+        }
+        return {};
+    }
+
+    AssetHandle Assets::load(std::string_view name, AssetCallback on_ready) {
+        const AssetHandle handle = find(name);
+        if (!handle.is_valid()) {
+            SPA_LOG_WARN("Asset '{}' is not in any mounted archive.", name);
+            return handle;
+        }
+
+        AssetSlot* slot = slot_of(handle);
+        bool queued = false;
+        {
+            std::lock_guard lock(s_mutex);
+            slot->refs++;
+            if (slot->state == AssetState::Unloaded) {
+                slot->state = AssetState::Queued;
+                s_pending++;
+                s_queue.push_back({handle});
+                queued = true;
+            }
+            if (on_ready) {
+                if (slot->state == AssetState::Queued) {
+                    s_waiting[handle.id].push_back(std::move(on_ready));
+                } else {
+                    s_completions.push_back({handle, std::move(on_ready)});
+                }
+            }
+        }
+        if (queued) s_queue_cv.notify_one();
+        return handle;
+    }
+
+    bool Assets::prefetch(AssetHandle handle, u64 offset, u64 size, AssetCallback on_ready) {
+        const ArchiveEntry* entry = nullptr;
+        if (!on_ready || !slot_of(handle, &entry) || offset > entry->size) return false;
+        size = std::min(size, entry->size - offset);
+        {
+            std::lock_guard lock(s_mutex);
+            s_queue.push_back({handle, offset, size, std::move(on_ready)});
+        }
+        s_queue_cv.notify_one();
+        return true;
+    }
+
+    void Assets::release(AssetHandle handle) {
+        const ArchiveEntry* entry = nullptr;
+        AssetSlot* slot = slot_of(handle, &entry);
+        if (!slot) return;
+
+        std::lock_guard lock(s_mutex);
+        SPA_ASSERT_MSG(slot->refs > 0, "Asset released more often than loaded");
+        if (--slot->refs > 0) return;
+
+        if (slot->state == AssetState::Ready) {
+            s_loaded--;
+            drop_pages(archive_of(handle)->base + entry->offset, entry->size);
+        } else if (slot->state == AssetState::Queued) {
+            s_pending--;
+            s_waiting.erase(handle.id);
+            s_done_cv.notify_all();
+        }
+        slot->state = AssetState::Unloaded;
+    }
+
+    AssetState Assets::get_state(AssetHandle handle) {
+        const AssetSlot* slot = slot_of(handle);
+        if (!slot) return AssetState::Unloaded;
+        std::lock_guard lock(s_mutex);
+        return slot->state;
+    }
+
+    bool Assets::get(AssetHandle handle, AssetView& out) {
+        const ArchiveEntry* entry = nullptr;
+        if (get_state(handle) != AssetState::Ready || !slot_of(handle, &entry)) return false;
+        out.data = archive_of(handle)->base + entry->offset;
+        out.size = entry->size;
+        out.type = entry->type;
+        return true;
+    }
+
+    bool Assets::wait(AssetHandle handle) {
+        const AssetSlot* slot = slot_of(handle);
+        if (!slot) return false;
+        std::unique_lock lock(s_mutex);
+        s_done_cv.wait(lock, [slot] { return slot->state != AssetState::Queued; });
+        return slot->state == AssetState::Ready;
+    }
+
+    void Assets::update() {
+        SPA_PROFILE_SCOPE("Assets::update");
+        std::vector<Completion> completions;
+        {
+            std::lock_guard lock(s_mutex);
+            if (s_completions.empty()) return;
+            completions.swap(s_completions);
+        }
+        // Outside the lock: callbacks may load or release more assets
+        for (Completion& completion : completions) {
+            AssetView view;
+            if (completion.range) {
+                const ArchiveEntry* entry = nullptr;
+                slot_of(completion.handle, &entry);
+                view.data = archive_of(completion.handle)->base + entry->offset;
+                view.size = entry->size;
+                view.type = entry->type;
+                completion.callback(completion.handle, &view);
+            } else if (get(completion.handle, view)) {
+                completion.callback(completion.handle, &view);
+            } else if (get_state(completion.handle) == AssetState::Failed) {
+                completion.callback(completion.handle, nullptr);
+            }
+            // Otherwise released since; the caller no longer wants it
+        }
+    }
+
+    AssetStats Assets::get_stats() {
+        AssetStats stats;
+        const u32 count = s_archive_count.load(std::memory_order_acquire);
+        stats.archives = count;
+        for (u32 i = 0; i < count; ++i) {
+            stats.entries += s_archives[i]->entry_count;
+        }
+        {
+            std::lock_guard lock(s_mutex);
+            stats.loaded = s_loaded;
+            stats.pending = s_pending;
+        }
+        stats.bytes_paged = s_bytes_paged.load(std::memory_order_relaxed);
+        stats.loads = s_loads.load(std::memory_order_relaxed);
+        stats.failures = s_failures.load(std::memory_order_relaxed);
+        stats.prefetches = s_prefetches.load(std::memory_order_relaxed);
+        stats.io_ms = static_cast<f64>(s_io_ns.load(std::memory_order_relaxed)) / 1'000'000.0;
+        return stats;
+    }
+}
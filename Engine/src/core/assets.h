@@ -0,0 +1,91 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include "asset_format.h"
+#include <functional>
+#include <string_view>
+
+namespace Sparkle {
+    // Mounted archive index << 24 | entry index; stays valid until the archive is unmounted at shutdown
+    struct AssetHandle {
+        u32 id = UINT32_MAX;
+
+        bool is_valid() const { return id != UINT32_MAX; }
+        bool operator==(const AssetHandle&) const = default;
+    };
+
+    enum class AssetState : u8 {
+        Unloaded,
+        Queued,  // Waiting for or being paged in by an I/O thread
+        Ready,
+        Failed,  // Content hash mismatch
+    };
+
+    // Points straight into the archive mapping: no copy is made, and the bytes can go to
+    // VulkanStagingRing::upload_buffer as they are. Valid while the asset is loaded.
+    struct AssetView {
+        const void* data = nullptr;
+        u64 size = 0;
+        AssetType type = AssetType::Raw;
+    };
+
+    // view is nullptr when the load failed
+    using AssetCallback = std::function<void(AssetHandle handle, const AssetView* view)>;
+
+    struct AssetStats {
+        u32 archives = 0;
+        u32 entries = 0;
+        u32 loaded = 0;       // Ready assets currently referenced
+        u32 pending = 0;      // Queued, not yet paged in
+        u64 bytes_paged = 0;  // Paged in by the I/O threads since init
+        u64 loads = 0;
+        u64 failures = 0;
+        u64 prefetches = 0;   // Ranges paged in by prefetch()
+        f64 io_ms = 0.0;      // Total I/O thread time spent paging in
+    };
+
+    // Asynchronous loading from memory-mapped packed archives.
+    // mount() maps an archive and validates its header and index only; nothing else is read, so startup
+    // never waits on asset data. load() resolves a name to a handle immediately and queues the asset for
+    // the I/O threads, which page it in (and verify its hash) off the main thread. Completion callbacks
+    // run on the main thread in update(), which Application calls once per frame.
+    // Loads are refcounted: each load() needs a matching release(); the last release lets the OS drop the pages.
+    class Assets {
+    public:
+        static bool init(u32 io_threads = 2, bool verify = true);
+        static void shutdown();
+        static bool is_initialized();
+
+        // Later mounts take precedence, so a patch archive can override assets of the base one
+        static bool mount(const char* path);
+
+        // Invalid handle if no mounted archive contains name. on_ready runs in a later update(),
+        // also when the asset was already loaded.
+        static AssetHandle load(std::string_view name, AssetCallback on_ready = nullptr);
+        static void release(AssetHandle handle);
+
+        // Page in bytes [offset, offset + size) of an asset without loading it, for readers that only
+        // need part of one (a texture's header, or the mips it is about to stream). No refcount and no
+        // content check; on_ready runs in a later update() with a view of the whole asset, of which only
+        // the prefetched range is guaranteed resident. The range is clipped to the asset; false if
+        // offset lies past its end.
+        static bool prefetch(AssetHandle handle, u64 offset, u64 size, AssetCallback on_ready);
+
+        // Resolve a name without loading it
+        static AssetHandle find(std::string_view name);
+        static AssetState get_state(AssetHandle handle);
+        // False unless the asset is Ready
+        static bool get(AssetHandle handle, AssetView& out);
+        // Block until the asset has left the queue (tools and loading screens; never per frame).
+        // Callbacks still run in update().
+        static bool wait(AssetHandle handle);
+
+        // Run callbacks of loads that finished since the last call. Main thread only.
+        static void update();
+
+        static AssetStats get_stats();
+    };
+}
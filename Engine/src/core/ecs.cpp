@@ -0,0 +1,350 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "ecs.h"
+#include "logger.h"
+#include "profiler.h"
+#include <atomic>
+
+namespace Sparkle {
+    static u32 s_component_sizes[Components::MAX] = {};
+    static u32 s_component_alignments[Components::MAX] = {};
+    static std::atomic<u32> s_component_count = 0;
+
+    // Component arrays start on their own cache line
+    static constexpr u32 COLUMN_ALIGNMENT = 64;
+
+    static u32 align_up(u32 value, u32 alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    ComponentId Components::register_type(u32 size, u32 alignment) {
+        const u32 id = s_component_count.fetch_add(1, std::memory_order_relaxed);
+        SPA_ASSERT_MSG(id < MAX, "Too many component types");
+        SPA_ASSERT_MSG(alignment <= COLUMN_ALIGNMENT, "Component alignment above a cache line");
+        s_component_sizes[id] = size;
+        s_component_alignments[id] = alignment;
+        return static_cast<ComponentId>(id);
+    }
+
+    u32 Components::get_size(ComponentId id) { return s_component_sizes[id]; }
+    u32 Components::get_alignment(ComponentId id) { return s_component_alignments[id]; }
+    u32 Components::get_count() { return s_component_count.load(std::memory_order_relaxed); }
+
+    World::World() {
+        m_records.resize(1); // Index 0 stays unused
+        find_or_create_archetype(0);
+    }
+
+    World::~World() = default;
+
+    // === Entities ===
+    Entity World::create() {
+        return create_with(0);
+    }
+
+    Entity World::create_with(ComponentMask mask) {
+        check_structural_change();
+        const u32 archetype = find_or_create_archetype(mask);
+
+        u32 index;
+        if (!m_free_indices.empty()) {
+            index = m_free_indices.back();
+            m_free_indices.pop_back();
+        } else {
+            index = static_cast<u32>(m_records.size());
+            m_records.emplace_back();
+        }
+
+        const Entity entity = {index, m_records[index].generation};
+        place(entity, archetype);
+        m_entity_count++;
+        return entity;
+    }
+
+    void World::destroy(Entity entity) {
+        check_structural_change();
+        if (!is_alive(entity)) return;
+
+        EntityRecord& record = m_records[entity.index];
+        free_row(record.archetype, record.chunk, record.row);
+        record.archetype = INVALID;
+        record.generation++;
+        m_free_indices.push_back(entity.index);
+        m_entity_count--;
+    }
+
+    bool World::is_alive(Entity entity) const {
+        return entity.index != 0 && entity.index < m_records.size() &&
+               m_records[entity.index].generation == entity.generation &&
+               m_records[entity.index].archetype != INVALID;
+    }
+
+    void World::clear() {
+        check_structural_change();
+        for (Archetype& archetype : m_archetypes) {
+            for (Chunk& chunk : archetype.chunks) {
+                m_free_chunks.push_back(std::move(chunk.storage));
+            }
+            archetype.chunks.clear();
+            archetype.entity_count = 0;
+        }
+
+        m_free_indices.clear();
+        for (u32 index = static_cast<u32>(m_records.size()) - 1; index > 0; --index) {
+            EntityRecord& record = m_records[index];
+            if (record.archetype != INVALID) {
+                record.archetype = INVALID;
+                record.generation++;
+            }
+            m_free_indices.push_back(index);
+        }
+        m_entity_count = 0;
+    }
+
+    // === Components ===
+    void* World::add_component(Entity entity, ComponentId id) {
+        check_structural_change();
+        SPA_ASSERT_MSG(is_alive(entity), "add on a dead entity");
+
+        const ComponentMask bit = ComponentMask{1} << id;
+        const u32 source = m_records[entity.index].archetype;
+        if (!(m_archetypes[source].mask & bit)) {
+            u32 target = m_archetypes[source].add_edges[id];
+            if (target == INVALID) {
+                // May grow m_archetypes, so nothing above holds a reference into it
+                target = find_or_create_archetype(m_archetypes[source].mask | bit);
+                m_archetypes[source].add_edges[id] = target;
+                m_archetypes[target].remove_edges[id] = source;
+            }
+            move(entity, target);
+        }
+        return get_component(entity, id);
+    }
+
+    void World::remove_component(Entity entity, ComponentId id) {
+        check_structural_change();
+        if (!is_alive(entity)) return;
+
+        const ComponentMask bit = ComponentMask{1} << id;
+        const u32 source = m_records[entity.index].archetype;
+        if (!(m_archetypes[source].mask & bit)) return;
+
+        u32 target = m_archetypes[source].remove_edges[id];
+        if (target == INVALID) {
+            target = find_or_create_archetype(m_archetypes[source].mask & ~bit);
+            m_archetypes[source].remove_edges[id] = target;
+            m_archetypes[target].add_edges[id] = source;
+        }
+        move(entity, target);
+    }
+
+    void* World::get_component(Entity entity, ComponentId id) const {
+        if (!is_alive(entity)) return nullptr;
+
+        const EntityRecord& record = m_records[entity.index];
+        const Archetype& archetype = m_archetypes[record.archetype];
+        if (!(archetype.mask & (ComponentMask{1} << id))) return nullptr;
+
+        return archetype.chunks[record.chunk].storage->bytes + archetype.offsets[id] +
+               static_cast<size_t>(record.row) * Components::get_size(id);
+    }
+
+    // === Storage ===
+    u32 World::find_or_create_archetype(ComponentMask mask) {
+        auto it = m_archetype_ids.find(mask);
+        if (it != m_archetype_ids.end()) return it->second;
+
+        Archetype archetype;
+        archetype.mask = mask;
+        u32 row_size = sizeof(Entity);
+        for (u32 id = 0; id < Components::MAX; ++id) {
+            if (mask & (ComponentMask{1} << id)) {
+                archetype.components.push_back(static_cast<ComponentId>(id));
+                row_size += Components::get_size(static_cast<ComponentId>(id));
+            }
+        }
+
+        // Leave room for every column to be padded up to its cache line
+        const u32 padding = COLUMN_ALIGNMENT * static_cast<u32>(archetype.components.size());
+        SPA_ASSERT_MSG(row_size + padding <= CHUNK_SIZE, "Archetype's components don't fit a chunk");
+        archetype.capacity = (CHUNK_SIZE - padding) / row_size;
+
+        u32 offset = sizeof(Entity) * archetype.capacity;
+        for (ComponentId id : archetype.components) {
+            offset = align_up(offset, COLUMN_ALIGNMENT);
+            archetype.offsets[id] = offset;
+            offset += Components::get_size(id) * archetype.capacity;
+        }
+        SPA_ASSERT(offset <= CHUNK_SIZE);
+
+        std::fill(std::begin(archetype.add_edges), std::end(archetype.add_edges), INVALID);
+        std::fill(std::begin(archetype.remove_edges), std::end(archetype.remove_edges), INVALID);
+
+        const u32 index = static_cast<u32>(m_archetypes.size());
+        m_archetypes.push_back(std::move(archetype));
+        m_archetype_ids.emplace(mask, index);
+        return index;
+    }
+
+    void World::place(Entity entity, u32 archetype_index) {
+        Archetype& archetype = m_archetypes[archetype_index];
+        if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity) {
+            Chunk chunk;
+            if (!m_free_chunks.empty()) {
+                chunk.storage = std::move(m_free_chunks.back());
+                m_free_chunks.pop_back();
+            } else {
+                chunk.storage = std::make_unique<ChunkStorage>();
+            }
+            archetype.chunks.push_back(std::move(chunk));
+        }
+
+        const u32 chunk_index = static_cast<u32>(archetype.chunks.size() - 1);
+        Chunk& chunk = archetype.chunks[chunk_index];
+        const u32 row = chunk.count++;
+        reinterpret_cast<Entity*>(chunk.storage->bytes)[row] = entity;
+        archetype.entity_count++;
+
+        EntityRecord& record = m_records[entity.index];
+        record.archetype = archetype_index;
+        record.chunk = chunk_index;
+        record.row = row;
+    }
+
+    void World::move(Entity entity, u32 target) {
+        const EntityRecord old = m_records[entity.index];
+        place(entity, target);
+        const EntityRecord& record = m_records[entity.index];
+
+        const Archetype& from = m_archetypes[old.archetype];
+        const Archetype& to = m_archetypes[target];
+        const u8* src = from.chunks[old.chunk].storage->bytes;
+        u8* dst = to.chunks[record.chunk].storage->bytes;
+        for (ComponentId id : from.components) {
+            if (!(to.mask & (ComponentMask{1} << id))) continue;
+            const u32 size = Components::get_size(id);
+            std::memcpy(dst + to.offsets[id] + static_cast<size_t>(record.row) * size,
+                        src + from.offsets[id] + static_cast<size_t>(old.row) * size, size);
+        }
+
+        free_row(old.archetype, old.chunk, old.row);
+    }
+
+    void World::free_row(u32 archetype_index, u32 chunk_index, u32 row) {
+        Archetype& archetype = m_archetypes[archetype_index];
+        const u32 last_chunk = static_cast<u32>(archetype.chunks.size() - 1);
+        Chunk& last = archetype.chunks[last_chunk];
+        const u32 last_row = last.count - 1;
+
+        if (chunk_index != last_chunk || row != last_row) {
+            u8* dst = archetype.chunks[chunk_index].storage->bytes;
+            const u8* src = last.storage->bytes;
+
+            const Entity moved = reinterpret_cast<const Entity*>(src)[last_row];
+            reinterpret_cast<Entity*>(dst)[row] = moved;
+            for (ComponentId id : archetype.components) {
+                const u32 size = Components::get_size(id);
+                std::memcpy(dst + archetype.offsets[id] + static_cast<size_t>(row) * size,
+                            src + archetype.offsets[id] + static_cast<size_t>(last_row) * size, size);
+            }
+            m_records[moved.index].chunk = chunk_index;
+            m_records[moved.index].row = row;
+        }
+
+        last.count--;
+        archetype.entity_count--;
+        if (last.count == 0) {
+            m_free_chunks.push_back(std::move(last.storage));
+            archetype.chunks.pop_back();
+        }
+    }
+
+    void World::check_structural_change() const {
+        SPA_ASSERT_MSG(!m_structure_locked, "Entities and components may only be created or removed by exclusive systems");
+    }
+
+    // === Systems ===
+    void World::add_system(const char* name, const SystemAccess& access, SystemFn fn, SystemPhase phase) {
+        m_systems.push_back({name, access, std::move(fn), phase});
+        m_stages_dirty = true;
+    }
+
+    void World::clear_systems() {
+        m_systems.clear();
+        for (auto& stages : m_stages) stages.clear();
+        m_stages_dirty = false;
+    }
+
+    void World::build_stages() {
+        // Each system goes into the first stage after every earlier system it conflicts with
+        std::vector<u32> stage_of(m_systems.size(), 0);
+        for (u32 phase = 0; phase < static_cast<u32>(SystemPhase::Count); ++phase) {
+            std::vector<std::vector<u32>>& stages = m_stages[phase];
+            stages.clear();
+
+            for (u32 i = 0; i < m_systems.size(); ++i) {
+                if (static_cast<u32>(m_systems[i].phase) != phase) continue;
+
+                u32 stage = 0;
+                for (u32 j = 0; j < i; ++j) {
+                    if (m_systems[j].phase == m_systems[i].phase && m_systems[j].access.conflicts(m_systems[i].access)) {
+                        stage = std::max(stage, stage_of[j] + 1);
+                    }
+                }
+                stage_of[i] = stage;
+                if (stages.size() <= stage) stages.resize(stage + 1);
+                stages[stage].push_back(i);
+            }
+        }
+        m_stages_dirty = false;
+    }
+
+    void World::run_systems(SystemPhase phase, f32 dt) {
+        if (m_stages_dirty) build_stages();
+
+        for (const std::vector<u32>& stage : m_stages[static_cast<u32>(phase)]) {
+            const System& first = m_systems[stage[0]];
+            m_structure_locked = !first.access.exclusive;
+
+            if (stage.size() == 1 || !JobSystem::is_initialized()) {
+                for (u32 index : stage) {
+                    const System& system = m_systems[index];
+                    SPA_PROFILE_SCOPE(system.name);
+                    system.fn(*this, dt);
+                }
+            } else {
+                // This thread takes the first system and helps with the rest while it waits
+                JobCounter counter;
+                for (u32 i = 1; i < stage.size(); ++i) {
+                    const System* system = &m_systems[stage[i]];
+                    JobSystem::run([this, system, dt] {
+                        SPA_PROFILE_SCOPE(system->name);
+                        system->fn(*this, dt);
+                    }, &counter);
+                }
+                {
+                    SPA_PROFILE_SCOPE(first.name);
+                    first.fn(*this, dt);
+                }
+                JobSystem::wait(counter);
+            }
+        }
+        m_structure_locked = false;
+    }
+
+    WorldStats World::get_stats() const {
+        WorldStats stats;
+        stats.entities = m_entity_count;
+        stats.archetypes = static_cast<u32>(m_archetypes.size());
+        for (const Archetype& archetype : m_archetypes) {
+            stats.chunks += static_cast<u32>(archetype.chunks.size());
+        }
+        stats.systems = static_cast<u32>(m_systems.size());
+        for (u32 phase = 0; phase < static_cast<u32>(SystemPhase::Count); ++phase) {
+            stats.stages[phase] = static_cast<u32>(m_stages[phase].size());
+        }
+        return stats;
+    }
+}
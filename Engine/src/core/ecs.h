@@ -0,0 +1,265 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include "job_system.h"
+#include "spa_assert.h"
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace Sparkle {
+    // Generational handle: a destroyed entity's index is reused with a new generation,
+    // so stale handles stop resolving instead of aliasing the new entity
+    struct Entity {
+        u32 index = 0;
+        u32 generation = 0; // Live entities start at 1, so a default Entity is never alive
+
+        bool operator==(const Entity&) const = default;
+    };
+
+    using ComponentId = u8;
+    using ComponentMask = u64;
+
+    // Component types get a process-wide id on first use. Components are plain data: they are moved
+    // between chunks with memcpy and never destroyed.
+    class Components {
+    public:
+        static constexpr u32 MAX = 64;
+
+        template<typename T>
+        static ComponentId id() {
+            static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                          "Components are moved with memcpy and never destroyed; keep them plain data");
+            static const ComponentId s_id = register_type(sizeof(T), alignof(T));
+            return s_id;
+        }
+
+        static u32 get_size(ComponentId id);
+        static u32 get_alignment(ComponentId id);
+        static u32 get_count();
+
+    private:
+        static ComponentId register_type(u32 size, u32 alignment);
+    };
+
+    template<typename... Cs>
+    ComponentMask component_mask() {
+        return (ComponentMask{0} | ... | (ComponentMask{1} << Components::id<std::remove_const_t<Cs>>()));
+    }
+
+    // Components a system touches. Two systems conflict when one writes what the other reads or writes;
+    // systems that don't conflict run at the same time.
+    struct SystemAccess {
+        ComponentMask reads = 0;
+        ComponentMask writes = 0;
+        bool exclusive = false; // Creates / destroys entities or adds / removes components; runs alone
+
+        template<typename... Cs>
+        SystemAccess& read() { reads |= component_mask<Cs...>(); return *this; }
+        template<typename... Cs>
+        SystemAccess& write() { writes |= component_mask<Cs...>(); return *this; }
+        SystemAccess& make_exclusive() { exclusive = true; return *this; }
+
+        bool conflicts(const SystemAccess& other) const {
+            return exclusive || other.exclusive ||
+                   (writes & (other.reads | other.writes)) != 0 || (other.writes & reads) != 0;
+        }
+    };
+
+    enum class SystemPhase : u8 {
+        FixedUpdate, // Once per fixed step, after Game::fixed_update
+        Update,      // Once per frame, after Game::update
+        Count,
+    };
+
+    class World;
+    using SystemFn = std::function<void(World& world, f32 dt)>;
+
+    struct WorldStats {
+        u32 entities = 0;
+        u32 archetypes = 0;
+        u32 chunks = 0;
+        u32 systems = 0;
+        u32 stages[static_cast<u32>(SystemPhase::Count)] = {}; // Parallel groups each phase runs in
+    };
+
+    // Entities and their components, stored by archetype (the exact set of components an entity has).
+    // Each archetype keeps its entities in fixed-size chunks laid out as structure-of-arrays: one
+    // contiguous array per component, so a query walks dense arrays chunk by chunk. Chunks stay
+    // packed; removing an entity moves the archetype's last entity into its row.
+    //
+    // Systems registered with add_system run once per phase, grouped into stages of systems whose
+    // SystemAccess doesn't conflict. A stage's systems run in parallel on the job system; stages run in
+    // registration order, so a system always sees the writes of earlier systems it conflicts with.
+    // Outside exclusive systems, entities and components may not be created or removed while systems run.
+    class World {
+    public:
+        static constexpr u32 CHUNK_SIZE = 16 * 1024;
+
+        World();
+        ~World();
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        Entity create();
+        template<typename... Cs>
+        Entity create(const Cs&... components) {
+            const Entity entity = create_with(component_mask<Cs...>());
+            (std::memcpy(get_component(entity, Components::id<Cs>()), &components, sizeof(Cs)), ...);
+            return entity;
+        }
+        void destroy(Entity entity);
+        bool is_alive(Entity entity) const;
+        // Destroy every entity; systems stay registered
+        void clear();
+
+        // Sets the value if the entity already has T
+        template<typename T>
+        void add(Entity entity, const T& value) {
+            std::memcpy(add_component(entity, Components::id<T>()), &value, sizeof(T));
+        }
+        template<typename T>
+        void remove(Entity entity) { remove_component(entity, Components::id<T>()); }
+        template<typename T>
+        bool has(Entity entity) const { return get_component(entity, Components::id<T>()) != nullptr; }
+        // nullptr if the entity is dead or lacks T; invalidated by the next structural change
+        template<typename T>
+        T* get(Entity entity) { return static_cast<T*>(get_component(entity, Components::id<T>())); }
+
+        // fn(count, entities, Cs*... arrays) once per non-empty chunk holding all of Cs.
+        // Declare read-only components const.
+        template<typename... Cs, typename F>
+        void each_chunk(F&& fn) {
+            const ComponentMask mask = component_mask<Cs...>();
+            for (Archetype& archetype : m_archetypes) {
+                if ((archetype.mask & mask) != mask) continue;
+                for (Chunk& chunk : archetype.chunks) {
+                    if (chunk.count == 0) continue;
+                    fn(chunk.count, chunk_entities(chunk), chunk_column<Cs>(archetype, chunk)...);
+                }
+            }
+        }
+
+        // fn(Cs&...) for every entity holding all of Cs
+        template<typename... Cs, typename F>
+        void each(F&& fn) {
+            each_chunk<Cs...>([&fn](u32 count, const Entity*, Cs*... columns) {
+                for (u32 i = 0; i < count; ++i) {
+                    fn(columns[i]...);
+                }
+            });
+        }
+
+        // each() with every archetype's chunks spread over the job system; fn runs concurrently
+        template<typename... Cs, typename F>
+        void par_each(F&& fn) {
+            const ComponentMask mask = component_mask<Cs...>();
+            for (Archetype& archetype : m_archetypes) {
+                if ((archetype.mask & mask) != mask || archetype.entity_count == 0) continue;
+                Archetype* a = &archetype;
+                JobSystem::parallel_for(static_cast<u32>(archetype.chunks.size()), 0, [a, &fn](u32 begin, u32 end) {
+                    for (u32 c = begin; c < end; ++c) {
+                        Chunk& chunk = a->chunks[c];
+                        call_rows(fn, chunk.count, chunk_column<Cs>(*a, chunk)...);
+                    }
+                });
+            }
+        }
+
+        // name must outlive the world (a string literal); it labels the system's profiler zone
+        void add_system(const char* name, const SystemAccess& access, SystemFn fn,
+                        SystemPhase phase = SystemPhase::Update);
+        void clear_systems();
+        // Run the phase's systems stage by stage (Application calls this every frame / fixed step)
+        void run_systems(SystemPhase phase, f32 dt);
+
+        u32 get_entity_count() const { return m_entity_count; }
+        WorldStats get_stats() const;
+
+    private:
+        static constexpr u32 INVALID = UINT32_MAX;
+
+        struct alignas(64) ChunkStorage {
+            u8 bytes[CHUNK_SIZE];
+        };
+
+        struct Chunk {
+            std::unique_ptr<ChunkStorage> storage; // Entity array first, then one array per component
+            u32 count = 0;
+        };
+
+        struct Archetype {
+            ComponentMask mask = 0;
+            u32 capacity = 0;                       // Entities per chunk
+            u32 entity_count = 0;
+            u32 offsets[Components::MAX] = {};      // Byte offset of each component's array, by ComponentId
+            std::vector<ComponentId> components;
+            std::vector<Chunk> chunks;              // All full except the last
+            u32 add_edges[Components::MAX];         // Archetype with one more / one less component, cached
+            u32 remove_edges[Components::MAX];
+        };
+
+        struct EntityRecord {
+            u32 archetype = INVALID;
+            u32 chunk = 0;
+            u32 row = 0;
+            u32 generation = 1;
+        };
+
+        struct System {
+            const char* name = nullptr;
+            SystemAccess access;
+            SystemFn fn;
+            SystemPhase phase = SystemPhase::Update;
+        };
+
+        static const Entity* chunk_entities(const Chunk& chunk) {
+            return reinterpret_cast<const Entity*>(chunk.storage->bytes);
+        }
+        template<typename C>
+        static C* chunk_column(const Archetype& archetype, Chunk& chunk) {
+            return reinterpret_cast<C*>(chunk.storage->bytes +
+                                        archetype.offsets[Components::id<std::remove_const_t<C>>()]);
+        }
+        template<typename F, typename... Cs>
+        static void call_rows(F& fn, u32 count, Cs*... columns) {
+            for (u32 i = 0; i < count; ++i) {
+                fn(columns[i]...);
+            }
+        }
+
+        Entity create_with(ComponentMask mask);
+        void* add_component(Entity entity, ComponentId id);
+        void remove_component(Entity entity, ComponentId id);
+        void* get_component(Entity entity, ComponentId id) const;
+
+        u32 find_or_create_archetype(ComponentMask mask);
+        // Append entity to archetype's last chunk and point its record there
+        void place(Entity entity, u32 archetype);
+        // Move entity's shared components to archetype and free its old row
+        void move(Entity entity, u32 archetype);
+        // Fill the row with the archetype's last entity and shrink it
+        void free_row(u32 archetype, u32 chunk, u32 row);
+        void build_stages();
+        void check_structural_change() const;
+
+        std::vector<Archetype> m_archetypes;
+        std::unordered_map<ComponentMask, u32> m_archetype_ids;
+        std::vector<EntityRecord> m_records;           // Indexed by Entity::index; slot 0 is never used
+        std::vector<u32> m_free_indices;
+        std::vector<std::unique_ptr<ChunkStorage>> m_free_chunks;
+        u32 m_entity_count = 0;
+
+        std::vector<System> m_systems;
+        // Per phase: system indices grouped into stages that run one after another
+        std::vector<std::vector<u32>> m_stages[static_cast<u32>(SystemPhase::Count)];
+        bool m_stages_dirty = false;
+        bool m_structure_locked = false; // A non-exclusive system is running
+    };
+}
@@ -0,0 +1,104 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+#include "defines.h"
+
+namespace Sparkle {
+    // What a logging thread does when the async log queue is full
+    enum class LogOverflowPolicy : u8 {
+        Block,     // Wait for the writer thread to make room (nothing is lost)
+        Drop,      // Discard the new message
+        Overwrite, // Discard the oldest queued message
+    };
+
+    // How finished frames are handed to the display (swapchain paths only)
+    enum class PresentMode : u8 {
+        Fifo,        // Vsync; always supported and the default
+        Mailbox,     // Vsync without blocking: a newer frame replaces the queued one, so frames nobody sees are still rendered
+        Immediate,   // No vsync; lowest latency, may tear
+        FifoRelaxed, // Vsync, but a frame that misses its refresh is shown right away (tears instead of stuttering)
+    };
+
+    struct LogConfig {
+        // Queue SPA_LOG_* records for a background writer instead of formatting and writing them
+        // to the console on the calling thread. FATAL messages are always written synchronously.
+        bool async = false;
+        u32 queue_capacity = 8192; // Records; rounded up to a power of two
+        LogOverflowPolicy overflow = LogOverflowPolicy::Drop;
+    };
+
+    struct ProfilerConfig {
+        // Record SPA_PROFILE_SCOPE zones and GPU timestamps from startup
+        // (needs an engine built with SPARKLE_PROFILE=ON, the default)
+        bool enabled = false;
+        u32 events_per_thread = 1 << 16; // Newest events kept per thread; rounded up to a power of two
+        // Chrome trace written at shutdown while enabled; nullptr skips it
+        const char* trace_path = "sparkle_trace.json";
+    };
+
+    struct AssetConfig {
+        // Packed archive (written by sparkle_cook) mounted at startup; nullptr mounts nothing.
+        // Only the index is read up front; asset data is paged in by the I/O threads on demand.
+        const char* archive = nullptr;
+        u32 io_threads = 2;
+        // Check each asset's content hash as it is paged in; the read faults every page in anyway
+        bool verify = true;
+        // Device memory the texture streamer may fill with mips; least recently used textures drop
+        // their finest mips to stay under it. Adjustable at runtime (VulkanTextureStreamer::set_budget).
+        u64 texture_budget = 256ull * 1024 * 1024;
+    };
+
+    // Engine-level settings that are not tied to the window
+    struct EngineConfig {
+        // Render into offscreen device images instead of a window surface.
+        // No SDL window, surface or present step is created, so this runs on
+        // display-less machines with a software ICD (e.g. lavapipe).
+        bool headless = false;
+
+        // Slices the draw list is cut into and recorded in parallel on the job system,
+        // one secondary command buffer each. 0 or 1 records inline on the main thread.
+        u32 render_record_threads = 0;
+
+        // Job system workers including the main thread; 0 uses one per hardware thread
+        u32 job_workers = 0;
+
+        // Draw frame N on a dedicated render thread while the main thread simulates frame N+1.
+        // Raises throughput when update and draw_frame cost about the same, at the price of up to
+        // one extra frame of latency (reported by Renderer::get_frame_latency_ms).
+        bool pipelined_render = false;
+
+        // Bytes per frame arena slot (FrameArena / FrameVector); overflow falls back to the heap
+        u64 frame_arena_size = 4 * 1024 * 1024;
+
+        // Run Game::fixed_update at this rate (0: only the variable-dt Game::update).
+        // At most max_fixed_steps run per frame; simulation time beyond that is dropped rather than
+        // caught up later, so a slow frame can't snowball into ever slower ones.
+        u32 fixed_update_hz = 0;
+        u32 max_fixed_steps = 5;
+
+        // Falls back to Fifo when the surface doesn't support the requested mode
+        PresentMode present_mode = PresentMode::Fifo;
+
+        // Cap on simulated frames per second; 0 runs as fast as the present mode allows.
+        // Waits by sleeping, then spinning the last stretch against SDL_GetTicksNS.
+        u32 target_fps = 0;
+
+        // Wait for the GPU to free the next frame slot before input is polled instead of inside the
+        // renderer, so input is sampled as late as possible. Serial rendering only (pipelined_render = false).
+        bool low_latency = false;
+
+        // VkPipelineCache saved at shutdown and fed back to the driver on the next start, so pipelines
+        // seen before don't have to be compiled from scratch. nullptr keeps the cache in memory only.
+        const char* pipeline_cache_path = "sparkle_pipeline_cache.bin";
+
+        // Draw through vkCmdBeginRendering (Vulkan 1.3) instead of render pass + framebuffer objects, so
+        // a resize only rebuilds image views and depth. Devices without it use the render pass path.
+        bool dynamic_rendering = true;
+
+        // Applied right after Game::init
+        LogConfig log;
+        ProfilerConfig profiler;
+        AssetConfig assets;
+    };
+}
@@ -0,0 +1,153 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "frame_arena.h"
+#include "logger.h"
+#include "spa_assert.h"
+#include <condition_variable>
+#include <mutex>
+#include <new>
+
+namespace Sparkle {
+    bool LinearArena::create(size_t capacity) {
+        m_memory = std::make_unique<u8[]>(capacity);
+        m_capacity = capacity;
+        m_offset = 0;
+        return m_memory != nullptr;
+    }
+
+    void LinearArena::destroy() {
+        m_memory.reset();
+        m_capacity = 0;
+        m_offset = 0;
+    }
+
+    void* LinearArena::allocate(size_t size, size_t alignment) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(m_memory.get());
+        size_t offset = m_offset.load(std::memory_order_relaxed);
+        size_t aligned;
+        do {
+            aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+            if (aligned + size > m_capacity) return nullptr;
+        } while (!m_offset.compare_exchange_weak(offset, aligned + size, std::memory_order_relaxed));
+
+        return m_memory.get() + aligned;
+    }
+
+    std::vector<std::unique_ptr<FrameArena::Slot>> FrameArena::s_slots;
+
+    static std::atomic<u32> s_sim_slot = 0;
+    static thread_local u32 t_bound_slot = UINT32_MAX;
+
+    static std::mutex s_retire_mutex;
+    static std::condition_variable s_retire_cv;
+
+    static std::atomic<u64> s_allocations = 0;
+    static std::atomic<u64> s_bytes = 0;
+    static std::atomic<u64> s_heap_fallbacks = 0;
+    static std::atomic<u64> s_peak_bytes = 0;
+    static std::atomic<u64> s_frames = 0;
+
+    bool FrameArena::init(u32 slot_count, size_t bytes_per_frame) {
+        SPA_ASSERT_MSG(s_slots.empty(), "FrameArena already initialized");
+        SPA_ASSERT(slot_count > 0);
+
+        for (u32 i = 0; i < slot_count; ++i) {
+            auto slot = std::make_unique<Slot>();
+            if (!slot->arena.create(bytes_per_frame)) {
+                SPA_LOG_ERROR("Failed to allocate {} byte frame arena.", bytes_per_frame);
+                s_slots.clear();
+                return false;
+            }
+            s_slots.push_back(std::move(slot));
+        }
+
+        SPA_LOG_DEBUG("Frame arena: {} slots of {} KiB.", slot_count, bytes_per_frame / 1024);
+        return true;
+    }
+
+    void FrameArena::shutdown() {
+        if (s_slots.empty()) return;
+
+        const FrameArenaStats stats = get_stats();
+        if (stats.heap_fallbacks > 0) {
+            SPA_LOG_WARN("Frame arena overflowed to the heap {} times (peak {} KiB per frame); raise frame_arena_size.",
+                         stats.heap_fallbacks, stats.peak_bytes / 1024);
+        }
+
+        s_slots.clear();
+        s_sim_slot = 0;
+    }
+
+    void FrameArena::begin_frame(u64 frame) {
+        if (s_slots.empty()) return;
+
+        const u32 index = static_cast<u32>(frame % s_slots.size());
+        Slot& slot = *s_slots[index];
+
+        if (slot.frame.load(std::memory_order_acquire) != 0) {
+            // Only happens if the renderer falls more than slot_count frames behind
+            std::unique_lock<std::mutex> lock(s_retire_mutex);
+            s_retire_cv.wait(lock, [&] { return slot.frame.load(std::memory_order_acquire) == 0; });
+        }
+
+        const u64 used = slot.arena.get_used();
+        u64 peak = s_peak_bytes.load(std::memory_order_relaxed);
+        while (used > peak && !s_peak_bytes.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {}
+
+        slot.arena.reset();
+        slot.frame.store(frame, std::memory_order_release);
+        s_sim_slot.store(index, std::memory_order_release);
+        t_bound_slot = index;
+        s_frames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void FrameArena::retire(u64 frame) {
+        if (s_slots.empty() || frame == 0) return;
+
+        Slot& slot = *s_slots[frame % s_slots.size()];
+        u64 expected = frame;
+        if (slot.frame.compare_exchange_strong(expected, 0, std::memory_order_acq_rel)) {
+            { std::lock_guard<std::mutex> lock(s_retire_mutex); }
+            s_retire_cv.notify_all();
+        }
+    }
+
+    void FrameArena::bind_thread(u64 frame) {
+        if (s_slots.empty() || frame == 0) return;
+        t_bound_slot = static_cast<u32>(frame % s_slots.size());
+    }
+
+    void* FrameArena::allocate(size_t size, size_t alignment) {
+        if (!s_slots.empty()) {
+            const u32 index = t_bound_slot != UINT32_MAX ? t_bound_slot : s_sim_slot.load(std::memory_order_acquire);
+            if (void* ptr = s_slots[index]->arena.allocate(size, alignment)) {
+                s_allocations.fetch_add(1, std::memory_order_relaxed);
+                s_bytes.fetch_add(size, std::memory_order_relaxed);
+                return ptr;
+            }
+        }
+
+        s_heap_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size, std::align_val_t(alignment));
+    }
+
+    void FrameArena::deallocate(void* ptr, size_t alignment) {
+        if (!ptr) return;
+        for (const std::unique_ptr<Slot>& slot : s_slots) {
+            if (slot->arena.owns(ptr)) return;
+        }
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+
+    FrameArenaStats FrameArena::get_stats() {
+        FrameArenaStats stats;
+        stats.allocations = s_allocations.load(std::memory_order_relaxed);
+        stats.bytes = s_bytes.load(std::memory_order_relaxed);
+        stats.heap_fallbacks = s_heap_fallbacks.load(std::memory_order_relaxed);
+        stats.peak_bytes = s_peak_bytes.load(std::memory_order_relaxed);
+        stats.frames = s_frames.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
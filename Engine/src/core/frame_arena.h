@@ -0,0 +1,103 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Sparkle {
+    // Bump allocator over one fixed block. allocate() is lock-free; reset() must not race it.
+    class LinearArena {
+    public:
+        bool create(size_t capacity);
+        void destroy();
+
+        // nullptr once the block is full
+        void* allocate(size_t size, size_t alignment);
+        void reset() { m_offset.store(0, std::memory_order_relaxed); }
+
+        bool owns(const void* ptr) const {
+            const u8* p = static_cast<const u8*>(ptr);
+            return p >= m_memory.get() && p < m_memory.get() + m_capacity;
+        }
+
+        size_t get_used() const { return m_offset.load(std::memory_order_relaxed); }
+        size_t get_capacity() const { return m_capacity; }
+
+    private:
+        std::unique_ptr<u8[]> m_memory;
+        size_t m_capacity = 0;
+        std::atomic<size_t> m_offset = 0;
+    };
+
+    struct FrameArenaStats {
+        u64 allocations = 0;     // Served from an arena
+        u64 bytes = 0;
+        u64 heap_fallbacks = 0;  // Arena was full and the request went to the heap
+        u64 peak_bytes = 0;      // Most bytes any single frame used
+        u64 frames = 0;
+    };
+
+    // One LinearArena per frame slot. The simulation starts frame N in slot N % slot_count, and
+    // the slot is only reset once the renderer has retired the frame that used it before
+    // (its in-flight fence signaled), so per-frame data stays valid for as long as the frame is in flight.
+    class FrameArena {
+    public:
+        static constexpr size_t DEFAULT_SIZE = 4 * 1024 * 1024;
+
+        static bool init(u32 slot_count, size_t bytes_per_frame = DEFAULT_SIZE);
+        static void shutdown();
+        static bool is_initialized() { return !s_slots.empty(); }
+
+        // Simulation side, once per frame (frame > 0). Blocks until the slot is free, then resets it.
+        static void begin_frame(u64 frame);
+        // Renderer side: everything recorded for frame has finished on the GPU
+        static void retire(u64 frame);
+        // Make the calling thread allocate from frame's slot (the render thread while it draws a packet).
+        // Other threads allocate from the frame the simulation started last.
+        static void bind_thread(u64 frame);
+
+        static void* allocate(size_t size, size_t alignment);
+        // No-op for arena memory; only heap fallbacks are freed
+        static void deallocate(void* ptr, size_t alignment);
+
+        static FrameArenaStats get_stats();
+
+    private:
+        struct Slot {
+            LinearArena arena;
+            std::atomic<u64> frame = 0; // Frame still using this slot, 0 once retired
+        };
+
+        static std::vector<std::unique_ptr<Slot>> s_slots;
+    };
+
+    // STL allocator that draws from the current frame's arena; memory lives until the frame retires
+    template<typename T>
+    class FrameAllocator {
+    public:
+        using value_type = T;
+
+        FrameAllocator() noexcept = default;
+        template<typename U>
+        FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(FrameArena::allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* ptr, size_t) noexcept {
+            FrameArena::deallocate(ptr, alignof(T));
+        }
+
+        template<typename U>
+        bool operator==(const FrameAllocator<U>&) const noexcept { return true; }
+    };
+
+    template<typename T>
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+}
@@ -0,0 +1,112 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "frame_stats.h"
+#include <cmath>
+
+namespace Sparkle {
+    u32 FrameStatsWindow::bucket_of(f64 ms) {
+        const f64 bucket = ms / BUCKET_MS;
+        return bucket >= BUCKET_COUNT - 1 ? BUCKET_COUNT - 1 : static_cast<u32>(bucket);
+    }
+
+    void FrameStatsWindow::push(u64 frame_ns) {
+        const f64 ms = static_cast<f64>(frame_ns) / 1'000'000.0;
+        const u64 seq = m_next++;
+
+        if (m_count == WINDOW) {
+            // Evict the oldest sample, which occupies the slot about to be written
+            const u64 oldest = seq - WINDOW;
+            const f64 old = sample(oldest);
+            m_sum -= old;
+            m_sum_sq -= old * old;
+            m_histogram[bucket_of(old)]--;
+            if (old > m_hitch_threshold_ms) m_hitches--;
+            if (m_min_queue.size && m_min_queue.front() == oldest) m_min_queue.pop_front();
+            if (m_max_queue.size && m_max_queue.front() == oldest) m_max_queue.pop_front();
+        } else {
+            m_count++;
+        }
+
+        m_samples[seq % WINDOW] = ms;
+        m_sum += ms;
+        m_sum_sq += ms * ms;
+        m_histogram[bucket_of(ms)]++;
+        if (ms > m_hitch_threshold_ms) {
+            m_hitches++;
+            m_total_hitches++;
+        }
+
+        while (m_min_queue.size && sample(m_min_queue.back()) >= ms) m_min_queue.pop_back();
+        m_min_queue.push_back(seq);
+        while (m_max_queue.size && sample(m_max_queue.back()) <= ms) m_max_queue.pop_back();
+        m_max_queue.push_back(seq);
+
+        // Running sums pick up rounding error as samples come and go; rebuild them once per window
+        if (++m_since_recompute == WINDOW) recompute_sums();
+    }
+
+    void FrameStatsWindow::recompute_sums() {
+        m_sum = 0.0;
+        m_sum_sq = 0.0;
+        for (u64 seq = m_next - m_count; seq < m_next; ++seq) {
+            const f64 ms = sample(seq);
+            m_sum += ms;
+            m_sum_sq += ms * ms;
+        }
+        m_since_recompute = 0;
+    }
+
+    void FrameStatsWindow::reset() {
+        const f32 threshold = m_hitch_threshold_ms;
+        *this = FrameStatsWindow{};
+        m_hitch_threshold_ms = threshold;
+    }
+
+    void FrameStatsWindow::set_hitch_threshold_ms(f32 threshold_ms) {
+        m_hitch_threshold_ms = threshold_ms;
+        m_hitches = 0;
+        for (u64 seq = m_next - m_count; seq < m_next; ++seq) {
+            if (sample(seq) > threshold_ms) m_hitches++;
+        }
+    }
+
+    f32 FrameStatsWindow::percentile(f32 p) const {
+        // Smallest bucket whose cumulative count reaches rank; report the bucket's upper edge,
+        // clamped to the real extremes so the result never leaves [min, max]
+        const u32 rank = std::max(1u, static_cast<u32>(std::ceil(p * static_cast<f32>(m_count))));
+        u32 seen = 0;
+        f64 value = sample(m_max_queue.front());
+        for (u32 bucket = 0; bucket < BUCKET_COUNT - 1; ++bucket) {
+            seen += m_histogram[bucket];
+            if (seen >= rank) {
+                value = (bucket + 1) * static_cast<f64>(BUCKET_MS);
+                break;
+            }
+        }
+        value = std::clamp(value, sample(m_min_queue.front()), sample(m_max_queue.front()));
+        return static_cast<f32>(value);
+    }
+
+    FrameStats FrameStatsWindow::get_stats() const {
+        FrameStats stats;
+        stats.total_hitches = m_total_hitches;
+        if (m_count == 0) return stats;
+
+        const f64 mean = m_sum / m_count;
+        const f64 variance = std::max(0.0, m_sum_sq / m_count - mean * mean);
+
+        stats.mean_ms = static_cast<f32>(mean);
+        stats.min_ms = static_cast<f32>(sample(m_min_queue.front()));
+        stats.max_ms = static_cast<f32>(sample(m_max_queue.front()));
+        stats.p50_ms = percentile(0.50f);
+        stats.p95_ms = percentile(0.95f);
+        stats.p99_ms = percentile(0.99f);
+        stats.variance_ms2 = static_cast<f32>(variance);
+        stats.stddev_ms = static_cast<f32>(std::sqrt(variance));
+        stats.hitches = m_hitches;
+        stats.sample_count = m_count;
+        return stats;
+    }
+}
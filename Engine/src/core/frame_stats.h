@@ -0,0 +1,80 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+
+namespace Sparkle {
+    // Summary of the frames currently in a FrameStatsWindow, all times in milliseconds
+    struct FrameStats {
+        f32 mean_ms = 0.0f;
+        f32 min_ms = 0.0f;
+        f32 max_ms = 0.0f;
+        f32 p50_ms = 0.0f;
+        f32 p95_ms = 0.0f;
+        f32 p99_ms = 0.0f;
+        f32 variance_ms2 = 0.0f;
+        f32 stddev_ms = 0.0f;
+        u32 hitches = 0;       // Frames in the window above the hitch threshold
+        u32 sample_count = 0;  // Frames in the window (< WINDOW until it fills)
+        u64 total_hitches = 0; // Since startup
+    };
+
+    // Fixed-size ring of the most recent frame times. push() is O(1): mean and variance come from
+    // running sums, min/max from monotonic queues, and percentiles from a histogram that gains the
+    // new frame's bucket and loses the evicted one. Nothing here allocates.
+    class FrameStatsWindow {
+    public:
+        static constexpr u32 WINDOW = 256;
+        static constexpr f32 BUCKET_MS = 0.1f;   // Percentile resolution
+        static constexpr u32 BUCKET_COUNT = 1000; // Frames longer than 100 ms share the last bucket
+
+        void push(u64 frame_ns);
+        void reset();
+
+        // Re-counts the hitches in the window against the new threshold
+        void set_hitch_threshold_ms(f32 threshold_ms);
+        f32 get_hitch_threshold_ms() const { return m_hitch_threshold_ms; }
+
+        // O(BUCKET_COUNT) for the percentiles, everything else is read directly
+        FrameStats get_stats() const;
+        f32 get_mean_ms() const { return m_count ? static_cast<f32>(m_sum / m_count) : 0.0f; }
+
+    private:
+        // Fixed-capacity deque of sample sequence numbers, for the sliding min / max
+        struct MonotonicQueue {
+            u64 items[WINDOW] = {};
+            u32 head = 0;
+            u32 size = 0;
+
+            u64 front() const { return items[head]; }
+            u64 back() const { return items[(head + size - 1) % WINDOW]; }
+            void pop_front() { head = (head + 1) % WINDOW; size--; }
+            void pop_back() { size--; }
+            void push_back(u64 seq) { items[(head + size) % WINDOW] = seq; size++; }
+        };
+
+        static u32 bucket_of(f64 ms);
+        f64 sample(u64 seq) const { return m_samples[seq % WINDOW]; }
+        f32 percentile(f32 p) const;
+        void recompute_sums();
+
+        f64 m_samples[WINDOW] = {};
+        u64 m_next = 0;  // Sequence number of the next sample
+        u32 m_count = 0;
+
+        f64 m_sum = 0.0;
+        f64 m_sum_sq = 0.0;
+        u32 m_since_recompute = 0;
+
+        MonotonicQueue m_min_queue; // Increasing values
+        MonotonicQueue m_max_queue; // Decreasing values
+
+        u16 m_histogram[BUCKET_COUNT] = {};
+
+        f32 m_hitch_threshold_ms = 33.3f;
+        u32 m_hitches = 0;
+        u64 m_total_hitches = 0;
+    };
+}
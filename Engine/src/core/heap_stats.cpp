@@ -0,0 +1,51 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "heap_stats.h"
+#include <atomic>
+#include <new>
+
+namespace Sparkle {
+    static std::atomic<u64> s_allocation_count = 0;
+    static std::atomic<u64> s_allocated_bytes = 0;
+
+#ifdef SPA_TRACK_HEAP
+    bool HeapStats::is_enabled() { return true; }
+#else
+    bool HeapStats::is_enabled() { return false; }
+#endif
+
+    u64 HeapStats::get_allocation_count() { return s_allocation_count.load(std::memory_order_relaxed); }
+    u64 HeapStats::get_allocated_bytes() { return s_allocated_bytes.load(std::memory_order_relaxed); }
+
+#ifdef SPA_TRACK_HEAP
+    static void* tracked_alloc(size_t size, size_t alignment) {
+        s_allocation_count.fetch_add(1, std::memory_order_relaxed);
+        s_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (size == 0) size = 1;
+        void* ptr = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                        ? std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1))
+                        : std::malloc(size);
+        if (!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+#endif
+}
+
+#ifdef SPA_TRACK_HEAP
+void* operator new(size_t size) { return Sparkle::tracked_alloc(size, 0); }
+void* operator new[](size_t size) { return Sparkle::tracked_alloc(size, 0); }
+void* operator new(size_t size, std::align_val_t align) { return Sparkle::tracked_alloc(size, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return Sparkle::tracked_alloc(size, static_cast<size_t>(align)); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+#endif
@@ -0,0 +1,17 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+
+namespace Sparkle {
+    // Counts every global operator new in the process. Only active when the engine is built with
+    // SPARKLE_TRACK_HEAP=ON, which replaces the global allocation functions; otherwise counts stay 0.
+    class HeapStats {
+    public:
+        static bool is_enabled();
+        static u64 get_allocation_count();
+        static u64 get_allocated_bytes();
+    };
+}
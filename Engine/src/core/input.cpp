@@ -3,55 +3,190 @@
 //
 #include "spa_pch.h"
 #include "input.h"
+#include "logger.h"
 
 namespace Sparkle {
-    bool Input::s_keys_current[MAX_KEYS] = {};
-    bool Input::s_keys_previous[MAX_KEYS] = {};
+    std::bitset<Input::MAX_KEYS> Input::s_keys_down;
+    std::bitset<Input::MAX_KEYS> Input::s_keys_pressed;
+    std::bitset<Input::MAX_KEYS> Input::s_keys_released;
 
-    bool Input::s_mouse_current[MAX_MOUSE_BUTTONS] = {};
-    bool Input::s_mouse_previous[MAX_MOUSE_BUTTONS] = {};
+    std::bitset<Input::MAX_MOUSE_BUTTONS> Input::s_mouse_down;
+    std::bitset<Input::MAX_MOUSE_BUTTONS> Input::s_mouse_pressed;
+    std::bitset<Input::MAX_MOUSE_BUTTONS> Input::s_mouse_released;
 
     int Input::s_mouse_x = 0;
     int Input::s_mouse_y = 0;
+    f32 Input::s_mouse_dx = 0.0f;
+    f32 Input::s_mouse_dy = 0.0f;
 
     int Input::s_scroll_x = 0;
     int Input::s_scroll_y = 0;
 
+    Input::GamepadState Input::s_gamepads[MAX_GAMEPADS] = {};
+
+    InputEvent Input::s_events[EVENT_CAPACITY] = {};
+    u64 Input::s_event_write = 0;
+    u64 Input::s_frame_first_event = 0;
+    u64 Input::s_dropped_events = 0;
+
     void Input::begin_frame() {
-        std::memcpy(s_keys_previous, s_keys_current, sizeof(s_keys_current));
-        std::memcpy(s_mouse_previous, s_mouse_current, sizeof(s_mouse_current));
+        // Only the transition masks are per frame; held state carries over untouched
+        s_keys_pressed.reset();
+        s_keys_released.reset();
+        s_mouse_pressed.reset();
+        s_mouse_released.reset();
+        for (GamepadState& pad : s_gamepads) {
+            pad.pressed.reset();
+            pad.released.reset();
+        }
+        s_mouse_dx = 0.0f;
+        s_mouse_dy = 0.0f;
         s_scroll_x = 0;
         s_scroll_y = 0;
+        s_frame_first_event = s_event_write;
+    }
+
+    void Input::shutdown() {
+        for (GamepadState& pad : s_gamepads) {
+            if (pad.handle) SDL_CloseGamepad(pad.handle);
+            pad = GamepadState{};
+        }
+    }
+
+    Input::GamepadState* Input::find_gamepad(SDL_JoystickID id, u8* slot) {
+        for (u8 i = 0; i < MAX_GAMEPADS; ++i) {
+            if (s_gamepads[i].handle && s_gamepads[i].id == id) {
+                if (slot) *slot = i;
+                return &s_gamepads[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void Input::push_event(const InputEvent& event) {
+        if (s_event_write - s_frame_first_event == EVENT_CAPACITY) {
+            // The oldest event of this frame is about to be overwritten
+            s_frame_first_event++;
+            s_dropped_events++;
+        }
+        s_events[s_event_write & (EVENT_CAPACITY - 1)] = event;
+        s_event_write++;
     }
 
     void Input::process_event(const SDL_Event &event) {
+        InputEvent record;
+        record.timestamp_ns = event.common.timestamp;
+
         switch (event.type) {
             case SDL_EVENT_KEY_DOWN:
-                if (event.key.repeat == 0)
-                    s_keys_current[event.key.scancode] = true;
+                if (event.key.repeat != 0 || event.key.scancode >= MAX_KEYS) break;
+                if (!s_keys_down.test(event.key.scancode)) {
+                    s_keys_down.set(event.key.scancode);
+                    s_keys_pressed.set(event.key.scancode);
+                }
+                record.type = InputEventType::KeyDown;
+                record.code = static_cast<u16>(event.key.scancode);
+                push_event(record);
                 break;
 
             case SDL_EVENT_KEY_UP:
-                s_keys_current[event.key.scancode] = false;
+                if (event.key.scancode >= MAX_KEYS) break;
+                s_keys_down.reset(event.key.scancode);
+                s_keys_released.set(event.key.scancode);
+                record.type = InputEventType::KeyUp;
+                record.code = static_cast<u16>(event.key.scancode);
+                push_event(record);
                 break;
 
             case SDL_EVENT_MOUSE_BUTTON_DOWN:
-                s_mouse_current[event.button.button] = true;
-                break;
+            case SDL_EVENT_MOUSE_BUTTON_UP: {
+                if (event.button.button >= MAX_MOUSE_BUTTONS) break;
+                const bool down = event.type == SDL_EVENT_MOUSE_BUTTON_DOWN;
+                s_mouse_down.set(event.button.button, down);
+                if (down) s_mouse_pressed.set(event.button.button);
+                else s_mouse_released.set(event.button.button);
 
-            case SDL_EVENT_MOUSE_BUTTON_UP:
-                s_mouse_current[event.button.button] = false;
+                record.type = down ? InputEventType::MouseButtonDown : InputEventType::MouseButtonUp;
+                record.code = event.button.button;
+                record.x = event.button.x;
+                record.y = event.button.y;
+                push_event(record);
                 break;
+            }
 
             case SDL_EVENT_MOUSE_MOTION:
                 s_mouse_x = event.motion.x;
                 s_mouse_y = event.motion.y;
+                s_mouse_dx += event.motion.xrel;
+                s_mouse_dy += event.motion.yrel;
+
+                record.type = InputEventType::MouseMotion;
+                record.x = event.motion.x;
+                record.y = event.motion.y;
+                record.dx = event.motion.xrel;
+                record.dy = event.motion.yrel;
+                push_event(record);
                 break;
 
             case SDL_EVENT_MOUSE_WHEEL:
                 s_scroll_x += event.wheel.x;
                 s_scroll_y += event.wheel.y;
+
+                record.type = InputEventType::MouseWheel;
+                record.x = event.wheel.x;
+                record.y = event.wheel.y;
+                push_event(record);
+                break;
+
+            case SDL_EVENT_GAMEPAD_ADDED: {
+                if (find_gamepad(event.gdevice.which)) break;
+                for (u32 i = 0; i < MAX_GAMEPADS; ++i) {
+                    if (s_gamepads[i].handle) continue;
+                    s_gamepads[i] = GamepadState{};
+                    s_gamepads[i].handle = SDL_OpenGamepad(event.gdevice.which);
+                    s_gamepads[i].id = event.gdevice.which;
+                    if (s_gamepads[i].handle) {
+                        SPA_LOG_INFO("Gamepad '{}' connected in slot {}.", SDL_GetGamepadName(s_gamepads[i].handle), i);
+                    }
+                    break;
+                }
+                break;
+            }
+
+            case SDL_EVENT_GAMEPAD_REMOVED:
+                if (GamepadState* pad = find_gamepad(event.gdevice.which)) {
+                    SDL_CloseGamepad(pad->handle);
+                    *pad = GamepadState{};
+                }
+                break;
+
+            case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+            case SDL_EVENT_GAMEPAD_BUTTON_UP: {
+                GamepadState* pad = find_gamepad(event.gbutton.which, &record.gamepad);
+                if (!pad || event.gbutton.button >= MAX_GAMEPAD_BUTTONS) break;
+                const bool down = event.type == SDL_EVENT_GAMEPAD_BUTTON_DOWN;
+                pad->down.set(event.gbutton.button, down);
+                if (down) pad->pressed.set(event.gbutton.button);
+                else pad->released.set(event.gbutton.button);
+
+                record.type = down ? InputEventType::GamepadButtonDown : InputEventType::GamepadButtonUp;
+                record.code = event.gbutton.button;
+                push_event(record);
+                break;
+            }
+
+            case SDL_EVENT_GAMEPAD_AXIS_MOTION: {
+                GamepadState* pad = find_gamepad(event.gaxis.which, &record.gamepad);
+                if (!pad || event.gaxis.axis >= MAX_GAMEPAD_AXES) break;
+                const f32 value = std::max(-1.0f, static_cast<f32>(event.gaxis.value) / 32767.0f);
+                pad->axes[event.gaxis.axis] = value;
+
+                record.type = InputEventType::GamepadAxis;
+                record.code = event.gaxis.axis;
+                record.x = value;
+                push_event(record);
                 break;
+            }
 
             default:
                 break;
@@ -61,38 +196,85 @@ namespace Sparkle {
     // === Keyboard ===
     bool Input::key_pressed(Key key) {
         int scancode = static_cast<int>(key);
-        return s_keys_current[scancode] && !s_keys_previous[scancode];
+        return s_keys_pressed.test(scancode);
     }
 
     bool Input::key_released(Key key) {
         int scancode = static_cast<int>(key);
-        return !s_keys_current[scancode] && s_keys_previous[scancode];
+        return s_keys_released.test(scancode);
     }
 
     bool Input::key_down(Key key) {
         int scancode = static_cast<int>(key);
-        return s_keys_current[scancode];
+        return s_keys_down.test(scancode);
     }
 
     // === Mouse ===
     bool Input::mouse_pressed(MouseButton button) {
         int idx = static_cast<int>(button);
-        return s_mouse_current[idx] && !s_mouse_previous[idx];
+        return s_mouse_pressed.test(idx);
     }
 
     bool Input::mouse_released(MouseButton button) {
         int idx = static_cast<int>(button);
-        return !s_mouse_current[idx] && s_mouse_previous[idx];
+        return s_mouse_released.test(idx);
     }
 
     bool Input::mouse_down(MouseButton button) {
         int idx = static_cast<int>(button);
-        return s_mouse_current[idx];
+        return s_mouse_down.test(idx);
     }
 
     int Input::mouse_x() { return s_mouse_x; }
     int Input::mouse_y() { return s_mouse_y; }
+    f32 Input::mouse_dx() { return s_mouse_dx; }
+    f32 Input::mouse_dy() { return s_mouse_dy; }
 
     int Input::scroll_x() { return s_scroll_x; }
     int Input::scroll_y() { return s_scroll_y; }
+
+    // === Gamepad ===
+    bool Input::gamepad_connected(u32 pad) {
+        return pad < MAX_GAMEPADS && s_gamepads[pad].handle != nullptr;
+    }
+
+    bool Input::gamepad_pressed(GamepadButton button, u32 pad) {
+        return pad < MAX_GAMEPADS && s_gamepads[pad].pressed.test(static_cast<int>(button));
+    }
+
+    bool Input::gamepad_released(GamepadButton button, u32 pad) {
+        return pad < MAX_GAMEPADS && s_gamepads[pad].released.test(static_cast<int>(button));
+    }
+
+    bool Input::gamepad_down(GamepadButton button, u32 pad) {
+        return pad < MAX_GAMEPADS && s_gamepads[pad].down.test(static_cast<int>(button));
+    }
+
+    f32 Input::gamepad_axis(GamepadAxis axis, u32 pad) {
+        return pad < MAX_GAMEPADS ? s_gamepads[pad].axes[static_cast<int>(axis)] : 0.0f;
+    }
+
+    // === Event ring ===
+    InputEventRange Input::frame_events() {
+        return {s_events, s_frame_first_event, s_event_write};
+    }
+
+    InputEventRange Input::events_between(u64 begin_ns, u64 end_ns) {
+        // Timestamps arrive in order, so both ends are found by binary search over the buffered events
+        auto lower_bound = [](u64 first, u64 last, u64 timestamp_ns) {
+            while (first < last) {
+                const u64 mid = first + (last - first) / 2;
+                if (s_events[mid & (EVENT_CAPACITY - 1)].timestamp_ns < timestamp_ns) first = mid + 1;
+                else last = mid;
+            }
+            return first;
+        };
+
+        const u64 oldest = s_event_write > EVENT_CAPACITY ? s_event_write - EVENT_CAPACITY : 0;
+        const u64 first = lower_bound(oldest, s_event_write, begin_ns);
+        const u64 last = lower_bound(first, s_event_write, end_ns);
+        return {s_events, first, last};
+    }
+
+    u64 Input::dropped_events() { return s_dropped_events; }
 }
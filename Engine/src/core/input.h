@@ -3,18 +3,82 @@
 //
 
 #pragma once
+#include "defines.h"
 #include "key_codes.h"
+#include <bitset>
 
 namespace Sparkle {
+    enum class InputEventType : u8 {
+        KeyDown,
+        KeyUp,
+        MouseButtonDown,
+        MouseButtonUp,
+        MouseMotion,
+        MouseWheel,
+        GamepadButtonDown,
+        GamepadButtonUp,
+        GamepadAxis,
+    };
+
+    // One SDL input event as it arrived (key repeats are not recorded)
+    struct InputEvent {
+        u64 timestamp_ns = 0; // SDL event timestamp, same clock as SDL_GetTicksNS
+        InputEventType type = InputEventType::KeyDown;
+        u16 code = 0;         // Scancode for keys, SDL button / axis index for mouse buttons and gamepads
+        u8 gamepad = 0;       // Gamepad slot for gamepad events
+        f32 x = 0.0f;         // Pointer position for motion / buttons, scroll amount for the wheel, axis value
+        f32 y = 0.0f;
+        f32 dx = 0.0f;        // Relative motion
+        f32 dy = 0.0f;
+    };
+
+    // View over a run of the input ring in arrival order. Valid until the ring wraps past it,
+    // i.e. for at least the frame it was taken in.
+    class InputEventRange {
+    public:
+        class Iterator {
+        public:
+            Iterator(const InputEvent* ring, u64 index) : m_ring(ring), m_index(index) {}
+            const InputEvent& operator*() const;
+            const InputEvent* operator->() const { return &**this; }
+            Iterator& operator++() { ++m_index; return *this; }
+            bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+            bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+        private:
+            const InputEvent* m_ring;
+            u64 m_index;
+        };
+
+        InputEventRange(const InputEvent* ring, u64 first, u64 last) : m_ring(ring), m_first(first), m_last(last) {}
+
+        Iterator begin() const { return {m_ring, m_first}; }
+        Iterator end() const { return {m_ring, m_last}; }
+        u64 size() const { return m_last - m_first; }
+        bool empty() const { return m_first == m_last; }
+
+    private:
+        const InputEvent* m_ring;
+        u64 m_first;
+        u64 m_last;
+    };
+
     class Input {
     public:
+        static constexpr u32 EVENT_CAPACITY = 1024; // Power of two
+        static constexpr u32 MAX_GAMEPADS = 4;
+
         // Called once per frame to reset transient input
         static void begin_frame();
 
         // Update state from SDL events
         static void process_event(const SDL_Event& event);
 
-        // Query input state
+        // Closes any open gamepads; call before SDL_Quit
+        static void shutdown();
+
+        // Query input state. pressed / released report any transition during the frame, so a key
+        // tapped and let go between two frames is both pressed and released (and not down).
         static bool key_pressed(Key key);
         static bool key_released(Key key);
         static bool key_down(Key key);
@@ -26,25 +90,75 @@ namespace Sparkle {
         // Mouse position
         static int mouse_x();
         static int mouse_y();
+        // Sum of every motion event this frame
+        static f32 mouse_dx();
+        static f32 mouse_dy();
 
         // Scroll
         static int scroll_x();
         static int scroll_y();
 
+        // Gamepads take the first free slot (0..MAX_GAMEPADS-1) when connected and keep it until removed.
+        // Axis values are raw: no deadzone is applied (see Actions for that).
+        static bool gamepad_connected(u32 pad);
+        static bool gamepad_pressed(GamepadButton button, u32 pad = 0);
+        static bool gamepad_released(GamepadButton button, u32 pad = 0);
+        static bool gamepad_down(GamepadButton button, u32 pad = 0);
+        static f32 gamepad_axis(GamepadAxis axis, u32 pad = 0);
+
+        // Every event processed since begin_frame, in arrival order
+        static InputEventRange frame_events();
+        // Buffered events with begin_ns <= timestamp < end_ns, across frame boundaries. A fixed-step update
+        // can read exactly the input of its own step (see Time::fixed_step_end_ns).
+        static InputEventRange events_between(u64 begin_ns, u64 end_ns);
+        // Events overwritten before they could be read (more than EVENT_CAPACITY in one frame)
+        static u64 dropped_events();
+
     private:
         static constexpr int MAX_KEYS = 512;
         static constexpr int MAX_MOUSE_BUTTONS = 8;
 
-        static bool s_keys_current[MAX_KEYS];
-        static bool s_keys_previous[MAX_KEYS];
+        static constexpr int MAX_GAMEPAD_BUTTONS = 32;
+        static constexpr int MAX_GAMEPAD_AXES = 8;
+
+        struct GamepadState {
+            SDL_Gamepad* handle = nullptr;
+            SDL_JoystickID id = 0;
+            std::bitset<MAX_GAMEPAD_BUTTONS> down;
+            std::bitset<MAX_GAMEPAD_BUTTONS> pressed;
+            std::bitset<MAX_GAMEPAD_BUTTONS> released;
+            f32 axes[MAX_GAMEPAD_AXES] = {};
+        };
 
-        static bool s_mouse_current[MAX_MOUSE_BUTTONS];
-        static bool s_mouse_previous[MAX_MOUSE_BUTTONS];
+        static void push_event(const InputEvent& event);
+        static GamepadState* find_gamepad(SDL_JoystickID id, u8* slot = nullptr);
+
+        // Current state plus the transitions seen since begin_frame
+        static std::bitset<MAX_KEYS> s_keys_down;
+        static std::bitset<MAX_KEYS> s_keys_pressed;
+        static std::bitset<MAX_KEYS> s_keys_released;
+
+        static std::bitset<MAX_MOUSE_BUTTONS> s_mouse_down;
+        static std::bitset<MAX_MOUSE_BUTTONS> s_mouse_pressed;
+        static std::bitset<MAX_MOUSE_BUTTONS> s_mouse_released;
 
         static int s_mouse_x;
         static int s_mouse_y;
+        static f32 s_mouse_dx;
+        static f32 s_mouse_dy;
 
         static int s_scroll_x;
         static int s_scroll_y;
+
+        static GamepadState s_gamepads[MAX_GAMEPADS];
+
+        static InputEvent s_events[EVENT_CAPACITY];
+        static u64 s_event_write;       // Events ever pushed; the ring holds the last EVENT_CAPACITY
+        static u64 s_frame_first_event; // First event of the current frame
+        static u64 s_dropped_events;
     };
-}
\ No newline at end of file
+
+    inline const InputEvent& InputEventRange::Iterator::operator*() const {
+        return m_ring[m_index & (Input::EVENT_CAPACITY - 1)];
+    }
+}
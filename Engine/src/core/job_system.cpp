@@ -0,0 +1,363 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "job_system.h"
+#include "logger.h"
+#include "profiler.h"
+#include "spa_assert.h"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Sparkle {
+    namespace {
+        // Chase-Lev deque: the owner pushes/pops at the bottom, thieves take from the top
+        template<typename T, u32 CAPACITY>
+        class WorkStealingDeque {
+            static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+        public:
+            bool push(T item) {
+                const i64 b = m_bottom.load(std::memory_order_relaxed);
+                const i64 t = m_top.load(std::memory_order_acquire);
+                if (b - t >= static_cast<i64>(CAPACITY)) return false;
+
+                m_items[b & (CAPACITY - 1)].store(item, std::memory_order_relaxed);
+                m_bottom.store(b + 1, std::memory_order_release);
+                return true;
+            }
+
+            T pop() {
+                const i64 b = m_bottom.load(std::memory_order_relaxed) - 1;
+                m_bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                i64 t = m_top.load(std::memory_order_relaxed);
+
+                if (t > b) {
+                    m_bottom.store(b + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+
+                T item = m_items[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+                if (t == b) {
+                    // Last item: race the thieves for it
+                    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                        item = nullptr;
+                    }
+                    m_bottom.store(b + 1, std::memory_order_relaxed);
+                }
+                return item;
+            }
+
+            T steal() {
+                i64 t = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const i64 b = m_bottom.load(std::memory_order_acquire);
+                if (t >= b) return nullptr;
+
+                T item = m_items[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+                if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return nullptr;
+                }
+                return item;
+            }
+
+        private:
+            alignas(64) std::atomic<i64> m_top{0};
+            alignas(64) std::atomic<i64> m_bottom{0};
+            std::atomic<T> m_items[CAPACITY];
+        };
+
+        // Ring the job structs are carved from: one per worker, plus a locked one shared by threads the job
+        // system does not own. A slot stays busy until its job has run, so the ring wrapping onto a job that
+        // is still queued or running never overwrites it. Owned by the job system and freed in shutdown(),
+        // so a submitting thread may exit while its jobs are still queued.
+        struct JobRing {
+            std::unique_ptr<u8[]> memory;
+            std::unique_ptr<std::atomic<bool>[]> busy;
+            u32 next = 0;
+        };
+    }
+
+    using JobDeque = WorkStealingDeque<void*, JobSystem::MAX_JOBS_PER_THREAD>;
+
+    static std::vector<std::unique_ptr<JobDeque>> s_queues;
+    static std::vector<std::thread> s_threads;
+    static std::atomic<bool> s_running = false;
+
+    // Jobs from threads the job system does not own, and jobs re-queued while waiting on a dependency
+    static std::mutex s_injection_mutex;
+    static std::deque<void*> s_injection;
+
+    // Jobs whose dependency was not done when they were picked up; released when a counter reaches zero
+    static std::mutex s_parked_mutex;
+    static std::vector<void*> s_parked;
+    static std::atomic<u32> s_parked_count = 0;
+
+    // s_rings[i] belongs to worker i; the last one is shared by every other thread
+    static std::vector<std::unique_ptr<JobRing>> s_rings;
+    static std::mutex s_shared_ring_mutex;
+
+    static std::atomic<u32> s_queued = 0;
+    static std::atomic<u32> s_sleeping = 0;
+    static std::mutex s_sleep_mutex;
+    static std::condition_variable s_wake_cv;
+
+    static thread_local u32 t_worker_index = UINT32_MAX;
+    static thread_local u32 t_steal_cursor = 0;
+
+    bool JobSystem::init(u32 worker_count) {
+        SPA_ASSERT_MSG(!s_running, "JobSystem already initialized");
+
+        if (worker_count == 0) {
+            worker_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        s_queues.clear();
+        s_rings.clear();
+        for (u32 i = 0; i < worker_count; ++i) {
+            s_queues.push_back(std::make_unique<JobDeque>());
+        }
+        for (u32 i = 0; i <= worker_count; ++i) {
+            auto ring = std::make_unique<JobRing>();
+            ring->memory = std::make_unique<u8[]>(sizeof(Job) * MAX_JOBS_PER_THREAD);
+            ring->busy = std::make_unique<std::atomic<bool>[]>(MAX_JOBS_PER_THREAD);
+            s_rings.push_back(std::move(ring));
+        }
+
+        t_worker_index = 0;
+        s_running = true;
+        for (u32 i = 1; i < worker_count; ++i) {
+            s_threads.emplace_back(&JobSystem::worker_loop, i);
+        }
+
+        SPA_LOG_DEBUG("Job system started with {} workers.", worker_count);
+        return true;
+    }
+
+    void JobSystem::shutdown() {
+        if (!s_running) return;
+
+        // Finish whatever is still queued so counters held by callers reach zero. Parked jobs are not
+        // counted, so this ends even if a dependency is never satisfied.
+        while (s_queued.load(std::memory_order_seq_cst) > 0) {
+            if (!try_run_one()) std::this_thread::yield();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_sleep_mutex);
+            s_running = false;
+        }
+        s_wake_cv.notify_all();
+        for (std::thread& thread : s_threads) {
+            thread.join();
+        }
+        s_threads.clear();
+
+        // Jobs the last running ones queued or released on their way out
+        while (s_queued.load(std::memory_order_seq_cst) > 0 && try_run_one()) {}
+
+        // Only jobs whose dependency can no longer be satisfied are left
+        if (!s_parked.empty()) {
+            SPA_LOG_WARN("Job system shut down with {} jobs still waiting on a dependency.", s_parked.size());
+        }
+        for (void* item : s_parked) {
+            release_job(static_cast<Job*>(item));
+        }
+        s_parked.clear();
+        s_parked_count = 0;
+
+        s_queues.clear();
+        s_injection.clear();
+        s_queued = 0;
+        s_rings.clear();
+        t_worker_index = UINT32_MAX;
+    }
+
+    bool JobSystem::is_initialized() { return s_running.load(std::memory_order_relaxed); }
+    u32 JobSystem::get_worker_count() { return static_cast<u32>(std::max<size_t>(1, s_queues.size())); }
+    u32 JobSystem::get_worker_index() { return t_worker_index; }
+
+    JobSystem::Job* JobSystem::allocate_job() {
+        // Before init() jobs run inline, so there is no ring to take them from
+        if (s_rings.empty()) return new Job();
+
+        const u32 worker = t_worker_index;
+        const bool shared = worker >= s_queues.size();
+        JobRing& ring = *s_rings[shared ? s_queues.size() : worker];
+        std::unique_lock<std::mutex> lock(s_shared_ring_mutex, std::defer_lock);
+        if (shared) lock.lock();
+
+        // Slots free up roughly in submission order, so if the oldest one is still busy the ring has
+        // MAX_JOBS_PER_THREAD jobs outstanding and the rest spill to the heap
+        const u32 index = ring.next & (MAX_JOBS_PER_THREAD - 1);
+        if (ring.busy[index].load(std::memory_order_acquire)) {
+            return new Job();
+        }
+        ring.next++;
+        ring.busy[index].store(true, std::memory_order_relaxed);
+        Job* job = new (ring.memory.get() + sizeof(Job) * index) Job();
+        job->slot = &ring.busy[index];
+        return job;
+    }
+
+    void JobSystem::release_job(Job* job) {
+        if (job->slot) {
+            job->slot->store(false, std::memory_order_release);
+        } else {
+            delete job;
+        }
+    }
+
+    void JobSystem::submit(Job* job) {
+        if (!is_initialized()) {
+            execute(job);
+            return;
+        }
+
+        // Count before publishing so a thief never sees the job before the counter does. This store and
+        // the s_sleeping load below pair with the reverse order in worker_loop; only seq_cst keeps one of
+        // the two sides from missing the other (a worker asleep with a job queued and no notify).
+        s_queued.fetch_add(1, std::memory_order_seq_cst);
+
+        const u32 index = t_worker_index;
+        if (index == UINT32_MAX || !s_queues[index]->push(job)) {
+            std::lock_guard<std::mutex> lock(s_injection_mutex);
+            s_injection.push_back(job);
+        }
+
+        if (s_sleeping.load(std::memory_order_seq_cst) > 0) {
+            // Taking the lock orders this wake-up after a sleeper's predicate check
+            { std::lock_guard<std::mutex> lock(s_sleep_mutex); }
+            s_wake_cv.notify_one();
+        }
+    }
+
+    void JobSystem::execute(Job* job) {
+        job->invoke(*job);
+        // The slot may be reused the moment it is released, so read the counter first
+        JobCounter* counter = job->counter;
+        release_job(job);
+        if (counter && counter->value.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+            s_parked_count.load(std::memory_order_seq_cst) > 0) {
+            release_parked();
+        }
+    }
+
+    void JobSystem::release_parked() {
+        u32 released = 0;
+        {
+            std::lock_guard<std::mutex> lock(s_parked_mutex);
+            for (size_t i = 0; i < s_parked.size();) {
+                Job* job = static_cast<Job*>(s_parked[i]);
+                if (!job->dependency->is_done()) {
+                    ++i;
+                    continue;
+                }
+                s_parked[i] = s_parked.back();
+                s_parked.pop_back();
+                s_queued.fetch_add(1, std::memory_order_seq_cst);
+                {
+                    std::lock_guard<std::mutex> injection_lock(s_injection_mutex);
+                    s_injection.push_back(job);
+                }
+                ++released;
+            }
+            s_parked_count.store(static_cast<u32>(s_parked.size()), std::memory_order_seq_cst);
+        }
+
+        if (released > 0 && s_sleeping.load(std::memory_order_seq_cst) > 0) {
+            { std::lock_guard<std::mutex> lock(s_sleep_mutex); }
+            s_wake_cv.notify_all();
+        }
+    }
+
+    bool JobSystem::try_run_one() {
+        void* item = nullptr;
+        const u32 index = t_worker_index;
+
+        if (index != UINT32_MAX && index < s_queues.size()) {
+            item = s_queues[index]->pop();
+        }
+
+        if (!item) {
+            std::lock_guard<std::mutex> lock(s_injection_mutex);
+            if (!s_injection.empty()) {
+                item = s_injection.front();
+                s_injection.pop_front();
+            }
+        }
+
+        // Steal round-robin, starting somewhere different each time to spread contention
+        const u32 count = static_cast<u32>(s_queues.size());
+        for (u32 i = 0; !item && i < count; ++i) {
+            const u32 victim = (t_steal_cursor++) % count;
+            if (victim != index) item = s_queues[victim]->steal();
+        }
+
+        if (!item) return false;
+        s_queued.fetch_sub(1, std::memory_order_relaxed);
+
+        Job* job = static_cast<Job*>(item);
+        if (job->dependency && !job->dependency->is_done()) {
+            // Not runnable yet: park it until the dependency's last job finishes. Publishing the count and then
+            // re-checking pairs with the reverse order in execute(), so one side always sees the other.
+            const JobCounter* dependency = job->dependency;
+            {
+                std::lock_guard<std::mutex> lock(s_parked_mutex);
+                s_parked.push_back(job);
+                s_parked_count.store(static_cast<u32>(s_parked.size()), std::memory_order_seq_cst);
+            }
+            if (dependency->value.load(std::memory_order_seq_cst) == 0) {
+                release_parked();
+            }
+            return false;
+        }
+
+        execute(job);
+        return true;
+    }
+
+    void JobSystem::wait(const JobCounter& counter) {
+        while (!counter.is_done()) {
+            if (!try_run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::worker_loop(u32 worker_index) {
+        t_worker_index = worker_index;
+        t_steal_cursor = worker_index;
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "Job worker %u", worker_index);
+        Profiler::set_thread_name(name);
+
+        constexpr u32 SPIN_COUNT = 64;
+        u32 idle = 0;
+
+        while (s_running.load(std::memory_order_relaxed)) {
+            if (try_run_one()) {
+                idle = 0;
+                continue;
+            }
+
+            if (++idle < SPIN_COUNT) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(s_sleep_mutex);
+            s_sleeping.fetch_add(1, std::memory_order_seq_cst);
+            s_wake_cv.wait(lock, [] {
+                return !s_running.load(std::memory_order_relaxed) || s_queued.load(std::memory_order_seq_cst) > 0;
+            });
+            s_sleeping.fetch_sub(1, std::memory_order_acq_rel);
+            idle = 0;
+        }
+    }
+}
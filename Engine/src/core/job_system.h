@@ -0,0 +1,116 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Sparkle {
+    // Counts outstanding jobs; reaches zero once every job attached to it has finished
+    struct JobCounter {
+        std::atomic<u32> value{0};
+
+        bool is_done() const { return value.load(std::memory_order_acquire) == 0; }
+    };
+
+    // Fixed pool of worker threads, each with its own work-stealing deque.
+    // The thread that calls init() becomes worker 0 and runs jobs while it waits.
+    class JobSystem {
+    public:
+        static constexpr u32 JOB_STORAGE_SIZE = 48;
+        static constexpr u32 MAX_JOBS_PER_THREAD = 4096; // Pooled job slots per thread; more outstanding go to the heap
+        static constexpr u32 MAX_CHUNKS_PER_WORKER = 16;  // parallel_for never splits into more jobs than this per worker
+
+        // worker_count includes the calling thread; 0 picks one per hardware thread
+        static bool init(u32 worker_count = 0);
+        static void shutdown();
+
+        static bool is_initialized();
+        static u32 get_worker_count();
+        // Index of the calling worker, UINT32_MAX on threads the job system does not own
+        static u32 get_worker_index();
+
+        // Queue fn to run on any worker. counter (if any) is incremented now and decremented when fn
+        // returns; the job is held back until dependency (if any) reaches zero. A dependency must be
+        // counted down by jobs, since parked jobs are released when a job brings a counter to zero.
+        template<typename F>
+        static void run(F&& fn, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr);
+
+        // Run other jobs until counter reaches zero
+        static void wait(const JobCounter& counter);
+
+        // Call fn(begin, end) over [0, count) in chunks of grain (0 picks a grain from the worker count)
+        // and return once all chunks are done. grain is raised if it would need more than
+        // MAX_CHUNKS_PER_WORKER chunks per worker.
+        template<typename F>
+        static void parallel_for(u32 count, u32 grain, F&& fn);
+
+    private:
+        struct Job {
+            void (*invoke)(Job& job) = nullptr;
+            JobCounter* counter = nullptr;
+            const JobCounter* dependency = nullptr;
+            std::atomic<bool>* slot = nullptr; // Ring slot released once the job is done; null for heap jobs
+            alignas(16) u8 storage[JOB_STORAGE_SIZE];
+        };
+
+        static Job* allocate_job();
+        static void release_job(Job* job);
+        static void submit(Job* job);
+        static void execute(Job* job);
+        // Move parked jobs whose dependency is done back to the queue
+        static void release_parked();
+        static bool try_run_one();
+        static void worker_loop(u32 worker_index);
+    };
+
+    template<typename F>
+    void JobSystem::run(F&& fn, JobCounter* counter, const JobCounter* dependency) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= JOB_STORAGE_SIZE, "Job captures too large; capture by reference or pointer");
+        static_assert(alignof(Fn) <= 16, "Job captures over-aligned");
+
+        Job* job = allocate_job();
+        new (job->storage) Fn(std::forward<F>(fn));
+        job->invoke = [](Job& j) {
+            Fn* f = std::launder(reinterpret_cast<Fn*>(j.storage));
+            (*f)();
+            f->~Fn();
+        };
+        job->counter = counter;
+        job->dependency = dependency;
+
+        if (counter) counter->value.fetch_add(1, std::memory_order_relaxed);
+        submit(job);
+    }
+
+    template<typename F>
+    void JobSystem::parallel_for(u32 count, u32 grain, F&& fn) {
+        if (count == 0) return;
+        if (grain == 0) {
+            // A few chunks per worker leaves room for stealing to even out the load
+            const u32 chunks = get_worker_count() * 4;
+            grain = (count + chunks - 1) / chunks;
+        }
+        const u32 max_chunks = get_worker_count() * MAX_CHUNKS_PER_WORKER;
+        if ((count + grain - 1) / grain > max_chunks) {
+            grain = (count + max_chunks - 1) / max_chunks;
+        }
+        if (grain >= count || !is_initialized()) {
+            fn(0u, count);
+            return;
+        }
+
+        JobCounter counter;
+        auto* body = &fn;
+        for (u32 begin = 0; begin < count; begin += grain) {
+            const u32 end = begin + grain < count ? begin + grain : count;
+            run([body, begin, end] { (*body)(begin, end); }, &counter);
+        }
+        wait(counter);
+    }
+}
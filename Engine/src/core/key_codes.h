@@ -77,4 +77,34 @@ namespace Sparkle {
         MIDDLE = SDL_BUTTON_MIDDLE,
         RIGHT = SDL_BUTTON_RIGHT
     };
+
+
+    // Positional names: SOUTH is A on Xbox, Cross on PlayStation
+    enum class GamepadButton {
+        SOUTH = SDL_GAMEPAD_BUTTON_SOUTH,
+        EAST = SDL_GAMEPAD_BUTTON_EAST,
+        WEST = SDL_GAMEPAD_BUTTON_WEST,
+        NORTH = SDL_GAMEPAD_BUTTON_NORTH,
+        BACK = SDL_GAMEPAD_BUTTON_BACK,
+        GUIDE = SDL_GAMEPAD_BUTTON_GUIDE,
+        START = SDL_GAMEPAD_BUTTON_START,
+        LEFT_STICK = SDL_GAMEPAD_BUTTON_LEFT_STICK,
+        RIGHT_STICK = SDL_GAMEPAD_BUTTON_RIGHT_STICK,
+        LEFT_SHOULDER = SDL_GAMEPAD_BUTTON_LEFT_SHOULDER,
+        RIGHT_SHOULDER = SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER,
+        DPAD_UP = SDL_GAMEPAD_BUTTON_DPAD_UP,
+        DPAD_DOWN = SDL_GAMEPAD_BUTTON_DPAD_DOWN,
+        DPAD_LEFT = SDL_GAMEPAD_BUTTON_DPAD_LEFT,
+        DPAD_RIGHT = SDL_GAMEPAD_BUTTON_DPAD_RIGHT
+    };
+
+    // Sticks are -1..1 (Y points down), triggers 0..1
+    enum class GamepadAxis {
+        LEFT_X = SDL_GAMEPAD_AXIS_LEFTX,
+        LEFT_Y = SDL_GAMEPAD_AXIS_LEFTY,
+        RIGHT_X = SDL_GAMEPAD_AXIS_RIGHTX,
+        RIGHT_Y = SDL_GAMEPAD_AXIS_RIGHTY,
+        LEFT_TRIGGER = SDL_GAMEPAD_AXIS_LEFT_TRIGGER,
+        RIGHT_TRIGGER = SDL_GAMEPAD_AXIS_RIGHT_TRIGGER
+    };
 }
@@ -5,11 +5,135 @@
 #include "logger.h"
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 
 namespace Sparkle {
     static std::shared_ptr<spdlog::logger> s_logger;
 
+    std::atomic<bool> Logger::s_async = false;
+
+    namespace {
+        // Bounded MPMC queue (Vyukov): producers and the writer only contend on their own index,
+        // and every slot carries a sequence number that says whose turn it is
+        class LogQueue {
+        public:
+            void create(u32 capacity) {
+                u32 size = 1;
+                while (size < capacity) size <<= 1;
+                m_slots = std::make_unique<Slot[]>(size);
+                for (u32 i = 0; i < size; ++i) {
+                    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+                }
+                m_mask = size - 1;
+                m_enqueue_pos.store(0, std::memory_order_relaxed);
+                m_dequeue_pos.store(0, std::memory_order_relaxed);
+            }
+
+            bool try_push(const LogRecord& record) {
+                u64 pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                while (true) {
+                    Slot& slot = m_slots[pos & m_mask];
+                    const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+                    const i64 diff = static_cast<i64>(sequence) - static_cast<i64>(pos);
+                    if (diff == 0) {
+                        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            std::memcpy(&slot.record, &record, sizeof(LogRecord));
+                            slot.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (diff < 0) {
+                        return false; // Full
+                    } else {
+                        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool try_pop(LogRecord& out) {
+                u64 pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                while (true) {
+                    Slot& slot = m_slots[pos & m_mask];
+                    const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+                    const i64 diff = static_cast<i64>(sequence) - static_cast<i64>(pos + 1);
+                    if (diff == 0) {
+                        if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            std::memcpy(&out, &slot.record, sizeof(LogRecord));
+                            slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (diff < 0) {
+                        return false; // Empty
+                    } else {
+                        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+        private:
+            struct Slot {
+                std::atomic<u64> sequence;
+                LogRecord record;
+            };
+
+            std::unique_ptr<Slot[]> m_slots;
+            u64 m_mask = 0;
+            alignas(64) std::atomic<u64> m_enqueue_pos = 0;
+            alignas(64) std::atomic<u64> m_dequeue_pos = 0;
+        };
+    }
+
+    static LogQueue s_queue;
+    static LogOverflowPolicy s_overflow = LogOverflowPolicy::Drop;
+    static std::thread s_writer;
+    static std::atomic<bool> s_writer_running = false;
+    static std::atomic<u64> s_enqueued = 0;
+    static std::atomic<u64> s_written = 0; // Written or discarded by Overwrite
+    static std::atomic<u64> s_dropped = 0;
+    static std::atomic<u64> s_long = 0;
+    static std::atomic<u32> s_producers = 0; // Threads inside enqueue() that saw the writer running
+    static std::mutex s_wake_mutex;
+    static std::condition_variable s_wake_cv;
+
+    static void write_record(const LogRecord& record) {
+        spdlog::memory_buf_t text;
+        spdlog::string_view_t message;
+        if (record.format) {
+            record.format(record, text);
+            message = spdlog::string_view_t(text.data(), text.size());
+        } else {
+            message = spdlog::string_view_t(record.long_text ? record.long_text : record.storage, record.text_size);
+        }
+        s_logger->log(record.time, spdlog::source_loc{}, record.level, message);
+    }
+
+    static void release_record(const LogRecord& record) {
+        delete[] record.long_text;
+    }
+
+    static bool write_next() {
+        LogRecord record;
+        if (!s_queue.try_pop(record)) return false;
+        write_record(record);
+        release_record(record);
+        s_written.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    static void writer_loop() {
+        while (true) {
+            if (write_next()) continue;
+
+            if (!s_writer_running.load(std::memory_order_acquire)) break;
+
+            // Producers never signal, so logging stays free of syscalls; poll at a rate the console can't notice
+            std::unique_lock<std::mutex> lock(s_wake_mutex);
+            s_wake_cv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
     bool Logger::init() {
         s_logger = spdlog::stdout_color_mt("sparkle");
         s_logger->set_pattern("[%l] %v");
@@ -18,14 +142,124 @@ namespace Sparkle {
     }
 
     void Logger::shutdown() {
+        configure(LogConfig{});
         spdlog::shutdown();
     }
     std::shared_ptr<spdlog::logger> &Logger::get_logger() {
         return s_logger;
     }
 
+    void Logger::configure(const LogConfig& config) {
+        if (is_async()) {
+            // Drain and stop the writer before touching the queue
+            s_async.store(false, std::memory_order_release);
+            flush();
+            // Pairs with enqueue(): a producer either sees the writer stopped or is waited for here
+            s_writer_running.store(false, std::memory_order_seq_cst);
+            while (s_producers.load(std::memory_order_seq_cst) != 0) {
+                s_wake_cv.notify_one();
+                std::this_thread::yield();
+            }
+            s_wake_cv.notify_all();
+            s_writer.join();
+            // Records pushed after the writer's last look at the queue
+            while (write_next()) {}
+
+            const u64 dropped = s_dropped.load(std::memory_order_relaxed);
+            if (dropped > 0 && s_logger) {
+                s_logger->warn("Async log queue dropped {} messages.", dropped);
+            }
+        }
+
+        if (!config.async) return;
+
+        s_queue.create(std::max(config.queue_capacity, 2u));
+        s_overflow = config.overflow;
+        s_enqueued = 0;
+        s_written = 0;
+        s_dropped = 0;
+        s_long = 0;
+        s_writer_running.store(true, std::memory_order_release);
+        s_writer = std::thread(writer_loop);
+        s_async.store(true, std::memory_order_release);
+    }
+
+    u64 Logger::get_dropped_count() {
+        return s_dropped.load(std::memory_order_relaxed);
+    }
+
+    u64 Logger::get_long_count() {
+        return s_long.load(std::memory_order_relaxed);
+    }
+
+    void Logger::set_text(LogRecord& record, const char* text, size_t size) {
+        record.text_size = static_cast<u32>(std::min<size_t>(size, UINT32_MAX));
+        if (record.text_size <= LogRecord::STORAGE_SIZE) {
+            std::memcpy(record.storage, text, record.text_size);
+            return;
+        }
+        // Rare enough (validation messages, long paths) that a heap copy beats wider queue slots
+        record.long_text = new char[record.text_size];
+        std::memcpy(record.long_text, text, record.text_size);
+        s_long.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Logger::flush() {
+        if (s_writer_running.load(std::memory_order_acquire)) {
+            const u64 target = s_enqueued.load(std::memory_order_acquire);
+            s_wake_cv.notify_one();
+            while (s_written.load(std::memory_order_acquire) < target) {
+                std::this_thread::yield();
+            }
+        }
+        if (s_logger) s_logger->flush();
+    }
+
+    void Logger::enqueue(const LogRecord& record) {
+        // configure() waits for every registered producer before it drains the queue for the last time
+        s_producers.fetch_add(1, std::memory_order_seq_cst);
+        if (!s_writer_running.load(std::memory_order_seq_cst)) {
+            s_producers.fetch_sub(1, std::memory_order_release);
+            write_record(record);
+            release_record(record);
+            return;
+        }
+
+        while (!s_queue.try_push(record)) {
+            switch (s_overflow) {
+                case LogOverflowPolicy::Drop:
+                    release_record(record);
+                    s_dropped.fetch_add(1, std::memory_order_relaxed);
+                    s_producers.fetch_sub(1, std::memory_order_release);
+                    return;
+                case LogOverflowPolicy::Overwrite: {
+                    // Make room by discarding the oldest record; it still counts as handled for flush()
+                    LogRecord oldest;
+                    if (s_queue.try_pop(oldest)) {
+                        release_record(oldest);
+                        s_dropped.fetch_add(1, std::memory_order_relaxed);
+                        s_written.fetch_add(1, std::memory_order_release);
+                    }
+                    break;
+                }
+                case LogOverflowPolicy::Block:
+                    // The writer may already be stopping; make room here so configure() is not kept waiting
+                    if (!s_writer_running.load(std::memory_order_acquire)) {
+                        write_next();
+                        break;
+                    }
+                    s_wake_cv.notify_one();
+                    std::this_thread::yield();
+                    break;
+            }
+        }
+        s_enqueued.fetch_add(1, std::memory_order_release);
+        s_producers.fetch_sub(1, std::memory_order_release);
+    }
+
     void report_assertion_failure(const char* expression, const char* message, const char* file, int32_t line) {
         if (auto logger = Logger::get_logger()) {
+            Logger::flush();
             logger->critical("Assertion Failure: {}: '{}' [file: {}, line: {}]", expression, message, file, line);
         }
     }
@@ -5,7 +5,11 @@
 #pragma once
 
 #include "defines.h"
+#include "engine_config.h"
 #include "spdlog/spdlog.h"
+#include <atomic>
+#include <cstring>
+#include <type_traits>
 
 #define SPA_LOG_ENABLE_WARN 1
 #define SPA_LOG_ENABLE_INFO 1
@@ -19,39 +23,150 @@
 
 
 namespace Sparkle {
+        // One queued log message. Arithmetic-only argument lists are stored raw and formatted on the
+        // writer thread; anything else (strings may not outlive the call) is formatted up front.
+        // Preformatted text longer than the storage goes to the heap and is owned by the record.
+        struct LogRecord {
+            static constexpr u32 STORAGE_SIZE = 200;
+            using FormatFn = void (*)(const LogRecord& record, spdlog::memory_buf_t& out);
+
+            spdlog::log_clock::time_point time;
+            FormatFn format = nullptr;    // Set for deferred records; storage then holds the arguments
+            spdlog::string_view_t fmt;    // Format string literal of a deferred record
+            char* long_text = nullptr;    // Preformatted text over STORAGE_SIZE; freed by whoever consumes the record
+            u32 text_size = 0;            // Bytes of preformatted text, in storage or long_text
+            spdlog::level::level_enum level = spdlog::level::info;
+            alignas(8) char storage[STORAGE_SIZE];
+        };
+
+        // Trivially copyable argument pack, so a record can be copied into the queue as raw bytes
+        template<typename... Ts>
+        struct LogArgs {
+            template<typename F>
+            void apply(F&& fn) const { fn(); }
+        };
+
+        template<typename T, typename... Ts>
+        struct LogArgs<T, Ts...> {
+            T value;
+            LogArgs<Ts...> rest;
+
+            template<typename F>
+            void apply(F&& fn) const {
+                rest.apply([&](const auto&... tail) { fn(value, tail...); });
+            }
+        };
+
+        template<typename... Ts>
+        LogArgs<std::decay_t<Ts>...> make_log_args(Ts&&... values) {
+            if constexpr (sizeof...(Ts) == 0) {
+                return {};
+            } else {
+                return [](auto&& first, auto&&... rest) -> LogArgs<std::decay_t<Ts>...> {
+                    return {first, make_log_args(rest...)};
+                }(values...);
+            }
+        }
+
+        template<typename... Args>
+        constexpr bool log_args_deferrable = ((std::is_arithmetic_v<std::decay_t<Args>>) && ...) &&
+                                             sizeof(LogArgs<std::decay_t<Args>...>) <= LogRecord::STORAGE_SIZE &&
+                                             alignof(LogArgs<std::decay_t<Args>...>) <= 8;
+
         class Logger {
         public:
             static bool init();
             static void shutdown();
             static std::shared_ptr<spdlog::logger>& get_logger();
 
+            // Switch between synchronous logging and the async queue. Leaving async mode drains the queue.
+            static void configure(const LogConfig& config);
+            static bool is_async() { return s_async.load(std::memory_order_acquire); }
+            // Messages lost to LogOverflowPolicy::Drop / Overwrite since the async queue started
+            static u64 get_dropped_count();
+            // Messages too long for a queue slot that took a heap allocation, since the async queue started
+            static u64 get_long_count();
+            // Block until every queued message has been written
+            static void flush();
+
+            template<typename... Args>
+            static void log(spdlog::level::level_enum level, spdlog::format_string_t<Args...> fmt, Args&&... args);
+
+        private:
+            static void set_text(LogRecord& record, const char* text, size_t size);
+            static void enqueue(const LogRecord& record);
+
+            static std::atomic<bool> s_async;
         };
 
+        template<typename... Args>
+        void Logger::log(spdlog::level::level_enum level, spdlog::format_string_t<Args...> fmt, Args&&... args) {
+            std::shared_ptr<spdlog::logger>& logger = get_logger();
+            if (!logger || !logger->should_log(level)) return;
+
+            if (!is_async() || level >= spdlog::level::critical) {
+                // Fatal messages go out immediately, after everything queued before them
+                if (is_async()) flush();
+                logger->log(level, fmt, std::forward<Args>(args)...);
+                return;
+            }
+
+#ifdef SPDLOG_USE_STD_FORMAT
+            const spdlog::string_view_t view = fmt.get();
+#else
+            const spdlog::string_view_t view = fmt;
+#endif
+
+            LogRecord record;
+            record.time = spdlog::log_clock::now();
+            record.level = level;
+
+            if constexpr (log_args_deferrable<Args...>) {
+                using Stored = LogArgs<std::decay_t<Args>...>;
+                const Stored stored = make_log_args(args...);
+                std::memcpy(record.storage, &stored, sizeof(Stored));
+                record.fmt = view;
+                record.format = [](const LogRecord& r, spdlog::memory_buf_t& out) {
+                    Stored values;
+                    std::memcpy(&values, r.storage, sizeof(Stored));
+                    values.apply([&](const auto&... a) {
+                        spdlog::fmt_lib::vformat_to(std::back_inserter(out), r.fmt, spdlog::fmt_lib::make_format_args(a...));
+                    });
+                };
+            } else {
+                spdlog::memory_buf_t text;
+                spdlog::fmt_lib::vformat_to(std::back_inserter(text), view, spdlog::fmt_lib::make_format_args(args...));
+                set_text(record, text.data(), text.size());
+            }
+
+            enqueue(record);
+        }
+
 }
 
-#define SPA_LOG_FATAL(...) ::Sparkle::Logger::get_logger()->critical(__VA_ARGS__)
-#define SPA_LOG_ERROR(...) ::Sparkle::Logger::get_logger()->error(__VA_ARGS__)
+#define SPA_LOG_FATAL(...) ::Sparkle::Logger::log(spdlog::level::critical, __VA_ARGS__)
+#define SPA_LOG_ERROR(...) ::Sparkle::Logger::log(spdlog::level::err, __VA_ARGS__)
 
 #if SPA_LOG_ENABLE_WARN == 1
-#define SPA_LOG_WARN(...)  ::Sparkle::Logger::get_logger()->warn(__VA_ARGS__)
+#define SPA_LOG_WARN(...)  ::Sparkle::Logger::log(spdlog::level::warn, __VA_ARGS__)
 #else
 #define SPA_LOG_WARN(...)
 #endif
 
 #if SPA_LOG_ENABLE_INFO == 1
-#define SPA_LOG_INFO(...)  ::Sparkle::Logger::get_logger()->info(__VA_ARGS__)
+#define SPA_LOG_INFO(...)  ::Sparkle::Logger::log(spdlog::level::info, __VA_ARGS__)
 #else
 #define SPA_LOG_INFO(...)
 #endif
 
 #if SPA_LOG_ENABLE_DEBUG == 1
-#define SPA_LOG_DEBUG(...) ::Sparkle::Logger::get_logger()->debug(__VA_ARGS__)
+#define SPA_LOG_DEBUG(...) ::Sparkle::Logger::log(spdlog::level::debug, __VA_ARGS__)
 #else
 #define SPA_LOG_DEBUG(...)
 #endif
 
 #if SPA_LOG_ENABLE_TRACE == 1
-#define SPA_LOG_TRACE(...) ::Sparkle::Logger::get_logger()->trace(__VA_ARGS__)
+#define SPA_LOG_TRACE(...) ::Sparkle::Logger::log(spdlog::level::trace, __VA_ARGS__)
 #else
 #define SPA_LOG_TRACE(...)
 #endif
\ No newline at end of file
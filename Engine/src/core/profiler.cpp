@@ -0,0 +1,158 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "profiler.h"
+#include "logger.h"
+#include <cstdio>
+#include <mutex>
+
+namespace Sparkle {
+    // Oldest events of a wrapped ring are skipped on export; zones that were already open when
+    // recording stopped may still land there while the exporter reads
+    static constexpr u64 EXPORT_SLACK = 256;
+
+    namespace {
+        // Written by its own thread only; head is published after the event so the exporter sees it whole
+        struct ThreadBuffer {
+            std::unique_ptr<ProfileEvent[]> events;
+            u64 mask = 0;
+            std::atomic<u64> head = 0;
+            u32 index = 0;
+            char name[32] = {};
+        };
+    }
+
+    std::atomic<bool> Profiler::s_enabled = false;
+
+    static std::mutex s_registry_mutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+    static u32 s_capacity = 0;
+    static std::atomic<u32> s_generation = 0; // Bumped by shutdown so stale thread pointers are dropped
+
+    static thread_local ThreadBuffer* t_buffer = nullptr;
+    static thread_local u32 t_generation = 0;
+    static thread_local char t_name[32] = {};
+
+    static ThreadBuffer* get_thread_buffer() {
+        const u32 generation = s_generation.load(std::memory_order_acquire);
+        if (t_buffer && t_generation == generation) return t_buffer;
+
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        if (s_capacity == 0) return nullptr;
+
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->events = std::make_unique<ProfileEvent[]>(s_capacity);
+        buffer->mask = s_capacity - 1;
+        buffer->index = static_cast<u32>(s_buffers.size());
+        if (t_name[0] != '\0') {
+            std::snprintf(buffer->name, sizeof(buffer->name), "%s", t_name);
+        } else {
+            std::snprintf(buffer->name, sizeof(buffer->name), "Thread %u", buffer->index);
+        }
+
+        t_buffer = buffer.get();
+        t_generation = generation;
+        s_buffers.push_back(std::move(buffer));
+        return t_buffer;
+    }
+
+    bool Profiler::init(u32 events_per_thread) {
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        u32 capacity = 1;
+        while (capacity < std::max(events_per_thread, static_cast<u32>(EXPORT_SLACK * 2))) capacity <<= 1;
+        s_capacity = capacity;
+        return true;
+    }
+
+    void Profiler::shutdown() {
+        set_enabled(false);
+
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        s_buffers.clear();
+        s_capacity = 0;
+        s_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    void Profiler::set_thread_name(const char* name) {
+        std::snprintf(t_name, sizeof(t_name), "%s", name);
+
+        std::lock_guard<std::mutex> lock(s_registry_mutex);
+        if (t_buffer && t_generation == s_generation.load(std::memory_order_relaxed)) {
+            std::snprintf(t_buffer->name, sizeof(t_buffer->name), "%s", name);
+        }
+    }
+
+    void Profiler::record(const char* name, u64 start_ns, u64 end_ns, u32 track) {
+        ThreadBuffer* buffer = get_thread_buffer();
+        if (!buffer) return;
+
+        const u64 head = buffer->head.load(std::memory_order_relaxed);
+        ProfileEvent& event = buffer->events[head & buffer->mask];
+        event.name = name;
+        event.start_ns = start_ns;
+        event.end_ns = end_ns;
+        event.track = track;
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    static void write_json_string(FILE* file, const char* text) {
+        std::fputc('"', file);
+        for (const char* c = text ? text : "?"; *c; ++c) {
+            if (*c == '"' || *c == '\\') std::fputc('\\', file);
+            if (static_cast<u8>(*c) >= 0x20) std::fputc(*c, file);
+        }
+        std::fputc('"', file);
+    }
+
+    bool Profiler::write_chrome_trace(const char* path) {
+        const bool was_enabled = is_enabled();
+        set_enabled(false);
+
+        FILE* file = std::fopen(path, "wb");
+        if (!file) {
+            SPA_LOG_ERROR("Failed to open profile trace '{}' for writing.", path);
+            set_enabled(was_enabled);
+            return false;
+        }
+
+        // Threads get tids after the virtual tracks so the GPU row sorts first
+        constexpr u32 FIRST_THREAD_TID = GPU_TRACK + 1;
+        u64 event_count = 0;
+
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}", GPU_TRACK);
+
+        {
+            std::lock_guard<std::mutex> lock(s_registry_mutex);
+            for (const std::unique_ptr<ThreadBuffer>& buffer : s_buffers) {
+                const u32 tid = FIRST_THREAD_TID + buffer->index;
+                std::fprintf(file, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", tid);
+                write_json_string(file, buffer->name);
+                std::fprintf(file, "}}");
+
+                const u64 head = buffer->head.load(std::memory_order_acquire);
+                const u64 capacity = buffer->mask + 1;
+                const u64 first = head > capacity ? head - capacity + EXPORT_SLACK : 0;
+
+                for (u64 i = first; i < head; ++i) {
+                    const ProfileEvent& event = buffer->events[i & buffer->mask];
+                    std::fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                                 event.track != 0 ? event.track : tid,
+                                 static_cast<f64>(event.start_ns) / 1000.0,
+                                 static_cast<f64>(event.end_ns - event.start_ns) / 1000.0);
+                    write_json_string(file, event.name);
+                    std::fputc('}', file);
+                }
+                event_count += head - first;
+            }
+        }
+
+        std::fprintf(file, "\n]}\n");
+        const bool ok = std::fclose(file) == 0;
+
+        SPA_LOG_INFO("Wrote {} profile events to '{}'.", event_count, path);
+        set_enabled(was_enabled);
+        return ok;
+    }
+}
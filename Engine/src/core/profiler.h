@@ -0,0 +1,78 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include <atomic>
+#include <chrono>
+
+namespace Sparkle {
+    // One finished zone. name must outlive the capture (string literals).
+    struct ProfileEvent {
+        const char* name = nullptr;
+        u64 start_ns = 0;
+        u64 end_ns = 0;
+        u32 track = 0; // 0: the recording thread, otherwise a virtual track such as GPU_TRACK
+    };
+
+    // Scoped CPU zones and resolved GPU timestamps, kept in one ring buffer per thread so recording
+    // is a couple of stores with no locks. Each ring keeps the newest events once it wraps, so a
+    // capture written at any point holds the last stretch of frames. Exported as Chrome trace JSON
+    // (chrome://tracing, https://ui.perfetto.dev).
+    class Profiler {
+    public:
+        static constexpr u32 GPU_TRACK = 1;
+
+        static bool init(u32 events_per_thread = 1 << 16);
+        static void shutdown();
+
+        // Recording is off until enabled; a disabled zone costs one relaxed load
+        static void set_enabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+        static bool is_enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+        // Shown as the calling thread's name in the trace
+        static void set_thread_name(const char* name);
+
+        static u64 now_ns() {
+            return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        static void record(const char* name, u64 start_ns, u64 end_ns, u32 track = 0);
+
+        // Writes every thread's buffered events. Stops recording while it runs.
+        static bool write_chrome_trace(const char* path);
+
+    private:
+        static std::atomic<bool> s_enabled;
+    };
+
+    class ProfileScope {
+    public:
+        explicit ProfileScope(const char* name)
+            : m_name(name), m_start(Profiler::is_enabled() ? Profiler::now_ns() : 0) {}
+
+        ~ProfileScope() {
+            if (m_start != 0) Profiler::record(m_name, m_start, Profiler::now_ns());
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        const char* m_name;
+        u64 m_start;
+    };
+}
+
+#define SPA_PROFILE_CONCAT_INNER(a, b) a##b
+#define SPA_PROFILE_CONCAT(a, b) SPA_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef SPA_PROFILE
+#define SPA_PROFILE_SCOPE(name) ::Sparkle::ProfileScope SPA_PROFILE_CONCAT(spa_profile_scope_, __LINE__)(name)
+#define SPA_PROFILE_FUNCTION() SPA_PROFILE_SCOPE(__func__)
+#else
+#define SPA_PROFILE_SCOPE(name)
+#define SPA_PROFILE_FUNCTION()
+#endif
@@ -5,24 +5,38 @@
 #pragma once
 
 #include "core/window.h"
+#include "core/engine_config.h"
+#include "core/job_system.h"
 
 //interface for the user create a game instance
 namespace Sparkle {
     class Game {
     public:
         WindowConfig config;
+        EngineConfig engine_config;
 
         virtual ~Game() = default;
 
         // Called once to initialize rendering-related state (e.g., shaders, textures)
         virtual bool init() = 0;
 
-        // Called every frame to draw things
+        // Called every frame to draw things.
+        // With EngineConfig::pipelined_render it runs on the main thread before the frame is handed to
+        // the render thread, so it must not touch the render backend directly.
         virtual bool render() = 0;
 
-        // Called every frame to update logic
+        // Called every frame to update logic.
+        // Heavy work can be fanned out with JobSystem::parallel_for / JobSystem::run; the main thread
+        // helps run jobs while it waits, and everything must be finished before update returns.
+        // Systems added to Application::GetWorld() run right after it, in parallel where their access allows.
         virtual bool update(float delta_time) = 0;
 
+        // Called 0..EngineConfig::max_fixed_steps times per frame, before update, with a constant
+        // step when EngineConfig::fixed_update_hz is set. Input edges (key_pressed) are per frame;
+        // Input::events_between(Time::fixed_step_end_ns() - step, Time::fixed_step_end_ns()) gives
+        // the events that fall inside this step.
+        virtual bool fixed_update(float /*fixed_delta*/) { return true; }
+
         // Called when the window is resized
         virtual void on_resize(int new_width, int new_height) = 0;
     private:
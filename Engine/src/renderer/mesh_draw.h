@@ -0,0 +1,21 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include <cstddef>
+
+namespace Sparkle {
+    // One mesh drawn in the main pass. transform and color are pushed to the mesh shader as they are.
+    struct MeshDraw {
+        // Object to Vulkan clip space (y down, depth 0..1), column-major: the model-view-projection matrix
+        f32 transform[16] = {1.0f, 0.0f, 0.0f, 0.0f,
+                             0.0f, 1.0f, 0.0f, 0.0f,
+                             0.0f, 0.0f, 1.0f, 0.0f,
+                             0.0f, 0.0f, 0.0f, 1.0f};
+        u32 color = 0xffffffff; // RGBA8 tint, R in the low byte
+        u32 mesh = 0;           // Renderer::register_mesh id, 0 for none
+    };
+    static_assert(offsetof(MeshDraw, mesh) == 68, "transform and color are pushed as-is; keep them in sync with mesh.vert");
+}
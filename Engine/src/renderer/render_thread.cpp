@@ -0,0 +1,103 @@
+//
+// Created by overlord on 10/17/26.
+//
+
+#include "spa_pch.h"
+#include "render_thread.h"
+#include "renderer.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/spa_assert.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Sparkle {
+
+    bool RenderThread::s_running = false;
+
+    static RenderPacket s_packets[2];
+    static u32 s_write_index = 0;
+
+    static std::thread s_thread;
+    static std::mutex s_mutex;
+    static std::condition_variable s_cv;
+    static bool s_pending = false; // A packet was submitted and not yet picked up
+    static bool s_busy = false;    // The render thread is drawing
+    static bool s_failed = false;  // The last packet failed to draw
+    static bool s_quit = false;
+
+    void RenderThread::start() {
+        SPA_ASSERT_MSG(!s_running, "Render thread already running");
+
+        s_write_index = 0;
+        s_pending = s_busy = s_failed = s_quit = false;
+        s_running = true;
+        s_thread = std::thread(&RenderThread::thread_loop);
+        SPA_LOG_DEBUG("Render thread started.");
+    }
+
+    void RenderThread::stop() {
+        if (!s_running) return;
+
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_quit = true;
+        }
+        s_cv.notify_all();
+        s_thread.join();
+        s_running = false;
+    }
+
+    RenderPacket* RenderThread::get_write_packet() {
+        return &s_packets[s_write_index];
+    }
+
+    bool RenderThread::submit() {
+        std::unique_lock<std::mutex> lock(s_mutex);
+        s_cv.wait(lock, [] { return !s_pending && !s_busy; });
+
+        // The failure is only reported; the new packet is handed over regardless so drawing recovers
+        const bool previous_ok = !s_failed;
+        s_failed = false;
+
+        s_pending = true;
+        s_write_index ^= 1;
+        lock.unlock();
+        s_cv.notify_all();
+        return previous_ok;
+    }
+
+    void RenderThread::wait_idle() {
+        std::unique_lock<std::mutex> lock(s_mutex);
+        s_cv.wait(lock, [] { return !s_pending && !s_busy; });
+    }
+
+    void RenderThread::thread_loop() {
+        Profiler::set_thread_name("Render thread");
+
+        while (true) {
+            RenderPacket* packet = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(s_mutex);
+                s_cv.wait(lock, [] { return s_pending || s_quit; });
+                if (!s_pending) break;
+
+                // The packet that was just submitted is the one the simulation is no longer writing
+                packet = &s_packets[s_write_index ^ 1];
+                s_pending = false;
+                s_busy = true;
+            }
+
+            const bool ok = Renderer::draw_frame(packet);
+
+            {
+                std::lock_guard<std::mutex> lock(s_mutex);
+                s_busy = false;
+                s_failed = !ok;
+            }
+            s_cv.notify_all();
+        }
+    }
+
+} // namespace Sparkle
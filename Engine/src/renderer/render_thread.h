@@ -0,0 +1,39 @@
+//
+// Created by overlord on 10/17/26.
+//
+
+#pragma once
+
+#include "renderer_backend.h"
+
+namespace Sparkle {
+
+    // Runs Renderer::draw_frame on its own thread, one frame behind the simulation.
+    // The simulation fills one RenderPacket while the render thread draws the other.
+    class RenderThread {
+    public:
+        // Renderer must already be initialized; every backend call moves to the render thread
+        static void start();
+        // Finishes the frame in flight and joins the thread
+        static void stop();
+
+        static bool is_running() { return s_running; }
+
+        // Packet the simulation thread may write for the next frame
+        static RenderPacket* get_write_packet();
+
+        // Hand the write packet to the render thread and swap buffers. Blocks while the render thread
+        // is still drawing the previous packet. The packet is always handed over; returns false if the
+        // previous packet failed to draw.
+        static bool submit();
+
+        // Block until the render thread has drawn everything it was given
+        static void wait_idle();
+
+    private:
+        static void thread_loop();
+
+        static bool s_running;
+    };
+
+} // namespace Sparkle
@@ -6,10 +6,21 @@
 #include "vulkan/vulkan_backend.h"
 #include <memory>
 #include "core/logger.h"
+#include "core/frame_arena.h"
+#include "core/profiler.h"
 
 namespace Sparkle {
 
     std::unique_ptr<RenderBackend> Renderer::s_backend = nullptr;
+    std::atomic<f64> Renderer::s_latency_ms = 0.0;
+    f64 Renderer::s_latency_total_ms = 0.0;
+    f64 Renderer::s_latency_max_ms = 0.0;
+    u64 Renderer::s_latency_frames = 0;
+    std::vector<Quad> Renderer::s_quads[DRAW_LISTS];
+    std::vector<MeshDraw> Renderer::s_meshes[DRAW_LISTS];
+    u32 Renderer::s_draw_list = 0;
+    u32 Renderer::s_window_width = 0;
+    u32 Renderer::s_window_height = 0;
 
     bool Renderer::initialize() {
         s_backend = std::make_unique<VulkanBackend>();
@@ -19,14 +30,65 @@ namespace Sparkle {
             return false;
         }
 
+        // The swapchain starts at the configured size; a different pixel size rebuilds it on the first frame
+        s_window_width = static_cast<u32>(Application::GetWidth());
+        s_window_height = static_cast<u32>(Application::GetHeight());
         return true;
     }
 
     void Renderer::shutdown() {
+        if (s_latency_frames > 0) {
+            SPA_LOG_INFO("Sim-to-submit latency over {} frames: avg {:.3f} ms, max {:.3f} ms",
+                         s_latency_frames, s_latency_total_ms / static_cast<f64>(s_latency_frames), s_latency_max_ms);
+        }
+
         if (s_backend) {
             s_backend->shutdown();
             s_backend.reset();
         }
+
+        for (u32 i = 0; i < DRAW_LISTS; ++i) {
+            s_quads[i].clear();
+            s_quads[i].shrink_to_fit();
+            s_meshes[i].clear();
+            s_meshes[i].shrink_to_fit();
+        }
+        s_draw_list = 0;
+    }
+
+    u16 Renderer::register_texture(std::string_view name) {
+        const AssetHandle asset = Assets::find(name);
+        if (!asset.is_valid()) {
+            SPA_LOG_WARN("Texture '{}' is not in any mounted archive.", name);
+            return 0;
+        }
+        return s_backend->register_texture(asset);
+    }
+
+    u32 Renderer::register_mesh(std::string_view name) {
+        return s_backend->register_mesh(name);
+    }
+
+    u32 Renderer::register_mesh(const MeshVertex* vertices, u32 vertex_count, const u32* indices, u32 index_count) {
+        return s_backend->register_mesh(vertices, vertex_count, indices, index_count);
+    }
+
+    void Renderer::remove_mesh(u32 mesh) {
+        if (mesh != 0) s_backend->remove_mesh(mesh);
+    }
+
+    void Renderer::flush_quads(RenderPacket* packet) {
+        std::vector<Quad>& quads = s_quads[s_draw_list];
+        packet->quads = quads.data();
+        packet->quadCount = static_cast<u32>(quads.size());
+        std::vector<MeshDraw>& meshes = s_meshes[s_draw_list];
+        packet->meshes = meshes.data();
+        packet->meshCount = static_cast<u32>(meshes.size());
+
+        // The next lists went out two packets ago, and that packet has been drawn by now; their capacity carries over
+        s_draw_list = (s_draw_list + 1) % DRAW_LISTS;
+        s_quads[s_draw_list].clear();
+        s_meshes[s_draw_list].clear();
     }
 
     bool Renderer::begin_frame(RenderPacket* packet) {
@@ -39,7 +101,22 @@ namespace Sparkle {
     }
 
     bool Renderer::draw_frame(RenderPacket* packet) {
-        if (begin_frame(packet)) {
+        SPA_PROFILE_SCOPE("Renderer::draw_frame");
+
+        // Per-frame allocations made while drawing belong to the packet's frame
+        FrameArena::bind_thread(packet->frameNumber);
+
+        if (packet->windowWidth != 0 &&
+            (packet->windowWidth != s_window_width || packet->windowHeight != s_window_height)) {
+            s_window_width = packet->windowWidth;
+            s_window_height = packet->windowHeight;
+            s_backend->resize(s_window_width, s_window_height);
+        }
+
+        if (!begin_frame(packet)) {
+            // Nothing was submitted, so nothing will retire this frame's arena
+            FrameArena::retire(packet->frameNumber);
+        } else {
 
             bool result = end_frame(packet);
             if (!result) {
@@ -47,6 +124,14 @@ namespace Sparkle {
                 return false;
             }
         }
+
+        if (packet->simStartNs != 0) {
+            const f64 latency = static_cast<f64>(SDL_GetTicksNS() - packet->simStartNs) / 1'000'000.0;
+            s_latency_ms.store(latency, std::memory_order_relaxed);
+            s_latency_total_ms += latency;
+            s_latency_max_ms = std::max(s_latency_max_ms, latency);
+            s_latency_frames++;
+        }
         return true;
     }
 
@@ -5,7 +5,9 @@
 #pragma once
 
 #include "renderer_backend.h"
+#include <atomic>
 #include <memory>
+#include <vector>
 
 namespace Sparkle {
 
@@ -18,11 +20,49 @@ namespace Sparkle {
 
         static RenderBackend* get_backend() { return s_backend.get(); }
 
+        // Queue a quad for the next flushed packet. Simulation thread only (Game::update / Game::render).
+        static void submit_quad(const Quad& quad) { s_quads[s_draw_list].push_back(quad); }
+        static void submit_quads(const Quad* quads, u32 count) {
+            s_quads[s_draw_list].insert(s_quads[s_draw_list].end(), quads, quads + count);
+        }
+        // Queue a mesh for the main pass of the next flushed packet. Simulation thread only.
+        static void submit_mesh(const MeshDraw& draw) { s_meshes[s_draw_list].push_back(draw); }
+        // Id for Quad::texture of a cooked texture in a mounted archive; 0 (untextured) if it isn't found.
+        // Its mips stream in at the size quads draw it. Main thread.
+        static u16 register_texture(std::string_view name);
+        // Id for MeshDraw::mesh of a cooked mesh in a mounted archive, or of geometry built at runtime
+        // (copied); 0 if it isn't found or meshes can't be drawn. All meshes share one vertex and one
+        // index buffer, so drawing them never rebinds. Main thread.
+        static u32 register_mesh(std::string_view name);
+        static u32 register_mesh(const MeshVertex* vertices, u32 vertex_count, const u32* indices, u32 index_count);
+        static void remove_mesh(u32 mesh);
+
+        // Hand the quads and meshes submitted since the last flush to packet and start new lists. The lists
+        // rotate through three buffers, so a packet's draws outlive the render thread drawing it one frame behind.
+        static void flush_quads(RenderPacket* packet);
+
+        // Time from RenderPacket::simStartNs to the end of draw_frame for the last drawn frame
+        static f64 get_frame_latency_ms() { return s_latency_ms.load(std::memory_order_relaxed); }
+
     private:
         static bool begin_frame(RenderPacket* packet);
         static bool end_frame(RenderPacket* packet);
 
         static std::unique_ptr<RenderBackend> s_backend;
+
+        static constexpr u32 DRAW_LISTS = 3;
+        static std::vector<Quad> s_quads[DRAW_LISTS];
+        static std::vector<MeshDraw> s_meshes[DRAW_LISTS];
+        static u32 s_draw_list;
+
+        static std::atomic<f64> s_latency_ms;
+        static f64 s_latency_total_ms;
+        static f64 s_latency_max_ms;
+        static u64 s_latency_frames;
+
+        // Window size the backend was last resized to, on the thread that draws
+        static u32 s_window_width;
+        static u32 s_window_height;
     };
 
 } // namespace Sparkle
@@ -7,6 +7,9 @@
 #include "defines.h"
 #include <vulkan/vulkan.h>
 #include "core/application.h"
+#include "renderer/sprite_batch.h"
+#include "renderer/mesh_draw.h"
+#include "core/assets.h"
 
 
 
@@ -14,6 +17,25 @@ namespace Sparkle {
     struct RenderPacket {
         f32 deltaTime = 0.0f;
         float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        // SDL_GetTicksNS() when simulation of this frame began; 0 skips latency tracking
+        u64 simStartNs = 0;
+        // Simulation frame that produced this packet; its FrameArena slot is retired once the GPU is done
+        u64 frameNumber = 0;
+        // SDL_GetTicksNS() once input for this frame was polled; 0 skips input-to-present tracking
+        u64 inputSampleNs = 0;
+        // How far between the last two fixed updates this frame falls, [0, 1); 0 without fixed updates
+        f32 interpolationAlpha = 0.0f;
+        // Quads to draw this frame, in submission order (Renderer::flush_quads); stays valid until
+        // the packet after next is flushed
+        const Quad* quads = nullptr;
+        u32 quadCount = 0;
+        // Meshes to draw in the main pass (Renderer::flush_quads), valid as long as quads
+        const MeshDraw* meshes = nullptr;
+        u32 meshCount = 0;
+        // Window size in pixels, read on the main thread; a change resizes the swapchain before drawing.
+        // 0 in headless runs.
+        u32 windowWidth = 0;
+        u32 windowHeight = 0;
     };
 
     class RenderBackend {
@@ -29,9 +51,29 @@ namespace Sparkle {
 
         virtual void set_clear_color(const RenderPacket* packet) = 0;
 
+        // Takes effect with the next frame; call from the thread that draws
+        virtual void set_present_mode(PresentMode mode) = 0;
+        // Block until the frame slot the next begin_frame uses is free on the GPU (EngineConfig::low_latency)
+        virtual void wait_for_frame_slot() = 0;
+
+        // Stream a cooked Texture asset for quads to sample; 0 if textures can't be streamed.
+        // Call on the thread that runs Assets::update.
+        virtual u16 register_texture(AssetHandle asset) = 0;
+
+        // Id for MeshDraw::mesh; 0 if meshes can't be drawn. The data goes to the GPU over the next
+        // frames, and draws of the mesh are skipped until it has. Main thread.
+        virtual u32 register_mesh(std::string_view name) = 0;
+        virtual u32 register_mesh(const MeshVertex* vertices, u32 vertex_count, const u32* indices, u32 index_count) = 0;
+        // Draws of mesh are skipped from the next frame on; its memory is reused once no frame in
+        // flight draws it. Main thread.
+        virtual void remove_mesh(u32 mesh) = 0;
+
         uint64_t get_frame_number() const { return m_frame_number; }
         uint32_t get_current_frame() const { return m_current_frame; }
         uint32_t get_current_image_index() const { return m_current_image_index; }
+        uint32_t get_max_frames_in_flight() const { return m_max_frames_in_flight; }
+        // GPU time of the most recently completed frame, 0 if timestamps are unsupported
+        f64 get_gpu_frame_time_ms() const { return m_gpu_frame_ms; }
 
 
     protected:
@@ -39,6 +81,7 @@ namespace Sparkle {
         uint32_t m_current_frame = 0;
         uint32_t m_current_image_index = 0;
         uint64_t m_frame_number = 0;
+        f64 m_gpu_frame_ms = 0.0;
 
 
     };
@@ -0,0 +1,110 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "sprite_batch.h"
+#include "core/job_system.h"
+#include "core/profiler.h"
+#include <SDL3/SDL.h>
+
+namespace Sparkle {
+    // Quads copied per job; large enough that a job costs far more than scheduling it
+    static constexpr u32 WRITE_GRAIN = 16 * 1024;
+
+    void SpriteBatch::build(const Quad* quads, u32 count, Quad* out) {
+        SPA_PROFILE_SCOPE("SpriteBatch::build");
+        m_batches.clear();
+        m_stats = {};
+        m_stats.quads = count;
+        if (count == 0) return;
+
+        const u64 sort_start = SDL_GetTicksNS();
+        if (m_keys.size() < count) {
+            m_keys.resize(count);
+            m_scratch.resize(count);
+        }
+
+        // Most frames submit in an order that is already sorted (or close to it); skip the sort then
+        bool sorted = true;
+        u32 previous = 0;
+        for (u32 i = 0; i < count; ++i) {
+            const u32 key = quads[i].sort_key();
+            sorted &= key >= previous;
+            previous = key;
+            m_keys[i] = static_cast<u64>(key) << 32 | i;
+        }
+        const std::vector<u64>& order = sorted ? m_keys : sort(count);
+        const u64 write_start = SDL_GetTicksNS();
+
+        // Scattered reads, sequential writes: friendly to write-combined instance memory
+        const u64* entries = order.data();
+        JobSystem::parallel_for(count, WRITE_GRAIN, [quads, out, entries](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i) {
+                out[i] = quads[static_cast<u32>(entries[i])];
+            }
+        });
+
+        // Runs come from the sorted keys, never from reading the write-combined instance memory back.
+        // Layer only orders the runs; neighbouring runs with the same state still share a draw.
+        constexpr u32 STATE_MASK = 0x00ffffff; // material << 16 | texture
+        QuadBatch batch;
+        u32 state = static_cast<u32>(entries[0] >> 32) & STATE_MASK;
+        batch.texture = static_cast<u16>(state);
+        batch.material = static_cast<u8>(state >> 16);
+        for (u32 i = 1; i < count; ++i) {
+            const u32 next = static_cast<u32>(entries[i] >> 32) & STATE_MASK;
+            if (next == state) continue;
+            batch.count = i - batch.first;
+            m_batches.push_back(batch);
+            batch.first = i;
+            state = next;
+            batch.texture = static_cast<u16>(state);
+            batch.material = static_cast<u8>(state >> 16);
+        }
+        batch.count = count - batch.first;
+        m_batches.push_back(batch);
+
+        const u64 end = SDL_GetTicksNS();
+        m_stats.batches = static_cast<u32>(m_batches.size());
+        m_stats.sort_ms = static_cast<f64>(write_start - sort_start) / 1'000'000.0;
+        m_stats.write_ms = static_cast<f64>(end - write_start) / 1'000'000.0;
+    }
+
+    const std::vector<u64>& SpriteBatch::sort(u32 count) {
+        // One 8-bit digit per byte of the 32-bit key in the upper half of each entry
+        static constexpr u32 DIGITS = 4;
+        u32 histograms[DIGITS][256] = {};
+        for (u32 i = 0; i < count; ++i) {
+            const u64 entry = m_keys[i];
+            for (u32 d = 0; d < DIGITS; ++d) {
+                histograms[d][(entry >> (32 + d * 8)) & 0xff]++;
+            }
+        }
+
+        std::vector<u64>* src = &m_keys;
+        std::vector<u64>* dst = &m_scratch;
+        for (u32 d = 0; d < DIGITS; ++d) {
+            const u32 shift = 32 + d * 8;
+            u32* histogram = histograms[d];
+
+            // A digit every key shares would only copy the entries around
+            if (histogram[((*src)[0] >> shift) & 0xff] == count) continue;
+
+            u32 offset = 0;
+            for (u32 b = 0; b < 256; ++b) {
+                const u32 n = histogram[b];
+                histogram[b] = offset;
+                offset += n;
+            }
+
+            const u64* in = src->data();
+            u64* out = dst->data();
+            for (u32 i = 0; i < count; ++i) {
+                out[histogram[(in[i] >> shift) & 0xff]++] = in[i];
+            }
+            std::swap(src, dst);
+            m_stats.sort_passes++;
+        }
+        return *src;
+    }
+}
@@ -0,0 +1,65 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include <vector>
+
+namespace Sparkle {
+    // One screen-space quad, drawn as one instance. The layout is the per-instance vertex input of
+    // the sprite shader, so sorted quads are copied to the GPU as they are.
+    struct Quad {
+        f32 position[2] = {0.0f, 0.0f};          // Center in pixels, origin at the top-left
+        f32 size[2] = {1.0f, 1.0f};              // Width and height in pixels
+        f32 uv[4] = {0.0f, 0.0f, 1.0f, 1.0f};    // u0, v0, u1, v1
+        u32 color = 0xffffffff;                  // RGBA8 tint, R in the low byte
+        f32 rotation = 0.0f;                     // Radians around the center
+        u16 texture = 0;                         // Renderer::register_texture id, 0 for none
+        u8 material = 0;                         // 0: alpha blended, 1: opaque
+        u8 layer = 0;                            // Lower layers are drawn first
+
+        // Draw order: layer, then material and texture so equal state ends up adjacent
+        u32 sort_key() const {
+            return static_cast<u32>(layer) << 24 | static_cast<u32>(material) << 16 | texture;
+        }
+    };
+    static_assert(sizeof(Quad) == 44, "Quad is uploaded as-is; keep it in sync with the sprite shader");
+
+    // A run of sorted quads that share material and texture: one instanced draw
+    struct QuadBatch {
+        u32 first = 0;
+        u32 count = 0;
+        u16 texture = 0;
+        u8 material = 0;
+    };
+
+    struct SpriteBatchStats {
+        u32 quads = 0;
+        u32 batches = 0;
+        u32 sort_passes = 0; // Radix passes run; digits every key shares are skipped
+        f64 sort_ms = 0.0;
+        f64 write_ms = 0.0;  // Copying sorted quads into the instance buffer
+    };
+
+    // Sorts a frame's quads by Quad::sort_key with a stable LSD radix sort (so quads with equal keys
+    // keep their submission order) and cuts the result into the fewest batches that preserve it.
+    class SpriteBatch {
+    public:
+        // Write quads in draw order to out (which must hold count quads, typically a mapped instance
+        // buffer) and rebuild the batch list. The copy is spread over the job system.
+        void build(const Quad* quads, u32 count, Quad* out);
+
+        const std::vector<QuadBatch>& get_batches() const { return m_batches; }
+        const SpriteBatchStats& get_stats() const { return m_stats; }
+
+    private:
+        // Returns the buffer holding the sorted entries (m_keys or m_scratch)
+        const std::vector<u64>& sort(u32 count);
+
+        std::vector<u64> m_keys;    // sort_key << 32 | submission index
+        std::vector<u64> m_scratch;
+        std::vector<QuadBatch> m_batches;
+        SpriteBatchStats m_stats;
+    };
+}
@@ -8,25 +8,30 @@ VulkanCommandPool::~VulkanCommandPool() {
     // Must call cleanup manually
 }
 
-VkResult VulkanCommandPool::create(VkDevice device, uint32_t queue_family_index) {
+VkResult VulkanCommandPool::create(VkDevice device, uint32_t queue_family_index, VkCommandPoolCreateFlags flags) {
     VkCommandPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
     pool_info.queueFamilyIndex = queue_family_index;
-    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Allow command buffer reuse
+    pool_info.flags = flags;
 
     return vkCreateCommandPool(device, &pool_info, nullptr, &m_pool);
 }
 
-VkResult VulkanCommandPool::allocate_buffers(VkDevice device, uint32_t count) {
+VkResult VulkanCommandPool::allocate_buffers(VkDevice device, uint32_t count, VkCommandBufferLevel level) {
     m_command_buffers.resize(count);
 
     VkCommandBufferAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
     alloc_info.commandPool = m_pool;
-    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.level = level;
     alloc_info.commandBufferCount = count;
 
     return vkAllocateCommandBuffers(device, &alloc_info, m_command_buffers.data());
 }
 
+VkResult VulkanCommandPool::reset(VkDevice device) {
+    // Buffers stay allocated; their memory is recycled by the pool
+    return vkResetCommandPool(device, m_pool, 0);
+}
+
 void VulkanCommandPool::cleanup(VkDevice device) {
     if (!m_command_buffers.empty()) {
         vkFreeCommandBuffers(device, m_pool,
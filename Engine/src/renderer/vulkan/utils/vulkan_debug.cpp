@@ -5,17 +5,22 @@
 #include "../vulkan_utils.h"
 
 
-std::vector<const char*> load_extensions() {
+std::vector<const char*> load_extensions(bool headless) {
     //loading extentions
-    Uint32 extension_count = 0;
+    std::vector<const char*> extension_names;
 
-    // Get the extension list from SDL
-    const char * const * extensions = SDL_Vulkan_GetInstanceExtensions(&extension_count);
-    if (!extensions) {
-        SPA_LOG_ERROR("SDL_Vulkan_GetInstanceExtensions failed: {}", SDL_GetError());
-        return {};
+    // Offscreen rendering needs no surface extensions, and SDL video is not initialized
+    if (!headless) {
+        Uint32 extension_count = 0;
+
+        // Get the extension list from SDL
+        const char * const * extensions = SDL_Vulkan_GetInstanceExtensions(&extension_count);
+        if (!extensions) {
+            SPA_LOG_ERROR("SDL_Vulkan_GetInstanceExtensions failed: {}", SDL_GetError());
+            return {};
+        }
+        extension_names.assign(extensions, extensions + extension_count);
     }
-    std::vector<const char*> extension_names(extensions, extensions + extension_count);
 #ifdef SPA_DEBUG
     extension_names.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
     extension_names.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -72,16 +77,16 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
     switch (message_severity) {
         default:
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-            SPA_LOG_ERROR(callback_data->pMessage);
+            SPA_LOG_ERROR("{}", callback_data->pMessage);
             break;
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-            SPA_LOG_WARN(callback_data->pMessage);
+            SPA_LOG_WARN("{}", callback_data->pMessage);
             break;
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-            SPA_LOG_INFO(callback_data->pMessage);
+            SPA_LOG_INFO("{}", callback_data->pMessage);
             break;
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-            SPA_LOG_TRACE(callback_data->pMessage);
+            SPA_LOG_TRACE("{}", callback_data->pMessage);
             break;
     }
     return VK_FALSE;
@@ -0,0 +1,329 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+
+using namespace Sparkle;
+
+// === VulkanRangeAllocator ===
+
+void VulkanRangeAllocator::reset(VkDeviceSize capacity) {
+    m_free.clear();
+    m_capacity = capacity;
+    m_used = 0;
+    if (capacity > 0) m_free[0] = capacity;
+}
+
+VkDeviceSize VulkanRangeAllocator::allocate(VkDeviceSize size) {
+    if (size == 0) return INVALID;
+    for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+        if (it->second < size) continue;
+        const VkDeviceSize offset = it->first;
+        const VkDeviceSize remaining = it->second - size;
+        m_free.erase(it);
+        if (remaining > 0) m_free[offset + size] = remaining;
+        m_used += size;
+        return offset;
+    }
+    return INVALID;
+}
+
+void VulkanRangeAllocator::free(VkDeviceSize offset, VkDeviceSize size) {
+    // Ranges freed late, after a reset, belong to nothing anymore
+    if (size == 0 || offset + size > m_capacity) return;
+    m_used -= size;
+
+    auto next = m_free.lower_bound(offset);
+    if (next != m_free.end() && offset + size == next->first) {
+        size += next->second;
+        next = m_free.erase(next);
+    }
+    if (next != m_free.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    m_free[offset] = size;
+}
+
+VkDeviceSize VulkanRangeAllocator::get_largest_free() const {
+    VkDeviceSize largest = 0;
+    for (const auto& [offset, size] : m_free) {
+        largest = std::max(largest, size);
+    }
+    return largest;
+}
+
+// === VulkanMeshBuffers ===
+
+VulkanMeshBuffers::~VulkanMeshBuffers() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanMeshBuffers::create(VulkanDevice& device, VulkanStagingRing& staging, uint32_t vertex_capacity,
+                                   uint32_t index_capacity) {
+    if (!staging.is_created()) return VK_ERROR_INITIALIZATION_FAILED;
+    m_memory = &device.get_memory_allocator();
+    m_staging = &staging;
+
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.size = static_cast<VkDeviceSize>(vertex_capacity) * sizeof(MeshVertex);
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult res = m_memory->create_buffer(buffer_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                           m_vertex_buffer, m_vertex_allocation);
+    if (res != VK_SUCCESS) return res;
+
+    buffer_info.size = static_cast<VkDeviceSize>(index_capacity) * sizeof(uint32_t);
+    buffer_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    res = m_memory->create_buffer(buffer_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                  m_index_buffer, m_index_allocation);
+    if (res != VK_SUCCESS) return res;
+
+    m_vertices.reset(vertex_capacity);
+    m_indices.reset(index_capacity);
+    m_meshes.reserve(1024);
+    m_pending_chunks.reserve(1024);
+    m_uploaded_bytes = 0;
+    return VK_SUCCESS;
+}
+
+void VulkanMeshBuffers::cleanup(VkDevice) {
+    if (m_memory) {
+        m_memory->destroy_buffer(m_vertex_buffer, m_vertex_allocation);
+        m_memory->destroy_buffer(m_index_buffer, m_index_allocation);
+        m_memory = nullptr;
+    }
+    m_staging = nullptr;
+    m_vertices.reset(0);
+    m_indices.reset(0);
+    m_meshes.clear();
+    m_pending_chunks.clear();
+    m_free_ids.clear();
+    m_chunks.clear();
+    m_retired.clear();
+}
+
+uint32_t VulkanMeshBuffers::add(const AssetView& view) {
+    MeshHeader header;
+    if (view.type != AssetType::Mesh || view.size < sizeof(MeshHeader)) {
+        SPA_LOG_WARN("Asset is not a cooked mesh.");
+        return INVALID_MESH;
+    }
+    const u8* blob = static_cast<const u8*>(view.data);
+    std::memcpy(&header, blob, sizeof(MeshHeader));
+
+    const u64 vertex_bytes = static_cast<u64>(header.vertex_count) * sizeof(MeshVertex);
+    const u64 index_bytes = static_cast<u64>(header.index_count) * header.index_size;
+    if (header.vertex_stride != sizeof(MeshVertex) || (header.index_size != 2 && header.index_size != 4) ||
+        header.vertex_offset > view.size || vertex_bytes > view.size - header.vertex_offset ||
+        header.index_offset > view.size || index_bytes > view.size - header.index_offset) {
+        SPA_LOG_WARN("Mesh blob is corrupt or from an incompatible cooker.");
+        return INVALID_MESH;
+    }
+
+    // One index buffer bound for every mesh means one index type; 16-bit meshes are widened
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(blob + header.index_offset);
+    if (header.index_size == 2) {
+        m_widened.resize(header.index_count);
+        const u8* narrow = blob + header.index_offset;
+        for (uint32_t i = 0; i < header.index_count; ++i) {
+            u16 index;
+            std::memcpy(&index, narrow + i * sizeof(u16), sizeof(u16));
+            m_widened[i] = index;
+        }
+        indices = m_widened.data();
+    }
+
+    const uint32_t mesh = add(reinterpret_cast<const MeshVertex*>(blob + header.vertex_offset), header.vertex_count,
+                              indices, header.index_count);
+    if (mesh != INVALID_MESH) {
+        std::memcpy(m_meshes[mesh].bounds_min, header.bounds_min, sizeof(header.bounds_min));
+        std::memcpy(m_meshes[mesh].bounds_max, header.bounds_max, sizeof(header.bounds_max));
+    }
+    return mesh;
+}
+
+uint32_t VulkanMeshBuffers::add(const MeshVertex* vertices, uint32_t vertex_count, const uint32_t* indices,
+                                uint32_t index_count) {
+    const VkDeviceSize first_vertex = m_vertices.allocate(vertex_count);
+    const VkDeviceSize first_index = m_indices.allocate(index_count);
+    if (first_vertex == VulkanRangeAllocator::INVALID || first_index == VulkanRangeAllocator::INVALID) {
+        if (first_vertex != VulkanRangeAllocator::INVALID) m_vertices.free(first_vertex, vertex_count);
+        if (first_index != VulkanRangeAllocator::INVALID) m_indices.free(first_index, index_count);
+        SPA_LOG_ERROR("Mesh buffers full: no room for {} vertices / {} indices.", vertex_count, index_count);
+        return INVALID_MESH;
+    }
+
+    uint32_t mesh;
+    if (!m_free_ids.empty()) {
+        mesh = m_free_ids.back();
+        m_free_ids.pop_back();
+    } else {
+        mesh = static_cast<uint32_t>(m_meshes.size());
+        m_meshes.emplace_back();
+        m_pending_chunks.push_back(0);
+    }
+
+    VulkanMesh& m = m_meshes[mesh];
+    m = {};
+    m.first_index = static_cast<uint32_t>(first_index);
+    m.index_count = index_count;
+    m.vertex_offset = static_cast<int32_t>(first_vertex);
+    m.vertex_count = vertex_count;
+    m_pending_chunks[mesh] = 0;
+
+    upload(mesh, vertices, static_cast<VkDeviceSize>(vertex_count) * sizeof(MeshVertex), m_vertex_buffer,
+           first_vertex * sizeof(MeshVertex));
+    upload(mesh, indices, static_cast<VkDeviceSize>(index_count) * sizeof(uint32_t), m_index_buffer,
+           first_index * sizeof(uint32_t));
+    return mesh;
+}
+
+void VulkanMeshBuffers::upload(uint32_t mesh, const void* data, VkDeviceSize size, VkBuffer dst,
+                               VkDeviceSize dst_offset) {
+    const u8* bytes = static_cast<const u8*>(data);
+    const VkDeviceSize chunk_size = m_staging->get_region_size();
+    for (VkDeviceSize done = 0; done < size;) {
+        const VkDeviceSize chunk = std::min(chunk_size, size - done);
+        // Once one chunk waits, the rest wait behind it rather than filling the region out of order
+        if (m_chunks.empty() && m_staging->upload_buffer(bytes + done, chunk, dst, dst_offset + done)) {
+            m_uploaded_bytes += chunk;
+        } else {
+            m_chunks.push_back({mesh, dst, dst_offset + done, std::vector<u8>(bytes + done, bytes + done + chunk)});
+            m_pending_chunks[mesh]++;
+        }
+        done += chunk;
+    }
+}
+
+void VulkanMeshBuffers::update(uint64_t frames_completed) {
+    while (!m_retired.empty() && m_retired.front().frame <= frames_completed) {
+        const Retired& retired = m_retired.front();
+        m_vertices.free(retired.first_vertex, retired.vertex_count);
+        m_indices.free(retired.first_index, retired.index_count);
+        m_retired.pop_front();
+    }
+
+    while (!m_chunks.empty()) {
+        Chunk& chunk = m_chunks.front();
+        if (!m_staging->upload_buffer(chunk.data.data(), chunk.data.size(), chunk.dst, chunk.dst_offset)) return;
+        m_uploaded_bytes += chunk.data.size();
+        m_pending_chunks[chunk.mesh]--;
+        m_chunks.pop_front();
+    }
+}
+
+void VulkanMeshBuffers::remove(uint32_t mesh, uint64_t frames_submitted) {
+    if (mesh >= m_meshes.size() || m_pending_chunks[mesh] == UINT32_MAX) return;
+
+    if (m_pending_chunks[mesh] > 0) {
+        std::erase_if(m_chunks, [mesh](const Chunk& chunk) { return chunk.mesh == mesh; });
+    }
+    const VulkanMesh& m = m_meshes[mesh];
+    SPA_ASSERT(m_retired.empty() || m_retired.back().frame <= frames_submitted);
+    m_retired.push_back({frames_submitted, static_cast<VkDeviceSize>(m.vertex_offset), m.vertex_count,
+                         m.first_index, m.index_count});
+
+    m_pending_chunks[mesh] = UINT32_MAX;
+    m_free_ids.push_back(mesh);
+}
+
+void VulkanMeshBuffers::bind(VkCommandBuffer cmd) const {
+    const VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(cmd, 0, 1, &m_vertex_buffer, &offset);
+    vkCmdBindIndexBuffer(cmd, m_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+VulkanMeshStats VulkanMeshBuffers::get_stats() const {
+    VulkanMeshStats stats;
+    stats.meshes = static_cast<uint32_t>(m_meshes.size() - m_free_ids.size());
+    stats.pending_uploads = static_cast<uint32_t>(m_chunks.size());
+    stats.vertices_used = m_vertices.get_used();
+    stats.vertex_capacity = m_vertices.get_capacity();
+    stats.indices_used = m_indices.get_used();
+    stats.index_capacity = m_indices.get_capacity();
+    stats.free_ranges = m_vertices.get_free_range_count() + m_indices.get_free_range_count();
+    stats.uploaded_bytes = m_uploaded_bytes;
+    return stats;
+}
+
+void VulkanMeshBuffers::test() const {
+    std::cout << "=== VulkanMeshBuffers Test ===\n";
+    std::cout << "Vertices: " << m_vertices.get_used() << " / " << m_vertices.get_capacity()
+              << " (" << m_vertices.get_capacity() * sizeof(MeshVertex) / (1024 * 1024) << " MiB)\n";
+    std::cout << "Indices: " << m_indices.get_used() << " / " << m_indices.get_capacity()
+              << " (" << m_indices.get_capacity() * sizeof(uint32_t) / (1024 * 1024) << " MiB)\n";
+    std::cout << "Meshes: " << m_meshes.size() - m_free_ids.size() << "\n";
+}
+
+// === VulkanDynamicBuffer ===
+
+VulkanDynamicBuffer::~VulkanDynamicBuffer() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanDynamicBuffer::create(VulkanDevice& device, uint32_t max_frames_in_flight, VkDeviceSize region_size) {
+    m_memory = &device.get_memory_allocator();
+
+    // Any allocation may be bound as a uniform or storage buffer at its offset
+    const VkPhysicalDeviceLimits& limits = device.get_properties().limits;
+    m_alignment = std::max<VkDeviceSize>({16, limits.minUniformBufferOffsetAlignment,
+                                          limits.minStorageBufferOffsetAlignment});
+    m_region_size = (region_size + m_alignment - 1) / m_alignment * m_alignment;
+    m_frame_count = max_frames_in_flight;
+
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.size = m_region_size * max_frames_in_flight;
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult res = m_memory->create_buffer(buffer_info,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                           m_buffer, m_allocation);
+    if (res != VK_SUCCESS) return res;
+    SPA_ASSERT(m_allocation.mapped != nullptr);
+
+    m_region_start = 0;
+    m_offset = 0;
+    m_peak = 0;
+    return VK_SUCCESS;
+}
+
+void VulkanDynamicBuffer::cleanup(VkDevice) {
+    if (m_memory) {
+        m_memory->destroy_buffer(m_buffer, m_allocation);
+        m_memory = nullptr;
+    }
+    m_region_size = 0;
+}
+
+void VulkanDynamicBuffer::begin_frame(uint32_t frame) {
+    SPA_ASSERT(frame < m_frame_count);
+    m_peak = std::max(m_peak, m_offset.load(std::memory_order_relaxed));
+    m_region_start = m_region_size * frame;
+    m_offset.store(0, std::memory_order_relaxed);
+}
+
+VulkanDynamicBuffer::Allocation VulkanDynamicBuffer::allocate(VkDeviceSize size) {
+    const VkDeviceSize aligned = (size + m_alignment - 1) / m_alignment * m_alignment;
+    const VkDeviceSize offset = m_offset.fetch_add(aligned, std::memory_order_relaxed);
+    if (offset + size > m_region_size) return {};
+
+    Allocation allocation;
+    allocation.offset = m_region_start + offset;
+    allocation.data = static_cast<u8*>(m_allocation.mapped) + allocation.offset;
+    return allocation;
+}
+
+void VulkanDynamicBuffer::test() const {
+    std::cout << "=== VulkanDynamicBuffer Test ===\n";
+    std::cout << "Regions: " << m_frame_count << " x " << m_region_size / 1024 << " KiB, alignment "
+              << m_alignment << "\n";
+    std::cout << "Mapped: " << (m_allocation.mapped ? "yes" : "no") << "\n";
+}
@@ -0,0 +1,28 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+
+VulkanDeletionQueue::~VulkanDeletionQueue() {
+    // Must call flush_all manually
+}
+
+void VulkanDeletionQueue::push(uint64_t frames_submitted, DestroyFn fn) {
+    SPA_ASSERT(m_entries.empty() || m_entries.back().frame <= frames_submitted);
+    m_entries.push_back({frames_submitted, std::move(fn)});
+}
+
+void VulkanDeletionQueue::flush(VkDevice device, uint64_t frames_completed) {
+    while (!m_entries.empty() && m_entries.front().frame <= frames_completed) {
+        m_entries.front().fn(device);
+        m_entries.pop_front();
+    }
+}
+
+void VulkanDeletionQueue::flush_all(VkDevice device) {
+    for (Entry& entry : m_entries) {
+        entry.fn(device);
+    }
+    m_entries.clear();
+}
@@ -17,6 +17,8 @@ VkResult VulkanDevice::create(VkInstance instance, VkSurfaceKHR surface, VkAlloc
 
     // Select a GPU that supports required features and presentation
     pick_physical_device(instance, surface);
+    vkGetPhysicalDeviceProperties(m_physical_device, &m_properties);
+    find_transfer_queue_family(m_physical_device);
 
     // Specify queues to create
     float queue_priority = 1.0f;
@@ -25,6 +27,8 @@ VkResult VulkanDevice::create(VkInstance instance, VkSurfaceKHR surface, VkAlloc
 
     if (m_graphics_queue_family != m_present_queue_family)
         unique_families.push_back(m_present_queue_family);
+    if (has_dedicated_transfer_queue() && m_transfer_queue_family != m_present_queue_family)
+        unique_families.push_back(m_transfer_queue_family);
 
     for (uint32_t family : unique_families) {
         VkDeviceQueueCreateInfo queue_info = {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
@@ -34,13 +38,53 @@ VkResult VulkanDevice::create(VkInstance instance, VkSurfaceKHR surface, VkAlloc
         queue_create_infos.push_back(queue_info);
     }
 
-    // Enable swapchain extension
+    // Enable swapchain extension (offscreen devices have nothing to present to)
     const char* device_extensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
+    // Timeline semaphores hand uploads from the transfer queue to graphics (core in 1.2)
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES};
+    // Dynamic rendering + synchronization2 replace render pass / framebuffer objects (core in 1.3)
+    VkPhysicalDeviceVulkan13Features vulkan13_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+    if (m_properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceFeatures2 features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+        features.pNext = &timeline_features;
+        if (m_properties.apiVersion >= VK_API_VERSION_1_3) timeline_features.pNext = &vulkan13_features;
+        vkGetPhysicalDeviceFeatures2(m_physical_device, &features);
+    }
+    m_timeline_semaphores = timeline_features.timelineSemaphore == VK_TRUE;
+    m_dynamic_rendering = vulkan13_features.dynamicRendering == VK_TRUE &&
+                          vulkan13_features.synchronization2 == VK_TRUE;
+
+    // Block-compressed textures from the cooker; desktop GPUs have them, mobile ones mostly don't
+    VkPhysicalDeviceFeatures supported_features = {};
+    vkGetPhysicalDeviceFeatures(m_physical_device, &supported_features);
+    m_bc_textures = supported_features.textureCompressionBC == VK_TRUE;
+    VkPhysicalDeviceFeatures enabled_features = {};
+    enabled_features.textureCompressionBC = supported_features.textureCompressionBC;
+
+    // Only enable what is used, not everything the query reported
+    vulkan13_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+    vulkan13_features.dynamicRendering = VK_TRUE;
+    vulkan13_features.synchronization2 = VK_TRUE;
+    timeline_features.pNext = nullptr;
+
+    void* features_chain = nullptr;
+    if (m_dynamic_rendering) {
+        vulkan13_features.pNext = features_chain;
+        features_chain = &vulkan13_features;
+    }
+    if (m_timeline_semaphores) {
+        timeline_features.pNext = features_chain;
+        features_chain = &timeline_features;
+    }
+
     VkDeviceCreateInfo create_info = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+    create_info.pNext = features_chain;
+    create_info.pEnabledFeatures = &enabled_features;
     create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
     create_info.pQueueCreateInfos = queue_create_infos.data();
-    create_info.enabledExtensionCount = 1;
+    create_info.enabledExtensionCount = surface != VK_NULL_HANDLE ? 1 : 0;
     create_info.ppEnabledExtensionNames = device_extensions;
 
     VkResult result = vkCreateDevice(m_physical_device, &create_info, m_allocator, &m_device);
@@ -49,8 +93,10 @@ VkResult VulkanDevice::create(VkInstance instance, VkSurfaceKHR surface, VkAlloc
     // Retrieve queues
     vkGetDeviceQueue(m_device, m_graphics_queue_family, 0, &m_graphics_queue);
     vkGetDeviceQueue(m_device, m_present_queue_family, 0, &m_present_queue);
+    vkGetDeviceQueue(m_device, m_transfer_queue_family, 0, &m_transfer_queue);
 
-    return VK_SUCCESS;
+    // All image/buffer memory is sub-allocated from here
+    return m_memory.create(*this);
 }
 
 void VulkanDevice::pick_physical_device(VkInstance instance, VkSurfaceKHR surface) {
@@ -77,6 +123,10 @@ bool VulkanDevice::is_device_suitable(VkPhysicalDevice device, VkSurfaceKHR surf
 }
 
 void VulkanDevice::find_queue_families(VkPhysicalDevice device, VkSurfaceKHR surface) {
+    // Results from a previously rejected device must not leak into this one
+    m_graphics_queue_family = UINT32_MAX;
+    m_present_queue_family = UINT32_MAX;
+
     uint32_t queue_count = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_count, nullptr);
     std::vector<VkQueueFamilyProperties> properties(queue_count);
@@ -86,8 +136,12 @@ void VulkanDevice::find_queue_families(VkPhysicalDevice device, VkSurfaceKHR sur
         if (properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
             m_graphics_queue_family = i;
 
+        // Without a surface there is no present step, so the graphics queue stands in for it
         VkBool32 present_support = VK_FALSE;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+        if (surface != VK_NULL_HANDLE)
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+        else
+            present_support = (properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
         if (present_support)
             m_present_queue_family = i;
 
@@ -96,7 +150,33 @@ void VulkanDevice::find_queue_families(VkPhysicalDevice device, VkSurfaceKHR sur
     }
 }
 
+void VulkanDevice::find_transfer_queue_family(VkPhysicalDevice device) {
+    uint32_t queue_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_count, nullptr);
+    std::vector<VkQueueFamilyProperties> properties(queue_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_count, properties.data());
+
+    // Prefer a pure copy engine, then any non-graphics family that can transfer (compute queues
+    // implicitly can); otherwise uploads share the graphics queue
+    m_transfer_queue_family = m_graphics_queue_family;
+    uint32_t best_score = 0;
+    for (uint32_t i = 0; i < queue_count; ++i) {
+        const VkQueueFlags flags = properties[i].queueFlags;
+        if (flags & VK_QUEUE_GRAPHICS_BIT) continue;
+
+        uint32_t score = 0;
+        if (flags & VK_QUEUE_TRANSFER_BIT) score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+        else if (flags & VK_QUEUE_COMPUTE_BIT) score = 1;
+
+        if (score > best_score) {
+            best_score = score;
+            m_transfer_queue_family = i;
+        }
+    }
+}
+
 void VulkanDevice::cleanup() {
+    m_memory.cleanup();
     if (m_device != VK_NULL_HANDLE) {
         vkDestroyDevice(m_device, m_allocator);
         m_device = VK_NULL_HANDLE;
@@ -104,8 +184,13 @@ void VulkanDevice::cleanup() {
     m_physical_device = VK_NULL_HANDLE;
     m_graphics_queue = VK_NULL_HANDLE;
     m_present_queue = VK_NULL_HANDLE;
+    m_transfer_queue = VK_NULL_HANDLE;
     m_graphics_queue_family = UINT32_MAX;
     m_present_queue_family = UINT32_MAX;
+    m_transfer_queue_family = UINT32_MAX;
+    m_timeline_semaphores = false;
+    m_dynamic_rendering = false;
+    m_bc_textures = false;
 }
 
 
@@ -115,7 +200,8 @@ void VulkanDevice::test() const {
     VkPhysicalDeviceProperties props{};
     vkGetPhysicalDeviceProperties(m_physical_device, &props);
 
-    std::cout << "Selected GPU: " << props.deviceName << "\n";
+    std::cout << "Selected GPU: " << props.deviceName
+              << (props.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? " (software)" : "") << "\n";
     std::cout << "API Version: "
               << VK_VERSION_MAJOR(props.apiVersion) << "."
               << VK_VERSION_MINOR(props.apiVersion) << "."
@@ -123,4 +209,10 @@ void VulkanDevice::test() const {
 
     std::cout << "Graphics Queue Family Index: " << m_graphics_queue_family << "\n";
     std::cout << "Present Queue Family Index: " << m_present_queue_family << "\n";
+    std::cout << "Transfer Queue Family Index: " << m_transfer_queue_family
+              << (has_dedicated_transfer_queue() ? " (dedicated)" : " (shared with graphics)") << "\n";
+    std::cout << "Timeline semaphores: " << (m_timeline_semaphores ? "yes" : "no") << "\n";
+    std::cout << "Dynamic rendering: " << (m_dynamic_rendering ? "yes" : "no") << "\n";
+    std::cout << "BC textures: " << (m_bc_textures ? "yes" : "no") << "\n";
+    std::cout << "Max memory allocations: " << props.limits.maxMemoryAllocationCount << "\n";
 }
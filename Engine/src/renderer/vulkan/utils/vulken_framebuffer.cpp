@@ -15,6 +15,15 @@ void VulkanFramebufferManager::cleanup(VkDevice device) {
     m_framebuffers.clear();
 }
 
+void VulkanFramebufferManager::retire(VulkanDeletionQueue& queue, uint64_t frames_submitted) {
+    queue.push(frames_submitted, [framebuffers = std::move(m_framebuffers)](VkDevice device) {
+        for (VkFramebuffer fb : framebuffers) {
+            vkDestroyFramebuffer(device, fb, nullptr);
+        }
+    });
+    m_framebuffers.clear();
+}
+
 VkResult VulkanFramebufferManager::create(VkDevice device,
                                           const std::vector<VkImageView>& color_views,
                                           VkImageView depth_view,
@@ -18,16 +18,28 @@ void VulkanImageViews::cleanup(VkDevice device) {
         vkDestroyImageView(device, m_depth_view, nullptr);
         m_depth_view = VK_NULL_HANDLE;
     }
-    if (m_depth_image) {
-        vkDestroyImage(device, m_depth_image, nullptr);
-        m_depth_image = VK_NULL_HANDLE;
-    }
-    if (m_depth_memory) {
-        vkFreeMemory(device, m_depth_memory, nullptr);
-        m_depth_memory = VK_NULL_HANDLE;
+    if (m_memory) {
+        m_memory->destroy_image(m_depth_image, m_depth_allocation);
     }
 }
 
+void VulkanImageViews::retire(VulkanDeletionQueue& queue, uint64_t frames_submitted) {
+    queue.push(frames_submitted, [views = std::move(m_color_views), depth_view = m_depth_view,
+                                  depth_image = m_depth_image, allocation = m_depth_allocation,
+                                  memory = m_memory](VkDevice device) mutable {
+        for (VkImageView view : views) {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        if (depth_view) vkDestroyImageView(device, depth_view, nullptr);
+        if (memory) memory->destroy_image(depth_image, allocation);
+    });
+
+    m_color_views.clear();
+    m_depth_view = VK_NULL_HANDLE;
+    m_depth_image = VK_NULL_HANDLE;
+    m_depth_allocation = {};
+}
+
 VkFormat VulkanImageViews::choose_depth_format(VkPhysicalDevice phys) {
     const VkFormat candidates[] = {
         VK_FORMAT_D32_SFLOAT,
@@ -44,8 +56,10 @@ VkFormat VulkanImageViews::choose_depth_format(VkPhysicalDevice phys) {
     assert(false && "No suitable depth format found.");
 }
 
-VkResult VulkanImageViews::create(VulkanDevice& device, const std::vector<VkImage>& images, VkFormat color_format, VkExtent2D extent) {
+VkResult VulkanImageViews::create(VulkanDevice& device, const std::vector<VkImage>& images, VkFormat color_format, VkExtent2D extent,
+                                  bool create_depth) {
     cleanup(device.get_logical_device()); // Ensure clean state
+    m_memory = &device.get_memory_allocator();
 
     m_color_views.resize(images.size());
 
@@ -67,6 +81,7 @@ VkResult VulkanImageViews::create(VulkanDevice& device, const std::vector<VkImag
 
     // === Create depth image + memory ===
     m_depth_format = choose_depth_format(device.get_physical_device());
+    if (!create_depth) return VK_SUCCESS;
 
     VkImageCreateInfo image_info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
     image_info.imageType = VK_IMAGE_TYPE_2D;
@@ -80,30 +95,10 @@ VkResult VulkanImageViews::create(VulkanDevice& device, const std::vector<VkImag
     image_info.samples = VK_SAMPLE_COUNT_1_BIT;
     image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    VkResult res = vkCreateImage(device.get_logical_device(), &image_info, nullptr, &m_depth_image);
-    if (res != VK_SUCCESS) return res;
-
-    VkMemoryRequirements mem_reqs;
-    vkGetImageMemoryRequirements(device.get_logical_device(), m_depth_image, &mem_reqs);
-
-    VkMemoryAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    alloc_info.allocationSize = mem_reqs.size;
-
-    VkPhysicalDeviceMemoryProperties mem_props;
-    vkGetPhysicalDeviceMemoryProperties(device.get_physical_device(), &mem_props);
-    for (uint32_t i = 0; i < mem_props.memoryTypeCount; ++i) {
-        if ((mem_reqs.memoryTypeBits & (1 << i)) &&
-            (mem_props.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
-            alloc_info.memoryTypeIndex = i;
-            break;
-        }
-    }
-
-    res = vkAllocateMemory(device.get_logical_device(), &alloc_info, nullptr, &m_depth_memory);
+    VkResult res = m_memory->create_image(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                          m_depth_image, m_depth_allocation);
     if (res != VK_SUCCESS) return res;
 
-    vkBindImageMemory(device.get_logical_device(), m_depth_image, m_depth_memory, 0);
-
     VkImageViewCreateInfo view_info = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
     view_info.image = m_depth_image;
     view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
@@ -124,7 +119,8 @@ void VulkanImageViews::test() const {
         std::cout << "  Color View #" << i << ": " << m_color_views[i] << "\n";
     }
     std::cout << "Depth Image: " << m_depth_image << "\n";
-    std::cout << "Depth Memory: " << m_depth_memory << "\n";
+    std::cout << "Depth Memory: " << m_depth_allocation.memory << " +" << m_depth_allocation.offset
+              << (m_depth_allocation.is_dedicated() ? " (dedicated)" : "") << "\n";
     std::cout << "Depth View: " << m_depth_view << "\n";
     std::cout << "Depth Format: " << m_depth_format << "\n";
 }
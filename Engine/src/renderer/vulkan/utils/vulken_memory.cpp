@@ -0,0 +1,390 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator() {
+    // Must call cleanup manually
+}
+
+uint32_t VulkanMemoryAllocator::order_for_size(VkDeviceSize size) {
+    uint32_t order = 0;
+    while ((MIN_ALLOCATION << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+VkResult VulkanMemoryAllocator::create(const VulkanDevice& device, VkDeviceSize block_size) {
+    m_device = device.get_logical_device();
+    m_block_size = block_size;
+    vkGetPhysicalDeviceMemoryProperties(device.get_physical_device(), &m_memory_properties);
+
+    m_pools.resize(m_memory_properties.memoryTypeCount * 2);
+    for (uint32_t i = 0; i < m_pools.size(); ++i) {
+        Pool& pool = m_pools[i];
+        pool.memory_type = i / 2;
+
+        // Keep blocks small relative to their heap so tiny heaps (e.g. 256MB BAR) aren't exhausted
+        const uint32_t heap_index = m_memory_properties.memoryTypes[pool.memory_type].heapIndex;
+        const VkDeviceSize heap_size = m_memory_properties.memoryHeaps[heap_index].size;
+        VkDeviceSize size = m_block_size;
+        while (size > heap_size / 8 && size > 1024 * 1024) {
+            size >>= 1;
+        }
+        pool.block_size = size;
+        pool.max_order = order_for_size(size);
+    }
+    return VK_SUCCESS;
+}
+
+void VulkanMemoryAllocator::cleanup() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_allocation_count > 0) {
+        SPA_LOG_WARN("VulkanMemoryAllocator destroyed with {} live allocations ({} bytes).",
+                     m_allocation_count, m_bytes_in_use);
+    }
+
+    for (Pool& pool : m_pools) {
+        for (Block& block : pool.blocks) {
+            if (block.memory) vkFreeMemory(m_device, block.memory, nullptr);
+        }
+    }
+    m_pools.clear();
+    m_bytes_in_use = 0;
+    m_dedicated_bytes = 0;
+    m_allocation_count = 0;
+    m_dedicated_count = 0;
+}
+
+static uint32_t choose_memory_type(const VkPhysicalDeviceMemoryProperties& props, uint32_t type_bits,
+                                   VkMemoryPropertyFlags flags) {
+    for (uint32_t i = 0; i < props.memoryTypeCount; ++i) {
+        if ((type_bits & (1u << i)) && (props.memoryTypes[i].propertyFlags & flags) == flags) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+void* VulkanMemoryAllocator::map_memory(VkDeviceMemory memory, uint32_t memory_type) {
+    if (!(m_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+        return nullptr;
+    }
+    void* mapped = nullptr;
+    if (vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        SPA_LOG_WARN("Failed to persistently map host-visible memory.");
+        return nullptr;
+    }
+    return mapped;
+}
+
+VkResult VulkanMemoryAllocator::allocate_dedicated(const VkMemoryRequirements& reqs, uint32_t memory_type,
+                                                   const VkMemoryDedicatedAllocateInfo* dedicated_info,
+                                                   VulkanAllocation& out) {
+    VkMemoryAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    alloc_info.pNext = dedicated_info;
+    alloc_info.allocationSize = reqs.size;
+    alloc_info.memoryTypeIndex = memory_type;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult res = vkAllocateMemory(m_device, &alloc_info, nullptr, &memory);
+    if (res != VK_SUCCESS) return res;
+
+    out = {};
+    out.memory = memory;
+    out.size = reqs.size;
+    out.memory_type = memory_type;
+    out.mapped = map_memory(memory, memory_type);
+
+    m_bytes_in_use += reqs.size;
+    m_dedicated_bytes += reqs.size;
+    m_allocation_count++;
+    m_dedicated_count++;
+    return VK_SUCCESS;
+}
+
+VkResult VulkanMemoryAllocator::add_block(Pool& pool, uint32_t& out_block) {
+    VkMemoryAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    alloc_info.allocationSize = pool.block_size;
+    alloc_info.memoryTypeIndex = pool.memory_type;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult res = vkAllocateMemory(m_device, &alloc_info, nullptr, &memory);
+    if (res != VK_SUCCESS) return res;
+
+    // Reuse a released slot so allocation block indices stay stable
+    uint32_t index = 0;
+    while (index < pool.blocks.size() && pool.blocks[index].memory != VK_NULL_HANDLE) {
+        index++;
+    }
+    if (index == pool.blocks.size()) pool.blocks.emplace_back();
+
+    Block& block = pool.blocks[index];
+    block.memory = memory;
+    block.mapped = map_memory(memory, pool.memory_type);
+    block.allocated = 0;
+    block.free_lists.assign(pool.max_order + 1, {});
+    block.free_lists[pool.max_order].insert(0);
+
+    out_block = index;
+    return VK_SUCCESS;
+}
+
+bool VulkanMemoryAllocator::allocate_from_block(Pool& pool, uint32_t block_index, uint32_t order,
+                                                VkDeviceSize& out_offset) {
+    Block& block = pool.blocks[block_index];
+    if (block.memory == VK_NULL_HANDLE) return false;
+
+    for (uint32_t k = order; k <= pool.max_order; ++k) {
+        if (block.free_lists[k].empty()) continue;
+
+        // Lowest offset first keeps live ranges packed toward the start of the block
+        const VkDeviceSize offset = *block.free_lists[k].begin();
+        block.free_lists[k].erase(block.free_lists[k].begin());
+
+        // Split down to the requested order, returning the upper halves to the free lists
+        while (k > order) {
+            k--;
+            block.free_lists[k].insert(offset + (MIN_ALLOCATION << k));
+        }
+
+        block.allocated += MIN_ALLOCATION << order;
+        out_offset = offset;
+        return true;
+    }
+    return false;
+}
+
+void VulkanMemoryAllocator::release_block(Pool& pool, uint32_t block_index) {
+    Block& block = pool.blocks[block_index];
+    vkFreeMemory(m_device, block.memory, nullptr);
+    block = {};
+}
+
+VkResult VulkanMemoryAllocator::allocate(const VkMemoryRequirements& reqs, VkMemoryPropertyFlags flags, bool linear,
+                                         bool dedicated, VulkanAllocation& out) {
+    const uint32_t memory_type = choose_memory_type(m_memory_properties, reqs.memoryTypeBits, flags);
+    if (memory_type == UINT32_MAX) {
+        SPA_LOG_ERROR("No memory type matches bits {:#x} with flags {:#x}", reqs.memoryTypeBits, flags);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const uint32_t pool_index = memory_type * 2 + (linear ? 1 : 0);
+    Pool& pool = m_pools[pool_index];
+
+    // Buddy ranges are aligned to their own size, so rounding up to the alignment is enough
+    const uint32_t order = order_for_size(std::max(reqs.size, reqs.alignment));
+    if (dedicated || order > pool.max_order || (MIN_ALLOCATION << order) > pool.block_size / 2) {
+        return allocate_dedicated(reqs, memory_type, nullptr, out);
+    }
+
+    VkDeviceSize offset = 0;
+    uint32_t block_index = UINT32_MAX;
+    for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+        if (allocate_from_block(pool, i, order, offset)) {
+            block_index = i;
+            break;
+        }
+    }
+
+    if (block_index == UINT32_MAX) {
+        VkResult res = add_block(pool, block_index);
+        if (res != VK_SUCCESS) return res;
+        allocate_from_block(pool, block_index, order, offset);
+    }
+
+    const Block& block = pool.blocks[block_index];
+    out = {};
+    out.memory = block.memory;
+    out.offset = offset;
+    out.size = reqs.size;
+    out.mapped = block.mapped ? static_cast<u8*>(block.mapped) + offset : nullptr;
+    out.memory_type = memory_type;
+    out.pool = pool_index;
+    out.block = block_index;
+    out.order = order;
+
+    m_bytes_in_use += reqs.size;
+    m_allocation_count++;
+    return VK_SUCCESS;
+}
+
+void VulkanMemoryAllocator::free(VulkanAllocation& allocation) {
+    if (!allocation.is_valid()) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bytes_in_use -= allocation.size;
+    m_allocation_count--;
+
+    if (allocation.is_dedicated()) {
+        vkFreeMemory(m_device, allocation.memory, nullptr);
+        m_dedicated_bytes -= allocation.size;
+        m_dedicated_count--;
+        allocation = {};
+        return;
+    }
+
+    Pool& pool = m_pools[allocation.pool];
+    Block& block = pool.blocks[allocation.block];
+    block.allocated -= MIN_ALLOCATION << allocation.order;
+
+    // Merge with free buddies as far up as possible
+    VkDeviceSize offset = allocation.offset;
+    uint32_t k = allocation.order;
+    while (k < pool.max_order) {
+        const VkDeviceSize buddy = offset ^ (MIN_ALLOCATION << k);
+        auto it = block.free_lists[k].find(buddy);
+        if (it == block.free_lists[k].end()) break;
+        block.free_lists[k].erase(it);
+        offset = std::min(offset, buddy);
+        k++;
+    }
+    block.free_lists[k].insert(offset);
+
+    // Give empty blocks back to the driver, but keep one per pool to avoid alloc/free thrashing
+    if (block.allocated == 0) {
+        const bool has_other_block = std::ranges::any_of(pool.blocks, [&](const Block& other) {
+            return &other != &block && other.memory != VK_NULL_HANDLE;
+        });
+        if (has_other_block) release_block(pool, allocation.block);
+    }
+
+    allocation = {};
+}
+
+VkResult VulkanMemoryAllocator::create_image(const VkImageCreateInfo& info, VkMemoryPropertyFlags flags,
+                                             VkImage& out_image, VulkanAllocation& out_allocation) {
+    VkResult res = vkCreateImage(m_device, &info, nullptr, &out_image);
+    if (res != VK_SUCCESS) return res;
+
+    VkMemoryDedicatedRequirements dedicated_reqs = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+    VkMemoryRequirements2 reqs2 = {VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+    reqs2.pNext = &dedicated_reqs;
+    VkImageMemoryRequirementsInfo2 reqs_info = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2};
+    reqs_info.image = out_image;
+    vkGetImageMemoryRequirements2(m_device, &reqs_info, &reqs2);
+
+    // Render targets and other big images are often better off in their own allocation
+    if (dedicated_reqs.prefersDedicatedAllocation || dedicated_reqs.requiresDedicatedAllocation) {
+        const uint32_t memory_type = choose_memory_type(m_memory_properties, reqs2.memoryRequirements.memoryTypeBits, flags);
+        if (memory_type == UINT32_MAX) {
+            res = VK_ERROR_FEATURE_NOT_PRESENT;
+        } else {
+            VkMemoryDedicatedAllocateInfo dedicated_info = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+            dedicated_info.image = out_image;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            res = allocate_dedicated(reqs2.memoryRequirements, memory_type, &dedicated_info, out_allocation);
+        }
+    } else {
+        res = allocate(reqs2.memoryRequirements, flags, info.tiling == VK_IMAGE_TILING_LINEAR, false, out_allocation);
+    }
+
+    if (res == VK_SUCCESS) {
+        res = vkBindImageMemory(m_device, out_image, out_allocation.memory, out_allocation.offset);
+    }
+    if (res != VK_SUCCESS) {
+        destroy_image(out_image, out_allocation);
+    }
+    return res;
+}
+
+VkResult VulkanMemoryAllocator::create_buffer(const VkBufferCreateInfo& info, VkMemoryPropertyFlags flags,
+                                              VkBuffer& out_buffer, VulkanAllocation& out_allocation) {
+    VkResult res = vkCreateBuffer(m_device, &info, nullptr, &out_buffer);
+    if (res != VK_SUCCESS) return res;
+
+    VkMemoryDedicatedRequirements dedicated_reqs = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+    VkMemoryRequirements2 reqs2 = {VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+    reqs2.pNext = &dedicated_reqs;
+    VkBufferMemoryRequirementsInfo2 reqs_info = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2};
+    reqs_info.buffer = out_buffer;
+    vkGetBufferMemoryRequirements2(m_device, &reqs_info, &reqs2);
+
+    // The spec requires the allocation to name the buffer when a dedicated one is required
+    if (dedicated_reqs.requiresDedicatedAllocation) {
+        const uint32_t memory_type = choose_memory_type(m_memory_properties, reqs2.memoryRequirements.memoryTypeBits, flags);
+        if (memory_type == UINT32_MAX) {
+            res = VK_ERROR_FEATURE_NOT_PRESENT;
+        } else {
+            VkMemoryDedicatedAllocateInfo dedicated_info = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+            dedicated_info.buffer = out_buffer;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            res = allocate_dedicated(reqs2.memoryRequirements, memory_type, &dedicated_info, out_allocation);
+        }
+    } else {
+        res = allocate(reqs2.memoryRequirements, flags, true, false, out_allocation);
+    }
+    if (res == VK_SUCCESS) {
+        res = vkBindBufferMemory(m_device, out_buffer, out_allocation.memory, out_allocation.offset);
+    }
+    if (res != VK_SUCCESS) {
+        destroy_buffer(out_buffer, out_allocation);
+    }
+    return res;
+}
+
+void VulkanMemoryAllocator::destroy_image(VkImage& image, VulkanAllocation& allocation) {
+    if (image != VK_NULL_HANDLE) {
+        vkDestroyImage(m_device, image, nullptr);
+        image = VK_NULL_HANDLE;
+    }
+    free(allocation);
+}
+
+void VulkanMemoryAllocator::destroy_buffer(VkBuffer& buffer, VulkanAllocation& allocation) {
+    if (buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(m_device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+    }
+    free(allocation);
+}
+
+VulkanMemoryStats VulkanMemoryAllocator::get_stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    VulkanMemoryStats stats;
+    stats.bytes_in_use = m_bytes_in_use;
+    stats.bytes_reserved = m_dedicated_bytes;
+    stats.bytes_allocated = m_dedicated_bytes;
+    stats.allocation_count = m_allocation_count;
+    stats.dedicated_count = m_dedicated_count;
+
+    VkDeviceSize free_bytes = 0;
+    for (const Pool& pool : m_pools) {
+        for (const Block& block : pool.blocks) {
+            if (block.memory == VK_NULL_HANDLE) continue;
+            stats.block_count++;
+            stats.bytes_reserved += pool.block_size;
+            stats.bytes_allocated += block.allocated;
+            free_bytes += pool.block_size - block.allocated;
+
+            for (uint32_t k = pool.max_order + 1; k-- > 0;) {
+                if (!block.free_lists[k].empty()) {
+                    stats.largest_free_range = std::max(stats.largest_free_range, MIN_ALLOCATION << k);
+                    break;
+                }
+            }
+        }
+    }
+
+    stats.device_allocation_count = stats.block_count + stats.dedicated_count;
+    stats.fragmentation = free_bytes > 0
+        ? 1.0f - static_cast<f32>(stats.largest_free_range) / static_cast<f32>(free_bytes)
+        : 0.0f;
+    return stats;
+}
+
+void VulkanMemoryAllocator::test() const {
+    const VulkanMemoryStats stats = get_stats();
+    std::cout << "=== VulkanMemoryAllocator Test ===\n";
+    std::cout << "Allocations: " << stats.allocation_count << " (" << stats.dedicated_count << " dedicated)\n";
+    std::cout << "Device allocations: " << stats.device_allocation_count << " (" << stats.block_count << " blocks)\n";
+    std::cout << "Bytes in use: " << stats.bytes_in_use << " / allocated: " << stats.bytes_allocated
+              << " / reserved: " << stats.bytes_reserved << "\n";
+    std::cout << "Largest free range: " << stats.largest_free_range
+              << " (fragmentation " << stats.fragmentation << ")\n";
+}
@@ -0,0 +1,99 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+
+// MeshDraw is pushed up to its mesh id: transform, then color
+static constexpr uint32_t MESH_PUSH_SIZE = offsetof(Sparkle::MeshDraw, mesh);
+
+VulkanMeshRenderer::~VulkanMeshRenderer() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanMeshRenderer::create(VulkanPipelineManager& pipelines, const VulkanMeshBuffers& meshes,
+                                    const VulkanPassTarget& target, const char* shader_dir) {
+    if (!meshes.is_created()) return VK_ERROR_INITIALIZATION_FAILED;
+    m_pipelines = &pipelines;
+
+    const std::string dir = shader_dir;
+    m_vertex_shader = pipelines.load_shader((dir + "/mesh.vert.spv").c_str());
+    m_fragment_shader = pipelines.load_shader((dir + "/mesh.frag.spv").c_str());
+    if (m_vertex_shader == UINT32_MAX || m_fragment_shader == UINT32_MAX) {
+        m_pipelines = nullptr;
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    m_meshes = &meshes;
+    set_target(target);
+    return VK_SUCCESS;
+}
+
+void VulkanMeshRenderer::cleanup() {
+    m_draws.clear();
+    m_vertex_shader = m_fragment_shader = UINT32_MAX;
+    m_pipeline = UINT32_MAX;
+    m_meshes = nullptr;
+    m_pipelines = nullptr;
+}
+
+void VulkanMeshRenderer::set_target(const VulkanPassTarget& target) {
+    VulkanPipelineDesc desc;
+    desc.vertex_shader = m_vertex_shader;
+    desc.fragment_shader = m_fragment_shader;
+    desc.push_constant_size = MESH_PUSH_SIZE;
+    desc.push_constant_stages = VK_SHADER_STAGE_VERTEX_BIT;
+
+    desc.vertex_stride = sizeof(Sparkle::MeshVertex);
+    desc.attribute_count = 3;
+    desc.attributes[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Sparkle::MeshVertex, position)};
+    desc.attributes[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Sparkle::MeshVertex, normal)};
+    desc.attributes[2] = {2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Sparkle::MeshVertex, uv)};
+    desc.set_target(target);
+
+    m_pipeline = m_pipelines->request(desc);
+}
+
+void VulkanMeshRenderer::wait_ready() {
+    if (m_pipeline != UINT32_MAX) m_pipelines->wait(m_pipeline);
+}
+
+uint32_t VulkanMeshRenderer::prepare(const Sparkle::MeshDraw* draws, uint32_t count,
+                                     const std::vector<uint32_t>& mesh_ids, VkExtent2D extent) {
+    m_draws.clear();
+    m_extent = extent;
+    if (m_pipelines->get(m_pipeline) == VK_NULL_HANDLE) return 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const Sparkle::MeshDraw& draw = draws[i];
+        if (draw.mesh >= mesh_ids.size()) continue;
+        // Skipped until every chunk of the mesh has been queued for upload
+        const uint32_t mesh = mesh_ids[draw.mesh];
+        if (!m_meshes->is_ready(mesh)) continue;
+        m_draws.push_back({&draw, mesh});
+    }
+    return static_cast<uint32_t>(m_draws.size());
+}
+
+void VulkanMeshRenderer::record(VkCommandBuffer cmd, uint32_t first, uint32_t count) const {
+    const VkPipeline pipeline = m_pipelines->get(m_pipeline);
+    if (pipeline == VK_NULL_HANDLE || count == 0) return;
+
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(m_extent.width);
+    viewport.height = static_cast<float>(m_extent.height);
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    VkRect2D scissor{{0, 0}, m_extent};
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    m_meshes->bind(cmd);
+
+    const VkPipelineLayout layout = m_pipelines->get_layout(m_pipeline);
+    const uint32_t last = std::min(first + count, static_cast<uint32_t>(m_draws.size()));
+    for (uint32_t i = first; i < last; ++i) {
+        vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, MESH_PUSH_SIZE, m_draws[i].draw->transform);
+        m_meshes->draw(cmd, m_draws[i].mesh);
+    }
+}
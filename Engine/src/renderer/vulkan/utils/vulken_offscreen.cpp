@@ -0,0 +1,138 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+
+VulkanOffscreenTarget::~VulkanOffscreenTarget() {
+    // cleanup must be called manually before destruction
+}
+
+VkResult VulkanOffscreenTarget::create(VulkanDevice& device, uint32_t width, uint32_t height, uint32_t image_count) {
+    VkDevice vk_device = device.get_logical_device();
+    m_memory = &device.get_memory_allocator();
+    m_extent = { width, height };
+
+    // 1. Create the color images that stand in for swapchain images
+    m_images.resize(image_count, VK_NULL_HANDLE);
+    m_image_allocations.resize(image_count);
+
+    for (uint32_t i = 0; i < image_count; ++i) {
+        VkImageCreateInfo image_info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent = { m_extent.width, m_extent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = COLOR_FORMAT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkResult res = m_memory->create_image(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                              m_images[i], m_image_allocations[i]);
+        if (res != VK_SUCCESS) return res;
+    }
+
+    // 2. Views for the color images + depth image/view
+    VkResult result = m_image_views.create(device, m_images, COLOR_FORMAT, m_extent, !m_dynamic_rendering);
+    if (result != VK_SUCCESS) {
+        std::cerr << "Failed to create offscreen image views!\n";
+        return result;
+    }
+
+    // The render graph draws straight into the views and owns depth; no render pass or framebuffers to build
+    if (m_dynamic_rendering) return VK_SUCCESS;
+
+    // 3. Render pass leaves the color image ready to be copied out
+    result = m_render_pass.create(vk_device, COLOR_FORMAT, m_image_views.get_depth_format(),
+                                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    if (result != VK_SUCCESS) {
+        std::cerr << "Failed to create offscreen render pass!\n";
+        return result;
+    }
+
+    // 4. Framebuffers, one per color image
+    result = m_framebuffers.create(vk_device,
+                                   m_image_views.get_color_views(),
+                                   m_image_views.get_depth_view(),
+                                   m_render_pass.get(),
+                                   m_extent);
+    if (result != VK_SUCCESS) {
+        std::cerr << "Failed to create offscreen framebuffers!\n";
+        return result;
+    }
+
+    return VK_SUCCESS;
+}
+
+void VulkanOffscreenTarget::record_single(VkCommandBuffer cmd, uint32_t image_index, VulkanGpuTimer* timer, uint32_t frame,
+                                          const VulkanDrawWork* work) {
+    SPA_ASSERT_MSG(!m_dynamic_rendering, "Dynamic rendering frames are recorded through the render graph");
+
+    VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &begin_info);
+    if (timer) timer->write_begin(cmd, frame);
+    if (work) work->record_pre_pass(cmd);
+
+    VkClearValue clears[2] = { m_clear_color, m_clear_depth };
+
+    VkRenderPassBeginInfo rp_info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+    rp_info.renderPass = m_render_pass.get();
+    rp_info.framebuffer = m_framebuffers.get_all()[image_index];
+    rp_info.renderArea.offset = { 0, 0 };
+    rp_info.renderArea.extent = m_extent;
+    rp_info.clearValueCount = 2;
+    rp_info.pClearValues = clears;
+
+    if (timer) timer->begin_zone(cmd, frame, "Main render pass");
+    vkCmdBeginRenderPass(cmd, &rp_info, work ? work->contents() : VK_SUBPASS_CONTENTS_INLINE);
+
+    if (work) work->record(cmd, {rp_info.renderPass, rp_info.framebuffer}, frame);
+
+    vkCmdEndRenderPass(cmd);
+    if (timer) timer->end_zone(cmd, frame);
+    if (timer) timer->write_end(cmd, frame);
+    vkEndCommandBuffer(cmd);
+}
+
+VulkanPassTarget VulkanOffscreenTarget::get_pass_target() const {
+    VulkanPassTarget target;
+    target.render_pass = m_render_pass.get();
+    target.color_format = COLOR_FORMAT;
+    target.depth_format = m_image_views.get_depth_format();
+    return target;
+}
+
+void VulkanOffscreenTarget::set_clear_color(float r, float g, float b, float a) {
+    m_clear_color.color.float32[0] = r;
+    m_clear_color.color.float32[1] = g;
+    m_clear_color.color.float32[2] = b;
+    m_clear_color.color.float32[3] = a;
+}
+
+void VulkanOffscreenTarget::cleanup(VkDevice device) {
+    m_framebuffers.cleanup(device);
+    m_render_pass.cleanup(device);
+    m_image_views.cleanup(device);
+
+    for (size_t i = 0; i < m_images.size(); ++i) {
+        m_memory->destroy_image(m_images[i], m_image_allocations[i]);
+    }
+    m_images.clear();
+    m_image_allocations.clear();
+}
+
+void VulkanOffscreenTarget::test() const {
+    std::cout << "=== VulkanOffscreenTarget Test ===\n";
+    std::cout << "Format: " << COLOR_FORMAT << "\n";
+    std::cout << "Extent: " << m_extent.width << " x " << m_extent.height << "\n";
+    std::cout << "Offscreen images: " << m_images.size() << "\n";
+    std::cout << "Dynamic rendering: " << (m_dynamic_rendering ? "yes" : "no") << "\n";
+
+    m_image_views.test();
+    m_render_pass.get() ? std::cout << "Render pass created\n" : std::cout << "No render pass\n";
+    m_framebuffers.test();
+}
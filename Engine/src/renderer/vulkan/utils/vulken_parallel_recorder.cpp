@@ -0,0 +1,117 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+#include "core/job_system.h"
+#include "core/profiler.h"
+
+VulkanParallelRecorder::~VulkanParallelRecorder() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanParallelRecorder::create(VkDevice device, uint32_t queue_family, uint32_t max_frames_in_flight,
+                                        uint32_t thread_count) {
+    SPA_ASSERT(thread_count > 0);
+    m_device = device;
+
+    // One transient pool + secondary buffer per (frame, slice)
+    m_pools.resize(max_frames_in_flight * thread_count);
+    for (VulkanCommandPool& pool : m_pools) {
+        VkResult res = pool.create(device, queue_family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        if (res != VK_SUCCESS) return res;
+
+        res = pool.allocate_buffers(device, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+        if (res != VK_SUCCESS) return res;
+    }
+
+    m_thread_count = thread_count;
+    m_slice_buffers.assign(thread_count, VK_NULL_HANDLE);
+    m_executed.reserve(thread_count);
+    return VK_SUCCESS;
+}
+
+void VulkanParallelRecorder::cleanup() {
+    for (VulkanCommandPool& pool : m_pools) {
+        pool.cleanup(m_device);
+    }
+    m_pools.clear();
+    m_slice_buffers.clear();
+    m_executed.clear();
+    m_thread_count = 0;
+}
+
+void VulkanParallelRecorder::reset_frame(uint32_t frame) {
+    for (uint32_t t = 0; t < m_thread_count; ++t) {
+        m_pools[frame * m_thread_count + t].reset(m_device);
+    }
+}
+
+const std::vector<VkCommandBuffer>& VulkanParallelRecorder::record(uint32_t frame, const VulkanPassTarget& target,
+                                                                   uint32_t item_count, const RecordFn& fn) {
+    // One job per slice; the calling thread records slices too while it waits
+    Sparkle::JobSystem::parallel_for(m_thread_count, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t slice = begin; slice < end; ++slice) {
+            record_slice(slice, frame, target, item_count, fn);
+        }
+    });
+
+    // Keep draw order: slices are concatenated by index
+    m_executed.clear();
+    for (VkCommandBuffer cmd : m_slice_buffers) {
+        if (cmd != VK_NULL_HANDLE) m_executed.push_back(cmd);
+    }
+    return m_executed;
+}
+
+void VulkanParallelRecorder::record_slice(uint32_t slice, uint32_t frame, const VulkanPassTarget& target,
+                                          uint32_t item_count, const RecordFn& fn) {
+    const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(item_count) * slice / m_thread_count);
+    const uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(item_count) * (slice + 1) / m_thread_count);
+    if (first == last) {
+        m_slice_buffers[slice] = VK_NULL_HANDLE;
+        return;
+    }
+
+    SPA_PROFILE_SCOPE("Record draw slice");
+    VkCommandBuffer cmd = m_pools[frame * m_thread_count + slice].get_buffers()[0];
+
+    VkCommandBufferInheritanceInfo inheritance = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+    inheritance.renderPass = target.render_pass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = target.framebuffer;
+
+    // Under dynamic rendering the secondaries only need the attachment formats they continue into
+    VkCommandBufferInheritanceRenderingInfo rendering = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO };
+    if (target.is_dynamic()) {
+        rendering.colorAttachmentCount = 1;
+        rendering.pColorAttachmentFormats = &target.color_format;
+        rendering.depthAttachmentFormat = target.depth_format;
+        rendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        inheritance.pNext = &rendering;
+    }
+
+    VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance;
+
+    vkBeginCommandBuffer(cmd, &begin_info);
+    fn(cmd, first, last - first);
+    vkEndCommandBuffer(cmd);
+
+    m_slice_buffers[slice] = cmd;
+}
+
+void VulkanDrawWork::record(VkCommandBuffer cmd, const VulkanPassTarget& target, uint32_t frame) const {
+    if (!is_parallel()) {
+        if (item_count > 0 && fn) (*fn)(cmd, 0, item_count);
+        // Inline only: a subpass recorded from secondaries can't take inline draws as well
+        if (sprites) sprites->record(cmd);
+        return;
+    }
+
+    const std::vector<VkCommandBuffer>& secondaries = recorder->record(frame, target, item_count, *fn);
+    if (!secondaries.empty()) {
+        vkCmdExecuteCommands(cmd, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+    }
+}
@@ -0,0 +1,530 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+#include "core/profiler.h"
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    void hash_value(uint64_t& hash, const T& value) {
+        hash = fnv1a(&value, sizeof(T), hash);
+    }
+
+    constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+    // Prefixed to the VkPipelineCache blob on disk. The driver checks its own header too, but some
+    // drivers crash on foreign data instead of rejecting it, so nothing reaches them unless this matches.
+    constexpr uint32_t CACHE_FILE_MAGIC = 0x43505053; // "SPPC"
+    constexpr uint32_t CACHE_FILE_VERSION = 1;
+    constexpr uint64_t CACHE_FILE_MAX_SIZE = 256ull * 1024 * 1024;
+
+    struct CacheFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint32_t driver_version;
+        uint8_t uuid[VK_UUID_SIZE]; // VkPhysicalDeviceProperties::pipelineCacheUUID
+        uint64_t data_size;
+        uint64_t data_hash;
+    };
+
+    void fill_cache_header(CacheFileHeader& header, const VkPhysicalDeviceProperties& properties) {
+        std::memset(&header, 0, sizeof(header));
+        header.magic = CACHE_FILE_MAGIC;
+        header.version = CACHE_FILE_VERSION;
+        header.vendor_id = properties.vendorID;
+        header.device_id = properties.deviceID;
+        header.driver_version = properties.driverVersion;
+        std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    }
+}
+
+uint64_t VulkanPipelineDesc::hash() const {
+    uint64_t h = FNV_OFFSET;
+    hash_value(h, vertex_shader);
+    hash_value(h, fragment_shader);
+    hash_value(h, topology);
+    hash_value(h, polygon_mode);
+    hash_value(h, cull_mode);
+    hash_value(h, front_face);
+    hash_value(h, depth_test);
+    hash_value(h, depth_write);
+    hash_value(h, depth_compare);
+    hash_value(h, alpha_blend);
+    hash_value(h, vertex_stride);
+    hash_value(h, input_rate);
+    hash_value(h, attribute_count);
+    h = fnv1a(attributes, sizeof(attributes[0]) * attribute_count, h);
+    hash_value(h, push_constant_size);
+    hash_value(h, push_constant_stages);
+    hash_value(h, set_layout_count);
+    h = fnv1a(set_layouts, sizeof(set_layouts[0]) * set_layout_count, h);
+    hash_value(h, render_pass);
+    hash_value(h, subpass);
+    hash_value(h, color_format);
+    hash_value(h, depth_format);
+    return h;
+}
+
+bool VulkanPipelineDesc::operator==(const VulkanPipelineDesc& other) const {
+    if (vertex_shader != other.vertex_shader || fragment_shader != other.fragment_shader ||
+        topology != other.topology || polygon_mode != other.polygon_mode || cull_mode != other.cull_mode ||
+        front_face != other.front_face || depth_test != other.depth_test || depth_write != other.depth_write ||
+        depth_compare != other.depth_compare || alpha_blend != other.alpha_blend ||
+        vertex_stride != other.vertex_stride || input_rate != other.input_rate || attribute_count != other.attribute_count ||
+        push_constant_size != other.push_constant_size || push_constant_stages != other.push_constant_stages ||
+        set_layout_count != other.set_layout_count ||
+        render_pass != other.render_pass || subpass != other.subpass ||
+        color_format != other.color_format || depth_format != other.depth_format) {
+        return false;
+    }
+    return std::memcmp(attributes, other.attributes, sizeof(attributes[0]) * attribute_count) == 0 &&
+           std::memcmp(set_layouts, other.set_layouts, sizeof(set_layouts[0]) * set_layout_count) == 0;
+}
+
+
+VulkanPipelineManager::~VulkanPipelineManager() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanPipelineManager::create(VulkanDevice& device, const char* cache_path) {
+    m_device = device.get_logical_device();
+    m_properties = device.get_properties();
+    m_cache_path = cache_path ? cache_path : "";
+    m_pipelines = std::make_unique<Pipeline[]>(MAX_PIPELINES);
+
+    const std::vector<uint8_t> initial_data = load_cache_file();
+
+    VkPipelineCacheCreateInfo cache_info = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    cache_info.initialDataSize = initial_data.size();
+    cache_info.pInitialData = initial_data.empty() ? nullptr : initial_data.data();
+
+    VkResult res = vkCreatePipelineCache(m_device, &cache_info, nullptr, &m_cache);
+    if (res != VK_SUCCESS && !initial_data.empty()) {
+        SPA_LOG_WARN("Driver rejected pipeline cache '{}'; starting cold.", m_cache_path);
+        cache_info.initialDataSize = 0;
+        cache_info.pInitialData = nullptr;
+        res = vkCreatePipelineCache(m_device, &cache_info, nullptr, &m_cache);
+    } else if (res == VK_SUCCESS) {
+        m_cache_bytes_loaded = initial_data.size();
+    }
+    if (res != VK_SUCCESS) return res;
+
+    if (m_cache_bytes_loaded > 0) {
+        SPA_LOG_DEBUG("Loaded {} bytes of pipeline cache from '{}'.", m_cache_bytes_loaded, m_cache_path);
+    }
+    return VK_SUCCESS;
+}
+
+std::vector<uint8_t> VulkanPipelineManager::load_cache_file() const {
+    std::vector<uint8_t> data;
+    if (m_cache_path.empty()) return data;
+
+    FILE* file = std::fopen(m_cache_path.c_str(), "rb");
+    if (!file) return data; // First run
+
+    CacheFileHeader expected;
+    fill_cache_header(expected, m_properties);
+
+    CacheFileHeader header;
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                 header.magic == CACHE_FILE_MAGIC && header.version == CACHE_FILE_VERSION;
+    if (valid && (header.vendor_id != expected.vendor_id || header.device_id != expected.device_id ||
+                  header.driver_version != expected.driver_version ||
+                  std::memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0)) {
+        SPA_LOG_INFO("Pipeline cache '{}' is from another device or driver version; starting cold.", m_cache_path);
+        std::fclose(file);
+        return data;
+    }
+    if (valid && header.data_size <= CACHE_FILE_MAX_SIZE) {
+        data.resize(header.data_size);
+        valid = std::fread(data.data(), 1, data.size(), file) == data.size() &&
+                fnv1a(data.data(), data.size()) == header.data_hash;
+    } else {
+        valid = false;
+    }
+    std::fclose(file);
+
+    if (!valid) {
+        SPA_LOG_WARN("Pipeline cache '{}' is corrupt; starting cold.", m_cache_path);
+        data.clear();
+    }
+    return data;
+}
+
+bool VulkanPipelineManager::save_cache() {
+    if (m_cache == VK_NULL_HANDLE || m_cache_path.empty()) return false;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(m_device, m_cache, &size, nullptr) != VK_SUCCESS) return false;
+    std::vector<uint8_t> data(size);
+    VkResult res = vkGetPipelineCacheData(m_device, m_cache, &size, data.data());
+    if (res != VK_SUCCESS && res != VK_INCOMPLETE) return false;
+    data.resize(size);
+
+    CacheFileHeader header;
+    fill_cache_header(header, m_properties);
+    header.data_size = data.size();
+    header.data_hash = fnv1a(data.data(), data.size());
+
+    // Write beside the old file and swap it in, so a crash mid-write never leaves a torn cache
+    const std::string temp_path = m_cache_path + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        SPA_LOG_WARN("Failed to open '{}' to save the pipeline cache.", temp_path);
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = std::fclose(file) == 0 && written;
+
+    std::error_code error;
+    if (written) std::filesystem::rename(temp_path, m_cache_path, error);
+    if (!written || error) {
+        SPA_LOG_WARN("Failed to save the pipeline cache to '{}'.", m_cache_path);
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    SPA_LOG_DEBUG("Saved {} bytes of pipeline cache to '{}'.", data.size(), m_cache_path);
+    return true;
+}
+
+void VulkanPipelineManager::cleanup(VkDevice device) {
+    if (m_cache == VK_NULL_HANDLE) return;
+
+    wait_all();
+    save_cache();
+
+    const uint32_t count = m_pipeline_count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i) {
+        VkPipeline pipeline = m_pipelines[i].pipeline.load(std::memory_order_acquire);
+        if (pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, pipeline, nullptr);
+    }
+    for (auto& [hash, layout] : m_layouts) {
+        vkDestroyPipelineLayout(device, layout, nullptr);
+    }
+    for (Shader& shader : m_shaders) {
+        vkDestroyShaderModule(device, shader.module, nullptr);
+    }
+    vkDestroyPipelineCache(device, m_cache, nullptr);
+
+    m_cache = VK_NULL_HANDLE;
+    m_pipelines.reset();
+    m_pipeline_count = 0;
+    m_pipeline_ids.clear();
+    m_layouts.clear();
+    m_shaders.clear();
+    m_shader_ids.clear();
+    m_dedup_hits = 0;
+    m_compiled_count = 0;
+    m_failed_count = 0;
+    m_compile_ns = 0;
+    m_cache_bytes_loaded = 0;
+}
+
+uint32_t VulkanPipelineManager::load_shader(const char* path) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_shader_ids.find(path);
+        if (it != m_shader_ids.end()) return it->second;
+    }
+
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        SPA_LOG_ERROR("Failed to open shader '{}'.", path);
+        return UINT32_MAX;
+    }
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+
+    std::vector<uint32_t> code(size > 0 ? (static_cast<size_t>(size) + 3) / 4 : 0);
+    const bool read = size > 0 && std::fread(code.data(), 1, static_cast<size_t>(size), file) == static_cast<size_t>(size);
+    std::fclose(file);
+    if (!read) {
+        SPA_LOG_ERROR("Failed to read shader '{}'.", path);
+        return UINT32_MAX;
+    }
+
+    return load_shader(path, code.data(), static_cast<size_t>(size));
+}
+
+uint32_t VulkanPipelineManager::load_shader(const char* name, const uint32_t* code, size_t size_bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_shader_ids.find(name);
+    if (it != m_shader_ids.end()) return it->second;
+
+    if (size_bytes < sizeof(uint32_t) * 5 || size_bytes % sizeof(uint32_t) != 0 || code[0] != SPIRV_MAGIC) {
+        SPA_LOG_ERROR("Shader '{}' is not SPIR-V.", name);
+        return UINT32_MAX;
+    }
+
+    VkShaderModuleCreateInfo module_info = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    module_info.codeSize = size_bytes;
+    module_info.pCode = code;
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(m_device, &module_info, nullptr, &module) != VK_SUCCESS) {
+        SPA_LOG_ERROR("Failed to create shader module '{}'.", name);
+        return UINT32_MAX;
+    }
+
+    const uint32_t id = static_cast<uint32_t>(m_shaders.size());
+    m_shaders.push_back({name, module});
+    m_shader_ids.emplace(name, id);
+    return id;
+}
+
+VkPipelineLayout VulkanPipelineManager::get_or_create_layout(const VulkanPipelineDesc& desc) {
+    uint64_t hash = FNV_OFFSET;
+    hash_value(hash, desc.push_constant_size);
+    hash_value(hash, desc.push_constant_stages);
+    hash_value(hash, desc.set_layout_count);
+    hash = fnv1a(desc.set_layouts, sizeof(desc.set_layouts[0]) * desc.set_layout_count, hash);
+
+    auto it = m_layouts.find(hash);
+    if (it != m_layouts.end()) return it->second;
+
+    VkPushConstantRange push_range{};
+    push_range.stageFlags = desc.push_constant_stages;
+    push_range.size = desc.push_constant_size;
+
+    VkPipelineLayoutCreateInfo layout_info = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    layout_info.setLayoutCount = desc.set_layout_count;
+    layout_info.pSetLayouts = desc.set_layouts;
+    layout_info.pushConstantRangeCount = desc.push_constant_size > 0 ? 1 : 0;
+    layout_info.pPushConstantRanges = &push_range;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if (vkCreatePipelineLayout(m_device, &layout_info, nullptr, &layout) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    m_layouts.emplace(hash, layout);
+    return layout;
+}
+
+uint32_t VulkanPipelineManager::request(const VulkanPipelineDesc& desc) {
+    const uint64_t hash = desc.hash();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto [first, last] = m_pipeline_ids.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        if (m_pipelines[it->second].desc == desc) {
+            m_dedup_hits++;
+            return it->second;
+        }
+    }
+
+    SPA_ASSERT(desc.attribute_count <= VulkanPipelineDesc::MAX_ATTRIBUTES);
+    SPA_ASSERT(desc.set_layout_count <= VulkanPipelineDesc::MAX_SET_LAYOUTS);
+    const bool has_fragment = desc.fragment_shader != UINT32_MAX;
+    if (desc.vertex_shader >= m_shaders.size() || (has_fragment && desc.fragment_shader >= m_shaders.size())) {
+        SPA_LOG_ERROR("Pipeline requested with an unknown shader id.");
+        return UINT32_MAX;
+    }
+
+    const uint32_t id = m_pipeline_count.load(std::memory_order_relaxed);
+    if (id == MAX_PIPELINES) {
+        SPA_LOG_ERROR("Pipeline limit ({}) reached.", MAX_PIPELINES);
+        return UINT32_MAX;
+    }
+
+    VkPipelineLayout layout = get_or_create_layout(desc);
+    if (layout == VK_NULL_HANDLE) {
+        SPA_LOG_ERROR("Failed to create pipeline layout.");
+        return UINT32_MAX;
+    }
+
+    Pipeline& entry = m_pipelines[id];
+    entry.desc = desc;
+    entry.vertex = m_shaders[desc.vertex_shader].module;
+    entry.fragment = has_fragment ? m_shaders[desc.fragment_shader].module : VK_NULL_HANDLE;
+    entry.layout = layout;
+    m_pipeline_ids.emplace(hash, id);
+    m_pipeline_count.store(id + 1, std::memory_order_release);
+
+    // Queued under the lock so wait() on this id always sees the job counted
+    Pipeline* job_entry = &entry;
+    Sparkle::JobSystem::run([this, job_entry] { compile(*job_entry); }, &entry.compile_job);
+    return id;
+}
+
+void VulkanPipelineManager::compile(Pipeline& entry) {
+    SPA_PROFILE_SCOPE("Compile pipeline");
+    const uint64_t start_ns = Sparkle::Profiler::now_ns();
+    const VulkanPipelineDesc& desc = entry.desc;
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = entry.vertex;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = entry.fragment;
+    stages[1].pName = "main";
+
+    VkVertexInputBindingDescription binding{};
+    binding.binding = 0;
+    binding.stride = desc.vertex_stride;
+    binding.inputRate = desc.input_rate;
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    if (desc.vertex_stride > 0) {
+        vertex_input.vertexBindingDescriptionCount = 1;
+        vertex_input.pVertexBindingDescriptions = &binding;
+        vertex_input.vertexAttributeDescriptionCount = desc.attribute_count;
+        vertex_input.pVertexAttributeDescriptions = desc.attributes;
+    }
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+    input_assembly.topology = desc.topology;
+
+    VkPipelineViewportStateCreateInfo viewport = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo raster = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+    raster.polygonMode = desc.polygon_mode;
+    raster.cullMode = desc.cull_mode;
+    raster.frontFace = desc.front_face;
+    raster.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depth = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+    depth.depthTestEnable = desc.depth_test;
+    depth.depthWriteEnable = desc.depth_write;
+    depth.depthCompareOp = desc.depth_compare;
+
+    VkPipelineColorBlendAttachmentState blend_attachment{};
+    blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    if (desc.alpha_blend) {
+        blend_attachment.blendEnable = VK_TRUE;
+        blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+        blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    }
+
+    // Depth-only pipelines under dynamic rendering have no color attachment to blend into
+    const bool has_color = desc.render_pass != VK_NULL_HANDLE || desc.color_format != VK_FORMAT_UNDEFINED;
+    VkPipelineColorBlendStateCreateInfo blend = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+    blend.attachmentCount = has_color ? 1 : 0;
+    blend.pAttachments = has_color ? &blend_attachment : nullptr;
+
+    const VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamic = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dynamic.dynamicStateCount = 2;
+    dynamic.pDynamicStates = dynamic_states;
+
+    VkGraphicsPipelineCreateInfo pipeline_info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    pipeline_info.stageCount = entry.fragment != VK_NULL_HANDLE ? 2 : 1;
+    pipeline_info.pStages = stages;
+    pipeline_info.pVertexInputState = &vertex_input;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport;
+    pipeline_info.pRasterizationState = &raster;
+    pipeline_info.pMultisampleState = &multisample;
+    pipeline_info.pDepthStencilState = &depth;
+    pipeline_info.pColorBlendState = &blend;
+    pipeline_info.pDynamicState = &dynamic;
+    pipeline_info.layout = entry.layout;
+    pipeline_info.renderPass = desc.render_pass;
+    pipeline_info.subpass = desc.subpass;
+
+    // Without a render pass the attachment formats come from here (dynamic rendering)
+    VkPipelineRenderingCreateInfo rendering = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+    if (desc.render_pass == VK_NULL_HANDLE) {
+        rendering.colorAttachmentCount = has_color ? 1 : 0;
+        rendering.pColorAttachmentFormats = &desc.color_format;
+        rendering.depthAttachmentFormat = desc.depth_format;
+        pipeline_info.pNext = &rendering;
+    }
+
+    // The cache is internally synchronized, so compiles on several workers can share it
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    const VkResult res = vkCreateGraphicsPipelines(m_device, m_cache, 1, &pipeline_info, nullptr, &pipeline);
+    m_compile_ns.fetch_add(Sparkle::Profiler::now_ns() - start_ns, std::memory_order_relaxed);
+
+    if (res != VK_SUCCESS) {
+        SPA_LOG_ERROR("Failed to compile pipeline {} ({}).", &entry - m_pipelines.get(), static_cast<i32>(res));
+        m_failed_count.fetch_add(1, std::memory_order_relaxed);
+        entry.state.store(PipelineState::Failed, std::memory_order_release);
+        return;
+    }
+
+    entry.pipeline.store(pipeline, std::memory_order_release);
+    entry.state.store(PipelineState::Ready, std::memory_order_release);
+    m_compiled_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+VkPipeline VulkanPipelineManager::get(uint32_t pipeline) const {
+    if (pipeline >= m_pipeline_count.load(std::memory_order_acquire)) return VK_NULL_HANDLE;
+    return m_pipelines[pipeline].pipeline.load(std::memory_order_acquire);
+}
+
+VkPipelineLayout VulkanPipelineManager::get_layout(uint32_t pipeline) const {
+    if (pipeline >= m_pipeline_count.load(std::memory_order_acquire)) return VK_NULL_HANDLE;
+    return m_pipelines[pipeline].layout;
+}
+
+VkPipeline VulkanPipelineManager::wait(uint32_t pipeline) {
+    if (pipeline >= m_pipeline_count.load(std::memory_order_acquire)) return VK_NULL_HANDLE;
+    Sparkle::JobSystem::wait(m_pipelines[pipeline].compile_job);
+    return m_pipelines[pipeline].pipeline.load(std::memory_order_acquire);
+}
+
+void VulkanPipelineManager::wait_all() {
+    const uint32_t count = m_pipeline_count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i) {
+        Sparkle::JobSystem::wait(m_pipelines[i].compile_job);
+    }
+}
+
+VulkanPipelineStats VulkanPipelineManager::get_stats() const {
+    VulkanPipelineStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.shader_count = static_cast<uint32_t>(m_shaders.size());
+        stats.dedup_hits = m_dedup_hits;
+    }
+    stats.pipeline_count = m_pipeline_count.load(std::memory_order_acquire);
+    stats.compiled_count = m_compiled_count.load(std::memory_order_relaxed);
+    stats.failed_count = m_failed_count.load(std::memory_order_relaxed);
+    stats.compile_ms = static_cast<f64>(m_compile_ns.load(std::memory_order_relaxed)) / 1'000'000.0;
+    stats.cache_bytes_loaded = m_cache_bytes_loaded;
+    return stats;
+}
+
+void VulkanPipelineManager::test() const {
+    const VulkanPipelineStats stats = get_stats();
+    std::cout << "=== VulkanPipelineManager Test ===\n";
+    std::cout << "Cache file: " << (m_cache_path.empty() ? "(none)" : m_cache_path) << "\n";
+    std::cout << "Cache bytes loaded: " << stats.cache_bytes_loaded << "\n";
+    std::cout << "Shaders: " << stats.shader_count << "\n";
+    std::cout << "Pipelines: " << stats.pipeline_count << " (" << stats.compiled_count << " compiled, "
+              << stats.failed_count << " failed, " << stats.dedup_hits << " dedup hits)\n";
+    std::cout << "Compile time: " << stats.compile_ms << " ms\n";
+}
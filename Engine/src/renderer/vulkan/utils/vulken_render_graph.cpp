@@ -0,0 +1,724 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+
+namespace {
+    using Access = VulkanRenderGraph::Access;
+
+    // Layout and synchronization scope of one kind of use
+    struct AccessInfo {
+        VkImageLayout layout;
+        VkPipelineStageFlags2 stages;
+        VkAccessFlags2 access;
+        VkImageUsageFlags usage;
+    };
+
+    constexpr VkAccessFlags2 WRITE_ACCESS = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                                            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                            VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    constexpr VkPipelineStageFlags2 DEPTH_STAGES = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                                                   VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+    AccessInfo access_info(Access access) {
+        switch (access) {
+            case Access::ColorWrite:
+                return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT};
+            case Access::DepthWrite:
+                return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, DEPTH_STAGES,
+                        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT};
+            case Access::DepthRead:
+                return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, DEPTH_STAGES,
+                        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT};
+            case Access::Sampled:
+                return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_USAGE_SAMPLED_BIT};
+            case Access::TransferSrc:
+                return {VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                        VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT};
+            case Access::TransferDst:
+                return {VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                        VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+        }
+        return {};
+    }
+
+    bool is_write(Access access) {
+        return access == Access::ColorWrite || access == Access::DepthWrite || access == Access::TransferDst;
+    }
+
+    bool is_attachment(Access access) {
+        return access == Access::ColorWrite || access == Access::DepthWrite || access == Access::DepthRead;
+    }
+
+    // Who touches an imported image after the graph is done with it
+    void final_layout_scope(VkImageLayout layout, VkPipelineStageFlags2& stages, VkAccessFlags2& access) {
+        switch (layout) {
+            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+                access = VK_ACCESS_2_TRANSFER_READ_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+                access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+                break;
+            default:
+                // Presentation is ordered by the render-finished semaphore; only the layout change matters
+                stages = VK_PIPELINE_STAGE_2_NONE;
+                access = VK_ACCESS_2_NONE;
+                break;
+        }
+    }
+
+    bool is_depth_format(VkFormat format) {
+        return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 ||
+               format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D16_UNORM_S8_UINT ||
+               format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+    VkImageAspectFlags aspect_for(VkFormat format) {
+        if (!is_depth_format(format)) return VK_IMAGE_ASPECT_COLOR_BIT;
+        if (format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+            format == VK_FORMAT_D32_SFLOAT_S8_UINT) {
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    }
+}
+
+VulkanRenderGraph::~VulkanRenderGraph() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanRenderGraph::create(VulkanDevice& device, VkExtent2D extent) {
+    m_device = device.get_logical_device();
+    m_memory = &device.get_memory_allocator();
+    m_extent = extent;
+    m_dirty = true;
+    return VK_SUCCESS;
+}
+
+void VulkanRenderGraph::cleanup(VkDevice device) {
+    if (m_device == VK_NULL_HANDLE) return;
+    SPA_ASSERT(device == m_device);
+    release_transients(nullptr, 0);
+
+    m_passes.clear();
+    m_images.clear();
+    m_schedule.clear();
+    m_barriers.clear();
+    m_final_barrier = 0;
+    m_dirty = true;
+    m_device = VK_NULL_HANDLE;
+    m_memory = nullptr;
+}
+
+// === Declaration ===
+uint32_t VulkanRenderGraph::import_image(const char* name, VkFormat format, VkImageLayout final_layout) {
+    Image image;
+    image.name = name;
+    image.imported = true;
+    image.desc.format = format;
+    image.final_layout = final_layout;
+    m_images.push_back(std::move(image));
+    m_dirty = true;
+    return static_cast<uint32_t>(m_images.size() - 1);
+}
+
+uint32_t VulkanRenderGraph::create_image(const char* name, const ImageDesc& desc) {
+    SPA_ASSERT(desc.format != VK_FORMAT_UNDEFINED);
+    Image image;
+    image.name = name;
+    image.desc = desc;
+    m_images.push_back(std::move(image));
+    m_dirty = true;
+    return static_cast<uint32_t>(m_images.size() - 1);
+}
+
+uint32_t VulkanRenderGraph::add_pass(const char* name, ExecuteFn fn) {
+    Pass pass;
+    pass.name = name;
+    pass.fn = std::move(fn);
+    m_passes.push_back(std::move(pass));
+    m_dirty = true;
+    return static_cast<uint32_t>(m_passes.size() - 1);
+}
+
+void VulkanRenderGraph::write(uint32_t pass, uint32_t image, Access access, const VkClearValue* clear) {
+    SPA_ASSERT(pass < m_passes.size() && image < m_images.size());
+    SPA_ASSERT_MSG(is_write(access), "Render graph write with a read access");
+
+    Use use;
+    use.image = image;
+    use.access = access;
+    use.write = true;
+    use.clear = clear != nullptr;
+    if (clear) use.clear_value = *clear;
+
+    for (const Use& existing : m_passes[pass].uses) {
+        SPA_ASSERT_MSG(existing.image != image, "Render graph image used twice by one pass");
+    }
+    m_passes[pass].uses.push_back(use);
+    m_dirty = true;
+}
+
+void VulkanRenderGraph::read(uint32_t pass, uint32_t image, Access access) {
+    SPA_ASSERT(pass < m_passes.size() && image < m_images.size());
+    SPA_ASSERT_MSG(!is_write(access), "Render graph read with a write access");
+
+    Use use;
+    use.image = image;
+    use.access = access;
+
+    for (const Use& existing : m_passes[pass].uses) {
+        SPA_ASSERT_MSG(existing.image != image, "Render graph image used twice by one pass");
+    }
+    m_passes[pass].uses.push_back(use);
+    m_dirty = true;
+}
+
+void VulkanRenderGraph::set_side_effects(uint32_t pass) {
+    SPA_ASSERT(pass < m_passes.size());
+    m_passes[pass].side_effects = true;
+    m_dirty = true;
+}
+
+void VulkanRenderGraph::clear() {
+    m_passes.clear();
+    m_images.clear();
+    m_dirty = true;
+}
+
+// === Per-frame state ===
+void VulkanRenderGraph::set_image(uint32_t image, VkImage handle, VkImageView view) {
+    SPA_ASSERT(image < m_images.size() && m_images[image].imported);
+    m_images[image].image = handle;
+    m_images[image].view = view;
+}
+
+void VulkanRenderGraph::set_clear_value(uint32_t pass, uint32_t image, const VkClearValue& clear) {
+    SPA_ASSERT(pass < m_passes.size());
+    for (Use& use : m_passes[pass].uses) {
+        if (use.image == image && use.clear) use.clear_value = clear;
+    }
+}
+
+void VulkanRenderGraph::set_rendering_flags(uint32_t pass, VkRenderingFlags flags) {
+    SPA_ASSERT(pass < m_passes.size());
+    m_passes[pass].rendering_flags = flags;
+}
+
+void VulkanRenderGraph::set_extent(VkExtent2D extent) {
+    if (extent.width == m_extent.width && extent.height == m_extent.height) return;
+    m_extent = extent;
+    m_dirty = true;
+}
+
+void VulkanRenderGraph::set_import_format(uint32_t image, VkFormat format) {
+    SPA_ASSERT(image < m_images.size() && m_images[image].imported);
+    if (m_images[image].desc.format == format) return;
+    m_images[image].desc.format = format;
+    m_dirty = true;
+}
+
+// === Compile ===
+VkResult VulkanRenderGraph::compile(VulkanDeletionQueue* deletion_queue, uint64_t frames_submitted) {
+    if (!m_dirty) return VK_SUCCESS;
+    SPA_ASSERT(is_created());
+
+    cull();
+
+    // Live passes in declaration order, and where each image is first and last used among them
+    m_schedule.clear();
+    for (Image& image : m_images) {
+        image.usage = 0;
+        image.first_use = INVALID_ID;
+        image.last_use = INVALID_ID;
+        image.last_stages = 0;
+        image.last_write_access = 0;
+    }
+    for (uint32_t p = 0; p < m_passes.size(); ++p) {
+        if (!m_passes[p].live) continue;
+        const uint32_t index = static_cast<uint32_t>(m_schedule.size());
+        CompiledPass compiled;
+        compiled.pass = p;
+        m_schedule.push_back(compiled);
+
+        for (const Use& use : m_passes[p].uses) {
+            Image& image = m_images[use.image];
+            const AccessInfo info = access_info(use.access);
+            image.usage |= info.usage;
+            if (image.first_use == INVALID_ID) image.first_use = index;
+            image.last_use = index;
+            image.last_stages = info.stages;
+            image.last_write_access = use.write ? info.access & WRITE_ACCESS : 0;
+        }
+    }
+
+    VkResult res = allocate_transients(deletion_queue, frames_submitted);
+    if (res != VK_SUCCESS) return res;
+
+    build_barriers();
+
+    m_dirty = false;
+    m_compile_count++;
+    return VK_SUCCESS;
+}
+
+void VulkanRenderGraph::cull() {
+    // Walk backwards from the imported images: a pass is live if it has side effects or writes something
+    // a later live pass (or the outside world) needs. A clear ends the need for what came before it.
+    std::vector<bool> needed(m_images.size(), false);
+    for (size_t i = 0; i < m_images.size(); ++i) {
+        needed[i] = m_images[i].imported;
+    }
+
+    for (size_t p = m_passes.size(); p-- > 0;) {
+        Pass& pass = m_passes[p];
+        pass.live = pass.side_effects;
+        for (const Use& use : pass.uses) {
+            if (use.write && needed[use.image]) pass.live = true;
+        }
+        if (!pass.live) continue;
+
+        for (const Use& use : pass.uses) {
+            needed[use.image] = !(use.write && use.clear);
+        }
+    }
+}
+
+VkExtent2D VulkanRenderGraph::image_extent(const Image& image) const {
+    if (image.desc.extent.width != 0 && image.desc.extent.height != 0) return image.desc.extent;
+    return {std::max(1u, static_cast<uint32_t>(static_cast<f32>(m_extent.width) * image.desc.scale)),
+            std::max(1u, static_cast<uint32_t>(static_cast<f32>(m_extent.height) * image.desc.scale))};
+}
+
+void VulkanRenderGraph::release_transients(VulkanDeletionQueue* deletion_queue, uint64_t frames_submitted) {
+    std::vector<VulkanAllocation> allocations;
+    for (AliasSlot& slot : m_slots) {
+        allocations.push_back(slot.allocation);
+    }
+    m_slots.clear();
+
+    auto destroy = [images = std::move(m_owned_images), views = std::move(m_owned_views),
+                    allocations = std::move(allocations), memory = m_memory](VkDevice device) mutable {
+        for (VkImageView view : views) {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        for (VkImage image : images) {
+            vkDestroyImage(device, image, nullptr);
+        }
+        for (VulkanAllocation& allocation : allocations) {
+            memory->free(allocation);
+        }
+    };
+    m_owned_images.clear();
+    m_owned_views.clear();
+
+    for (Image& image : m_images) {
+        if (image.imported) continue;
+        image.image = VK_NULL_HANDLE;
+        image.view = VK_NULL_HANDLE;
+        image.slot = INVALID_ID;
+    }
+
+    if (deletion_queue) deletion_queue->push(frames_submitted, std::move(destroy));
+    else destroy(m_device);
+}
+
+VkResult VulkanRenderGraph::allocate_transients(VulkanDeletionQueue* deletion_queue, uint64_t frames_submitted) {
+    // Frames in flight may still use the previous compile's images
+    release_transients(deletion_queue, frames_submitted);
+
+    std::vector<uint32_t> transients;
+    for (uint32_t i = 0; i < m_images.size(); ++i) {
+        Image& image = m_images[i];
+        if (image.imported || image.first_use == INVALID_ID) continue;
+
+        const VkExtent2D extent = image_extent(image);
+        VkImageCreateInfo image_info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent = { extent.width, extent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = image.desc.format;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.usage = image.usage;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkResult res = vkCreateImage(m_device, &image_info, nullptr, &image.image);
+        if (res != VK_SUCCESS) return res;
+        m_owned_images.push_back(image.image);
+
+        vkGetImageMemoryRequirements(m_device, image.image, &image.requirements);
+        transients.push_back(i);
+    }
+
+    // Largest first, each into the first slot whose memory type fits and whose images are all dead
+    // by the time this one is first used (or not yet alive when it is last used)
+    std::sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+        return m_images[a].requirements.size > m_images[b].requirements.size;
+    });
+
+    for (uint32_t index : transients) {
+        Image& image = m_images[index];
+        for (uint32_t s = 0; s < m_slots.size() && image.slot == INVALID_ID; ++s) {
+            AliasSlot& slot = m_slots[s];
+            if ((slot.requirements.memoryTypeBits & image.requirements.memoryTypeBits) == 0) continue;
+
+            bool overlaps = false;
+            for (uint32_t other : slot.images) {
+                const Image& o = m_images[other];
+                if (image.first_use <= o.last_use && o.first_use <= image.last_use) overlaps = true;
+            }
+            if (overlaps) continue;
+
+            slot.requirements.size = std::max(slot.requirements.size, image.requirements.size);
+            slot.requirements.alignment = std::max(slot.requirements.alignment, image.requirements.alignment);
+            slot.requirements.memoryTypeBits &= image.requirements.memoryTypeBits;
+            slot.images.push_back(index);
+            image.slot = s;
+        }
+
+        if (image.slot == INVALID_ID) {
+            AliasSlot slot;
+            slot.requirements = image.requirements;
+            slot.images.push_back(index);
+            image.slot = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back(std::move(slot));
+        }
+    }
+
+    for (AliasSlot& slot : m_slots) {
+        VkResult res = m_memory->allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, false,
+                                          slot.allocation);
+        if (res != VK_SUCCESS) return res;
+
+        std::sort(slot.images.begin(), slot.images.end(), [this](uint32_t a, uint32_t b) {
+            return m_images[a].first_use < m_images[b].first_use;
+        });
+
+        for (uint32_t index : slot.images) {
+            Image& image = m_images[index];
+            res = vkBindImageMemory(m_device, image.image, slot.allocation.memory, slot.allocation.offset);
+            if (res != VK_SUCCESS) return res;
+
+            VkImageViewCreateInfo view_info = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+            view_info.image = image.image;
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = image.desc.format;
+            view_info.subresourceRange.aspectMask = is_depth_format(image.desc.format) ? VK_IMAGE_ASPECT_DEPTH_BIT
+                                                                                        : VK_IMAGE_ASPECT_COLOR_BIT;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.layerCount = 1;
+
+            res = vkCreateImageView(m_device, &view_info, nullptr, &image.view);
+            if (res != VK_SUCCESS) return res;
+            m_owned_views.push_back(image.view);
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+void VulkanRenderGraph::build_barriers() {
+    struct State {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 write_stages = 0;  // Last write (or layout transition) ...
+        VkAccessFlags2 write_access = 0;
+        VkPipelineStageFlags2 synced_stages = 0; // ... and the stages that already waited for it
+        VkPipelineStageFlags2 read_stages = 0;   // Reads since, which a write or transition waits for
+        bool written = false;
+    };
+
+    // The first use in a frame waits for whatever used the memory last: the image that used the same
+    // alias slot before it (the slot's last image of the previous frame for the first one), or for imported
+    // images their own last use, whoever takes them after the graph, and the swapchain acquire semaphore.
+    std::vector<State> states(m_images.size());
+    for (uint32_t i = 0; i < m_images.size(); ++i) {
+        const Image& image = m_images[i];
+        if (image.first_use == INVALID_ID) continue;
+        State& state = states[i];
+
+        if (image.imported) {
+            VkPipelineStageFlags2 final_stages;
+            VkAccessFlags2 final_access;
+            final_layout_scope(image.final_layout, final_stages, final_access);
+            state.write_stages = image.last_stages | final_stages | VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+            state.write_access = image.last_write_access;
+            continue;
+        }
+
+        const std::vector<uint32_t>& slot_images = m_slots[image.slot].images;
+        const auto it = std::find(slot_images.begin(), slot_images.end(), i);
+        const uint32_t previous = it == slot_images.begin() ? slot_images.back() : *(it - 1);
+        state.write_stages = m_images[previous].last_stages;
+        state.write_access = m_images[previous].last_write_access;
+    }
+
+    m_barriers.clear();
+    for (uint32_t index = 0; index < m_schedule.size(); ++index) {
+        CompiledPass& compiled = m_schedule[index];
+        const Pass& pass = m_passes[compiled.pass];
+        compiled.first_barrier = static_cast<uint32_t>(m_barriers.size());
+        compiled.color_count = 0;
+        compiled.depth = Attachment{};
+
+        for (uint32_t u = 0; u < pass.uses.size(); ++u) {
+            const Use& use = pass.uses[u];
+            const Image& image = m_images[use.image];
+            const AccessInfo info = access_info(use.access);
+            State& state = states[use.image];
+
+            Barrier barrier;
+            barrier.image = use.image;
+            barrier.dst_stages = info.stages;
+            barrier.dst_access = info.access;
+            barrier.old_layout = state.layout;
+            barrier.new_layout = info.layout;
+
+            if (use.write) {
+                // Writes wait for every earlier access; a clear discards the old contents
+                barrier.src_stages = state.write_stages | state.read_stages;
+                barrier.src_access = state.write_access;
+                if (use.clear) barrier.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                m_barriers.push_back(barrier);
+
+                state.write_stages = info.stages;
+                state.write_access = info.access & WRITE_ACCESS;
+                state.synced_stages = info.stages;
+                state.read_stages = 0;
+            } else if (state.layout != info.layout) {
+                barrier.src_stages = state.write_stages | state.read_stages;
+                barrier.src_access = state.write_access;
+                m_barriers.push_back(barrier);
+
+                // Later readers only need to wait for the transition, which this use's stages already did
+                state.write_stages = info.stages;
+                state.write_access = 0;
+                state.synced_stages = info.stages;
+                state.read_stages = info.stages;
+            } else if (info.stages & ~state.synced_stages) {
+                // Same layout, but this stage hasn't waited for the last write yet
+                barrier.src_stages = state.write_stages;
+                barrier.src_access = state.write_access;
+                m_barriers.push_back(barrier);
+
+                state.synced_stages |= info.stages;
+                state.read_stages |= info.stages;
+            } else {
+                state.read_stages |= info.stages;
+            }
+            state.layout = info.layout;
+
+            if (!is_attachment(use.access)) {
+                state.written |= use.write;
+                continue;
+            }
+
+            Attachment attachment;
+            attachment.use = u;
+            if (use.clear) attachment.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            else if (state.written) attachment.load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+            // Stored if anything later in the frame (or outside the graph) looks at it
+            if (image.imported || image.last_use > index) attachment.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+            state.written |= use.write;
+
+            if (use.access == Access::ColorWrite) {
+                SPA_ASSERT_MSG(compiled.color_count < MAX_COLOR_ATTACHMENTS, "Too many color attachments in one pass");
+                compiled.colors[compiled.color_count++] = attachment;
+            } else {
+                SPA_ASSERT_MSG(compiled.depth.use == INVALID_ID, "One depth attachment per pass");
+                compiled.depth = attachment;
+            }
+        }
+        compiled.barrier_count = static_cast<uint32_t>(m_barriers.size()) - compiled.first_barrier;
+    }
+
+    // Hand imported images over in the layout their owner expects
+    m_final_barrier = static_cast<uint32_t>(m_barriers.size());
+    for (uint32_t i = 0; i < m_images.size(); ++i) {
+        const Image& image = m_images[i];
+        if (!image.imported || image.first_use == INVALID_ID) continue;
+        const State& state = states[i];
+
+        Barrier barrier;
+        barrier.image = i;
+        barrier.src_stages = state.write_stages | state.read_stages;
+        barrier.src_access = state.write_access;
+        final_layout_scope(image.final_layout, barrier.dst_stages, barrier.dst_access);
+        barrier.old_layout = state.layout;
+        barrier.new_layout = image.final_layout;
+        if (barrier.old_layout != barrier.new_layout || barrier.dst_stages != VK_PIPELINE_STAGE_2_NONE) {
+            m_barriers.push_back(barrier);
+        }
+    }
+}
+
+// === Execute ===
+void VulkanRenderGraph::record_barriers(VkCommandBuffer cmd, uint32_t first, uint32_t count) {
+    if (count == 0) return;
+
+    m_scratch.clear();
+    for (uint32_t b = first; b < first + count; ++b) {
+        const Barrier& barrier = m_barriers[b];
+        const Image& image = m_images[barrier.image];
+        SPA_ASSERT_MSG(image.image != VK_NULL_HANDLE, "Render graph image has no VkImage (set_image not called?)");
+
+        VkImageMemoryBarrier2 vk_barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+        vk_barrier.srcStageMask = barrier.src_stages;
+        vk_barrier.srcAccessMask = barrier.src_access;
+        vk_barrier.dstStageMask = barrier.dst_stages;
+        vk_barrier.dstAccessMask = barrier.dst_access;
+        vk_barrier.oldLayout = barrier.old_layout;
+        vk_barrier.newLayout = barrier.new_layout;
+        vk_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vk_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vk_barrier.image = image.image;
+        vk_barrier.subresourceRange.aspectMask = aspect_for(image.desc.format);
+        vk_barrier.subresourceRange.levelCount = 1;
+        vk_barrier.subresourceRange.layerCount = 1;
+        m_scratch.push_back(vk_barrier);
+    }
+
+    VkDependencyInfo dependency = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dependency.imageMemoryBarrierCount = static_cast<uint32_t>(m_scratch.size());
+    dependency.pImageMemoryBarriers = m_scratch.data();
+    vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+VkResult VulkanRenderGraph::execute(VkCommandBuffer cmd, VulkanGpuTimer* timer, uint32_t frame,
+                                    VulkanDeletionQueue* deletion_queue, uint64_t frames_submitted) {
+    VkResult res = compile(deletion_queue, frames_submitted);
+    if (res != VK_SUCCESS) return res;
+
+    for (const CompiledPass& compiled : m_schedule) {
+        const Pass& pass = m_passes[compiled.pass];
+        record_barriers(cmd, compiled.first_barrier, compiled.barrier_count);
+
+        PassContext ctx;
+        ctx.cmd = cmd;
+        ctx.frame = frame;
+        ctx.extent = m_extent;
+
+        if (timer) timer->begin_zone(cmd, frame, pass.name);
+        if (compiled.color_count == 0 && compiled.depth.use == INVALID_ID) {
+            if (pass.fn) pass.fn(ctx);
+            if (timer) timer->end_zone(cmd, frame);
+            continue;
+        }
+
+        auto attachment_info = [&](const Attachment& attachment) {
+            const Use& use = pass.uses[attachment.use];
+            const Image& image = m_images[use.image];
+            VkRenderingAttachmentInfo info = { VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+            info.imageView = image.view;
+            info.imageLayout = access_info(use.access).layout;
+            info.loadOp = attachment.load_op;
+            info.storeOp = attachment.store_op;
+            info.clearValue = use.clear_value;
+            ctx.extent = image.imported ? m_extent : image_extent(image);
+            return info;
+        };
+
+        VkRenderingAttachmentInfo colors[MAX_COLOR_ATTACHMENTS];
+        for (uint32_t c = 0; c < compiled.color_count; ++c) {
+            colors[c] = attachment_info(compiled.colors[c]);
+        }
+        VkRenderingAttachmentInfo depth = { VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+        if (compiled.depth.use != INVALID_ID) depth = attachment_info(compiled.depth);
+
+        // Secondaries and pipelines see the first color attachment's format
+        if (compiled.color_count > 0) {
+            ctx.target.color_format = m_images[pass.uses[compiled.colors[0].use].image].desc.format;
+        }
+        if (compiled.depth.use != INVALID_ID) {
+            ctx.target.depth_format = m_images[pass.uses[compiled.depth.use].image].desc.format;
+        }
+
+        VkRenderingInfo rendering_info = { VK_STRUCTURE_TYPE_RENDERING_INFO };
+        rendering_info.flags = pass.rendering_flags;
+        rendering_info.renderArea.extent = ctx.extent;
+        rendering_info.layerCount = 1;
+        rendering_info.colorAttachmentCount = compiled.color_count;
+        rendering_info.pColorAttachments = colors;
+        rendering_info.pDepthAttachment = compiled.depth.use != INVALID_ID ? &depth : nullptr;
+        vkCmdBeginRendering(cmd, &rendering_info);
+
+        // Inline passes get the viewport and scissor every pipeline leaves dynamic; secondaries set their own
+        if (!(pass.rendering_flags & VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT)) {
+            const VkViewport viewport = {0.0f, 0.0f, static_cast<f32>(ctx.extent.width),
+                                         static_cast<f32>(ctx.extent.height), 0.0f, 1.0f};
+            const VkRect2D scissor = {{0, 0}, ctx.extent};
+            vkCmdSetViewport(cmd, 0, 1, &viewport);
+            vkCmdSetScissor(cmd, 0, 1, &scissor);
+        }
+
+        if (pass.fn) pass.fn(ctx);
+
+        vkCmdEndRendering(cmd);
+        if (timer) timer->end_zone(cmd, frame);
+    }
+
+    record_barriers(cmd, m_final_barrier, static_cast<uint32_t>(m_barriers.size()) - m_final_barrier);
+    return VK_SUCCESS;
+}
+
+// === Queries ===
+VkImage VulkanRenderGraph::get_image(uint32_t image) const {
+    SPA_ASSERT(image < m_images.size());
+    return m_images[image].image;
+}
+
+VkImageView VulkanRenderGraph::get_view(uint32_t image) const {
+    SPA_ASSERT(image < m_images.size());
+    return m_images[image].view;
+}
+
+VkFormat VulkanRenderGraph::get_format(uint32_t image) const {
+    SPA_ASSERT(image < m_images.size());
+    return m_images[image].desc.format;
+}
+
+bool VulkanRenderGraph::is_culled(uint32_t pass) const {
+    SPA_ASSERT(pass < m_passes.size());
+    return !m_passes[pass].live;
+}
+
+VulkanRenderGraphStats VulkanRenderGraph::get_stats() const {
+    VulkanRenderGraphStats stats;
+    stats.pass_count = static_cast<uint32_t>(m_passes.size());
+    stats.culled_count = stats.pass_count - static_cast<uint32_t>(m_schedule.size());
+    stats.barrier_count = static_cast<uint32_t>(m_barriers.size());
+    stats.transient_count = static_cast<uint32_t>(m_owned_images.size());
+    for (const Image& image : m_images) {
+        if (!image.imported && image.image != VK_NULL_HANDLE) stats.transient_bytes += image.requirements.size;
+    }
+    for (const AliasSlot& slot : m_slots) {
+        stats.allocated_bytes += slot.requirements.size;
+    }
+    stats.compile_count = m_compile_count;
+    return stats;
+}
+
+void VulkanRenderGraph::test() const {
+    const VulkanRenderGraphStats stats = get_stats();
+    std::cout << "=== VulkanRenderGraph Test ===\n";
+    std::cout << "Extent: " << m_extent.width << " x " << m_extent.height << "\n";
+    std::cout << "Passes: " << stats.pass_count << " (" << stats.culled_count << " culled)\n";
+    for (const CompiledPass& compiled : m_schedule) {
+        std::cout << "  " << m_passes[compiled.pass].name << ": " << compiled.barrier_count << " barriers, "
+                  << compiled.color_count << " color" << (compiled.depth.use != INVALID_ID ? " + depth" : "") << "\n";
+    }
+    std::cout << "Barriers per frame: " << stats.barrier_count << "\n";
+    std::cout << "Transient images: " << stats.transient_count << " (" << stats.transient_bytes << " bytes in "
+              << m_slots.size() << " slots, " << stats.allocated_bytes << " bytes allocated)\n";
+    std::cout << "Compiles: " << stats.compile_count << "\n";
+}
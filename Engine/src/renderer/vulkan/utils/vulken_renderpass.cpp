@@ -16,7 +16,13 @@ void VulkanRenderPass::cleanup(VkDevice device) {
     }
 }
 
-VkResult VulkanRenderPass::create(VkDevice device, VkFormat color_format, VkFormat depth_format) {
+VkRenderPass VulkanRenderPass::release() {
+    VkRenderPass render_pass = m_render_pass;
+    m_render_pass = VK_NULL_HANDLE;
+    return render_pass;
+}
+
+VkResult VulkanRenderPass::create(VkDevice device, VkFormat color_format, VkFormat depth_format, VkImageLayout color_final_layout) {
     // === Color attachment description ===
     VkAttachmentDescription color_attachment{};
     color_attachment.format = color_format;
@@ -26,7 +32,7 @@ VkResult VulkanRenderPass::create(VkDevice device, VkFormat color_format, VkForm
     color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    color_attachment.finalLayout = color_final_layout;
 
     // === Depth attachment description ===
     VkAttachmentDescription depth_attachment{};
@@ -0,0 +1,324 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+
+// Vertex shader push constants: pixels to normalized device coordinates
+struct SpritePushConstants {
+    float scale[2];
+};
+
+VulkanSpriteRenderer::~VulkanSpriteRenderer() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanSpriteRenderer::create(VulkanDevice& device, VulkanPipelineManager& pipelines, const VulkanPassTarget& target,
+                                      uint32_t max_frames_in_flight, const char* shader_dir, uint32_t capacity) {
+    m_device = device.get_logical_device();
+    m_memory = &device.get_memory_allocator();
+    m_pipelines = &pipelines;
+    m_frame_count = max_frames_in_flight;
+
+    const std::string dir = shader_dir;
+    m_vertex_shader = pipelines.load_shader((dir + "/sprite.vert.spv").c_str());
+    m_fragment_shader = pipelines.load_shader((dir + "/sprite.frag.spv").c_str());
+    m_textured_shader = pipelines.load_shader((dir + "/sprite_textured.frag.spv").c_str());
+    if (m_vertex_shader == UINT32_MAX || m_fragment_shader == UINT32_MAX || m_textured_shader == UINT32_MAX) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkResult res = create_buffer(std::max(capacity, 1u));
+    if (res != VK_SUCCESS) return res;
+
+    res = create_descriptors();
+    if (res != VK_SUCCESS) return res;
+
+    set_target(target);
+    return VK_SUCCESS;
+}
+
+VkResult VulkanSpriteRenderer::create_descriptors() {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layout_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    VkResult res = vkCreateDescriptorSetLayout(m_device, &layout_info, nullptr, &m_set_layout);
+    if (res != VK_SUCCESS) return res;
+
+    // Trilinear over whatever mips are resident; the view's level range is what limits detail
+    VkSamplerCreateInfo sampler_info = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+    res = vkCreateSampler(m_device, &sampler_info, nullptr, &m_sampler);
+    if (res != VK_SUCCESS) return res;
+
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURE_SETS};
+    VkDescriptorPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.maxSets = MAX_TEXTURE_SETS;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    m_descriptor_pools.assign(m_frame_count, VK_NULL_HANDLE);
+    for (VkDescriptorPool& pool : m_descriptor_pools) {
+        res = vkCreateDescriptorPool(m_device, &pool_info, nullptr, &pool);
+        if (res != VK_SUCCESS) return res;
+    }
+    return VK_SUCCESS;
+}
+
+void VulkanSpriteRenderer::cleanup(VkDevice device) {
+    if (m_buffer != VK_NULL_HANDLE) {
+        m_memory->destroy_buffer(m_buffer, m_allocation);
+    }
+    for (VkDescriptorPool pool : m_descriptor_pools) {
+        if (pool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    m_descriptor_pools.clear();
+    if (m_sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(device, m_sampler, nullptr);
+        m_sampler = VK_NULL_HANDLE;
+    }
+    if (m_set_layout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, m_set_layout, nullptr);
+        m_set_layout = VK_NULL_HANDLE;
+    }
+    m_batch_sets.clear();
+    m_frame_sets.clear();
+    m_sets_exhausted = false;
+    m_capacity = 0;
+    m_offset = 0;
+    m_vertex_shader = m_fragment_shader = m_textured_shader = UINT32_MAX;
+    for (uint32_t& pipeline : m_material_pipelines) pipeline = UINT32_MAX;
+    for (uint32_t& pipeline : m_textured_pipelines) pipeline = UINT32_MAX;
+    m_texture_view = nullptr;
+    m_batch = {};
+    m_pipelines = nullptr;
+    m_memory = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+VkResult VulkanSpriteRenderer::create_buffer(uint32_t capacity) {
+    VkBufferCreateInfo buffer_info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    buffer_info.size = static_cast<VkDeviceSize>(capacity) * sizeof(Sparkle::Quad) * m_frame_count;
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // Written once by the CPU and read once by the GPU each frame, so it stays in host memory
+    VkResult res = m_memory->create_buffer(buffer_info,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                           m_buffer, m_allocation);
+    if (res != VK_SUCCESS) return res;
+    SPA_ASSERT(m_allocation.mapped != nullptr);
+    m_capacity = capacity;
+    return VK_SUCCESS;
+}
+
+void VulkanSpriteRenderer::set_target(const VulkanPassTarget& target) {
+    VulkanPipelineDesc desc;
+    desc.vertex_shader = m_vertex_shader;
+    desc.fragment_shader = m_fragment_shader;
+    desc.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP; // 4 vertices per instance, corners from gl_VertexIndex
+    desc.depth_test = false;
+    desc.depth_write = false;
+    desc.push_constant_size = sizeof(SpritePushConstants);
+    desc.push_constant_stages = VK_SHADER_STAGE_VERTEX_BIT;
+
+    desc.vertex_stride = sizeof(Sparkle::Quad);
+    desc.input_rate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    desc.attribute_count = 4;
+    desc.attributes[0] = {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Sparkle::Quad, position)}; // position + size
+    desc.attributes[1] = {1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Sparkle::Quad, uv)};
+    desc.attributes[2] = {2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(Sparkle::Quad, color)};
+    desc.attributes[3] = {3, 0, VK_FORMAT_R32_SFLOAT, offsetof(Sparkle::Quad, rotation)};
+    desc.set_target(target);
+
+    for (uint32_t material = 0; material < MATERIAL_COUNT; ++material) {
+        desc.alpha_blend = material == 0;
+        m_material_pipelines[material] = m_pipelines->request(desc);
+    }
+
+    if (m_set_layout == VK_NULL_HANDLE) return;
+    desc.fragment_shader = m_textured_shader;
+    desc.set_layout_count = 1;
+    desc.set_layouts[0] = m_set_layout;
+    for (uint32_t material = 0; material < MATERIAL_COUNT; ++material) {
+        desc.alpha_blend = material == 0;
+        m_textured_pipelines[material] = m_pipelines->request(desc);
+    }
+}
+
+void VulkanSpriteRenderer::wait_ready() {
+    for (uint32_t pipeline : m_material_pipelines) {
+        if (pipeline != UINT32_MAX) m_pipelines->wait(pipeline);
+    }
+    for (uint32_t pipeline : m_textured_pipelines) {
+        if (pipeline != UINT32_MAX) m_pipelines->wait(pipeline);
+    }
+}
+
+bool VulkanSpriteRenderer::prepare(uint32_t frame, const Sparkle::Quad* quads, uint32_t count, VkExtent2D extent,
+                                   VulkanDeletionQueue& deletion_queue, uint64_t frames_submitted) {
+    SPA_ASSERT(frame < m_frame_count);
+    m_extent = extent;
+
+    if (count > m_capacity) {
+        // Frames in flight keep drawing from the old buffer until they retire
+        if (m_buffer != VK_NULL_HANDLE) {
+            VkBuffer old_buffer = m_buffer;
+            VulkanAllocation old_allocation = m_allocation;
+            deletion_queue.push(frames_submitted, [memory = m_memory, old_buffer, old_allocation](VkDevice) mutable {
+                memory->destroy_buffer(old_buffer, old_allocation);
+            });
+        }
+
+        // Grow geometrically so a steadily rising count doesn't reallocate every frame
+        uint32_t capacity = std::max(m_capacity, 1u);
+        while (capacity < count) capacity = capacity > UINT32_MAX / 2 ? count : capacity * 2;
+
+        m_buffer = VK_NULL_HANDLE;
+        m_allocation = {};
+        if (create_buffer(capacity) != VK_SUCCESS) {
+            SPA_LOG_ERROR("Failed to grow the sprite instance buffer to {} quads.", capacity);
+            m_batch.build(nullptr, 0, nullptr);
+            m_capacity = 0;
+            return false;
+        }
+        SPA_LOG_DEBUG("Sprite instance buffer grown to {} quads per frame.", capacity);
+    }
+
+    m_offset = static_cast<VkDeviceSize>(frame) * m_capacity * sizeof(Sparkle::Quad);
+    auto* region = reinterpret_cast<Sparkle::Quad*>(static_cast<uint8_t*>(m_allocation.mapped) + m_offset);
+    m_batch.build(quads, count, region);
+    write_texture_sets(frame);
+    return true;
+}
+
+void VulkanSpriteRenderer::write_texture_sets(uint32_t frame) {
+    const std::vector<Sparkle::QuadBatch>& batches = m_batch.get_batches();
+    m_batch_sets.assign(batches.size(), VK_NULL_HANDLE);
+    if (!m_texture_view || m_descriptor_pools.empty()) return;
+
+    // The frame's fence has signaled, so none of its sets are still in use. Views are fetched every
+    // frame since a finished stream replaces them.
+    VkDescriptorPool pool = m_descriptor_pools[frame];
+    vkResetDescriptorPool(m_device, pool, 0);
+    m_frame_sets.clear();
+
+    for (size_t i = 0; i < batches.size(); ++i) {
+        const uint16_t texture = batches[i].texture;
+        if (texture == 0) continue;
+
+        auto it = m_frame_sets.find(texture);
+        if (it != m_frame_sets.end()) {
+            m_batch_sets[i] = it->second;
+            continue;
+        }
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        const VkImageView view = m_texture_view(texture);
+        if (view != VK_NULL_HANDLE) {
+            if (m_frame_sets.size() == MAX_TEXTURE_SETS) {
+                if (!m_sets_exhausted) {
+                    SPA_LOG_WARN("More than {} textures in one frame of quads; the rest draw untextured.", MAX_TEXTURE_SETS);
+                    m_sets_exhausted = true;
+                }
+            } else {
+                VkDescriptorSetAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+                alloc_info.descriptorPool = pool;
+                alloc_info.descriptorSetCount = 1;
+                alloc_info.pSetLayouts = &m_set_layout;
+                if (vkAllocateDescriptorSets(m_device, &alloc_info, &set) == VK_SUCCESS) {
+                    VkDescriptorImageInfo image_info{};
+                    image_info.sampler = m_sampler;
+                    image_info.imageView = view;
+                    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+                    VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                    write.dstSet = set;
+                    write.dstBinding = 0;
+                    write.descriptorCount = 1;
+                    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    write.pImageInfo = &image_info;
+                    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+                } else {
+                    set = VK_NULL_HANDLE;
+                }
+            }
+        }
+        // Cached even when null, so a texture that isn't resident is only looked up once per frame
+        m_frame_sets.emplace(texture, set);
+        m_batch_sets[i] = set;
+    }
+}
+
+void VulkanSpriteRenderer::record(VkCommandBuffer cmd) const {
+    const std::vector<Sparkle::QuadBatch>& batches = m_batch.get_batches();
+    if (batches.empty()) return;
+
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(m_extent.width);
+    viewport.height = static_cast<float>(m_extent.height);
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    VkRect2D scissor{{0, 0}, m_extent};
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+    vkCmdBindVertexBuffers(cmd, 0, 1, &m_buffer, &m_offset);
+
+    // Every material shares the push constant layout
+    const SpritePushConstants push = {{2.0f / static_cast<float>(m_extent.width),
+                                       2.0f / static_cast<float>(m_extent.height)}};
+    uint32_t bound_pipeline = UINT32_MAX;
+    VkDescriptorSet bound_set = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    for (size_t i = 0; i < batches.size(); ++i) {
+        const Sparkle::QuadBatch& batch = batches[i];
+        const uint32_t material = batch.material < MATERIAL_COUNT ? batch.material : 0;
+        // Batches whose texture isn't resident yet (or whose textured pipeline is compiling) draw untextured
+        VkDescriptorSet set = i < m_batch_sets.size() ? m_batch_sets[i] : VK_NULL_HANDLE;
+        uint32_t id = m_material_pipelines[material];
+        if (set != VK_NULL_HANDLE && m_pipelines->get(m_textured_pipelines[material]) != VK_NULL_HANDLE) {
+            id = m_textured_pipelines[material];
+        } else {
+            set = VK_NULL_HANDLE;
+        }
+
+        if (id != bound_pipeline) {
+            pipeline = m_pipelines->get(id);
+            bound_pipeline = id;
+            bound_set = VK_NULL_HANDLE;
+            if (pipeline == VK_NULL_HANDLE) continue;
+
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdPushConstants(cmd, m_pipelines->get_layout(id), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+        }
+        if (pipeline == VK_NULL_HANDLE) continue;
+
+        if (set != VK_NULL_HANDLE && set != bound_set) {
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines->get_layout(id), 0, 1, &set,
+                                    0, nullptr);
+            bound_set = set;
+        }
+        vkCmdDraw(cmd, 4, batch.count, 0, batch.first);
+    }
+}
+
+void VulkanSpriteRenderer::test() const {
+    std::cout << "=== VulkanSpriteRenderer Test ===\n";
+    std::cout << "Capacity: " << m_capacity << " quads x " << m_frame_count << " frames ("
+              << static_cast<VkDeviceSize>(m_capacity) * m_frame_count * sizeof(Sparkle::Quad) / 1024 << " KiB)\n";
+    std::cout << "Mapped: " << (m_allocation.mapped ? "yes" : "no") << "\n";
+    std::cout << "Material pipelines: " << m_material_pipelines[0] << ", " << m_material_pipelines[1] << "\n";
+    std::cout << "Textured: " << (m_set_layout != VK_NULL_HANDLE ? "yes" : "no") << "\n";
+}
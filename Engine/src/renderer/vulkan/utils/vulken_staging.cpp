@@ -0,0 +1,272 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+
+VulkanStagingRing::~VulkanStagingRing() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanStagingRing::create(VulkanDevice& device, uint32_t max_frames_in_flight, VkDeviceSize region_size) {
+    if (!device.supports_timeline_semaphores()) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    m_device = device.get_logical_device();
+    m_memory = &device.get_memory_allocator();
+    m_queue = device.get_transfer_queue();
+    m_transfer_family = device.get_transfer_queue_family();
+    m_graphics_family = device.get_graphics_queue_family();
+    m_region_size = region_size;
+
+    VkBufferCreateInfo buffer_info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    buffer_info.size = region_size * max_frames_in_flight;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkResult res = m_memory->create_buffer(buffer_info,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                           m_buffer, m_allocation);
+    if (res != VK_SUCCESS) return res;
+    SPA_ASSERT(m_allocation.mapped != nullptr);
+
+    VkSemaphoreTypeCreateInfo type_info = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    semaphore_info.pNext = &type_info;
+    res = vkCreateSemaphore(m_device, &semaphore_info, nullptr, &m_timeline);
+    if (res != VK_SUCCESS) return res;
+    m_timeline_value = 0;
+
+    m_regions.resize(max_frames_in_flight);
+    for (Region& region : m_regions) {
+        res = region.pool.create(m_device, m_transfer_family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        if (res != VK_SUCCESS) return res;
+
+        res = region.pool.allocate_buffers(m_device, 1);
+        if (res != VK_SUCCESS) return res;
+        region.cmd = region.pool.get_buffers()[0];
+
+        // Upload batches are usually small; keep steady-state frames off the heap
+        region.releases.reserve(64);
+        region.acquires.reserve(64);
+        region.image_releases.reserve(16);
+        region.image_acquires.reserve(16);
+    }
+    m_pending_acquires.reserve(64);
+    m_pending_image_acquires.reserve(16);
+
+    m_current = 0;
+    open_region(0);
+    return VK_SUCCESS;
+}
+
+void VulkanStagingRing::cleanup(VkDevice device) {
+    for (Region& region : m_regions) {
+        region.pool.cleanup(device);
+    }
+    m_regions.clear();
+    m_pending_acquires.clear();
+    m_pending_image_acquires.clear();
+
+    if (m_timeline != VK_NULL_HANDLE) {
+        vkDestroySemaphore(device, m_timeline, nullptr);
+        m_timeline = VK_NULL_HANDLE;
+    }
+    if (m_memory) {
+        m_memory->destroy_buffer(m_buffer, m_allocation);
+        m_memory = nullptr;
+    }
+    m_device = VK_NULL_HANDLE;
+}
+
+bool VulkanStagingRing::stage(const void* data, VkDeviceSize size, VkDeviceSize& src_offset) {
+    Region& region = m_regions[m_current];
+
+    const VkDeviceSize offset = (region.offset + 15) & ~VkDeviceSize(15);
+    if (size > m_region_size || offset + size > m_region_size) {
+        if (size > m_region_size) {
+            SPA_LOG_ERROR("Upload of {} bytes exceeds the {} byte staging region.", size, m_region_size);
+        }
+        return false;
+    }
+
+    src_offset = m_region_size * m_current + offset;
+    std::memcpy(static_cast<u8*>(m_allocation.mapped) + src_offset, data, size);
+    region.offset = offset + size;
+
+    if (!region.recording) {
+        VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(region.cmd, &begin_info);
+        region.recording = true;
+    }
+    m_bytes_uploaded += size;
+    return true;
+}
+
+bool VulkanStagingRing::upload_buffer(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dst_offset) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    VkDeviceSize src_offset = 0;
+    if (!stage(data, size, src_offset)) return false;
+    Region& region = m_regions[m_current];
+
+    VkBufferCopy copy = {};
+    copy.srcOffset = src_offset;
+    copy.dstOffset = dst_offset;
+    copy.size = size;
+    vkCmdCopyBuffer(region.cmd, m_buffer, dst, 1, &copy);
+
+    // Exclusive buffers written on another family must be released here and acquired by graphics
+    if (m_transfer_family != m_graphics_family) {
+        VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+        barrier.srcQueueFamilyIndex = m_transfer_family;
+        barrier.dstQueueFamilyIndex = m_graphics_family;
+        barrier.buffer = dst;
+        barrier.offset = dst_offset;
+        barrier.size = size;
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        region.releases.push_back(barrier);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        region.acquires.push_back(barrier);
+    }
+    return true;
+}
+
+bool VulkanStagingRing::upload_image(const void* data, VkDeviceSize size, VkImage dst, uint32_t mip_level,
+                                     VkExtent2D extent) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    VkDeviceSize src_offset = 0;
+    if (!stage(data, size, src_offset)) return false;
+    Region& region = m_regions[m_current];
+
+    VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dst;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, mip_level, 1, 0, 1 };
+
+    // The level's previous contents (none) are discarded
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(region.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy copy = {};
+    copy.bufferOffset = src_offset;
+    copy.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip_level, 0, 1 };
+    copy.imageExtent = { extent.width, extent.height, 1 };
+    vkCmdCopyBufferToImage(region.cmd, m_buffer, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+    // Into the sampling layout at the end of the batch; across families that is the release half of an
+    // ownership transfer and record_acquire() performs the same transition on graphics
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    if (m_transfer_family != m_graphics_family) {
+        barrier.srcQueueFamilyIndex = m_transfer_family;
+        barrier.dstQueueFamilyIndex = m_graphics_family;
+        region.image_releases.push_back(barrier);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        region.image_acquires.push_back(barrier);
+    } else {
+        region.image_releases.push_back(barrier);
+    }
+    return true;
+}
+
+uint64_t VulkanStagingRing::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Region& region = m_regions[m_current];
+
+    m_pending_acquires.clear();
+    m_pending_image_acquires.clear();
+    if (!region.recording) return 0;
+
+    if (!region.releases.empty() || !region.image_releases.empty()) {
+        vkCmdPipelineBarrier(region.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, static_cast<uint32_t>(region.releases.size()), region.releases.data(),
+                             static_cast<uint32_t>(region.image_releases.size()), region.image_releases.data());
+    }
+    vkEndCommandBuffer(region.cmd);
+    region.recording = false;
+
+    const uint64_t signal_value = ++m_timeline_value;
+
+    VkTimelineSemaphoreSubmitInfo timeline_info = { VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
+    timeline_info.signalSemaphoreValueCount = 1;
+    timeline_info.pSignalSemaphoreValues = &signal_value;
+
+    VkSubmitInfo submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submit_info.pNext = &timeline_info;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &region.cmd;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &m_timeline;
+
+    if (vkQueueSubmit(m_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+        SPA_LOG_ERROR("Failed to submit staging uploads; dropping the batch.");
+        --m_timeline_value;
+        open_region(m_current);
+        return 0;
+    }
+    region.timeline_value = signal_value;
+
+    // The graphics side acquires what this batch released
+    m_pending_acquires.swap(region.acquires);
+    m_pending_image_acquires.swap(region.image_acquires);
+
+    m_current = (m_current + 1) % static_cast<uint32_t>(m_regions.size());
+    open_region(m_current);
+    return signal_value;
+}
+
+void VulkanStagingRing::open_region(uint32_t index) {
+    Region& region = m_regions[index];
+
+    // Normally long done: the graphics frame that waited on this batch has passed its fence
+    if (region.timeline_value != 0) {
+        VkSemaphoreWaitInfo wait_info = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+        wait_info.semaphoreCount = 1;
+        wait_info.pSemaphores = &m_timeline;
+        wait_info.pValues = &region.timeline_value;
+        vkWaitSemaphores(m_device, &wait_info, UINT64_MAX);
+    }
+
+    region.pool.reset(m_device);
+    region.offset = 0;
+    region.recording = false;
+    region.releases.clear();
+    region.acquires.clear();
+    region.image_releases.clear();
+    region.image_acquires.clear();
+}
+
+void VulkanStagingRing::record_acquire(VkCommandBuffer cmd) const {
+    if (m_pending_acquires.empty() && m_pending_image_acquires.empty()) return;
+
+    vkCmdPipelineBarrier(cmd, CONSUMER_STAGES, CONSUMER_STAGES, 0,
+                         0, nullptr, static_cast<uint32_t>(m_pending_acquires.size()), m_pending_acquires.data(),
+                         static_cast<uint32_t>(m_pending_image_acquires.size()), m_pending_image_acquires.data());
+}
+
+void VulkanStagingRing::test() const {
+    std::cout << "=== VulkanStagingRing Test ===\n";
+    std::cout << "Regions: " << m_regions.size() << " x " << m_region_size / 1024 << " KiB\n";
+    std::cout << "Queue family: " << m_transfer_family
+              << (m_transfer_family != m_graphics_family ? " (dedicated transfer)" : " (graphics)") << "\n";
+    std::cout << "Mapped: " << (m_allocation.mapped ? "yes" : "no") << "\n";
+}
@@ -6,6 +6,13 @@ VulkanSwapchain::~VulkanSwapchain() {
 }
 
 VkResult VulkanSwapchain::create(VulkanDevice& device, VkSurfaceKHR surface, uint32_t width, uint32_t height) {
+    VkResult result = create_swapchain(device, surface, width, height);
+    if (result != VK_SUCCESS) return result;
+
+    return create_targets(device);
+}
+
+VkResult VulkanSwapchain::create_swapchain(VulkanDevice& device, VkSurfaceKHR surface, uint32_t width, uint32_t height) {
     VkDevice vk_device = device.get_logical_device();
     VkPhysicalDevice phys_device = device.get_physical_device();
 
@@ -34,6 +41,7 @@ VkResult VulkanSwapchain::create(VulkanDevice& device, VkSurfaceKHR surface, uin
 
     m_format = surface_format.format;
     m_extent = extent;
+    m_present_mode = present_mode;
 
     // 4. Setup swapchain create info
     uint32_t image_count = surface_capabilities.minImageCount + 1;
@@ -65,38 +73,48 @@ VkResult VulkanSwapchain::create(VulkanDevice& device, VkSurfaceKHR surface, uin
     swapchain_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchain_info.presentMode = present_mode;
     swapchain_info.clipped = VK_TRUE;
+    // Lets the driver hand over resources from the old swapchain; it is retired either way,
+    // and the caller destroys it once no frame in flight can present from it
     swapchain_info.oldSwapchain = m_swapchain;
 
     // 5. Create swapchain
+    m_swapchain = VK_NULL_HANDLE;
     VkResult result = vkCreateSwapchainKHR(vk_device, &swapchain_info, nullptr, &m_swapchain);
     if (result != VK_SUCCESS) {
         std::cerr << "Failed to create swapchain!\n";
+        m_swapchain = VK_NULL_HANDLE;
         return result;
     }
 
-    // If we have an old swapchain, destroy it (recreation case)
-    if (swapchain_info.oldSwapchain != VK_NULL_HANDLE) {
-        vkDestroySwapchainKHR(vk_device, swapchain_info.oldSwapchain, nullptr);
-    }
-
     // 6. Get swapchain images
     uint32_t swapchain_image_count = 0;
     vkGetSwapchainImagesKHR(vk_device, m_swapchain, &swapchain_image_count, nullptr);
     m_images.resize(swapchain_image_count);
     vkGetSwapchainImagesKHR(vk_device, m_swapchain, &swapchain_image_count, m_images.data());
 
+    return VK_SUCCESS;
+}
+
+VkResult VulkanSwapchain::create_targets(VulkanDevice& device) {
+    VkDevice vk_device = device.get_logical_device();
+
     // 7. Create image views for swapchain images and create depth image + view
-    result = m_image_views.create(device, m_images, m_format, m_extent);
+    VkResult result = m_image_views.create(device, m_images, m_format, m_extent, !m_dynamic_rendering);
     if (result != VK_SUCCESS) {
         std::cerr << "Failed to create image views!\n";
         return result;
     }
 
-    // 8. Create render pass with chosen formats
-    result = m_render_pass.create(vk_device, m_format, m_image_views.get_depth_format());
-    if (result != VK_SUCCESS) {
-        std::cerr << "Failed to create render pass!\n";
-        return result;
+    // The render graph draws straight into the views and owns depth; no render pass or framebuffers to build
+    if (m_dynamic_rendering) return VK_SUCCESS;
+
+    // 8. Create render pass with chosen formats (kept across resizes)
+    if (m_render_pass.get() == VK_NULL_HANDLE) {
+        result = m_render_pass.create(vk_device, m_format, m_image_views.get_depth_format());
+        if (result != VK_SUCCESS) {
+            std::cerr << "Failed to create render pass!\n";
+            return result;
+        }
     }
 
     // 9. Create framebuffers for each swapchain image + depth image
@@ -110,84 +128,24 @@ VkResult VulkanSwapchain::create(VulkanDevice& device, VkSurfaceKHR surface, uin
         return result;
     }
 
-    // 10. Create command pool for graphics queue family
-    result = m_command_pool.create(vk_device, device.get_graphics_queue_family());
-    if (result != VK_SUCCESS) {
-        std::cerr << "Failed to create command pool!\n";
-        return result;
-    }
-
-    // 11. Allocate command buffers (one per framebuffer)
-    result = m_command_pool.allocate_buffers(vk_device, m_framebuffers.get_all().size());
-    if (result != VK_SUCCESS) {
-        std::cerr << "Failed to allocate command buffers!\n";
-        return result;
-    }
-
-    // 12. Record command buffers (render pass begin/end with clear values)
-     record_all();
     return VK_SUCCESS;
 }
 
-void VulkanSwapchain::record_all() {
-    auto command_buffers = m_command_pool.get_buffers();
-    auto render_pass = m_render_pass.get();
-    auto framebuffers = m_framebuffers.get_all();
-    VkExtent2D extent = m_extent;
-    VkClearValue &clear_color = m_clear_color;
-    VkClearValue &clear_depth = m_clear_depth;
-
-    for (size_t i = 0; i < command_buffers.size(); ++i) {
+void VulkanSwapchain::record_single(VkCommandBuffer cmd, uint32_t image_index, VulkanGpuTimer* timer, uint32_t frame,
+                                   const VulkanDrawWork* work) {
+    SPA_ASSERT_MSG(!m_dynamic_rendering, "Dynamic rendering frames are recorded through the render graph");
 
+    // cmd was reset together with the rest of its frame's pool
+    VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &begin_info);
+    if (timer) timer->write_begin(cmd, frame);
+    if (work) work->record_pre_pass(cmd);
 
-        VkCommandBuffer cmd = command_buffers[i];
-
-        vkResetCommandBuffer(cmd, 0);
-
-        // Begin command buffer
-        VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-        begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        vkBeginCommandBuffer(cmd, &begin_info);
-
-        // Set clear values
-        VkClearValue clears[2] = { clear_color, clear_depth };
-
-        VkRenderPassBeginInfo rp_info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-        rp_info.renderPass = render_pass;
-        rp_info.framebuffer = framebuffers[i];
-        rp_info.renderArea.offset = { 0, 0 };
-        rp_info.renderArea.extent = extent;
-        rp_info.clearValueCount = 2;
-        rp_info.pClearValues = clears;
-
-        // Begin render pass
-        vkCmdBeginRenderPass(cmd, &rp_info, VK_SUBPASS_CONTENTS_INLINE);
-
-        // (This is where future drawing will go)
-
-        // End render pass
-        vkCmdEndRenderPass(cmd);
-
-        // End command buffer
-        VkResult res = vkEndCommandBuffer(cmd);
-        if (res != VK_SUCCESS) {
-            std::cerr << "Failed to record command buffer #" << i << "\n";
-        }
-    }
-}
-void VulkanSwapchain::record_single(uint32_t image_index) {
-    VkCommandBuffer cmd = m_command_pool.get_buffers()[image_index];
     VkRenderPass render_pass = m_render_pass.get();
     VkFramebuffer framebuffer = m_framebuffers.get_all()[image_index];
     VkExtent2D extent = m_extent;
 
-    // ✅ Reset only the command buffer we're about to re-record
-    vkResetCommandBuffer(cmd, 0);
-
-    VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-    begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-    vkBeginCommandBuffer(cmd, &begin_info);
-
     VkClearValue clears[2] = { m_clear_color, m_clear_depth };
 
     VkRenderPassBeginInfo rp_info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
@@ -198,14 +156,24 @@ void VulkanSwapchain::record_single(uint32_t image_index) {
     rp_info.clearValueCount = 2;
     rp_info.pClearValues = clears;
 
-    vkCmdBeginRenderPass(cmd, &rp_info, VK_SUBPASS_CONTENTS_INLINE);
+    if (timer) timer->begin_zone(cmd, frame, "Main render pass");
+    vkCmdBeginRenderPass(cmd, &rp_info, work ? work->contents() : VK_SUBPASS_CONTENTS_INLINE);
 
-    // TODO: draw commands later
+    if (work) work->record(cmd, {render_pass, framebuffer}, frame);
 
     vkCmdEndRenderPass(cmd);
+    if (timer) timer->end_zone(cmd, frame);
+    if (timer) timer->write_end(cmd, frame);
     vkEndCommandBuffer(cmd);
 }
 
+VulkanPassTarget VulkanSwapchain::get_pass_target() const {
+    VulkanPassTarget target;
+    target.render_pass = m_render_pass.get();
+    target.color_format = m_format;
+    target.depth_format = m_image_views.get_depth_format();
+    return target;
+}
 
 void VulkanSwapchain::set_clear_color(float r, float g, float b, float a) {
     m_clear_color.color.float32[0] = r;
@@ -214,13 +182,39 @@ void VulkanSwapchain::set_clear_color(float r, float g, float b, float a) {
     m_clear_color.color.float32[3] = a;
 }
 
-void VulkanSwapchain::recreate(VulkanDevice& device, VkSurfaceKHR surface, uint32_t width, uint32_t height) {
-    cleanup(device.get_logical_device());
-    create(device, surface, width, height);
+VkResult VulkanSwapchain::recreate(VulkanDevice& device, VkSurfaceKHR surface, uint32_t width, uint32_t height,
+                                   VulkanDeletionQueue& deletion_queue, uint64_t frames_submitted) {
+    // A minimized window has no area and no valid swapchain extent; keep the old one until it comes back
+    VkSurfaceCapabilitiesKHR surface_capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.get_physical_device(), surface, &surface_capabilities);
+    const VkExtent2D extent = choose_extent(surface_capabilities, width, height);
+    if (extent.width == 0 || extent.height == 0) return VK_NOT_READY;
+
+    // Frames still in flight may read the old views and framebuffers or present old images
+    m_image_views.retire(deletion_queue, frames_submitted);
+    if (!m_dynamic_rendering) m_framebuffers.retire(deletion_queue, frames_submitted);
+
+    const VkSwapchainKHR old_swapchain = m_swapchain;
+    const VkFormat old_format = m_format;
+    VkResult result = create_swapchain(device, surface, width, height);
+    if (old_swapchain != VK_NULL_HANDLE) {
+        deletion_queue.push(frames_submitted, [old_swapchain](VkDevice vk_device) {
+            vkDestroySwapchainKHR(vk_device, old_swapchain, nullptr);
+        });
+    }
+    if (result != VK_SUCCESS) return result;
+
+    // The render pass only depends on the formats, so a plain resize keeps it
+    if (m_format != old_format && m_render_pass.get() != VK_NULL_HANDLE) {
+        deletion_queue.push(frames_submitted, [render_pass = m_render_pass.release()](VkDevice vk_device) {
+            vkDestroyRenderPass(vk_device, render_pass, nullptr);
+        });
+    }
+
+    return create_targets(device);
 }
 
 void VulkanSwapchain::cleanup(VkDevice device) {
-    m_command_pool.cleanup(device);
     m_framebuffers.cleanup(device);
     m_render_pass.cleanup(device);
     m_image_views.cleanup(device);
@@ -236,11 +230,12 @@ void VulkanSwapchain::test() const {
     std::cout << "Format: " << m_format << "\n";
     std::cout << "Extent: " << m_extent.width << " x " << m_extent.height << "\n";
     std::cout << "Swapchain images: " << m_images.size() << "\n";
+    std::cout << "Present mode: " << m_present_mode << "\n";
+    std::cout << "Dynamic rendering: " << (m_dynamic_rendering ? "yes" : "no") << "\n";
 
     m_image_views.test();
     m_render_pass.get() ? std::cout << "Render pass created\n" : std::cout << "No render pass\n";
     m_framebuffers.test();
-    m_command_pool.test();
 }
 
 // Helper picks best format (prefers BGRA8 + SRGB color space)
@@ -252,12 +247,15 @@ VkSurfaceFormatKHR VulkanSwapchain::choose_surface_format(const std::vector<VkSu
     return available_formats[0];
 }
 
-// Helper picks best present mode (prefers MAILBOX, else FIFO)
+// Helper picks the requested present mode if the surface has it, else FIFO
 VkPresentModeKHR VulkanSwapchain::choose_present_mode(const std::vector<VkPresentModeKHR>& available_modes) {
     for (const auto& mode : available_modes) {
-        if (mode == VK_PRESENT_MODE_MAILBOX_KHR)
+        if (mode == m_preferred_present_mode)
             return mode;
     }
+    if (m_preferred_present_mode != VK_PRESENT_MODE_FIFO_KHR) {
+        SPA_LOG_WARN("Present mode {} not supported by the surface; using FIFO.", static_cast<i32>(m_preferred_present_mode));
+    }
     return VK_PRESENT_MODE_FIFO_KHR; // guaranteed to be supported
 }
 
@@ -28,6 +28,16 @@ VkResult VulkanSyncObjects::create(VkDevice device, uint32_t max_frames_in_fligh
     return VK_SUCCESS;
 }
 
+VkResult VulkanSyncObjects::recreate_in_flight_fence(VkDevice device, uint32_t index) {
+    // The failed submit left nothing pending on it, so it can be destroyed right away
+    vkDestroyFence(device, m_in_flight_fences[index], nullptr);
+    m_in_flight_fences[index] = VK_NULL_HANDLE;
+
+    VkFenceCreateInfo fence_info = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    return vkCreateFence(device, &fence_info, nullptr, &m_in_flight_fences[index]);
+}
+
 void VulkanSyncObjects::cleanup(VkDevice device) {
     for (size_t i = 0; i < m_image_available_semaphores.size(); ++i) {
         if (m_image_available_semaphores[i] != VK_NULL_HANDLE) {
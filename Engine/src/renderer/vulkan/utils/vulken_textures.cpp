@@ -0,0 +1,438 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+#include "core/profiler.h"
+#include <cmath>
+
+using namespace Sparkle;
+
+// Covers the header and the mip table of any chain the cooker writes
+static constexpr u64 HEADER_PREFETCH_SIZE = 4096;
+static constexpr u32 MAX_MIPS = 16;
+
+static VkFormat to_vk_format(TextureFormat format, bool srgb) {
+    switch (format) {
+        case TextureFormat::RGBA8: return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        case TextureFormat::BC1: return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case TextureFormat::BC3: return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+VulkanTextureStreamer::~VulkanTextureStreamer() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanTextureStreamer::create(VulkanDevice& device, VulkanStagingRing& staging, VkDeviceSize budget) {
+    if (!staging.is_created() || !Assets::is_initialized()) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    m_device = device.get_logical_device();
+    m_memory = &device.get_memory_allocator();
+    m_bc_textures = device.supports_bc_textures();
+    m_budget = budget;
+
+    m_textures = std::make_unique<Texture[]>(MAX_TEXTURES);
+    m_count = 1;
+    m_streaming = 0;
+    m_committed = 0;
+    m_frame = 0;
+    m_stats = {};
+    m_candidates.reserve(256);
+    {
+        std::lock_guard<std::mutex> lock(m_completed_mutex);
+        m_completed.clear();
+    }
+    m_applying.clear();
+
+    m_staging = &staging;
+    return VK_SUCCESS;
+}
+
+void VulkanTextureStreamer::cleanup(VkDevice device) {
+    if (m_textures) {
+        const uint32_t count = m_count.load(std::memory_order_acquire);
+        for (uint32_t id = 1; id < count; ++id) {
+            Texture& texture = m_textures[id];
+            if (texture.view) vkDestroyImageView(device, texture.view, nullptr);
+            if (texture.next_view) vkDestroyImageView(device, texture.next_view, nullptr);
+            m_memory->destroy_image(texture.image, texture.allocation);
+            m_memory->destroy_image(texture.next_image, texture.next_allocation);
+        }
+        m_textures.reset();
+    }
+    m_count = 1;
+    m_candidates.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_completed_mutex);
+        m_completed.clear();
+    }
+    m_applying.clear();
+    m_staging = nullptr;
+    m_memory = nullptr;
+    m_device = VK_NULL_HANDLE;
+}
+
+uint32_t VulkanTextureStreamer::add(AssetHandle asset) {
+    const uint32_t id = m_count.load(std::memory_order_relaxed);
+    if (id == MAX_TEXTURES) {
+        SPA_LOG_ERROR("Cannot stream more than {} textures.", MAX_TEXTURES - 1);
+        return 0;
+    }
+
+    Texture& texture = m_textures[id];
+    texture.asset = asset;
+    texture.state = State::Header;
+
+    // Callbacks run later in Assets::update, after the id is published below
+    const bool queued = Assets::prefetch(asset, 0, HEADER_PREFETCH_SIZE, [this, id](AssetHandle, const AssetView* view) {
+        Completion completion;
+        completion.id = id;
+        if (view) completion.view = *view;
+        completion.ok = view != nullptr;
+        std::lock_guard<std::mutex> lock(m_completed_mutex);
+        m_completed.push_back(completion);
+    });
+    if (!queued) {
+        SPA_LOG_WARN("Texture asset {:#x} is not in any mounted archive.", asset.id);
+        texture.state = State::Failed;
+    }
+    m_count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+void VulkanTextureStreamer::complete(const Completion& completion) {
+    Texture& texture = m_textures[completion.id];
+    if (completion.serial == 0) {
+        texture.state = completion.ok && parse_header(texture, completion.view) ? State::Ready : State::Failed;
+    } else if (completion.serial == texture.stream_serial) {
+        texture.next_paged = true;
+    }
+}
+
+bool VulkanTextureStreamer::parse_header(Texture& texture, const AssetView& view) {
+    const u8* blob = static_cast<const u8*>(view.data);
+    if (view.type != AssetType::Texture || view.size < sizeof(TextureHeader)) {
+        SPA_LOG_WARN("Asset {:#x} is not a cooked texture.", texture.asset.id);
+        return false;
+    }
+
+    std::memcpy(&texture.header, blob, sizeof(TextureHeader));
+    const TextureHeader& header = texture.header;
+    if (header.mip_count == 0 || header.mip_count > MAX_MIPS ||
+        view.size < sizeof(TextureHeader) + header.mip_count * sizeof(TextureMip)) {
+        SPA_LOG_WARN("Texture {:#x} has a corrupt header.", texture.asset.id);
+        return false;
+    }
+    texture.mips.resize(header.mip_count);
+    std::memcpy(texture.mips.data(), blob + sizeof(TextureHeader), header.mip_count * sizeof(TextureMip));
+    for (const TextureMip& mip : texture.mips) {
+        if (mip.offset > view.size || mip.size > view.size - mip.offset) {
+            SPA_LOG_WARN("Texture {:#x} has a mip outside its blob.", texture.asset.id);
+            return false;
+        }
+    }
+
+    texture.format = to_vk_format(header.format, header.flags & TEXTURE_SRGB);
+    if (texture.format == VK_FORMAT_UNDEFINED) {
+        SPA_LOG_WARN("Texture {:#x} has unknown format {}.", texture.asset.id, static_cast<u32>(header.format));
+        return false;
+    }
+    if (header.format != TextureFormat::RGBA8 && !m_bc_textures) {
+        SPA_LOG_WARN("Texture {:#x} is block-compressed, which this device can't sample; "
+                     "cook with --uncompressed for it.", texture.asset.id);
+        return false;
+    }
+
+    texture.tail = header.mip_count - 1;
+    for (uint32_t i = 0; i < header.mip_count; ++i) {
+        if (std::max(texture.mips[i].width, texture.mips[i].height) <= TAIL_SIZE) {
+            texture.tail = i;
+            break;
+        }
+    }
+    texture.wanted = texture.tail;
+    texture.blob = blob;
+    return true;
+}
+
+VkDeviceSize VulkanTextureStreamer::chain_bytes(const Texture& texture, uint32_t mip) const {
+    VkDeviceSize bytes = 0;
+    for (uint32_t i = mip; i < texture.mips.size(); ++i) {
+        bytes += texture.mips[i].size;
+    }
+    return bytes;
+}
+
+uint32_t VulkanTextureStreamer::target_mip(const Texture& texture) const {
+    return texture.next_image ? texture.next_mip : texture.resident_mip;
+}
+
+void VulkanTextureStreamer::request(uint32_t texture, f32 pixels) {
+    if (texture == 0 || texture >= m_count.load(std::memory_order_acquire) || !(pixels > 0.0f)) return;
+
+    const uint32_t value = pixels >= 1e9f ? UINT32_MAX : static_cast<uint32_t>(std::ceil(pixels));
+    std::atomic<uint32_t>& slot = m_textures[texture].pixels;
+    uint32_t current = slot.load(std::memory_order_relaxed);
+    while (current < value && !slot.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+void VulkanTextureStreamer::request_distance(uint32_t texture, f32 world_size, f32 distance, f32 fov_y,
+                                             uint32_t viewport_height) {
+    if (distance <= 0.0f) {
+        request(texture, 1e9f); // At the camera: full detail
+        return;
+    }
+    const f32 view_height = 2.0f * distance * std::tan(fov_y * 0.5f);
+    request(texture, world_size / view_height * static_cast<f32>(viewport_height));
+}
+
+void VulkanTextureStreamer::request_quads(const Quad* quads, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        const Quad& quad = quads[i];
+        if (quad.texture == 0) continue;
+        // An atlas region spans part of the texture, so the whole texture spans proportionally more pixels
+        const f32 du = std::max(std::abs(quad.uv[2] - quad.uv[0]), 1.0f / 4096.0f);
+        const f32 dv = std::max(std::abs(quad.uv[3] - quad.uv[1]), 1.0f / 4096.0f);
+        request(quad.texture, std::max(quad.size[0] / du, quad.size[1] / dv));
+    }
+}
+
+bool VulkanTextureStreamer::start_stream(uint32_t id, uint32_t mip) {
+    // Checked here rather than by callers, so streams started to evict for another can't exceed it either
+    if (m_streaming >= MAX_STREAMS) return false;
+
+    Texture& texture = m_textures[id];
+    const TextureMip& top = texture.mips[mip];
+    const uint32_t previous = target_mip(texture);
+
+    VkImageCreateInfo image_info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = texture.format;
+    image_info.extent = {top.width, top.height, 1};
+    image_info.mipLevels = texture.header.mip_count - mip;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkResult res = m_memory->create_image(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                          texture.next_image, texture.next_allocation);
+    if (res != VK_SUCCESS) {
+        SPA_LOG_WARN("Out of device memory streaming texture {} at mip {}.", id, mip);
+        return false;
+    }
+
+    VkImageViewCreateInfo view_info = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    view_info.image = texture.next_image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = texture.format;
+    view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, image_info.mipLevels, 0, 1};
+    res = vkCreateImageView(m_device, &view_info, nullptr, &texture.next_view);
+    if (res != VK_SUCCESS) {
+        m_memory->destroy_image(texture.next_image, texture.next_allocation);
+        return false;
+    }
+
+    m_committed = m_committed + chain_bytes(texture, mip) - chain_bytes(texture, previous);
+    if (mip < previous) m_stats.loads_started++;
+
+    texture.next_mip = mip;
+    texture.next_uploaded = 0;
+    texture.next_paged = false;
+    const uint32_t serial = ++texture.stream_serial;
+    m_streaming++;
+
+    // Mips are stored largest first, so the chain from mip down is one contiguous range
+    const TextureMip& last = texture.mips.back();
+    const u64 offset = top.offset;
+    const u64 size = last.offset + last.size - offset;
+    const bool queued = Assets::prefetch(texture.asset, offset, size, [this, id, serial](AssetHandle, const AssetView*) {
+        Completion completion;
+        completion.id = id;
+        completion.serial = serial;
+        completion.ok = true;
+        std::lock_guard<std::mutex> lock(m_completed_mutex);
+        m_completed.push_back(completion);
+    });
+    // Reading straight from the mapping still works, it just faults on this thread
+    if (!queued) texture.next_paged = true;
+    return true;
+}
+
+void VulkanTextureStreamer::advance_stream(Texture& texture, VulkanDeletionQueue& deletion_queue,
+                                           uint64_t frames_submitted) {
+    if (!texture.next_paged) return;
+
+    const uint32_t levels = texture.header.mip_count - texture.next_mip;
+    while (texture.next_uploaded < levels) {
+        const uint32_t level = texture.next_uploaded;
+        const TextureMip& mip = texture.mips[texture.next_mip + level];
+        // Region full: the rest goes out with a later frame's batch
+        if (!m_staging->upload_image(texture.blob + mip.offset, mip.size, texture.next_image, level,
+                                     {mip.width, mip.height})) {
+            return;
+        }
+        texture.next_uploaded++;
+        m_stats.uploaded_bytes += mip.size;
+    }
+
+    // Every level is in this frame's batch or an earlier one, all of which this frame waits on
+    if (texture.image) {
+        deletion_queue.push(frames_submitted, [image = texture.image, allocation = texture.allocation,
+                                               view = texture.view, memory = m_memory](VkDevice device) mutable {
+            vkDestroyImageView(device, view, nullptr);
+            memory->destroy_image(image, allocation);
+        });
+    }
+    if (texture.next_mip < texture.resident_mip) m_stats.loads_completed++;
+
+    texture.image = texture.next_image;
+    texture.allocation = texture.next_allocation;
+    texture.view = texture.next_view;
+    texture.resident_mip = texture.next_mip;
+    texture.next_image = VK_NULL_HANDLE;
+    texture.next_allocation = {};
+    texture.next_view = VK_NULL_HANDLE;
+    texture.next_mip = UINT32_MAX;
+    m_streaming--;
+}
+
+bool VulkanTextureStreamer::evict_one(uint32_t keep) {
+    const uint32_t count = m_count.load(std::memory_order_acquire);
+    uint32_t victim = 0;
+    for (uint32_t id = 1; id < count; ++id) {
+        const Texture& texture = m_textures[id];
+        // Only whole chains finer than the tail, and nothing this frame needs at its current detail
+        if (id == keep || texture.state != State::Ready || texture.next_image ||
+            texture.resident_mip >= texture.tail) {
+            continue;
+        }
+        if (texture.last_used == m_frame && texture.resident_mip >= texture.wanted) continue;
+        if (victim == 0 || texture.last_used < m_textures[victim].last_used) victim = id;
+    }
+    if (victim == 0) return false;
+
+    Texture& texture = m_textures[victim];
+    if (!start_stream(victim, texture.resident_mip + 1)) return false;
+    m_stats.evictions++;
+    return true;
+}
+
+void VulkanTextureStreamer::update(VulkanDeletionQueue& deletion_queue, uint64_t frames_submitted) {
+    SPA_PROFILE_SCOPE("VulkanTextureStreamer::update");
+    m_frame++;
+    m_stats.budget_limited = 0;
+    m_stats.loads_started = 0;
+    m_stats.loads_completed = 0;
+    m_stats.evictions = 0;
+    m_stats.uploaded_bytes = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_completed_mutex);
+        m_applying.swap(m_completed);
+    }
+    for (const Completion& completion : m_applying) {
+        complete(completion);
+    }
+    m_applying.clear();
+
+    // This frame's requests become wanted mips: the coarsest one with at least a texel per pixel
+    const uint32_t count = m_count.load(std::memory_order_acquire);
+    for (uint32_t id = 1; id < count; ++id) {
+        Texture& texture = m_textures[id];
+        const uint32_t pixels = texture.pixels.exchange(0, std::memory_order_relaxed);
+        if (texture.state != State::Ready || pixels == 0) continue;
+
+        const uint32_t size = std::max(texture.header.width, texture.header.height);
+        uint32_t mip = 0;
+        while (mip < texture.tail && (size >> (mip + 1)) >= pixels) mip++;
+        texture.wanted = mip;
+        texture.last_used = m_frame;
+    }
+
+    // Finish what earlier frames started first, so their images free up or swap in soonest
+    for (uint32_t id = 1; id < count; ++id) {
+        Texture& texture = m_textures[id];
+        if (texture.next_image) advance_stream(texture, deletion_queue, frames_submitted);
+    }
+
+    // The budget may have shrunk
+    while (m_committed > m_budget && evict_one(0)) {}
+
+    // Missing tails, and finer mips for what this frame requested; tails first, then biggest deficit
+    m_candidates.clear();
+    for (uint32_t id = 1; id < count; ++id) {
+        const Texture& texture = m_textures[id];
+        if (texture.state != State::Ready || texture.next_image) continue;
+        if (texture.resident_mip == UINT32_MAX ||
+            (texture.last_used == m_frame && texture.wanted < texture.resident_mip)) {
+            m_candidates.push_back(id);
+        }
+    }
+    std::sort(m_candidates.begin(), m_candidates.end(), [this](uint32_t a, uint32_t b) {
+        const Texture& ta = m_textures[a];
+        const Texture& tb = m_textures[b];
+        const bool tail_a = ta.resident_mip == UINT32_MAX;
+        const bool tail_b = tb.resident_mip == UINT32_MAX;
+        if (tail_a != tail_b) return tail_a;
+        return ta.resident_mip - ta.wanted > tb.resident_mip - tb.wanted;
+    });
+
+    for (uint32_t id : m_candidates) {
+        if (m_streaming >= MAX_STREAMS) break;
+        Texture& texture = m_textures[id];
+        if (texture.next_image) continue; // Evicted for an earlier candidate
+
+        // Tails always load; finer mips only as far as the budget reaches after evicting for them
+        uint32_t mip = texture.resident_mip == UINT32_MAX ? texture.tail : texture.wanted;
+        // A mip must fit one staging region
+        while (mip < texture.tail && texture.mips[mip].size > m_staging->get_region_size()) mip++;
+        if (texture.resident_mip != UINT32_MAX) {
+            const uint32_t wanted = mip;
+            const VkDeviceSize current = chain_bytes(texture, texture.resident_mip);
+            while (m_committed + chain_bytes(texture, mip) - current > m_budget && evict_one(id)) {}
+            while (mip < texture.resident_mip && m_committed + chain_bytes(texture, mip) - current > m_budget) mip++;
+            if (mip != wanted) m_stats.budget_limited++;
+            if (mip >= texture.resident_mip) continue;
+        }
+        start_stream(id, mip);
+    }
+
+    m_stats.textures = count - 1;
+    m_stats.resident = 0;
+    m_stats.resident_bytes = 0;
+    for (uint32_t id = 1; id < count; ++id) {
+        const Texture& texture = m_textures[id];
+        if (texture.resident_mip == UINT32_MAX) continue;
+        m_stats.resident++;
+        m_stats.resident_bytes += chain_bytes(texture, texture.resident_mip);
+    }
+    m_stats.streaming = m_streaming;
+    m_stats.committed_bytes = m_committed;
+    m_stats.budget_bytes = m_budget;
+}
+
+VkImageView VulkanTextureStreamer::get_view(uint32_t texture) const {
+    if (texture == 0 || texture >= m_count.load(std::memory_order_acquire)) return VK_NULL_HANDLE;
+    return m_textures[texture].view;
+}
+
+uint32_t VulkanTextureStreamer::get_resident_mip(uint32_t texture) const {
+    if (texture == 0 || texture >= m_count.load(std::memory_order_acquire)) return UINT32_MAX;
+    return m_textures[texture].resident_mip;
+}
+
+void VulkanTextureStreamer::test() const {
+    std::cout << "=== VulkanTextureStreamer Test ===\n";
+    std::cout << "Textures: " << m_stats.textures << " (" << m_stats.resident << " resident, "
+              << m_stats.streaming << " streaming)\n";
+    std::cout << "Budget: " << m_budget / (1024 * 1024) << " MiB, committed "
+              << m_committed / (1024 * 1024) << " MiB\n";
+    std::cout << "BC textures: " << (m_bc_textures ? "yes" : "no") << "\n";
+}
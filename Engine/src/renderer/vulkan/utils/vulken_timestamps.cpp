@@ -0,0 +1,161 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "spa_pch.h"
+#include "../vulkan_utils.h"
+#include "core/profiler.h"
+
+VulkanGpuTimer::~VulkanGpuTimer() {
+    // Must call cleanup manually
+}
+
+VkResult VulkanGpuTimer::create(VulkanDevice& device, uint32_t max_frames_in_flight) {
+    const VkPhysicalDeviceLimits& limits = device.get_properties().limits;
+    if (!limits.timestampComputeAndGraphics || limits.timestampPeriod <= 0.0f) {
+        SPA_LOG_WARN("Device does not support graphics timestamps; GPU frame times disabled.");
+        return VK_SUCCESS;
+    }
+    m_period_ns = limits.timestampPeriod;
+
+    // Bits above timestampValidBits are undefined; 0 valid bits means the queue can't write timestamps at all
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device.get_physical_device(), &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device.get_physical_device(), &family_count, families.data());
+    const uint32_t valid_bits = device.get_graphics_queue_family() < family_count
+                                    ? families[device.get_graphics_queue_family()].timestampValidBits : 0;
+    if (valid_bits == 0) {
+        SPA_LOG_WARN("Graphics queue does not support timestamps; GPU frame times disabled.");
+        return VK_SUCCESS;
+    }
+    m_valid_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+    VkQueryPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = max_frames_in_flight * QUERIES_PER_FRAME;
+
+    m_frames.assign(max_frames_in_flight, FrameQueries{});
+    VkResult res = vkCreateQueryPool(device.get_logical_device(), &pool_info, nullptr, &m_pool);
+    if (res != VK_SUCCESS) return res;
+
+    calibrate(device);
+    return VK_SUCCESS;
+}
+
+void VulkanGpuTimer::calibrate(VulkanDevice& device) {
+    // One timestamp written by an otherwise empty submit, paired with the midpoint of the CPU time
+    // around it. Good to tens of microseconds, which is enough to line GPU zones up with CPU ones.
+    VkDevice vk_device = device.get_logical_device();
+    VulkanCommandPool pool;
+    if (pool.create(vk_device, device.get_graphics_queue_family(), VK_COMMAND_POOL_CREATE_TRANSIENT_BIT) != VK_SUCCESS ||
+        pool.allocate_buffers(vk_device, 1) != VK_SUCCESS) {
+        pool.cleanup(vk_device);
+        return;
+    }
+    VkCommandBuffer cmd = pool.get_buffers()[0];
+
+    VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &begin_info);
+    vkCmdResetQueryPool(cmd, m_pool, 0, 1);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool, 0);
+    vkEndCommandBuffer(cmd);
+
+    VkFenceCreateInfo fence_info = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    VkFence fence = VK_NULL_HANDLE;
+    if (vkCreateFence(vk_device, &fence_info, nullptr, &fence) == VK_SUCCESS) {
+        VkSubmitInfo submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &cmd;
+
+        const u64 cpu_before = Sparkle::Profiler::now_ns();
+        if (vkQueueSubmit(device.get_graphics_queue(), 1, &submit_info, fence) == VK_SUCCESS &&
+            vkWaitForFences(vk_device, 1, &fence, VK_TRUE, UINT64_MAX) == VK_SUCCESS) {
+            const u64 cpu_after = Sparkle::Profiler::now_ns();
+
+            uint64_t ticks = 0;
+            if (vkGetQueryPoolResults(vk_device, m_pool, 0, 1, sizeof(ticks), &ticks, sizeof(uint64_t),
+                                      VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+                ticks &= m_valid_mask;
+                const f64 gpu_ns = static_cast<f64>(ticks) * m_period_ns;
+                m_gpu_to_cpu_ns = static_cast<i64>(cpu_before + (cpu_after - cpu_before) / 2) - static_cast<i64>(gpu_ns);
+            }
+        }
+        vkDestroyFence(vk_device, fence, nullptr);
+    }
+    pool.cleanup(vk_device);
+}
+
+void VulkanGpuTimer::cleanup(VkDevice device) {
+    if (m_pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device, m_pool, nullptr);
+        m_pool = VK_NULL_HANDLE;
+    }
+    m_frames.clear();
+}
+
+void VulkanGpuTimer::write_begin(VkCommandBuffer cmd, uint32_t frame) {
+    if (!m_pool) return;
+    FrameQueries& queries = m_frames[frame];
+    queries.written = false;
+    queries.zone_count = 0;
+    queries.open_count = 0;
+
+    vkCmdResetQueryPool(cmd, m_pool, frame * QUERIES_PER_FRAME, QUERIES_PER_FRAME);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_pool, frame * QUERIES_PER_FRAME);
+}
+
+void VulkanGpuTimer::write_end(VkCommandBuffer cmd, uint32_t frame) {
+    if (!m_pool) return;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool, frame * QUERIES_PER_FRAME + 1);
+    m_frames[frame].written = true;
+}
+
+void VulkanGpuTimer::begin_zone(VkCommandBuffer cmd, uint32_t frame, const char* name) {
+    if (!m_pool) return;
+    FrameQueries& queries = m_frames[frame];
+    if (queries.zone_count == MAX_ZONES) return;
+
+    const uint32_t zone = queries.zone_count++;
+    queries.names[zone] = name;
+    queries.open[queries.open_count++] = zone;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_pool, frame * QUERIES_PER_FRAME + 2 + zone * 2);
+}
+
+void VulkanGpuTimer::end_zone(VkCommandBuffer cmd, uint32_t frame) {
+    if (!m_pool) return;
+    FrameQueries& queries = m_frames[frame];
+    if (queries.open_count == 0) return;
+
+    const uint32_t zone = queries.open[--queries.open_count];
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool, frame * QUERIES_PER_FRAME + 3 + zone * 2);
+}
+
+bool VulkanGpuTimer::resolve(VkDevice device, uint32_t frame, f64& out_ms) {
+    if (!m_pool || !m_frames[frame].written) return false;
+    const FrameQueries& queries = m_frames[frame];
+
+    uint64_t ticks[QUERIES_PER_FRAME] = {};
+    const uint32_t count = 2 + queries.zone_count * 2;
+    VkResult res = vkGetQueryPoolResults(device, m_pool, frame * QUERIES_PER_FRAME, count, sizeof(ticks), ticks,
+                                         sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (res != VK_SUCCESS) return false;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        ticks[i] &= m_valid_mask;
+    }
+    // Masking the difference too keeps a counter that wrapped inside the frame from reading as huge
+    out_ms = static_cast<f64>((ticks[1] - ticks[0]) & m_valid_mask) * m_period_ns / 1'000'000.0;
+
+    if (Sparkle::Profiler::is_enabled()) {
+        auto to_cpu_ns = [this](uint64_t t) {
+            return static_cast<u64>(static_cast<i64>(static_cast<f64>(t) * m_period_ns) + m_gpu_to_cpu_ns);
+        };
+        Sparkle::Profiler::record("GPU frame", to_cpu_ns(ticks[0]), to_cpu_ns(ticks[1]), Sparkle::Profiler::GPU_TRACK);
+        for (uint32_t zone = 0; zone < queries.zone_count; ++zone) {
+            Sparkle::Profiler::record(queries.names[zone], to_cpu_ns(ticks[2 + zone * 2]), to_cpu_ns(ticks[3 + zone * 2]),
+                                      Sparkle::Profiler::GPU_TRACK);
+        }
+    }
+    return true;
+}
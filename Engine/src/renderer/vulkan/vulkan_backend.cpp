@@ -3,6 +3,8 @@
 //
 #include "spa_pch.h"
 #include "vulkan_backend.h"
+#include "core/frame_arena.h"
+#include "core/profiler.h"
 
 
 VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
@@ -13,6 +15,16 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
 
 
 namespace Sparkle {
+    static VkPresentModeKHR to_vk_present_mode(PresentMode mode) {
+        switch (mode) {
+            case PresentMode::Mailbox: return VK_PRESENT_MODE_MAILBOX_KHR;
+            case PresentMode::Immediate: return VK_PRESENT_MODE_IMMEDIATE_KHR;
+            case PresentMode::FifoRelaxed: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+            case PresentMode::Fifo:
+            default: return VK_PRESENT_MODE_FIFO_KHR;
+        }
+    }
+
     bool VulkanBackend::init() {
         // Setup Vulkan instance.
         VkApplicationInfo app_info = {VK_STRUCTURE_TYPE_APPLICATION_INFO};
@@ -22,8 +34,10 @@ namespace Sparkle {
         app_info.pEngineName = "Sparkle Engine";
         app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
 
-        std::vector<const char *> extension_names = load_extensions();
-        SPA_ASSERT(!extension_names.empty());
+        m_headless = Application::IsHeadless();
+
+        std::vector<const char *> extension_names = load_extensions(m_headless);
+        SPA_ASSERT(m_headless || !extension_names.empty());
 
         VkInstanceCreateInfo create_info = {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
         create_info.pApplicationInfo = &app_info;
@@ -39,9 +53,11 @@ namespace Sparkle {
         VK_CHECK(res);
         SPA_LOG_DEBUG("Vulkan debug messenger created.");
 
-        bool result = SDL_Vulkan_CreateSurface(Application::GetWindow(), m_instance, m_allocator, &m_surface);
-        SPA_ASSERT(result);
-        SPA_LOG_DEBUG("Vulkan surface created");
+        if (!m_headless) {
+            bool result = SDL_Vulkan_CreateSurface(Application::GetWindow(), m_instance, m_allocator, &m_surface);
+            SPA_ASSERT(result);
+            SPA_LOG_DEBUG("Vulkan surface created");
+        }
 
         res = m_device.create(m_instance, m_surface, m_allocator);
         VK_CHECK(res);
@@ -50,22 +66,125 @@ namespace Sparkle {
 #endif
         SPA_LOG_DEBUG("Vulkan device created and validated.");
 
-        // Create the swapchain (including views, render pass, depth, and framebuffers)
-        res = m_swapchain.create(m_device, m_surface,
-                                 Application::GetWidth(),
-                                 Application::GetHeight());
-        SPA_ASSERT(res == VK_SUCCESS);
+        res = m_pipelines.create(m_device, Application::GetEngineConfig().pipeline_cache_path);
+        VK_CHECK(res);
+
+        const bool dynamic_rendering = Application::GetEngineConfig().dynamic_rendering &&
+                                       m_device.supports_dynamic_rendering();
+        if (Application::GetEngineConfig().dynamic_rendering && !dynamic_rendering) {
+            SPA_LOG_WARN("Device lacks dynamic rendering; using render pass objects.");
+        }
+
+        if (m_headless) {
+            // One offscreen image per frame in flight, so an image is free once its frame's fence signals
+            m_offscreen.set_dynamic_rendering(dynamic_rendering);
+            res = m_offscreen.create(m_device,
+                                     Application::GetWidth(),
+                                     Application::GetHeight(),
+                                     m_max_frames_in_flight);
+            SPA_ASSERT(res == VK_SUCCESS);
+#ifdef SPA_DEBUG
+            m_offscreen.test();
+#endif
+            SPA_LOG_DEBUG("Offscreen render target created.");
+        } else {
+            // Create the swapchain (including views, depth, and the render pass + framebuffers without dynamic rendering)
+            m_swapchain.set_dynamic_rendering(dynamic_rendering);
+            m_swapchain.set_present_mode(to_vk_present_mode(Application::GetEngineConfig().present_mode));
+            res = m_swapchain.create(m_device, m_surface,
+                                     Application::GetWidth(),
+                                     Application::GetHeight());
+            SPA_ASSERT(res == VK_SUCCESS);
+            m_swapchain_width = m_swapchain.get_extent().width;
+            m_swapchain_height = m_swapchain.get_extent().height;
 #ifdef SPA_DEBUG
-        // Test all the internal components for correctness
-        m_swapchain.test();
+            // Test all the internal components for correctness
+            m_swapchain.test();
 #endif
-        SPA_LOG_DEBUG("Swapchain created.");
+            SPA_LOG_DEBUG("Swapchain created.");
+        }
+
+        res = m_sprites.create(m_device, m_pipelines, get_pass_target(), m_max_frames_in_flight, SPA_SHADER_DIR);
+        if (res == VK_SUCCESS) {
+#ifdef SPA_DEBUG
+            m_sprites.test();
+#endif
+            SPA_LOG_DEBUG("Sprite renderer created.");
+        } else {
+            SPA_LOG_WARN("Sprite renderer unavailable (shaders missing from {}); quads will not be drawn.", SPA_SHADER_DIR);
+            m_sprites.cleanup(m_device.get_logical_device());
+        }
+
+        if (dynamic_rendering) {
+            create_graph(m_headless);
+            SPA_LOG_DEBUG("Render graph created.");
+        }
 
         // Create sync objects
         res = m_sync_objects.create(m_device.get_logical_device(), m_max_frames_in_flight);
         if (res != VK_SUCCESS) return res;
         SPA_LOG_DEBUG("sync objects created.");
 
+        if (!create_frames()) return false;
+        SPA_LOG_DEBUG("per-frame command pools created.");
+
+        set_record_threads(Application::GetEngineConfig().render_record_threads);
+
+        res = m_gpu_timer.create(m_device, m_max_frames_in_flight);
+        VK_CHECK(res);
+
+        res = m_staging.create(m_device, m_max_frames_in_flight);
+        if (res == VK_SUCCESS) {
+#ifdef SPA_DEBUG
+            m_staging.test();
+#endif
+            SPA_LOG_DEBUG("Staging ring created.");
+        } else {
+            SPA_LOG_WARN("Staging ring unavailable (no timeline semaphores); GPU uploads disabled.");
+            m_staging.cleanup(m_device.get_logical_device());
+        }
+
+        if (m_staging.is_created()) {
+            res = m_meshes.create(m_device, m_staging);
+            VK_CHECK(res);
+#ifdef SPA_DEBUG
+            m_meshes.test();
+#endif
+            SPA_LOG_DEBUG("Mesh buffers created.");
+
+            res = m_mesh_renderer.create(m_pipelines, m_meshes, get_pass_target(), SPA_SHADER_DIR);
+            if (res == VK_SUCCESS) {
+                m_mesh_fn = [this](VkCommandBuffer cmd, uint32_t first, uint32_t count) {
+                    m_mesh_renderer.record(cmd, first, count);
+                };
+                SPA_LOG_DEBUG("Mesh renderer created.");
+            } else {
+                SPA_LOG_WARN("Mesh renderer unavailable (shaders missing from {}); meshes will not be drawn.", SPA_SHADER_DIR);
+                m_mesh_renderer.cleanup();
+            }
+        }
+
+        res = m_dynamic.create(m_device, m_max_frames_in_flight);
+        VK_CHECK(res);
+#ifdef SPA_DEBUG
+        m_dynamic.test();
+#endif
+        SPA_LOG_DEBUG("Dynamic buffer created.");
+
+        if (m_staging.is_created() && Assets::is_initialized()) {
+            res = m_textures.create(m_device, m_staging, Application::GetEngineConfig().assets.texture_budget);
+            VK_CHECK(res);
+#ifdef SPA_DEBUG
+            m_textures.test();
+#endif
+            SPA_LOG_DEBUG("Texture streamer created.");
+
+            // Quads sample whatever mips of their texture are resident this frame
+            if (m_sprites.is_created()) {
+                m_sprites.set_texture_source([this](uint16_t texture) { return m_textures.get_view(texture); });
+            }
+        }
+
 
         SPA_LOG_INFO("Vulkan renderer initialized successfully.");
 
@@ -78,9 +197,34 @@ namespace Sparkle {
 
         SPA_LOG_DEBUG("Destroying sync objects...");
         m_sync_objects.cleanup(m_device.get_logical_device());
-
-        SPA_LOG_DEBUG("Destroying swapchain...");
+        m_gpu_timer.cleanup(m_device.get_logical_device());
+        m_textures.cleanup(m_device.get_logical_device());
+        m_mesh_renderer.cleanup();
+        m_mesh_fn = nullptr;
+        {
+            // Assets loaded for registrations that never reached a frame
+            std::lock_guard<std::mutex> lock(m_mesh_mutex);
+            for (const MeshRequest& request : m_mesh_requests) {
+                if (request.asset.is_valid()) Assets::release(request.asset);
+            }
+            m_mesh_requests.clear();
+        }
+        m_mesh_ids.clear();
+        m_meshes.cleanup(m_device.get_logical_device());
+        m_dynamic.cleanup(m_device.get_logical_device());
+        m_staging.cleanup(m_device.get_logical_device());
+        m_sprites.cleanup(m_device.get_logical_device());
+        m_recorder.cleanup();
+        destroy_frames();
+
+        SPA_LOG_DEBUG("Saving pipeline cache and destroying pipelines...");
+        m_pipelines.cleanup(m_device.get_logical_device());
+
+        SPA_LOG_DEBUG("Destroying render graph and swapchain...");
+        m_graph.cleanup(m_device.get_logical_device());
         m_swapchain.cleanup(m_device.get_logical_device());
+        m_offscreen.cleanup(m_device.get_logical_device());
+        m_deletion_queue.flush_all(m_device.get_logical_device());
 
         SPA_LOG_DEBUG("Destroying Vulkan devices...");
         m_device.cleanup();
@@ -109,66 +253,466 @@ namespace Sparkle {
     }
 
     void VulkanBackend::resize(uint32_t width, uint32_t height) {
-        // Wait for the device to be idle before resizing
-        vkDeviceWaitIdle(m_device.get_logical_device());
+        if (m_headless) {
+            // Offscreen targets are only resized by tools, so a full idle is acceptable here
+            vkDeviceWaitIdle(m_device.get_logical_device());
+            m_offscreen.cleanup(m_device.get_logical_device());
+            m_offscreen.create(m_device, width, height, m_max_frames_in_flight);
+            if (m_graph.is_created()) m_graph.set_extent(m_offscreen.get_extent());
+            if (m_sprites.is_created()) m_sprites.set_target(m_offscreen.get_pass_target());
+            if (m_mesh_renderer.is_created()) m_mesh_renderer.set_target(m_offscreen.get_pass_target());
+            return;
+        }
+
+        // The swapchain is rebuilt at the start of the next frame, without idling the device
+        m_swapchain_width = width;
+        m_swapchain_height = height;
+        m_swapchain_dirty = true;
+    }
 
-        // Recreate swapchain with new dimensions
-        m_swapchain.recreate(m_device, m_surface, width, height);
+    void VulkanBackend::set_present_mode(PresentMode mode) {
+        if (m_headless) return;
 
-        // Reset frame index if needed
-        m_current_frame = 0;
+        const VkPresentModeKHR vk_mode = to_vk_present_mode(mode);
+        m_swapchain.set_present_mode(vk_mode);
+        if (vk_mode != m_swapchain.get_present_mode()) {
+            m_swapchain_dirty = true;
+        }
+    }
+
+    void VulkanBackend::wait_for_frame_slot() {
+        SPA_PROFILE_SCOPE("Wait for frame fence");
+        VkFence in_flight_fence = m_sync_objects.get_in_flight_fence(m_current_frame);
+        vkWaitForFences(m_device.get_logical_device(), 1, &in_flight_fence, VK_TRUE, UINT64_MAX);
+    }
+
+    u16 VulkanBackend::register_texture(AssetHandle asset) {
+        if (!m_textures.is_created()) {
+            SPA_LOG_WARN("Texture streaming is unavailable; quads using this texture draw untextured.");
+            return 0;
+        }
+        return static_cast<u16>(m_textures.add(asset));
+    }
+
+    u32 VulkanBackend::register_mesh(std::string_view name) {
+        if (!m_mesh_renderer.is_created()) {
+            SPA_LOG_WARN("Mesh rendering is unavailable; '{}' will not be drawn.", name);
+            return 0;
+        }
+
+        u32 mesh;
+        {
+            std::lock_guard<std::mutex> lock(m_mesh_mutex);
+            mesh = m_next_mesh++;
+        }
+        // The load keeps the asset's pages resident until the request has been applied and releases it
+        const AssetHandle asset = Assets::load(name, [this, mesh](AssetHandle handle, const AssetView* view) {
+            MeshRequest request;
+            request.mesh = mesh;
+            request.asset = handle;
+            if (view) request.view = *view;
+            else SPA_LOG_WARN("Mesh asset {:#x} failed to load.", handle.id);
+
+            std::lock_guard<std::mutex> lock(m_mesh_mutex);
+            m_mesh_requests.push_back(std::move(request));
+        });
+        return asset.is_valid() ? mesh : 0;
+    }
+
+    u32 VulkanBackend::register_mesh(const MeshVertex* vertices, u32 vertex_count, const u32* indices, u32 index_count) {
+        if (!m_mesh_renderer.is_created()) {
+            SPA_LOG_WARN("Mesh rendering is unavailable; the mesh will not be drawn.");
+            return 0;
+        }
+        if (!vertices || !indices || vertex_count == 0 || index_count == 0) return 0;
+
+        MeshRequest request;
+        request.vertices.assign(vertices, vertices + vertex_count);
+        request.indices.assign(indices, indices + index_count);
+
+        std::lock_guard<std::mutex> lock(m_mesh_mutex);
+        request.mesh = m_next_mesh++;
+        const u32 mesh = request.mesh;
+        m_mesh_requests.push_back(std::move(request));
+        return mesh;
+    }
+
+    void VulkanBackend::remove_mesh(u32 mesh) {
+        MeshRequest request;
+        request.mesh = mesh;
+        request.remove = true;
+
+        std::lock_guard<std::mutex> lock(m_mesh_mutex);
+        if (mesh == 0 || mesh >= m_next_mesh) return;
+        m_mesh_requests.push_back(std::move(request));
+    }
+
+    bool VulkanBackend::recreate_swapchain() {
+        SPA_PROFILE_SCOPE("Recreate swapchain");
+
+        // Surfaces without a fixed currentExtent (e.g. Wayland) take the window's pixel size, which the
+        // main thread reads and passes in through resize()
+        VkResult res = m_swapchain.recreate(m_device, m_surface, m_swapchain_width, m_swapchain_height,
+                                            m_deletion_queue, m_frame_number);
+        if (res == VK_NOT_READY) return false; // Minimized: skip frames until the window has an area again
+        if (res != VK_SUCCESS) {
+            SPA_LOG_ERROR("Failed to recreate swapchain ({}).", static_cast<i32>(res));
+            return false;
+        }
+
+        // Transient attachments follow the new size; the graph is recompiled before its next frame
+        if (m_graph.is_created()) {
+            m_graph.set_extent(m_swapchain.get_extent());
+            m_graph.set_import_format(m_backbuffer, m_swapchain.get_pass_target().color_format);
+        }
+        // Unchanged targets map to the pipelines already built
+        if (m_sprites.is_created()) m_sprites.set_target(m_swapchain.get_pass_target());
+        if (m_mesh_renderer.is_created()) m_mesh_renderer.set_target(m_swapchain.get_pass_target());
+
+        m_swapchain_dirty = false;
+        SPA_LOG_DEBUG("Swapchain recreated at {}x{}.", m_swapchain.get_extent().width, m_swapchain.get_extent().height);
+        return true;
     }
 
     bool VulkanBackend::begin_frame(const RenderPacket *packet) {
+        SPA_PROFILE_SCOPE("VulkanBackend::begin_frame");
         VkDevice device = m_device.get_logical_device();
 
-        // Wait on the in-flight fence for the current frame to ensure the previous frame has finished
-        VkFence in_flight_fence = m_sync_objects.get_in_flight_fence(m_current_frame);
-        vkWaitForFences(device, 1, &in_flight_fence, VK_TRUE, UINT64_MAX);
-        vkResetFences(device, 1, &in_flight_fence);
+        // Wait on the in-flight fence for the current frame to ensure the previous frame has finished.
+        // It is only reset right before the next submit, so a frame skipped below leaves it signaled.
+        // In low-latency mode the application already waited before polling input, so this returns at once.
+        wait_for_frame_slot();
+
+        // Queues complete in order, so every frame up to the one that last used this slot is done
+        if (m_frame_number >= m_max_frames_in_flight) {
+            m_deletion_queue.flush(device, m_frame_number - m_max_frames_in_flight + 1);
+        }
+
+        // The frame that last used this slot is done, so its timestamps are readable
+        // and its command buffers can be recycled in one pool reset
+        m_gpu_timer.resolve(device, m_current_frame, m_gpu_frame_ms);
+        VulkanFrame& frame = m_frames[m_current_frame];
+        FrameArena::retire(frame.packet_frame);
+        frame.packet_frame = 0;
+        frame.command_pool.reset(device);
+        if (m_recorder.is_created()) m_recorder.reset_frame(m_current_frame);
+        if (m_dynamic.is_created()) m_dynamic.begin_frame(m_current_frame);
+
+        VulkanDrawWork work;
+        work.item_count = m_draw_fn ? m_draw_count : 0;
+        work.fn = &m_draw_fn;
+        work.recorder = &m_recorder;
 
         // 2. Set clear color for this frame
-        const float* cc = packet->clearColor;
-        m_swapchain.set_clear_color(cc[0], cc[1], cc[2], cc[3]);
+        set_clear_color(packet);
+
+        if (m_headless) {
+            m_current_image_index = m_current_frame;
+            queue_uploads(packet);
+            m_upload_wait_value = m_staging.is_created() ? m_staging.flush() : 0;
+            work.uploads = m_upload_wait_value ? &m_staging : nullptr;
+            prepare_meshes(packet, m_offscreen.get_extent(), work);
+            prepare_sprites(packet, m_offscreen.get_extent(), work);
+
+            SPA_PROFILE_SCOPE("Record commands");
+            if (m_graph.is_created()) {
+                record_graph(frame.command_buffer, m_offscreen.get_images()[m_current_image_index],
+                             m_offscreen.get_color_views()[m_current_image_index], work);
+            } else {
+                m_offscreen.record_single(frame.command_buffer, m_current_image_index, &m_gpu_timer, m_current_frame, &work);
+            }
+            frame.packet_frame = packet->frameNumber;
+            return true;
+        }
+
+        if (m_swapchain_dirty && !recreate_swapchain()) {
+            return false;
+        }
 
         // Acquire next image from the swapchain
-        VkResult result = vkAcquireNextImageKHR(
-            device,
-            m_swapchain.get_swapchain(),
-            UINT64_MAX,
-            m_sync_objects.get_image_available_semaphore(m_current_frame),
-            VK_NULL_HANDLE,
-            &m_current_image_index
-        );
+        VkResult result;
+        {
+            SPA_PROFILE_SCOPE("Acquire image");
+            result = vkAcquireNextImageKHR(
+                device,
+                m_swapchain.get_swapchain(),
+                UINT64_MAX,
+                m_sync_objects.get_image_available_semaphore(m_current_frame),
+                VK_NULL_HANDLE,
+                &m_current_image_index
+            );
+        }
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-            resize(m_swapchain.get_extent().width, m_swapchain.get_extent().height); // trigger recreate
+            m_swapchain_dirty = true; // Recreate next frame at the last size the window reported
             return false;
         }
+        if (result == VK_SUBOPTIMAL_KHR) {
+            // Still presentable; draw this frame and rebuild before the next
+            m_swapchain_dirty = true;
+        }
         if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
             SPA_LOG_ERROR("Failed to acquire swapchain image:");
             printf("\b%d\n", result);
             return false;
         }
 
-        m_swapchain.record_single(m_current_image_index);
+        // Only flush once the frame is certain to be submitted, so its acquire barriers are not lost
+        queue_uploads(packet);
+        m_upload_wait_value = m_staging.is_created() ? m_staging.flush() : 0;
+        work.uploads = m_upload_wait_value ? &m_staging : nullptr;
+        prepare_meshes(packet, m_swapchain.get_extent(), work);
+        prepare_sprites(packet, m_swapchain.get_extent(), work);
+
+        SPA_PROFILE_SCOPE("Record commands");
+        if (m_graph.is_created()) {
+            record_graph(frame.command_buffer, m_swapchain.get_images()[m_current_image_index],
+                         m_swapchain.get_color_views()[m_current_image_index], work);
+        } else {
+            m_swapchain.record_single(frame.command_buffer, m_current_image_index, &m_gpu_timer, m_current_frame, &work);
+        }
+        frame.packet_frame = packet->frameNumber;
 
         return true;
     }
 
 
+    void VulkanBackend::create_graph(bool headless) {
+        const VulkanPassTarget target = headless ? m_offscreen.get_pass_target() : m_swapchain.get_pass_target();
+        const VkExtent2D extent = headless ? m_offscreen.get_extent() : m_swapchain.get_extent();
+        VkResult res = m_graph.create(m_device, extent);
+        VK_CHECK(res);
+
+        // Offscreen images end up ready to be copied out, like the render pass path leaves them
+        m_backbuffer = m_graph.import_image("Backbuffer", target.color_format,
+                                            headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                                     : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        m_depth_target = m_graph.create_image("Depth", {target.depth_format});
+
+        m_main_pass = m_graph.add_pass("Main render pass", [this](const VulkanRenderGraph::PassContext& ctx) {
+            if (m_frame_work) m_frame_work->record(ctx.cmd, ctx.target, ctx.frame);
+        });
+        const VkClearValue clear_depth = {1.0f, 0.0f};
+        m_graph.write(m_main_pass, m_backbuffer, VulkanRenderGraph::Access::ColorWrite, &m_clear_color);
+        m_graph.write(m_main_pass, m_depth_target, VulkanRenderGraph::Access::DepthWrite, &clear_depth);
+
+        // Quads go on top of the main pass. Depth stays bound read-only so the sprite pipelines, built
+        // for the full pass target, match the attachments.
+        if (m_sprites.is_created()) {
+            m_sprite_pass = m_graph.add_pass("Sprites", [this](const VulkanRenderGraph::PassContext& ctx) {
+                m_sprites.record(ctx.cmd);
+            });
+            m_graph.write(m_sprite_pass, m_backbuffer, VulkanRenderGraph::Access::ColorWrite);
+            m_graph.read(m_sprite_pass, m_depth_target, VulkanRenderGraph::Access::DepthRead);
+        }
+    }
+
+    void VulkanBackend::record_graph(VkCommandBuffer cmd, VkImage image, VkImageView view, const VulkanDrawWork& work) {
+        // cmd was reset together with the rest of its frame's pool
+        VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(cmd, &begin_info);
+        m_gpu_timer.write_begin(cmd, m_current_frame);
+        work.record_pre_pass(cmd);
+
+        m_graph.set_image(m_backbuffer, image, view);
+        m_graph.set_clear_value(m_main_pass, m_backbuffer, m_clear_color);
+        m_graph.set_rendering_flags(m_main_pass, work.rendering_flags());
+
+        m_frame_work = &work;
+        VkResult res = m_graph.execute(cmd, &m_gpu_timer, m_current_frame, &m_deletion_queue, m_frame_number);
+        m_frame_work = nullptr;
+        if (res != VK_SUCCESS) SPA_LOG_ERROR("Failed to compile the render graph ({}).", static_cast<i32>(res));
+
+        m_gpu_timer.write_end(cmd, m_current_frame);
+        vkEndCommandBuffer(cmd);
+    }
+
+    void VulkanBackend::queue_uploads(const RenderPacket* packet) {
+        if (m_meshes.is_created()) {
+            apply_mesh_requests();
+            // Same frames as the deletion queue flush in begin_frame
+            const uint64_t frames_completed =
+                m_frame_number >= m_max_frames_in_flight ? m_frame_number - m_max_frames_in_flight + 1 : 0;
+            m_meshes.update(frames_completed);
+        }
+        if (m_textures.is_created()) {
+            m_textures.request_quads(packet->quads, packet->quadCount);
+            m_textures.update(m_deletion_queue, m_frame_number);
+        }
+    }
+
+    void VulkanBackend::apply_mesh_requests() {
+        {
+            std::lock_guard<std::mutex> lock(m_mesh_mutex);
+            m_mesh_batch.swap(m_mesh_requests);
+        }
+
+        for (MeshRequest& request : m_mesh_batch) {
+            if (request.mesh >= m_mesh_ids.size()) {
+                m_mesh_ids.resize(request.mesh + 1, VulkanMeshBuffers::INVALID_MESH);
+            }
+            uint32_t& id = m_mesh_ids[request.mesh];
+            if (request.remove) {
+                // Frames already submitted may still draw it; this one no longer does
+                m_meshes.remove(id, m_frame_number);
+                id = REMOVED_MESH;
+            } else if (id != REMOVED_MESH) {
+                // A mesh removed before its asset finished loading is never added
+                if (!request.asset.is_valid()) {
+                    id = m_meshes.add(request.vertices.data(), static_cast<uint32_t>(request.vertices.size()),
+                                      request.indices.data(), static_cast<uint32_t>(request.indices.size()));
+                } else if (request.view.data) {
+                    id = m_meshes.add(request.view);
+                }
+            }
+            if (request.asset.is_valid()) Assets::release(request.asset);
+        }
+        m_mesh_batch.clear();
+    }
+
+    void VulkanBackend::prepare_meshes(const RenderPacket* packet, VkExtent2D extent, VulkanDrawWork& work) {
+        if (!m_mesh_renderer.is_created() || m_draw_fn) return;
+
+        SPA_PROFILE_SCOPE("Prepare meshes");
+        work.item_count = m_mesh_renderer.prepare(packet->meshes, packet->meshCount, m_mesh_ids, extent);
+        work.fn = &m_mesh_fn;
+    }
+
+    void VulkanBackend::prepare_sprites(const RenderPacket* packet, VkExtent2D extent, VulkanDrawWork& work) {
+        if (!m_sprites.is_created()) return;
+
+        SPA_PROFILE_SCOPE("Prepare sprites");
+        // The frame's fence has signaled, so its region of the instance buffer is free
+        m_sprites.prepare(m_current_frame, packet->quads, packet->quadCount, extent, m_deletion_queue, m_frame_number);
+        if (m_graph.is_created() || !m_sprites.has_work()) return;
+
+        // Render pass path: the quads are drawn inline at the end of the main pass
+        if (!work.is_parallel()) {
+            work.sprites = &m_sprites;
+        } else if (!m_sprites_skipped) {
+            SPA_LOG_WARN("Quads are not drawn while the draw list is recorded in parallel without dynamic rendering.");
+            m_sprites_skipped = true;
+        }
+    }
+
+    void VulkanBackend::set_record_threads(uint32_t thread_count) {
+        // Per-thread pools may still back buffers in flight
+        vkDeviceWaitIdle(m_device.get_logical_device());
+        m_recorder.cleanup();
+
+        if (thread_count <= 1) return;
+
+        VkResult res = m_recorder.create(m_device.get_logical_device(), m_device.get_graphics_queue_family(),
+                                         m_max_frames_in_flight, thread_count);
+        if (res != VK_SUCCESS) {
+            SPA_LOG_ERROR("Failed to create parallel recorder; recording inline.");
+            m_recorder.cleanup();
+            return;
+        }
+        SPA_LOG_DEBUG("Recording draw list on {} threads.", thread_count);
+    }
+
+    bool VulkanBackend::create_frames() {
+        VkDevice device = m_device.get_logical_device();
+        m_frames.resize(m_max_frames_in_flight);
+
+        for (VulkanFrame& frame : m_frames) {
+            // Transient pool: buffers are re-recorded every frame and only reset as a whole
+            VkResult res = frame.command_pool.create(device, m_device.get_graphics_queue_family(),
+                                                     VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+            if (res != VK_SUCCESS) {
+                SPA_LOG_ERROR("Failed to create per-frame command pool.");
+                return false;
+            }
+
+            res = frame.command_pool.allocate_buffers(device, 1);
+            if (res != VK_SUCCESS) {
+                SPA_LOG_ERROR("Failed to allocate per-frame command buffer.");
+                return false;
+            }
+            frame.command_buffer = frame.command_pool.get_buffers()[0];
+        }
+        return true;
+    }
+
+    void VulkanBackend::destroy_frames() {
+        for (VulkanFrame& frame : m_frames) {
+            frame.command_pool.cleanup(m_device.get_logical_device());
+            frame.command_buffer = VK_NULL_HANDLE;
+        }
+        m_frames.clear();
+    }
+
+    void VulkanBackend::restore_frame_fence() {
+        VkResult res = m_sync_objects.recreate_in_flight_fence(m_device.get_logical_device(), m_current_frame);
+        if (res != VK_SUCCESS) SPA_LOG_ERROR("Failed to recreate the frame fence ({}).", static_cast<i32>(res));
+    }
+
+    bool VulkanBackend::submit_offscreen(const RenderPacket* packet) {
+        VkCommandBuffer command_buffer = m_frames[m_current_frame].command_buffer;
+
+        // Nothing to acquire or present; only this frame's uploads need waiting on
+        VkSemaphore timeline = m_staging.get_timeline();
+        VkPipelineStageFlags wait_stage = VulkanStagingRing::CONSUMER_STAGES;
+        VkTimelineSemaphoreSubmitInfo timeline_info = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+        timeline_info.waitSemaphoreValueCount = 1;
+        timeline_info.pWaitSemaphoreValues = &m_upload_wait_value;
+
+        VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &command_buffer;
+        if (m_upload_wait_value != 0) {
+            submit_info.pNext = &timeline_info;
+            submit_info.waitSemaphoreCount = 1;
+            submit_info.pWaitSemaphores = &timeline;
+            submit_info.pWaitDstStageMask = &wait_stage;
+        }
+
+        // Recording succeeded in begin_frame, so the fence is only unsignaled for a submit that happens
+        VkFence in_flight_fence = m_sync_objects.get_in_flight_fence(m_current_frame);
+        vkResetFences(m_device.get_logical_device(), 1, &in_flight_fence);
+        {
+            SPA_PROFILE_SCOPE("Queue submit");
+            if (vkQueueSubmit(m_device.get_graphics_queue(), 1, &submit_info, in_flight_fence) != VK_SUCCESS) {
+                SPA_LOG_ERROR("Failed to submit offscreen command buffer.");
+                restore_frame_fence();
+                return false;
+            }
+        }
+        // Nothing is presented offscreen; the submit is where the frame leaves the CPU
+        Time::report_present(packet->inputSampleNs);
+
+        m_frame_number++;
+        m_current_frame = (m_current_frame + 1) % m_max_frames_in_flight;
+        return true;
+    }
+
     bool VulkanBackend::end_frame(const RenderPacket *packet) {
+        SPA_PROFILE_SCOPE("VulkanBackend::end_frame");
+        if (m_headless) return submit_offscreen(packet);
+
         VkDevice device = m_device.get_logical_device();
 
-        VkSemaphore wait_semaphores[] = {m_sync_objects.get_image_available_semaphore(m_current_frame)};
-        VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        // Binary image-available wait, plus the timeline wait for this frame's uploads if any
+        VkSemaphore wait_semaphores[] = {m_sync_objects.get_image_available_semaphore(m_current_frame),
+                                         m_staging.get_timeline()};
+        VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                              VulkanStagingRing::CONSUMER_STAGES};
+        const uint64_t wait_values[] = {0, m_upload_wait_value};
+        const uint32_t wait_count = m_upload_wait_value != 0 ? 2 : 1;
         VkSemaphore signal_semaphores[] = {m_sync_objects.get_render_finished_semaphore(m_current_frame)};
 
-        VkCommandBuffer command_buffer = m_swapchain.get_command_buffers()[m_current_image_index];
+        VkTimelineSemaphoreSubmitInfo timeline_info = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+        timeline_info.waitSemaphoreValueCount = wait_count;
+        timeline_info.pWaitSemaphoreValues = wait_values;
+
+        VkCommandBuffer command_buffer = m_frames[m_current_frame].command_buffer;
 
         // Submit command buffer
         VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
-        submit_info.waitSemaphoreCount = 1;
+        submit_info.pNext = m_upload_wait_value != 0 ? &timeline_info : nullptr;
+        submit_info.waitSemaphoreCount = wait_count;
         submit_info.pWaitSemaphores = wait_semaphores;
         submit_info.pWaitDstStageMask = wait_stages;
         submit_info.commandBufferCount = 1;
@@ -176,12 +720,22 @@ namespace Sparkle {
         submit_info.signalSemaphoreCount = 1;
         submit_info.pSignalSemaphores = signal_semaphores;
 
+        // Acquire and recording succeeded in begin_frame, so the fence is only unsignaled for a submit that happens
         VkFence in_flight_fence = m_sync_objects.get_in_flight_fence(m_current_frame);
-        if (vkQueueSubmit(m_device.get_graphics_queue(), 1, &submit_info, in_flight_fence) != VK_SUCCESS) {
-            SPA_LOG_ERROR("Failed to submit draw command buffer.");
-            return false;
+        vkResetFences(device, 1, &in_flight_fence);
+        {
+            SPA_PROFILE_SCOPE("Queue submit");
+            if (vkQueueSubmit(m_device.get_graphics_queue(), 1, &submit_info, in_flight_fence) != VK_SUCCESS) {
+                SPA_LOG_ERROR("Failed to submit draw command buffer.");
+                restore_frame_fence();
+                return false;
+            }
         }
 
+        // The frame is on the GPU now, whatever happens to the present
+        m_frame_number++;
+        m_current_frame = (m_current_frame + 1) % m_max_frames_in_flight;
+
         // Present the rendered image to the screen
         VkPresentInfoKHR present_info = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
         present_info.waitSemaphoreCount = 1;
@@ -193,11 +747,19 @@ namespace Sparkle {
         present_info.pImageIndices = &m_current_image_index;
         present_info.pResults = nullptr;
 
-        VkResult result = vkQueuePresentKHR(m_device.get_present_queue(), &present_info);
+        VkResult result;
+        {
+            SPA_PROFILE_SCOPE("Present");
+            result = vkQueuePresentKHR(m_device.get_present_queue(), &present_info);
+        }
+
+        if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+            Time::report_present(packet->inputSampleNs);
+        }
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-            resize(m_swapchain.get_extent().width, m_swapchain.get_extent().height);
-            return false;
+            m_swapchain_dirty = true;
+            return true;
         }
         if (result != VK_SUCCESS) {
             SPA_LOG_ERROR("Failed to present swapchain image: ");
@@ -205,10 +767,6 @@ namespace Sparkle {
 
             return false;
         }
-
-        m_frame_number++;
-        // Advance to next frame in flight
-        m_current_frame = (m_current_frame + 1) % m_max_frames_in_flight;
         return true;
     }
 }
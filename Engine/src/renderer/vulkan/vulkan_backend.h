@@ -10,6 +10,13 @@
 
 namespace Sparkle {
 
+    // Resources owned by one frame in flight; reused only after that frame's fence signals
+    struct VulkanFrame {
+        VulkanCommandPool command_pool;
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        u64 packet_frame = 0; // RenderPacket::frameNumber recorded into this slot, retired with its fence
+    };
+
     class VulkanBackend : public RenderBackend {
     public:
         VulkanBackend() = default;
@@ -24,18 +31,132 @@ namespace Sparkle {
 
         void set_clear_color(const RenderPacket* packet) override {
             const float* cc = packet->clearColor;
-            m_swapchain.set_clear_color(cc[0], cc[1], cc[2], cc[3]);
+            if (m_headless) m_offscreen.set_clear_color(cc[0], cc[1], cc[2], cc[3]);
+            else m_swapchain.set_clear_color(cc[0], cc[1], cc[2], cc[3]);
+            for (int i = 0; i < 4; ++i) m_clear_color.color.float32[i] = cc[i];
+        }
+
+        void set_present_mode(PresentMode mode) override;
+        void wait_for_frame_slot() override;
+        u16 register_texture(AssetHandle asset) override;
+        u32 register_mesh(std::string_view name) override;
+        u32 register_mesh(const MeshVertex* vertices, u32 vertex_count, const u32* indices, u32 index_count) override;
+        void remove_mesh(u32 mesh) override;
+
+        // Number of threads recording the draw list; <= 1 records inline. Waits for the device to idle.
+        void set_record_threads(uint32_t thread_count);
+        uint32_t get_record_threads() const { return m_recorder.is_created() ? m_recorder.get_thread_count() : 1; }
+
+        // Draw list recorded inside the main render pass every frame (fn may be called from worker threads).
+        // While one is set it replaces RenderPacket::meshes; set_draw_work(0, nullptr) goes back to them.
+        void set_draw_work(uint32_t item_count, VulkanParallelRecorder::RecordFn fn) {
+            m_draw_count = item_count;
+            m_draw_fn = std::move(fn);
         }
 
+        // Uploads queued here are copied on the transfer queue and visible to the next frame's draws.
+        // Not created when the device lacks timeline semaphores.
+        VulkanStagingRing& get_staging_ring() { return m_staging; }
+        VulkanDevice& get_device() { return m_device; }
+        // Shader modules and graphics pipelines; pipelines compile on the job system
+        VulkanPipelineManager& get_pipelines() { return m_pipelines; }
+        // Render pass or attachment formats of the main pass, for VulkanPipelineDesc::set_target
+        VulkanPassTarget get_pass_target() const {
+            return m_headless ? m_offscreen.get_pass_target() : m_swapchain.get_pass_target();
+        }
+        // Streams mips of cooked textures within EngineConfig::assets.texture_budget; quads request their
+        // texture at their on-screen size. Not created without a staging ring or Assets.
+        VulkanTextureStreamer& get_textures() { return m_textures; }
+        // Static vertices and indices of every mesh in two shared buffers: bind once per command buffer,
+        // then draw each mesh by offset. Not created without a staging ring.
+        VulkanMeshBuffers& get_meshes() { return m_meshes; }
+        // Records RenderPacket::meshes as the main pass draw work. Not created without mesh buffers or
+        // when the mesh shaders are missing.
+        VulkanMeshRenderer& get_mesh_renderer() { return m_mesh_renderer; }
+        // Per-frame uniforms and instance data; allocate while recording the frame (its region is reset
+        // in begin_frame once the slot's fence has signaled)
+        VulkanDynamicBuffer& get_dynamic_buffer() { return m_dynamic; }
+        // Draws RenderPacket::quads after the main pass. Not created when the sprite shaders are missing.
+        VulkanSpriteRenderer& get_sprites() { return m_sprites; }
+
+        // Frame graph under dynamic rendering (not created on the render pass path). It starts with the
+        // main pass, which clears the backbuffer and a transient depth image and records the draw work;
+        // passes added before or after it (shadows, post-processing, UI) are ordered and synchronized with it.
+        VulkanRenderGraph& get_render_graph() { return m_graph; }
+        uint32_t get_backbuffer() const { return m_backbuffer; }
+        uint32_t get_depth_target() const { return m_depth_target; }
+        uint32_t get_main_pass() const { return m_main_pass; }
+
 
     private:
+        bool create_frames();
+        void destroy_frames();
+        bool submit_offscreen(const RenderPacket* packet);
+        // After a failed submit: leave the frame slot's fence signaled again
+        void restore_frame_fence();
+        bool recreate_swapchain();
+        void create_graph(bool headless);
+        void record_graph(VkCommandBuffer cmd, VkImage image, VkImageView view, const VulkanDrawWork& work);
+        void prepare_sprites(const RenderPacket* packet, VkExtent2D extent, VulkanDrawWork& work);
+        // Mesh chunks and texture mips for this frame's staging batch
+        void queue_uploads(const RenderPacket* packet);
+        // Apply the mesh registrations and removals made on the main thread since the last frame
+        void apply_mesh_requests();
+        // Make the packet's meshes the draw work unless set_draw_work installed a list of its own
+        void prepare_meshes(const RenderPacket* packet, VkExtent2D extent, VulkanDrawWork& work);
+
+        // A register_mesh or remove_mesh call, handed from the main thread to the thread that draws
+        struct MeshRequest {
+            u32 mesh = 0;
+            bool remove = false;
+            AssetHandle asset;   // Loaded Mesh asset to add from view, released once copied
+            AssetView view;
+            std::vector<MeshVertex> vertices;
+            std::vector<u32> indices;
+        };
+        static constexpr uint32_t REMOVED_MESH = VulkanMeshBuffers::INVALID_MESH - 1;
+
+        bool m_headless = false;
         VkInstance m_instance = VK_NULL_HANDLE;
         VkAllocationCallbacks* m_allocator = nullptr;
         VkDebugUtilsMessengerEXT m_debug_messenger{};
         VkSurfaceKHR m_surface = VK_NULL_HANDLE;
         VulkanDevice m_device;
         VulkanSwapchain m_swapchain;
+        VulkanDeletionQueue m_deletion_queue; // Swapchain resources retired while frames were in flight
+        bool m_swapchain_dirty = false;
+        uint32_t m_swapchain_width = 0;
+        uint32_t m_swapchain_height = 0;
+        VulkanOffscreenTarget m_offscreen;
         VulkanSyncObjects m_sync_objects;
+        std::vector<VulkanFrame> m_frames;
+        VulkanParallelRecorder m_recorder;
+        VulkanParallelRecorder::RecordFn m_draw_fn;
+        uint32_t m_draw_count = 0;
+        VulkanGpuTimer m_gpu_timer;
+        VulkanStagingRing m_staging;
+        VulkanTextureStreamer m_textures;
+        VulkanMeshBuffers m_meshes;
+        VulkanMeshRenderer m_mesh_renderer;
+        VulkanParallelRecorder::RecordFn m_mesh_fn;
+        std::mutex m_mesh_mutex;                // Guards the two below
+        std::vector<MeshRequest> m_mesh_requests;
+        u32 m_next_mesh = 1;
+        std::vector<MeshRequest> m_mesh_batch;  // Requests being applied, swapped with m_mesh_requests
+        std::vector<uint32_t> m_mesh_ids;       // Renderer mesh id -> VulkanMeshBuffers id, on the thread that draws
+        VulkanDynamicBuffer m_dynamic;
+        VulkanPipelineManager m_pipelines;
+        VulkanSpriteRenderer m_sprites;
+        bool m_sprites_skipped = false; // Warned that parallel recording on the render pass path hides quads
+        uint64_t m_upload_wait_value = 0; // Timeline value the current frame's graphics submit waits on
+
+        VulkanRenderGraph m_graph;
+        uint32_t m_backbuffer = VulkanRenderGraph::INVALID_ID;
+        uint32_t m_depth_target = VulkanRenderGraph::INVALID_ID;
+        uint32_t m_main_pass = VulkanRenderGraph::INVALID_ID;
+        uint32_t m_sprite_pass = VulkanRenderGraph::INVALID_ID;
+        VkClearValue m_clear_color{};
+        const VulkanDrawWork* m_frame_work = nullptr; // Draw work of the frame being recorded, for the main pass
     };
 
 
@@ -4,14 +4,152 @@
 #include <vulkan/vulkan.h>
 #include "core/spa_assert.h"
 #include "core/logger.h"
+#include "core/job_system.h"
+#include "core/assets.h"
+#include "renderer/sprite_batch.h"
+#include "renderer/mesh_draw.h"
 #include "SDL3/SDL_vulkan.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #define VK_CHECK(res) do {SPA_ASSERT(res == VK_SUCCESS);} while(false)
 
-std::vector<const char*> load_extensions();
+std::vector<const char*> load_extensions(bool headless = false);
 bool setup_validation_layers(VkInstanceCreateInfo& create_info);
 VkResult setup_debugger(VkInstance &m_instance, VkAllocationCallbacks* m_allocator, VkDebugUtilsMessengerEXT &m_debug_messenger);
 
+class VulkanDevice;
+class VulkanSpriteRenderer;
+
+// Destroys Vulkan objects once no frame in flight can still use them. Each entry is tagged with the
+// number of frames submitted when it was retired and runs once that many frames have completed.
+class VulkanDeletionQueue {
+public:
+    using DestroyFn = std::function<void(VkDevice)>;
+
+    VulkanDeletionQueue() = default;
+    ~VulkanDeletionQueue();
+
+    // frames_submitted must not decrease between calls
+    void push(uint64_t frames_submitted, DestroyFn fn);
+    // Run every entry whose frames have all completed
+    void flush(VkDevice device, uint64_t frames_completed);
+    // Run everything; the device must be idle
+    void flush_all(VkDevice device);
+
+    size_t size() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        uint64_t frame = 0;
+        DestroyFn fn;
+    };
+
+    std::deque<Entry> m_entries;
+};
+
+// A range of device memory handed out by VulkanMemoryAllocator
+struct VulkanAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;           // Requested size
+    void* mapped = nullptr;          // Persistently mapped pointer for HOST_VISIBLE memory
+    uint32_t memory_type = UINT32_MAX;
+    uint32_t pool = UINT32_MAX;      // UINT32_MAX for dedicated allocations
+    uint32_t block = UINT32_MAX;
+    uint32_t order = 0;              // Buddy level the range was taken from
+
+    bool is_valid() const { return memory != VK_NULL_HANDLE; }
+    bool is_dedicated() const { return is_valid() && pool == UINT32_MAX; }
+};
+
+struct VulkanMemoryStats {
+    VkDeviceSize bytes_in_use = 0;        // Sum of requested sizes
+    VkDeviceSize bytes_allocated = 0;     // Buddy ranges handed out (includes rounding waste)
+    VkDeviceSize bytes_reserved = 0;      // vkAllocateMemory total: blocks + dedicated allocations
+    VkDeviceSize largest_free_range = 0;
+    uint32_t block_count = 0;
+    uint32_t dedicated_count = 0;
+    uint32_t allocation_count = 0;
+    uint32_t device_allocation_count = 0; // Live vkAllocateMemory calls, bounded by maxMemoryAllocationCount
+    f32 fragmentation = 0.0f;             // 1 - largest_free_range / total free bytes in blocks
+};
+
+// Sub-allocates device memory from large per-memory-type blocks using a buddy allocator.
+// Buffers and images get separate pools so bufferImageGranularity never has to be honoured
+// between neighbours. Large or driver-preferred resources get dedicated allocations.
+class VulkanMemoryAllocator {
+public:
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+    static constexpr VkDeviceSize MIN_ALLOCATION = 256;
+
+    VulkanMemoryAllocator() = default;
+    ~VulkanMemoryAllocator();
+
+    VkResult create(const VulkanDevice& device, VkDeviceSize block_size = DEFAULT_BLOCK_SIZE);
+    void cleanup();
+
+    // Allocate memory satisfying reqs; linear is true for buffers / linear-tiled images
+    VkResult allocate(const VkMemoryRequirements& reqs, VkMemoryPropertyFlags flags, bool linear,
+                      bool dedicated, VulkanAllocation& out);
+    void free(VulkanAllocation& allocation);
+
+    // Create the resource, allocate its memory and bind it
+    VkResult create_image(const VkImageCreateInfo& info, VkMemoryPropertyFlags flags,
+                          VkImage& out_image, VulkanAllocation& out_allocation);
+    VkResult create_buffer(const VkBufferCreateInfo& info, VkMemoryPropertyFlags flags,
+                           VkBuffer& out_buffer, VulkanAllocation& out_allocation);
+    void destroy_image(VkImage& image, VulkanAllocation& allocation);
+    void destroy_buffer(VkBuffer& buffer, VulkanAllocation& allocation);
+
+    VulkanMemoryStats get_stats() const;
+    void test() const;
+
+private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize allocated = 0;
+        std::vector<std::set<VkDeviceSize>> free_lists; // free offsets per order (order 0 = MIN_ALLOCATION)
+    };
+
+    struct Pool {
+        uint32_t memory_type = 0;
+        VkDeviceSize block_size = 0;
+        uint32_t max_order = 0;
+        std::vector<Block> blocks; // empty slots (memory == null) are reused
+    };
+
+    VkResult allocate_dedicated(const VkMemoryRequirements& reqs, uint32_t memory_type,
+                                const VkMemoryDedicatedAllocateInfo* dedicated_info, VulkanAllocation& out);
+    VkResult add_block(Pool& pool, uint32_t& out_block);
+    bool allocate_from_block(Pool& pool, uint32_t block_index, uint32_t order, VkDeviceSize& out_offset);
+    void release_block(Pool& pool, uint32_t block_index);
+    void* map_memory(VkDeviceMemory memory, uint32_t memory_type);
+    static uint32_t order_for_size(VkDeviceSize size);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties m_memory_properties{};
+    VkDeviceSize m_block_size = DEFAULT_BLOCK_SIZE;
+
+    std::vector<Pool> m_pools; // [memory_type * 2 + (linear ? 1 : 0)]
+
+    VkDeviceSize m_bytes_in_use = 0;
+    VkDeviceSize m_dedicated_bytes = 0;
+    uint32_t m_allocation_count = 0;
+    uint32_t m_dedicated_count = 0;
+
+    mutable std::mutex m_mutex;
+};
+
 class VulkanDevice {
 public:
     VulkanDevice() = default;
@@ -30,25 +168,44 @@ public:
     VkQueue get_present_queue() const { return m_present_queue; }
     uint32_t get_graphics_queue_family() const { return m_graphics_queue_family; }
     uint32_t get_present_queue_family() const { return m_present_queue_family; }
+    // Falls back to the graphics queue when the device has no transfer-only family
+    VkQueue get_transfer_queue() const { return m_transfer_queue; }
+    uint32_t get_transfer_queue_family() const { return m_transfer_queue_family; }
+    bool has_dedicated_transfer_queue() const { return m_transfer_queue_family != m_graphics_queue_family; }
+    bool supports_timeline_semaphores() const { return m_timeline_semaphores; }
+    // dynamicRendering and synchronization2 are both enabled
+    bool supports_dynamic_rendering() const { return m_dynamic_rendering; }
+    // textureCompressionBC is enabled
+    bool supports_bc_textures() const { return m_bc_textures; }
+    const VkPhysicalDeviceProperties& get_properties() const { return m_properties; }
+    VulkanMemoryAllocator& get_memory_allocator() { return m_memory; }
 
 private:
     bool is_device_suitable(VkPhysicalDevice device, VkSurfaceKHR surface);
     void pick_physical_device(VkInstance instance, VkSurfaceKHR surface);
     void find_queue_families(VkPhysicalDevice device, VkSurfaceKHR surface);
+    void find_transfer_queue_family(VkPhysicalDevice device);
 
 
 
     VkInstance m_instance = VK_NULL_HANDLE;
     VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties m_properties{};
     VkDevice m_device = VK_NULL_HANDLE;
 
     VkQueue m_graphics_queue = VK_NULL_HANDLE;
     VkQueue m_present_queue = VK_NULL_HANDLE;
+    VkQueue m_transfer_queue = VK_NULL_HANDLE;
 
     uint32_t m_graphics_queue_family = UINT32_MAX;
     uint32_t m_present_queue_family = UINT32_MAX;
+    uint32_t m_transfer_queue_family = UINT32_MAX;
+    bool m_timeline_semaphores = false;
+    bool m_dynamic_rendering = false;
+    bool m_bc_textures = false;
 
     VkAllocationCallbacks* m_allocator = nullptr;
+    VulkanMemoryAllocator m_memory;
 };
 
 
@@ -58,12 +215,16 @@ public:
     VulkanImageViews() = default;
     ~VulkanImageViews();
 
-    // Creates image views for swapchain images + depth image/view
-    VkResult create(VulkanDevice& device, const std::vector<VkImage>& images, VkFormat color_format, VkExtent2D extent);
+    // Creates image views for swapchain images + depth image/view. Without create_depth only the depth
+    // format is picked (the render graph owns depth under dynamic rendering).
+    VkResult create(VulkanDevice& device, const std::vector<VkImage>& images, VkFormat color_format, VkExtent2D extent,
+                    bool create_depth = true);
 
     void test() const;
 
     void cleanup(VkDevice device);
+    // Hand every view and the depth image to the deletion queue instead of destroying them now
+    void retire(VulkanDeletionQueue& queue, uint64_t frames_submitted);
 
     const std::vector<VkImageView>& get_color_views() const { return m_color_views; }
     VkImageView get_depth_view() const { return m_depth_view; }
@@ -74,8 +235,9 @@ private:
     std::vector<VkImageView> m_color_views;
 
     // Depth buffer
+    VulkanMemoryAllocator* m_memory = nullptr;
     VkImage m_depth_image = VK_NULL_HANDLE;
-    VkDeviceMemory m_depth_memory = VK_NULL_HANDLE;
+    VulkanAllocation m_depth_allocation;
     VkImageView m_depth_view = VK_NULL_HANDLE;
     VkFormat m_depth_format{};
 
@@ -89,9 +251,13 @@ public:
     VulkanRenderPass() = default;
     ~VulkanRenderPass();
 
-    // Create a render pass with given color + depth formats
-    VkResult create(VkDevice device, VkFormat color_format, VkFormat depth_format);
+    // Create a render pass with given color + depth formats.
+    // Offscreen targets finish in a non-present layout (e.g. TRANSFER_SRC for readback)
+    VkResult create(VkDevice device, VkFormat color_format, VkFormat depth_format,
+                    VkImageLayout color_final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
     void cleanup(VkDevice device);
+    // Give up ownership without destroying (for deferred destruction)
+    VkRenderPass release();
 
     VkRenderPass get() const { return m_render_pass; }
 
@@ -100,6 +266,161 @@ private:
 };
 
 
+// What a pass draws into, as seen by pipelines and secondary command buffers: a render pass
+// (+ framebuffer when recording) on the legacy path, or just the attachment formats under dynamic rendering
+struct VulkanPassTarget {
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkFormat color_format = VK_FORMAT_UNDEFINED;
+    VkFormat depth_format = VK_FORMAT_UNDEFINED;
+
+    bool is_dynamic() const { return render_pass == VK_NULL_HANDLE; }
+};
+
+
+// Fixed-function and shader state a graphics pipeline is built from. Descs that compare equal
+// share one VkPipeline. Viewport and scissor are always dynamic.
+struct VulkanPipelineDesc {
+    static constexpr uint32_t MAX_ATTRIBUTES = 8;
+    static constexpr uint32_t MAX_SET_LAYOUTS = 4;
+
+    // Ids from VulkanPipelineManager::load_shader
+    uint32_t vertex_shader = UINT32_MAX;
+    uint32_t fragment_shader = UINT32_MAX;
+
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cull_mode = VK_CULL_MODE_NONE;
+    VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    bool depth_test = true;
+    bool depth_write = true;
+    VkCompareOp depth_compare = VK_COMPARE_OP_LESS;
+    bool alpha_blend = false; // SRC_ALPHA / ONE_MINUS_SRC_ALPHA on the color attachment
+
+    // One interleaved vertex buffer at binding 0; a stride of 0 means no vertex input
+    uint32_t vertex_stride = 0;
+    VkVertexInputRate input_rate = VK_VERTEX_INPUT_RATE_VERTEX; // INSTANCE: one element per instance
+    uint32_t attribute_count = 0;
+    VkVertexInputAttributeDescription attributes[MAX_ATTRIBUTES] = {};
+
+    // One push constant range at offset 0, visible to push_constant_stages
+    uint32_t push_constant_size = 0;
+    VkShaderStageFlags push_constant_stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    uint32_t set_layout_count = 0;
+    VkDescriptorSetLayout set_layouts[MAX_SET_LAYOUTS] = {};
+
+    // Any render pass compatible with the one the pipeline is bound in, or VK_NULL_HANDLE to build
+    // for dynamic rendering with the attachment formats below
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    uint32_t subpass = 0;
+    VkFormat color_format = VK_FORMAT_UNDEFINED;
+    VkFormat depth_format = VK_FORMAT_UNDEFINED;
+
+    // Fill render_pass or the formats from the target the pipeline will draw into
+    void set_target(const VulkanPassTarget& target) {
+        render_pass = target.render_pass;
+        subpass = 0;
+        color_format = target.is_dynamic() ? target.color_format : VK_FORMAT_UNDEFINED;
+        depth_format = target.is_dynamic() ? target.depth_format : VK_FORMAT_UNDEFINED;
+    }
+
+    uint64_t hash() const;
+    bool operator==(const VulkanPipelineDesc& other) const;
+};
+
+struct VulkanPipelineStats {
+    uint32_t shader_count = 0;
+    uint32_t pipeline_count = 0;   // Unique descs requested
+    uint32_t compiled_count = 0;
+    uint32_t failed_count = 0;
+    uint64_t dedup_hits = 0;       // Requests answered by an existing pipeline
+    f64 compile_ms = 0.0;          // Summed over all compiles (they may overlap on the job system)
+    size_t cache_bytes_loaded = 0; // Size of the pipeline cache read from disk, 0 on a cold start
+};
+
+// Loads SPIR-V shader modules and builds graphics pipelines from VulkanPipelineDesc, handing out one
+// pipeline per unique desc. Pipelines compile on the job system, seeded from a VkPipelineCache that is
+// read from and written back to disk so later runs skip most of the driver's compile work.
+class VulkanPipelineManager {
+public:
+    static constexpr uint32_t MAX_PIPELINES = 1024;
+
+    VulkanPipelineManager() = default;
+    ~VulkanPipelineManager();
+
+    // cache_path may be nullptr to keep the pipeline cache in memory. A cache file written by another
+    // device or driver version is ignored and replaced on save.
+    VkResult create(VulkanDevice& device, const char* cache_path);
+    // Waits for pending compiles, saves the cache and destroys every pipeline and shader module
+    void cleanup(VkDevice device);
+    bool is_created() const { return m_cache != VK_NULL_HANDLE; }
+
+    // Load a SPIR-V module once per name / path; UINT32_MAX on failure
+    uint32_t load_shader(const char* path);
+    uint32_t load_shader(const char* name, const uint32_t* code, size_t size_bytes);
+
+    // Id of the pipeline for desc, queueing its compile the first time desc is seen.
+    // UINT32_MAX if desc names an unknown shader or the manager is full.
+    uint32_t request(const VulkanPipelineDesc& desc);
+    // VK_NULL_HANDLE while the pipeline is compiling or if its compile failed
+    VkPipeline get(uint32_t pipeline) const;
+    VkPipelineLayout get_layout(uint32_t pipeline) const;
+    // Run jobs until the pipeline is compiled, then return it (VK_NULL_HANDLE if it failed)
+    VkPipeline wait(uint32_t pipeline);
+    void wait_all();
+
+    // Write the pipeline cache to disk now; cleanup does this too
+    bool save_cache();
+
+    VulkanPipelineStats get_stats() const;
+    void test() const;
+
+private:
+    enum class PipelineState : uint8_t { Pending, Ready, Failed };
+
+    struct Shader {
+        std::string name;
+        VkShaderModule module = VK_NULL_HANDLE;
+    };
+
+    struct Pipeline {
+        VulkanPipelineDesc desc;
+        VkShaderModule vertex = VK_NULL_HANDLE;
+        VkShaderModule fragment = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        std::atomic<VkPipeline> pipeline{VK_NULL_HANDLE};
+        std::atomic<PipelineState> state{PipelineState::Pending};
+        Sparkle::JobCounter compile_job;
+    };
+
+    void compile(Pipeline& pipeline);
+    VkPipelineLayout get_or_create_layout(const VulkanPipelineDesc& desc);
+    std::vector<uint8_t> load_cache_file() const;
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties m_properties{};
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    std::string m_cache_path;
+    size_t m_cache_bytes_loaded = 0;
+
+    std::vector<Shader> m_shaders;
+    std::unordered_map<std::string, uint32_t> m_shader_ids;
+
+    // Fixed storage so get() can read entries without the lock while request() appends
+    std::unique_ptr<Pipeline[]> m_pipelines;
+    std::atomic<uint32_t> m_pipeline_count{0};
+    std::unordered_multimap<uint64_t, uint32_t> m_pipeline_ids; // desc hash -> id
+    std::unordered_map<uint64_t, VkPipelineLayout> m_layouts;   // layout hash -> layout
+    uint64_t m_dedup_hits = 0;
+
+    std::atomic<uint32_t> m_compiled_count{0};
+    std::atomic<uint32_t> m_failed_count{0};
+    std::atomic<uint64_t> m_compile_ns{0};
+
+    mutable std::mutex m_mutex;
+};
+
+
 // Manages Vulkan framebuffers for each swapchain image view
 class VulkanFramebufferManager {
 public:
@@ -115,6 +436,8 @@ public:
 
     // Destroy all framebuffers
     void cleanup(VkDevice device);
+    // Destroy them once the frames submitted so far have completed
+    void retire(VulkanDeletionQueue& queue, uint64_t frames_submitted);
 
     // Accessor
     const std::vector<VkFramebuffer>& get_all() const { return m_framebuffers; }
@@ -133,11 +456,17 @@ public:
     VulkanCommandPool() = default;
     ~VulkanCommandPool();
 
-    // Create the command pool for a specific queue family
-    VkResult create(VkDevice device, uint32_t queue_family_index);
+    // Create the command pool for a specific queue family.
+    // Per-frame pools pass TRANSIENT and are recycled as a whole with reset()
+    VkResult create(VkDevice device, uint32_t queue_family_index,
+                    VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
-    // Allocate primary command buffers
-    VkResult allocate_buffers(VkDevice device, uint32_t count);
+    // Allocate command buffers (primary unless asked for secondaries)
+    VkResult allocate_buffers(VkDevice device, uint32_t count,
+                              VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+    // Reset every buffer allocated from this pool in one call (vkResetCommandPool)
+    VkResult reset(VkDevice device);
 
     // Free and destroy all Vulkan resources
     void cleanup(VkDevice device);
@@ -154,6 +483,828 @@ private:
 };
 
 
+// Measures GPU time per frame in flight with a begin/end timestamp pair, plus up to MAX_ZONES
+// named zones inside the frame that are handed to the Profiler's GPU track while it records
+class VulkanGpuTimer {
+public:
+    static constexpr uint32_t MAX_ZONES = 8;
+
+    VulkanGpuTimer() = default;
+    ~VulkanGpuTimer();
+
+    // Creates the timestamp queries for every frame; does nothing if the device can't time graphics queues
+    VkResult create(VulkanDevice& device, uint32_t max_frames_in_flight);
+    void cleanup(VkDevice device);
+
+    // Recorded outside of a render pass at the start / end of the frame's command buffer
+    void write_begin(VkCommandBuffer cmd, uint32_t frame);
+    void write_end(VkCommandBuffer cmd, uint32_t frame);
+
+    // Zones nest inside write_begin / write_end and may be nested in each other.
+    // name must be a string literal; zones past MAX_ZONES are ignored.
+    void begin_zone(VkCommandBuffer cmd, uint32_t frame, const char* name);
+    void end_zone(VkCommandBuffer cmd, uint32_t frame);
+
+    // Reads back the frame's queries; call only after the frame's fence has signaled.
+    // Returns false when no result is available yet.
+    bool resolve(VkDevice device, uint32_t frame, f64& out_ms);
+
+    bool is_supported() const { return m_pool != VK_NULL_HANDLE; }
+
+private:
+    static constexpr uint32_t QUERIES_PER_FRAME = 2 + MAX_ZONES * 2;
+
+    struct FrameQueries {
+        bool written = false;
+        uint32_t zone_count = 0;
+        uint32_t open_count = 0;
+        const char* names[MAX_ZONES] = {};
+        uint32_t open[MAX_ZONES] = {}; // Zones begun but not yet ended, innermost last
+    };
+
+    // Offset from GPU timestamps (in ns) to Profiler::now_ns()
+    void calibrate(VulkanDevice& device);
+
+    VkQueryPool m_pool = VK_NULL_HANDLE;
+    f64 m_period_ns = 0.0;
+    uint64_t m_valid_mask = ~0ull; // Bits of a result the graphics queue family defines (timestampValidBits)
+    i64 m_gpu_to_cpu_ns = 0;
+    std::vector<FrameQueries> m_frames;
+};
+
+
+// Persistently mapped, host-coherent upload buffer cut into one region per frame in flight.
+// Copies queued during a frame are submitted as one batch on the transfer queue (the graphics queue
+// when the device has no separate one) and signal a timeline semaphore the graphics submit waits on,
+// so uploads overlap rendering of the previous frame instead of stalling it.
+class VulkanStagingRing {
+public:
+    static constexpr VkDeviceSize DEFAULT_REGION_SIZE = 16ull * 1024 * 1024;
+    // Stages that may read uploaded data; the graphics submit waits on the timeline here
+    static constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                                            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    VulkanStagingRing() = default;
+    ~VulkanStagingRing();
+
+    // Needs timeline semaphore support (VulkanDevice::supports_timeline_semaphores)
+    VkResult create(VulkanDevice& device, uint32_t max_frames_in_flight,
+                    VkDeviceSize region_size = DEFAULT_REGION_SIZE);
+    void cleanup(VkDevice device);
+    bool is_created() const { return m_buffer != VK_NULL_HANDLE; }
+
+    // Copy data into the current region and queue a copy into dst. Thread-safe.
+    // Returns false when the region is full; retry after the next flush.
+    bool upload_buffer(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dst_offset = 0);
+    // Same for one whole mip level of a single-layer color image (data tightly packed, blocks for
+    // compressed formats). The level's old contents are discarded; it ends up in
+    // SHADER_READ_ONLY_OPTIMAL for the graphics frame that waits on the flush.
+    bool upload_image(const void* data, VkDeviceSize size, VkImage dst, uint32_t mip_level, VkExtent2D extent);
+
+    // Submit everything queued since the last flush and open the next region (waiting for its
+    // previous batch only if the GPU is that far behind). Returns the timeline value the graphics
+    // submit must wait for, 0 if nothing was queued.
+    uint64_t flush();
+
+    // Acquire side of the queue family ownership transfer for the last flush. Record outside a
+    // render pass in the graphics command buffer that waits on flush()'s value.
+    void record_acquire(VkCommandBuffer cmd) const;
+
+    VkSemaphore get_timeline() const { return m_timeline; }
+    VkDeviceSize get_region_size() const { return m_region_size; }
+    uint64_t get_bytes_uploaded() const { return m_bytes_uploaded; }
+
+    void test() const;
+
+private:
+    struct Region {
+        VulkanCommandPool pool;
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        uint64_t timeline_value = 0; // Signaled once this region's last batch has been copied
+        bool recording = false;
+        std::vector<VkBufferMemoryBarrier> releases;
+        std::vector<VkBufferMemoryBarrier> acquires;
+        std::vector<VkImageMemoryBarrier> image_releases;
+        std::vector<VkImageMemoryBarrier> image_acquires;
+    };
+
+    void open_region(uint32_t index);
+    // Copy data into the current region and start its command buffer; m_mutex held
+    bool stage(const void* data, VkDeviceSize size, VkDeviceSize& src_offset);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VulkanMemoryAllocator* m_memory = nullptr;
+    VkQueue m_queue = VK_NULL_HANDLE;
+    uint32_t m_transfer_family = UINT32_MAX;
+    uint32_t m_graphics_family = UINT32_MAX;
+
+    VkBuffer m_buffer = VK_NULL_HANDLE;
+    VulkanAllocation m_allocation;
+    VkDeviceSize m_region_size = 0;
+
+    VkSemaphore m_timeline = VK_NULL_HANDLE;
+    uint64_t m_timeline_value = 0;
+
+    std::vector<Region> m_regions;
+    uint32_t m_current = 0;
+    std::vector<VkBufferMemoryBarrier> m_pending_acquires;
+    std::vector<VkImageMemoryBarrier> m_pending_image_acquires;
+    uint64_t m_bytes_uploaded = 0;
+
+    std::mutex m_mutex;
+};
+
+struct VulkanTextureStreamStats {
+    uint32_t textures = 0;          // Registered with add()
+    uint32_t resident = 0;          // With at least their mip tail on the GPU
+    uint32_t streaming = 0;         // Residency changes in flight
+    uint32_t budget_limited = 0;    // Wanted a finer mip this frame than the budget allowed
+    uint32_t loads_started = 0;     // This frame
+    uint32_t loads_completed = 0;   // This frame
+    uint32_t evictions = 0;         // This frame: finest mips dropped to make room
+    VkDeviceSize resident_bytes = 0;   // Mips of swapped-in images
+    VkDeviceSize committed_bytes = 0;  // What residency converges to once streams finish; kept <= budget
+    VkDeviceSize budget_bytes = 0;
+    VkDeviceSize uploaded_bytes = 0;   // This frame
+};
+
+// Streams the mip chains of cooked textures (TextureHeader assets) into device memory on demand.
+// A registered texture always keeps its mip tail (mips up to TAIL_SIZE) resident; finer mips are loaded
+// when request*() reports it covering more screen pixels, and the least recently requested textures lose
+// their finest mip whenever the committed size would pass the budget. A residency change builds a new
+// image holding the wanted mip and everything coarser: the mips are paged in from the archive by the
+// asset I/O threads, uploaded through the staging ring over as many frames as its regions allow, and
+// the new view replaces the old one only once complete, so sampling never sees a partial chain.
+// Texture ids start at 1, so Quad::texture 0 stays "untextured".
+class VulkanTextureStreamer {
+public:
+    static constexpr uint32_t MAX_TEXTURES = 4096;
+    static constexpr uint32_t TAIL_SIZE = 64;    // Mips no larger than this are never evicted
+    static constexpr uint32_t MAX_STREAMS = 8;   // Residency changes in flight at once
+
+    VulkanTextureStreamer() = default;
+    ~VulkanTextureStreamer();
+
+    // Needs a created staging ring and Assets
+    VkResult create(VulkanDevice& device, VulkanStagingRing& staging, VkDeviceSize budget);
+    // The device must be idle
+    void cleanup(VkDevice device);
+    bool is_created() const { return m_staging != nullptr; }
+
+    // Threads: add() on the thread that runs Assets::update, whose prefetch callbacks only queue
+    // completions for update() to apply. request*() from any thread. Everything else on the thread
+    // that draws frames, which is the render thread when pipelined_render is on.
+
+    // Register a Texture asset; its header is read on the I/O threads and its tail streamed after that.
+    // Returns the id the other calls take, 0 when the table is full.
+    uint32_t add(Sparkle::AssetHandle asset);
+    void set_budget(VkDeviceSize bytes) { m_budget = bytes; }
+
+    // Feedback for this frame: texture spans pixels screen pixels along its larger axis. The largest
+    // request of the frame wins. Thread-safe.
+    void request(uint32_t texture, f32 pixels);
+    // Distance-based estimate: an object world_size across at distance under a perspective projection
+    void request_distance(uint32_t texture, f32 world_size, f32 distance, f32 fov_y, uint32_t viewport_height);
+    // Request every quad's texture at its size (Quad::texture taken as a streamer id)
+    void request_quads(const Sparkle::Quad* quads, uint32_t count);
+
+    // Apply finished reads, then start, advance and finish residency changes from this frame's requests.
+    // Call once per frame after its fence has signaled and before VulkanStagingRing::flush, whose batch
+    // then carries the uploads.
+    void update(VulkanDeletionQueue& deletion_queue, uint64_t frames_submitted);
+
+    // All resident mips, in SHADER_READ_ONLY_OPTIMAL; VK_NULL_HANDLE until the tail has arrived.
+    // Changes when a stream finishes, so fetch it every frame rather than caching descriptors of it.
+    VkImageView get_view(uint32_t texture) const;
+    // Finest resident mip level of the full chain, UINT32_MAX when none
+    uint32_t get_resident_mip(uint32_t texture) const;
+    const VulkanTextureStreamStats& get_stats() const { return m_stats; }
+
+    void test() const;
+
+private:
+    enum class State : uint8_t { Header, Ready, Failed };
+
+    struct Texture {
+        Sparkle::AssetHandle asset;
+        State state = State::Header;
+        Sparkle::TextureHeader header{};
+        std::vector<Sparkle::TextureMip> mips;
+        const u8* blob = nullptr;           // In the archive mapping, valid until Assets::shutdown
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t tail = 0;                  // Coarsest mip ever streamed in; always resident
+        uint32_t wanted = 0;                // Mip the latest request asked for
+        std::atomic<uint32_t> pixels = 0;   // Largest request this frame
+        uint64_t last_used = 0;             // Frame of the latest request
+
+        VkImage image = VK_NULL_HANDLE;
+        VulkanAllocation allocation;
+        VkImageView view = VK_NULL_HANDLE;
+        uint32_t resident_mip = UINT32_MAX;
+
+        // The image being filled; replaces the one above once every level is uploaded
+        VkImage next_image = VK_NULL_HANDLE;
+        VulkanAllocation next_allocation;
+        VkImageView next_view = VK_NULL_HANDLE;
+        uint32_t next_mip = UINT32_MAX;
+        uint32_t next_uploaded = 0;         // Levels of next_image uploaded so far
+        bool next_paged = false;            // Its mips are paged in
+        uint32_t stream_serial = 0;         // Tells completions of a replaced stream apart
+    };
+
+    // A prefetch that finished, handed from the thread running Assets::update to update()
+    struct Completion {
+        uint32_t id = 0;
+        uint32_t serial = 0;                // Stream whose mips were paged in; 0 for the header read
+        Sparkle::AssetView view;
+        bool ok = false;
+    };
+
+    void complete(const Completion& completion);
+    bool parse_header(Texture& texture, const Sparkle::AssetView& view);
+    // Bytes of mips [mip, end): what an image starting at mip holds
+    VkDeviceSize chain_bytes(const Texture& texture, uint32_t mip) const;
+    // The mip residency is converging to
+    uint32_t target_mip(const Texture& texture) const;
+    bool start_stream(uint32_t id, uint32_t mip);
+    void advance_stream(Texture& texture, VulkanDeletionQueue& deletion_queue, uint64_t frames_submitted);
+    // Drop the finest mip of the least recently used texture that this frame doesn't need it of
+    bool evict_one(uint32_t keep);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VulkanMemoryAllocator* m_memory = nullptr;
+    VulkanStagingRing* m_staging = nullptr;
+    bool m_bc_textures = false;
+
+    std::unique_ptr<Texture[]> m_textures; // [0] unused
+    std::atomic<uint32_t> m_count = 1;
+    uint32_t m_streaming = 0;
+    std::vector<uint32_t> m_candidates; // Textures wanting a finer mip, in load order
+    std::mutex m_completed_mutex;
+    std::vector<Completion> m_completed; // Guarded by m_completed_mutex
+    std::vector<Completion> m_applying;  // Swapped with m_completed by update()
+    uint64_t m_frame = 0;
+    VkDeviceSize m_budget = 0;
+    VkDeviceSize m_committed = 0;
+    VulkanTextureStreamStats m_stats;
+};
+
+// First-fit free list over [0, capacity) in whatever unit the owner counts in (vertices, indices),
+// merging neighbours on free. Shared buffers hand out these offsets instead of buffers of their own.
+class VulkanRangeAllocator {
+public:
+    static constexpr VkDeviceSize INVALID = UINT64_MAX;
+
+    void reset(VkDeviceSize capacity);
+    // INVALID when no free range is large enough
+    VkDeviceSize allocate(VkDeviceSize size);
+    void free(VkDeviceSize offset, VkDeviceSize size);
+
+    VkDeviceSize get_capacity() const { return m_capacity; }
+    VkDeviceSize get_used() const { return m_used; }
+    VkDeviceSize get_largest_free() const;
+    uint32_t get_free_range_count() const { return static_cast<uint32_t>(m_free.size()); }
+
+private:
+    std::map<VkDeviceSize, VkDeviceSize> m_free; // offset -> size
+    VkDeviceSize m_capacity = 0;
+    VkDeviceSize m_used = 0;
+};
+
+// Where a mesh lives in VulkanMeshBuffers; the arguments of its vkCmdDrawIndexed
+struct VulkanMesh {
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+    int32_t vertex_offset = 0;   // Added to each index: the mesh's first vertex in the shared buffer
+    uint32_t vertex_count = 0;
+    f32 bounds_min[3] = {};
+    f32 bounds_max[3] = {};
+};
+
+struct VulkanMeshStats {
+    uint32_t meshes = 0;
+    uint32_t pending_uploads = 0;     // Chunks waiting for staging space
+    VkDeviceSize vertices_used = 0;
+    VkDeviceSize vertex_capacity = 0;
+    VkDeviceSize indices_used = 0;
+    VkDeviceSize index_capacity = 0;
+    uint32_t free_ranges = 0;         // Holes in both buffers; many small ones mean fragmentation
+    VkDeviceSize uploaded_bytes = 0;  // Since create
+};
+
+// Static geometry of every mesh in two shared device-local buffers: vertices (Sparkle::MeshVertex) in
+// one, uint32 indices in the other, each sub-allocated by offset. Bind both once per command buffer and
+// every mesh is one vkCmdDrawIndexed with its first index and vertex offset, without rebinding.
+// Data goes through the staging ring; chunks that don't fit the current region wait in CPU memory and
+// are queued by update() in later frames, and a mesh is drawable once all of its chunks are queued.
+class VulkanMeshBuffers {
+public:
+    static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 2 * 1024 * 1024; // Vertices (64 MiB)
+    static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 8 * 1024 * 1024;  // Indices (32 MiB)
+    static constexpr uint32_t INVALID_MESH = UINT32_MAX;
+
+    VulkanMeshBuffers() = default;
+    ~VulkanMeshBuffers();
+
+    VkResult create(VulkanDevice& device, VulkanStagingRing& staging,
+                    uint32_t vertex_capacity = DEFAULT_VERTEX_CAPACITY,
+                    uint32_t index_capacity = DEFAULT_INDEX_CAPACITY);
+    // The device must be idle
+    void cleanup(VkDevice device);
+    bool is_created() const { return m_vertex_buffer != VK_NULL_HANDLE; }
+
+    // A mesh cooked by sparkle_cook (MeshHeader blob, e.g. the AssetView of a Mesh asset); 16-bit
+    // indices are widened. INVALID_MESH if the blob is malformed or the buffers are full.
+    uint32_t add(const Sparkle::AssetView& view);
+    uint32_t add(const Sparkle::MeshVertex* vertices, uint32_t vertex_count, const uint32_t* indices,
+                 uint32_t index_count);
+    // The id can be reused right away; the ranges only once frames that may draw the mesh have completed
+    void remove(uint32_t mesh, uint64_t frames_submitted);
+
+    // Free the ranges of meshes removed before frames_completed, then queue chunks that earlier frames
+    // had no staging space for. Call before VulkanStagingRing::flush.
+    void update(uint64_t frames_completed);
+
+    // False while some of the mesh's data still waits for staging space
+    bool is_ready(uint32_t mesh) const { return mesh < m_pending_chunks.size() && m_pending_chunks[mesh] == 0; }
+    const VulkanMesh& get(uint32_t mesh) const { return m_meshes[mesh]; }
+
+    // Bind both buffers; once per command buffer (each parallel recording slice binds its own)
+    void bind(VkCommandBuffer cmd) const;
+    void draw(VkCommandBuffer cmd, uint32_t mesh, uint32_t instance_count = 1, uint32_t first_instance = 0) const {
+        const VulkanMesh& m = m_meshes[mesh];
+        vkCmdDrawIndexed(cmd, m.index_count, instance_count, m.first_index, m.vertex_offset, first_instance);
+    }
+
+    // Also bindable as storage buffers, for vertex pulling
+    VkBuffer get_vertex_buffer() const { return m_vertex_buffer; }
+    VkBuffer get_index_buffer() const { return m_index_buffer; }
+    VulkanMeshStats get_stats() const;
+    void test() const;
+
+private:
+    struct Chunk {
+        uint32_t mesh = 0;
+        VkBuffer dst = VK_NULL_HANDLE;
+        VkDeviceSize dst_offset = 0;
+        std::vector<u8> data;
+    };
+
+    // Ranges of a removed mesh, held until the frames that may still draw it have completed
+    struct Retired {
+        uint64_t frame = 0;
+        VkDeviceSize first_vertex = 0;
+        uint32_t vertex_count = 0;
+        uint32_t first_index = 0;
+        uint32_t index_count = 0;
+    };
+
+    // Stage size bytes for dst at dst_offset, keeping what doesn't fit for update()
+    void upload(uint32_t mesh, const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dst_offset);
+
+    VulkanMemoryAllocator* m_memory = nullptr;
+    VulkanStagingRing* m_staging = nullptr;
+
+    VkBuffer m_vertex_buffer = VK_NULL_HANDLE;
+    VulkanAllocation m_vertex_allocation;
+    VkBuffer m_index_buffer = VK_NULL_HANDLE;
+    VulkanAllocation m_index_allocation;
+    VulkanRangeAllocator m_vertices;
+    VulkanRangeAllocator m_indices;
+
+    std::vector<VulkanMesh> m_meshes;
+    std::vector<uint32_t> m_pending_chunks; // Per mesh; UINT32_MAX marks a free id
+    std::vector<uint32_t> m_free_ids;
+    std::deque<Chunk> m_chunks;
+    std::deque<Retired> m_retired;
+    std::vector<uint32_t> m_widened;        // Scratch for 16-bit index blobs
+    VkDeviceSize m_uploaded_bytes = 0;
+};
+
+// Per-frame data the CPU rewrites every frame (uniforms, instance data, dynamic vertices): one
+// persistently mapped, host-coherent buffer with a region per frame in flight that allocations bump
+// through. Bind it once and address each allocation by its offset (dynamic uniform offset, vertex
+// buffer offset, or an index into a storage buffer).
+class VulkanDynamicBuffer {
+public:
+    static constexpr VkDeviceSize DEFAULT_REGION_SIZE = 4ull * 1024 * 1024;
+
+    struct Allocation {
+        void* data = nullptr; // nullptr when the frame's region is full
+        VkDeviceSize offset = 0;
+    };
+
+    VulkanDynamicBuffer() = default;
+    ~VulkanDynamicBuffer();
+
+    VkResult create(VulkanDevice& device, uint32_t max_frames_in_flight,
+                    VkDeviceSize region_size = DEFAULT_REGION_SIZE);
+    // The device must be idle
+    void cleanup(VkDevice device);
+    bool is_created() const { return m_buffer != VK_NULL_HANDLE; }
+
+    // Start handing out frame's region; call once its fence has signaled
+    void begin_frame(uint32_t frame);
+    // size bytes aligned for any use (at least minUniformBufferOffsetAlignment). Thread-safe.
+    Allocation allocate(VkDeviceSize size);
+
+    VkBuffer get_buffer() const { return m_buffer; }
+    VkDeviceSize get_region_size() const { return m_region_size; }
+    // Bytes handed out in the current frame, and the most any frame has asked for (including refusals)
+    VkDeviceSize get_used() const { return std::min(m_offset.load(std::memory_order_relaxed), m_region_size); }
+    VkDeviceSize get_peak() const { return m_peak; }
+    void test() const;
+
+private:
+    VulkanMemoryAllocator* m_memory = nullptr;
+    VkBuffer m_buffer = VK_NULL_HANDLE;
+    VulkanAllocation m_allocation;
+    VkDeviceSize m_region_size = 0;
+    VkDeviceSize m_alignment = 16;
+    uint32_t m_frame_count = 0;
+
+    VkDeviceSize m_region_start = 0;
+    std::atomic<VkDeviceSize> m_offset = 0; // Within the current region
+    VkDeviceSize m_peak = 0;
+};
+
+// Records a draw list in parallel on the job system: the list is cut into one slice per
+// recording thread, and each slice owns a transient pool per frame in flight from which its
+// secondary command buffer is allocated (a pool is only ever used by one job at a time).
+class VulkanParallelRecorder {
+public:
+    // Records items [first, first + count) into cmd; called concurrently from several threads
+    using RecordFn = std::function<void(VkCommandBuffer cmd, uint32_t first, uint32_t count)>;
+
+    VulkanParallelRecorder() = default;
+    ~VulkanParallelRecorder();
+
+    VkResult create(VkDevice device, uint32_t queue_family, uint32_t max_frames_in_flight, uint32_t thread_count);
+    void cleanup();
+
+    // Recycle all of the frame's per-slice pools; call once the frame's fence has signaled
+    void reset_frame(uint32_t frame);
+
+    // Split item_count items across slices and record them as secondaries continuing subpass 0 of
+    // target's render pass, or its dynamic rendering scope. Blocks until every slice is ended; returns
+    // the buffers in draw order.
+    const std::vector<VkCommandBuffer>& record(uint32_t frame, const VulkanPassTarget& target,
+                                               uint32_t item_count, const RecordFn& fn);
+
+    uint32_t get_thread_count() const { return m_thread_count; }
+    bool is_created() const { return m_thread_count > 0; }
+
+private:
+    void record_slice(uint32_t slice, uint32_t frame, const VulkanPassTarget& target,
+                      uint32_t item_count, const RecordFn& fn);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    uint32_t m_thread_count = 0;
+    std::vector<VulkanCommandPool> m_pools;       // [frame * thread_count + slice]
+    std::vector<VkCommandBuffer> m_slice_buffers; // one slot per slice, null when the slice was empty
+    std::vector<VkCommandBuffer> m_executed;      // non-empty slices of the last record()
+};
+
+// Draw list handed to record_single; recorded inline unless a parallel recorder is attached
+struct VulkanDrawWork {
+    uint32_t item_count = 0;
+    const VulkanParallelRecorder::RecordFn* fn = nullptr;
+    VulkanParallelRecorder* recorder = nullptr;
+    const VulkanStagingRing* uploads = nullptr; // Set when this frame waits on a staging flush
+    const VulkanSpriteRenderer* sprites = nullptr; // Drawn after the draw list when it is recorded inline
+
+    bool is_parallel() const { return recorder && recorder->is_created() && item_count > 0; }
+    VkSubpassContents contents() const {
+        return is_parallel() ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+    }
+    // Dynamic rendering counterpart of contents()
+    VkRenderingFlags rendering_flags() const {
+        return is_parallel() ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+    }
+
+    // Called after vkBeginCommandBuffer, before the render pass
+    void record_pre_pass(VkCommandBuffer cmd) const {
+        if (uploads) uploads->record_acquire(cmd);
+    }
+
+    // Called between vkCmdBeginRenderPass(contents()) / vkCmdBeginRendering(rendering_flags()) and the matching end
+    void record(VkCommandBuffer cmd, const VulkanPassTarget& target, uint32_t frame) const;
+};
+
+struct VulkanRenderGraphStats {
+    uint32_t pass_count = 0;          // Declared passes
+    uint32_t culled_count = 0;        // Passes skipped because nothing uses what they write
+    uint32_t barrier_count = 0;       // Image barriers recorded per frame
+    uint32_t transient_count = 0;     // Transient images used by live passes
+    VkDeviceSize transient_bytes = 0; // Their summed sizes
+    VkDeviceSize allocated_bytes = 0; // Memory allocated for them once aliased
+    uint32_t compile_count = 0;
+};
+
+// A frame described as passes that declare the images they read and write. Compiling culls passes whose
+// output nothing uses, derives the layout transitions and synchronization2 barriers between the passes
+// that remain, and places transient images whose lifetimes don't overlap in the same memory. Passes run
+// in the order they were added. The compiled graph is kept across frames: declaring anything, or a change
+// of extent or imported format, makes the next execute() recompile. Needs dynamic rendering.
+class VulkanRenderGraph {
+public:
+    static constexpr uint32_t INVALID_ID = UINT32_MAX;
+    static constexpr uint32_t MAX_COLOR_ATTACHMENTS = 4;
+
+    enum class Access : uint8_t {
+        ColorWrite,  // Color attachment
+        DepthWrite,  // Depth attachment, tested and written
+        DepthRead,   // Depth attachment, tested only
+        Sampled,     // Sampled in fragment shaders
+        TransferSrc,
+        TransferDst,
+    };
+
+    struct ImageDesc {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent = {}; // {0, 0} follows the graph extent, multiplied by scale
+        f32 scale = 1.0f;
+    };
+
+    struct PassContext {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        uint32_t frame = 0;
+        VkExtent2D extent = {};  // Render area, viewport and scissor of the pass's attachments
+        VulkanPassTarget target; // Attachment formats, for pipelines and secondaries
+    };
+    using ExecuteFn = std::function<void(const PassContext& ctx)>;
+
+    VulkanRenderGraph() = default;
+    ~VulkanRenderGraph();
+
+    VkResult create(VulkanDevice& device, VkExtent2D extent);
+    // Destroys the transient images; the device must be idle
+    void cleanup(VkDevice device);
+    bool is_created() const { return m_device != VK_NULL_HANDLE; }
+
+    // Image owned elsewhere (e.g. a swapchain image), handed over every frame with set_image. Its contents
+    // are undefined when the frame starts; it is left in final_layout after the last pass that uses it.
+    uint32_t import_image(const char* name, VkFormat format, VkImageLayout final_layout);
+    // Image owned by the graph that only lives within the frame
+    uint32_t create_image(const char* name, const ImageDesc& desc);
+    // name must be a string literal; it also names the pass's GPU zone
+    uint32_t add_pass(const char* name, ExecuteFn fn);
+    // One use per image and pass. Writes with a clear value clear the attachment as the pass begins,
+    // other writes keep what earlier passes drew.
+    void write(uint32_t pass, uint32_t image, Access access, const VkClearValue* clear = nullptr);
+    void read(uint32_t pass, uint32_t image, Access access);
+    // Keep the pass even when nothing reads what it writes
+    void set_side_effects(uint32_t pass);
+    // Drop every pass and image; transient images are released by the next compile
+    void clear();
+
+    // Per-frame state, none of which recompiles
+    void set_image(uint32_t image, VkImage handle, VkImageView view);
+    void set_clear_value(uint32_t pass, uint32_t image, const VkClearValue& clear);
+    void set_rendering_flags(uint32_t pass, VkRenderingFlags flags);
+    // These recompile only when the value actually changed
+    void set_extent(VkExtent2D extent);
+    void set_import_format(uint32_t image, VkFormat format);
+
+    // Compile now if anything changed. Transient images replaced by a recompile go to deletion_queue,
+    // or are destroyed at once when it is nullptr (the device must then be idle).
+    VkResult compile(VulkanDeletionQueue* deletion_queue = nullptr, uint64_t frames_submitted = 0);
+    // Compile if needed, then record every live pass and its barriers into cmd
+    VkResult execute(VkCommandBuffer cmd, VulkanGpuTimer* timer = nullptr, uint32_t frame = 0,
+                     VulkanDeletionQueue* deletion_queue = nullptr, uint64_t frames_submitted = 0);
+
+    // Transient handles stay valid until the next recompile (see VulkanRenderGraphStats::compile_count)
+    // and are null for images no live pass uses
+    VkImage get_image(uint32_t image) const;
+    VkImageView get_view(uint32_t image) const;
+    VkFormat get_format(uint32_t image) const;
+    bool is_culled(uint32_t pass) const;
+
+    VulkanRenderGraphStats get_stats() const;
+    void test() const;
+
+private:
+    struct Use {
+        uint32_t image = INVALID_ID;
+        Access access = Access::ColorWrite;
+        bool write = false;
+        bool clear = false;
+        VkClearValue clear_value{};
+    };
+
+    struct Pass {
+        const char* name = nullptr;
+        ExecuteFn fn;
+        std::vector<Use> uses;
+        VkRenderingFlags rendering_flags = 0;
+        bool side_effects = false;
+        bool live = false;
+    };
+
+    struct Image {
+        std::string name;
+        bool imported = false;
+        ImageDesc desc;
+        VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+
+        // Filled by compile
+        VkImageUsageFlags usage = 0;
+        uint32_t first_use = INVALID_ID; // Index into m_schedule
+        uint32_t last_use = INVALID_ID;
+        VkPipelineStageFlags2 last_stages = 0;
+        VkAccessFlags2 last_write_access = 0;
+        VkMemoryRequirements requirements{};
+        uint32_t slot = INVALID_ID;
+    };
+
+    struct Barrier {
+        uint32_t image = INVALID_ID;
+        VkPipelineStageFlags2 src_stages = 0;
+        VkAccessFlags2 src_access = 0;
+        VkPipelineStageFlags2 dst_stages = 0;
+        VkAccessFlags2 dst_access = 0;
+        VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+
+    struct Attachment {
+        uint32_t use = INVALID_ID; // Index into the pass's uses
+        VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        VkAttachmentStoreOp store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    };
+
+    struct CompiledPass {
+        uint32_t pass = INVALID_ID;
+        uint32_t first_barrier = 0;
+        uint32_t barrier_count = 0;
+        uint32_t color_count = 0;
+        Attachment colors[MAX_COLOR_ATTACHMENTS];
+        Attachment depth;
+    };
+
+    // Memory shared by transient images that are never alive at the same time
+    struct AliasSlot {
+        VkMemoryRequirements requirements{};
+        std::vector<uint32_t> images; // Ordered by first use
+        VulkanAllocation allocation;
+    };
+
+    void cull();
+    VkResult allocate_transients(VulkanDeletionQueue* deletion_queue, uint64_t frames_submitted);
+    void release_transients(VulkanDeletionQueue* deletion_queue, uint64_t frames_submitted);
+    void build_barriers();
+    void record_barriers(VkCommandBuffer cmd, uint32_t first, uint32_t count);
+    VkExtent2D image_extent(const Image& image) const;
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VulkanMemoryAllocator* m_memory = nullptr;
+    VkExtent2D m_extent = {};
+
+    std::vector<Pass> m_passes;
+    std::vector<Image> m_images;
+    bool m_dirty = true;
+
+    // Compiled state
+    std::vector<CompiledPass> m_schedule;
+    std::vector<Barrier> m_barriers;
+    uint32_t m_final_barrier = 0; // Transitions of imported images to their final layouts start here
+    std::vector<AliasSlot> m_slots;
+    std::vector<VkImage> m_owned_images;
+    std::vector<VkImageView> m_owned_views;
+    std::vector<VkImageMemoryBarrier2> m_scratch;
+    uint32_t m_compile_count = 0;
+};
+
+
+// Draws a frame's quads (RenderPacket::quads) as instanced quads. Each frame in flight owns a region
+// of one persistently mapped, host-coherent instance buffer that SpriteBatch writes the sorted quads
+// straight into, and every QuadBatch becomes one instanced vkCmdDraw. When a frame outgrows its
+// region the buffer is replaced by a larger one and the old one retired through the deletion queue.
+class VulkanSpriteRenderer {
+public:
+    static constexpr uint32_t MATERIAL_COUNT = 2;            // Quad::material: 0 alpha blended, 1 opaque
+    static constexpr uint32_t DEFAULT_CAPACITY = 64 * 1024;  // Quads per frame before the first grow
+    static constexpr uint32_t MAX_TEXTURE_SETS = 1024;       // Distinct textures per frame; the rest draw untextured
+
+    // View to sample for Quad::texture, VK_NULL_HANDLE while it has nothing resident (drawn untextured).
+    // Called from prepare() on the thread that draws.
+    using TextureViewFn = std::function<VkImageView(uint16_t texture)>;
+
+    VulkanSpriteRenderer() = default;
+    ~VulkanSpriteRenderer();
+
+    // Loads sprite.vert.spv / sprite.frag.spv / sprite_textured.frag.spv from shader_dir and queues an
+    // untextured and a textured pipeline per material
+    VkResult create(VulkanDevice& device, VulkanPipelineManager& pipelines, const VulkanPassTarget& target,
+                    uint32_t max_frames_in_flight, const char* shader_dir, uint32_t capacity = DEFAULT_CAPACITY);
+    // The device must be idle
+    void cleanup(VkDevice device);
+    bool is_created() const { return m_buffer != VK_NULL_HANDLE; }
+
+    // Queue pipelines for a target whose formats or render pass changed
+    void set_target(const VulkanPassTarget& target);
+    void set_texture_source(TextureViewFn fn) { m_texture_view = std::move(fn); }
+    // Run jobs until every material pipeline has compiled
+    void wait_ready();
+
+    // Sort quads into frame's region, growing the buffer first if they don't fit.
+    // Call once the frame's fence has signaled, before recording it.
+    bool prepare(uint32_t frame, const Sparkle::Quad* quads, uint32_t count, VkExtent2D extent,
+                 VulkanDeletionQueue& deletion_queue, uint64_t frames_submitted);
+    // Draw what the last prepare() sorted, inside the pass; sets its own viewport and scissor.
+    // Batches whose pipeline is still compiling are skipped.
+    void record(VkCommandBuffer cmd) const;
+    bool has_work() const { return !m_batch.get_batches().empty(); }
+
+    const Sparkle::SpriteBatchStats& get_stats() const { return m_batch.get_stats(); }
+    uint32_t get_capacity() const { return m_capacity; }
+    void test() const;
+
+private:
+    VkResult create_buffer(uint32_t capacity);
+    VkResult create_descriptors();
+    // One descriptor set per distinct resident texture of the sorted batches, from frame's pool
+    void write_texture_sets(uint32_t frame);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VulkanMemoryAllocator* m_memory = nullptr;
+    VulkanPipelineManager* m_pipelines = nullptr;
+    uint32_t m_frame_count = 0;
+
+    uint32_t m_vertex_shader = UINT32_MAX;
+    uint32_t m_fragment_shader = UINT32_MAX;
+    uint32_t m_textured_shader = UINT32_MAX;
+    uint32_t m_material_pipelines[MATERIAL_COUNT] = {UINT32_MAX, UINT32_MAX};
+    uint32_t m_textured_pipelines[MATERIAL_COUNT] = {UINT32_MAX, UINT32_MAX};
+    TextureViewFn m_texture_view;
+
+    VkDescriptorSetLayout m_set_layout = VK_NULL_HANDLE;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> m_descriptor_pools; // One per frame in flight, reset in prepare()
+    std::vector<VkDescriptorSet> m_batch_sets;        // Per sorted batch; VK_NULL_HANDLE draws untextured
+    std::unordered_map<uint16_t, VkDescriptorSet> m_frame_sets;
+    bool m_sets_exhausted = false;                    // Warned that MAX_TEXTURE_SETS was exceeded
+
+    VkBuffer m_buffer = VK_NULL_HANDLE;
+    VulkanAllocation m_allocation;
+    uint32_t m_capacity = 0;       // Quads per frame region
+
+    Sparkle::SpriteBatch m_batch;
+    VkDeviceSize m_offset = 0;     // Region of the last prepare()
+    VkExtent2D m_extent{};
+};
+
+// Draws a frame's mesh draws (RenderPacket::meshes) from VulkanMeshBuffers in the main pass. Every mesh
+// shares one pipeline and the two shared buffers, so each draw is a push of its transform and one
+// vkCmdDrawIndexed at the mesh's offsets. record() takes any range of the prepared draws, so it can be
+// the draw work the parallel recorder splits across threads.
+class VulkanMeshRenderer {
+public:
+    VulkanMeshRenderer() = default;
+    ~VulkanMeshRenderer();
+
+    // Loads mesh.vert.spv / mesh.frag.spv from shader_dir and queues the pipeline
+    VkResult create(VulkanPipelineManager& pipelines, const VulkanMeshBuffers& meshes, const VulkanPassTarget& target,
+                    const char* shader_dir);
+    void cleanup();
+    bool is_created() const { return m_meshes != nullptr; }
+
+    // Queue the pipeline for a target whose formats or render pass changed
+    void set_target(const VulkanPassTarget& target);
+    void wait_ready();
+
+    // Keep the draws whose mesh is drawable: mesh_ids maps MeshDraw::mesh to a VulkanMeshBuffers id, and
+    // ids the buffers don't hold are skipped. draws must stay valid until the frame is recorded.
+    // Returns the number of draws kept, 0 while the pipeline is compiling.
+    uint32_t prepare(const Sparkle::MeshDraw* draws, uint32_t count, const std::vector<uint32_t>& mesh_ids,
+                     VkExtent2D extent);
+    // Draw [first, first + count) of what the last prepare() kept, inside the main pass; binds the
+    // pipeline and both mesh buffers and sets its own viewport and scissor. Safe to call from several
+    // threads at once on different command buffers.
+    void record(VkCommandBuffer cmd, uint32_t first, uint32_t count) const;
+    uint32_t get_draw_count() const { return static_cast<uint32_t>(m_draws.size()); }
+
+private:
+    struct Draw {
+        const Sparkle::MeshDraw* draw = nullptr;
+        uint32_t mesh = 0; // VulkanMeshBuffers id
+    };
+
+    VulkanPipelineManager* m_pipelines = nullptr;
+    const VulkanMeshBuffers* m_meshes = nullptr;
+    uint32_t m_vertex_shader = UINT32_MAX;
+    uint32_t m_fragment_shader = UINT32_MAX;
+    uint32_t m_pipeline = UINT32_MAX;
+
+    std::vector<Draw> m_draws;
+    VkExtent2D m_extent{};
+};
+
+
 class VulkanSwapchain {
 public:
     VulkanSwapchain() = default;
@@ -162,11 +1313,16 @@ public:
     // Create swapchain + all related resources
     VkResult create(VulkanDevice& device, VkSurfaceKHR surface, uint32_t width, uint32_t height);
 
-    // Recreate swapchain on resize or other changes
-    void recreate(VulkanDevice& device, VkSurfaceKHR surface, uint32_t width, uint32_t height);
+    // Recreate swapchain on resize or other changes without idling the device: the new swapchain is
+    // built from the old one, the render pass is kept unless the surface format changed (there is none
+    // to rebuild under dynamic rendering), and everything retired goes to deletion_queue.
+    // Returns VK_NOT_READY (old swapchain kept) while the surface has no area.
+    VkResult recreate(VulkanDevice& device, VkSurfaceKHR surface, uint32_t width, uint32_t height,
+                      VulkanDeletionQueue& deletion_queue, uint64_t frames_submitted);
 
-    void record_all();
-    void record_single(uint32_t image_index);
+    // Record the frame into cmd, which comes from the current frame's command pool (render pass path only)
+    void record_single(VkCommandBuffer cmd, uint32_t image_index, VulkanGpuTimer* timer = nullptr, uint32_t frame = 0,
+                       const VulkanDrawWork* work = nullptr);
 
     // Cleanup all Vulkan resources related to swapchain
     void cleanup(VkDevice device);
@@ -176,11 +1332,25 @@ public:
 
     void set_clear_color(float r, float g, float b, float a);
 
+    // Used from the next create / recreate on, if the surface supports it (FIFO otherwise)
+    void set_present_mode(VkPresentModeKHR mode) { m_preferred_present_mode = mode; }
+    VkPresentModeKHR get_present_mode() const { return m_present_mode; }
+
+    // Only create the image views: frames are recorded through a VulkanRenderGraph with dynamic rendering
+    // instead of record_single's render pass + framebuffers. Set before create; needs
+    // VulkanDevice::supports_dynamic_rendering.
+    void set_dynamic_rendering(bool enabled) { m_dynamic_rendering = enabled; }
+    bool uses_dynamic_rendering() const { return m_dynamic_rendering; }
+
     VkSwapchainKHR get_swapchain() const { return m_swapchain; }
     VkExtent2D get_extent() const { return m_extent; }
+    // VK_NULL_HANDLE under dynamic rendering
     VkRenderPass get_render_pass() const { return m_render_pass.get(); }
     const std::vector<VkFramebuffer>& get_framebuffers() const { return m_framebuffers.get_all(); }
-    const std::vector<VkCommandBuffer>& get_command_buffers() const { return m_command_pool.get_buffers(); }
+    const std::vector<VkImage>& get_images() const { return m_images; }
+    const std::vector<VkImageView>& get_color_views() const { return m_image_views.get_color_views(); }
+    // What pipelines drawn in the main pass are built for
+    VulkanPassTarget get_pass_target() const;
 
 
 private:
@@ -189,10 +1359,19 @@ private:
     VkPresentModeKHR choose_present_mode(const std::vector<VkPresentModeKHR>& available_modes);
     VkExtent2D choose_extent(const VkSurfaceCapabilitiesKHR& capabilities, uint32_t width, uint32_t height);
 
+    // Swapchain handle + images (passes the current swapchain as oldSwapchain)
+    VkResult create_swapchain(VulkanDevice& device, VkSurfaceKHR surface, uint32_t width, uint32_t height);
+    // Views, depth, render pass (if not already created) and framebuffers for the current images;
+    // only views and depth under dynamic rendering
+    VkResult create_targets(VulkanDevice& device);
+
 private:
     VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
     VkFormat m_format = VK_FORMAT_UNDEFINED;
     VkExtent2D m_extent = {};
+    VkPresentModeKHR m_preferred_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+    VkPresentModeKHR m_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+    bool m_dynamic_rendering = false;
 
     std::vector<VkImage> m_images;
     VkClearValue m_clear_color{};
@@ -202,7 +1381,52 @@ private:
     VulkanImageViews m_image_views;
     VulkanRenderPass m_render_pass;
     VulkanFramebufferManager m_framebuffers;
-    VulkanCommandPool m_command_pool;
+};
+
+// Render target made of device images for running without a window surface.
+// Mirrors the parts of VulkanSwapchain the backend uses, minus acquire/present.
+class VulkanOffscreenTarget {
+public:
+    VulkanOffscreenTarget() = default;
+    ~VulkanOffscreenTarget();
+
+    // Create color images + depth, render pass and framebuffers (only the color images and views with dynamic rendering)
+    VkResult create(VulkanDevice& device, uint32_t width, uint32_t height, uint32_t image_count);
+
+    void record_single(VkCommandBuffer cmd, uint32_t image_index, VulkanGpuTimer* timer = nullptr, uint32_t frame = 0,
+                       const VulkanDrawWork* work = nullptr);
+
+    void cleanup(VkDevice device);
+
+    void test() const;
+
+    void set_clear_color(float r, float g, float b, float a);
+
+    // Same as VulkanSwapchain::set_dynamic_rendering
+    void set_dynamic_rendering(bool enabled) { m_dynamic_rendering = enabled; }
+    bool uses_dynamic_rendering() const { return m_dynamic_rendering; }
+
+    VkExtent2D get_extent() const { return m_extent; }
+    VkRenderPass get_render_pass() const { return m_render_pass.get(); }
+    const std::vector<VkImage>& get_images() const { return m_images; }
+    const std::vector<VkImageView>& get_color_views() const { return m_image_views.get_color_views(); }
+    VulkanPassTarget get_pass_target() const;
+
+private:
+    static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+    VkExtent2D m_extent = {};
+    bool m_dynamic_rendering = false;
+
+    VulkanMemoryAllocator* m_memory = nullptr;
+    std::vector<VkImage> m_images;
+    std::vector<VulkanAllocation> m_image_allocations;
+    VkClearValue m_clear_color{};
+    VkClearValue m_clear_depth{1.0f, 0.0f};
+
+    VulkanImageViews m_image_views;
+    VulkanRenderPass m_render_pass;
+    VulkanFramebufferManager m_framebuffers;
 };
 
 class VulkanSyncObjects {
@@ -220,6 +1444,9 @@ public:
     VkSemaphore get_image_available_semaphore(uint32_t index) const { return m_image_available_semaphores[index]; }
     VkSemaphore get_render_finished_semaphore(uint32_t index) const { return m_render_finished_semaphores[index]; }
     VkFence get_in_flight_fence(uint32_t index) const { return m_in_flight_fences[index]; }
+    // Replace a fence that was reset for a submit that failed with a signaled one, so the next wait
+    // on its frame slot returns instead of blocking forever
+    VkResult recreate_in_flight_fence(VkDevice device, uint32_t index);
 
     uint32_t get_max_frames_in_flight() const { return static_cast<uint32_t>(m_in_flight_fences.size()); }
 
@@ -0,0 +1,60 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace SparkleBench {
+    // Summary of a set of timing samples (in whatever unit they were collected)
+    struct BenchStats {
+        f64 mean = 0.0;
+        f64 min = 0.0;
+        f64 max = 0.0;
+        f64 p50 = 0.0;
+        f64 p99 = 0.0;
+    };
+
+    inline f64 percentile(const std::vector<f64>& sorted, f64 p) {
+        if (sorted.empty()) return 0.0;
+        const size_t idx = static_cast<size_t>(p * static_cast<f64>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+
+    inline BenchStats summarize(std::vector<f64> samples) {
+        BenchStats stats;
+        if (samples.empty()) return stats;
+
+        std::sort(samples.begin(), samples.end());
+        f64 sum = 0.0;
+        for (f64 s : samples) sum += s;
+
+        stats.mean = sum / static_cast<f64>(samples.size());
+        stats.min = samples.front();
+        stats.max = samples.back();
+        stats.p50 = percentile(samples, 0.50);
+        stats.p99 = percentile(samples, 0.99);
+        return stats;
+    }
+
+    inline void print_stats(const char* label, const BenchStats& stats, const char* unit = "ms") {
+        std::printf("%-24s mean %9.4f  min %9.4f  p50 %9.4f  p99 %9.4f  max %9.4f  (%s)\n",
+                    label, stats.mean, stats.min, stats.p50, stats.p99, stats.max, unit);
+    }
+
+    // Each benchmark takes the arguments that follow its name on the command line
+    int bench_frame(int argc, char** argv);
+    int bench_record(int argc, char** argv);
+    int bench_jobs(int argc, char** argv);
+    int bench_pipeline(int argc, char** argv);
+    int bench_arena(int argc, char** argv);
+    int bench_upload(int argc, char** argv);
+    int bench_log(int argc, char** argv);
+    int bench_sprites(int argc, char** argv);
+    int bench_ecs(int argc, char** argv);
+    int bench_assets(int argc, char** argv);
+    int bench_textures(int argc, char** argv);
+}
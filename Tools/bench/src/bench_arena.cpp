@@ -0,0 +1,88 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/frame_arena.h"
+#include "core/heap_stats.h"
+#include "core/logger.h"
+#include <chrono>
+#include <cstdlib>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    struct DrawItem {
+        u32 mesh;
+        u32 material;
+        f32 transform[12];
+    };
+
+    // A typical per-frame build: a draw list grown one item at a time plus a sort key array
+    template<typename Vector, typename KeyVector>
+    static u64 build_frame(u32 items) {
+        Vector draws;
+        KeyVector keys;
+        for (u32 i = 0; i < items; ++i) {
+            draws.push_back({i % 64, i % 16, {}});
+            keys.push_back((static_cast<u64>(i % 16) << 32) | i);
+        }
+        return draws.size() + keys.size();
+    }
+
+    template<typename Vector, typename KeyVector>
+    static void run_case(const char* label, u32 frames, u32 items, u32 slots, bool arena) {
+        std::vector<f64> frame_us;
+        frame_us.reserve(frames);
+        u64 sink = 0;
+        u64 heap_start = 0;
+
+        for (u32 i = 0; i < frames; ++i) {
+            // Retire the frame that last used the slot, as the renderer would once its fence signals
+            const u64 frame = i + 1;
+            if (arena) {
+                if (frame > slots) FrameArena::retire(frame - slots);
+                FrameArena::begin_frame(frame);
+            }
+            if (i == frames / 2) heap_start = HeapStats::get_allocation_count();
+
+            const auto start = std::chrono::steady_clock::now();
+            sink += build_frame<Vector, KeyVector>(items);
+            const auto end = std::chrono::steady_clock::now();
+            frame_us.push_back(std::chrono::duration<f64, std::micro>(end - start).count());
+        }
+
+        const u64 heap = HeapStats::get_allocation_count() - heap_start;
+        print_stats(label, summarize(frame_us), "us/frame");
+        if (HeapStats::is_enabled()) {
+            std::printf("%-24s %.2f heap allocations per frame (steady state)\n", "",
+                        static_cast<f64>(heap) / static_cast<f64>(frames - frames / 2));
+        }
+        if (sink == 0) std::printf("\n");
+    }
+
+    int bench_arena(int argc, char** argv) {
+        const u32 frames = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 1000;
+        const u32 items = argc > 1 ? static_cast<u32>(std::atoi(argv[1])) : 10000;
+        constexpr u32 SLOTS = 4;
+
+        Logger::init();
+        FrameArena::init(SLOTS, 16 * 1024 * 1024);
+
+        std::printf("arena bench: %u frames, %u items per frame\n", frames, items);
+        run_case<std::vector<DrawItem>, std::vector<u64>>("std::vector", frames, items, SLOTS, false);
+        run_case<FrameVector<DrawItem>, FrameVector<u64>>("FrameVector", frames, items, SLOTS, true);
+
+        const FrameArenaStats stats = FrameArena::get_stats();
+        std::printf("arena: %llu allocations, %llu heap fallbacks, peak %llu KiB per frame\n",
+                    static_cast<unsigned long long>(stats.allocations),
+                    static_cast<unsigned long long>(stats.heap_fallbacks),
+                    static_cast<unsigned long long>(stats.peak_bytes / 1024));
+        if (!HeapStats::is_enabled()) {
+            std::printf("configure with -DSPARKLE_TRACK_HEAP=ON to count heap allocations\n");
+        }
+
+        FrameArena::shutdown();
+        Logger::shutdown();
+        return 0;
+    }
+}
@@ -0,0 +1,150 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/ecs.h"
+#include "core/job_system.h"
+#include "core/logger.h"
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    struct Position { f32 x, y, z; };
+    struct Velocity { f32 x, y, z; };
+    struct Health { f32 value, regen; };
+
+    // What the same entity looks like as a typical game object: the hot fields sit between
+    // data the update never touches, so every cache line loaded is mostly wasted
+    struct GameObject {
+        char name[32];
+        f32 transform[16];
+        Position position;
+        Velocity velocity;
+        Health health;
+        u32 flags;
+        void* owner;
+    };
+
+    static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template<typename F>
+    static BenchStats time_runs(u32 iterations, F&& fn) {
+        std::vector<f64> ms;
+        ms.reserve(iterations);
+        fn(); // warm caches
+        for (u32 i = 0; i < iterations; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            ms.push_back(elapsed_ms(start));
+        }
+        return summarize(ms);
+    }
+
+    static void report(const char* label, const BenchStats& stats, f64 baseline) {
+        char line[64];
+        std::snprintf(line, sizeof(line), "%s (x%.2f)", label, stats.p50 > 0.0 ? baseline / stats.p50 : 0.0);
+        print_stats(line, stats);
+    }
+
+    int bench_ecs(int argc, char** argv) {
+        const u32 entities = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 1'000'000;
+        const u32 iterations = argc > 1 ? static_cast<u32>(std::atoi(argv[1])) : 50;
+        const u32 workers = argc > 2 ? static_cast<u32>(std::atoi(argv[2]))
+                                     : std::max(1u, std::thread::hardware_concurrency());
+        constexpr f32 dt = 1.0f / 60.0f;
+
+        Logger::init();
+        Logger::get_logger()->set_level(spdlog::level::warn);
+        JobSystem::init(workers);
+
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<f32> dist(-1.0f, 1.0f);
+
+        // AoS baselines: one contiguous array, and separately allocated objects visited in shuffled order
+        std::vector<GameObject> objects(entities);
+        std::vector<std::unique_ptr<GameObject>> scattered(entities);
+        for (u32 i = 0; i < entities; ++i) {
+            GameObject& object = objects[i];
+            object = {};
+            object.position = {dist(rng), dist(rng), dist(rng)};
+            object.velocity = {dist(rng), dist(rng), dist(rng)};
+            object.health = {100.0f, 1.0f};
+            scattered[i] = std::make_unique<GameObject>(object);
+        }
+        std::shuffle(scattered.begin(), scattered.end(), rng);
+
+        World world;
+        for (const GameObject& object : objects) {
+            world.create(object.position, object.velocity, object.health);
+        }
+
+        std::printf("ecs bench: %u entities, %u iterations, %u workers (GameObject is %zu bytes)\n",
+                    entities, iterations, workers, sizeof(GameObject));
+
+        const BenchStats aos = time_runs(iterations, [&] {
+            for (GameObject& object : objects) {
+                object.position.x += object.velocity.x * dt;
+                object.position.y += object.velocity.y * dt;
+                object.position.z += object.velocity.z * dt;
+            }
+        });
+        const f64 baseline = aos.p50;
+        report("AoS array", aos, baseline);
+
+        report("AoS pointers", time_runs(iterations, [&] {
+            for (const std::unique_ptr<GameObject>& object : scattered) {
+                object->position.x += object->velocity.x * dt;
+                object->position.y += object->velocity.y * dt;
+                object->position.z += object->velocity.z * dt;
+            }
+        }), baseline);
+
+        auto movement = [](Position& position, const Velocity& velocity) {
+            position.x += velocity.x * dt;
+            position.y += velocity.y * dt;
+            position.z += velocity.z * dt;
+        };
+        report("ECS each", time_runs(iterations, [&] {
+            world.each<Position, const Velocity>(movement);
+        }), baseline);
+
+        report("ECS par_each", time_runs(iterations, [&] {
+            world.par_each<Position, const Velocity>(movement);
+        }), baseline);
+
+        // Two systems with disjoint writes share a stage and run side by side
+        auto regen = [](Health& health) { health.value = std::min(100.0f, health.value + health.regen * dt); };
+        world.add_system("Movement", SystemAccess().write<Position>().read<Velocity>(), [&](World& w, f32) {
+            w.each<Position, const Velocity>(movement);
+        });
+        world.add_system("Regen", SystemAccess().write<Health>(), [&](World& w, f32) {
+            w.each<Health>(regen);
+        });
+
+        const BenchStats serial = time_runs(iterations, [&] {
+            world.each<Position, const Velocity>(movement);
+            world.each<Health>(regen);
+        });
+        report("2 systems serial", serial, serial.p50);
+        report("2 systems scheduled", time_runs(iterations, [&] {
+            world.run_systems(SystemPhase::Update, dt);
+        }), serial.p50);
+
+        const WorldStats stats = world.get_stats();
+        std::printf("world: %u archetypes, %u chunks of %u bytes, update phase in %u stage(s)\n",
+                    stats.archetypes, stats.chunks, World::CHUNK_SIZE,
+                    stats.stages[static_cast<u32>(SystemPhase::Update)]);
+
+        world.clear_systems();
+        world.clear();
+        JobSystem::shutdown();
+        Logger::shutdown();
+        return 0;
+    }
+}
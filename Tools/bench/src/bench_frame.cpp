@@ -0,0 +1,77 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/application.h"
+#include "renderer/renderer.h"
+#include <cstdlib>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    // Minimal game that only asks for an offscreen renderer
+    class FrameBenchGame : public Game {
+    public:
+        FrameBenchGame(i32 width, i32 height, bool dynamic_rendering) {
+            config.title = "sparkle_bench";
+            config.width = width;
+            config.height = height;
+            engine_config.headless = true;
+            engine_config.dynamic_rendering = dynamic_rendering;
+        }
+
+        bool init() override { return true; }
+        bool render() override { return true; }
+        bool update(float) override { return true; }
+        void on_resize(int, int) override {}
+    };
+
+    int bench_frame(int argc, char** argv) {
+        const u32 frames = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 1000;
+        const i32 width = argc > 1 ? std::atoi(argv[1]) : 1280;
+        const i32 height = argc > 2 ? std::atoi(argv[2]) : 720;
+        const bool dynamic_rendering = argc > 3 ? std::atoi(argv[3]) != 0 : true;
+        // Skip the first frames: pipeline warmup and GPU timestamps that are not resolved yet
+        const u32 warmup = std::min<u32>(frames / 10 + 3, 100);
+
+        FrameBenchGame game(width, height, dynamic_rendering);
+        Application::SetGameInst(&game);
+        if (!Application::Init()) {
+            std::printf("engine failed to initialize\n");
+            return 1;
+        }
+
+        RenderPacket packet = {.clearColor = {0.0f, 0.0f, 1.0f, 1.0f}};
+        std::vector<f64> cpu_ms;
+        std::vector<f64> gpu_ms;
+        cpu_ms.reserve(frames);
+        gpu_ms.reserve(frames);
+
+        for (u32 i = 0; i < frames + warmup; ++i) {
+            const u64 start = SDL_GetTicksNS();
+            if (!Renderer::draw_frame(&packet)) {
+                std::printf("draw_frame failed at frame %u\n", i);
+                break;
+            }
+            const u64 end = SDL_GetTicksNS();
+
+            if (i < warmup) continue;
+            cpu_ms.push_back(static_cast<f64>(end - start) / 1'000'000.0);
+
+            const f64 gpu = Renderer::get_backend()->get_gpu_frame_time_ms();
+            if (gpu > 0.0) gpu_ms.push_back(gpu);
+        }
+
+        std::printf("frame bench: %zu frames at %dx%d (headless, %s)\n", cpu_ms.size(), width, height,
+                    dynamic_rendering ? "dynamic rendering" : "render pass");
+        print_stats("cpu draw_frame", summarize(cpu_ms));
+        if (gpu_ms.empty()) {
+            std::printf("%-24s n/a (no timestamp support)\n", "gpu frame");
+        } else {
+            print_stats("gpu frame", summarize(gpu_ms));
+        }
+
+        Application::Shutdown();
+        return 0;
+    }
+}
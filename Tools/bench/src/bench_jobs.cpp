@@ -0,0 +1,81 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/job_system.h"
+#include "core/logger.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int bench_jobs(int argc, char** argv) {
+        const u32 max_workers = argc > 0 ? static_cast<u32>(std::atoi(argv[0]))
+                                         : std::max(1u, std::thread::hardware_concurrency());
+        const u32 rounds = argc > 1 ? static_cast<u32>(std::atoi(argv[1])) : 50;
+
+        Logger::init();
+        Logger::get_logger()->set_level(spdlog::level::warn);
+
+        // 1. Dispatch overhead: empty jobs, submitted from the main thread and waited on
+        std::printf("job dispatch: empty jobs, %u rounds\n", rounds);
+        JobSystem::init(max_workers);
+        for (u32 batch : {1u, 16u, 256u, 4000u}) {
+            std::vector<f64> per_job_us;
+            for (u32 r = 0; r < rounds; ++r) {
+                JobCounter counter;
+                const auto start = std::chrono::steady_clock::now();
+                for (u32 i = 0; i < batch; ++i) {
+                    JobSystem::run([] {}, &counter);
+                }
+                JobSystem::wait(counter);
+                per_job_us.push_back(elapsed_ms(start) * 1000.0 / batch);
+            }
+
+            char label[64];
+            std::snprintf(label, sizeof(label), "%5u jobs per batch", batch);
+            print_stats(label, summarize(per_job_us), "us/job");
+        }
+        JobSystem::shutdown();
+
+        // 2. Scaling: a fixed amount of math split with parallel_for over 1..max_workers
+        constexpr u32 ITEMS = 1u << 20;
+        std::vector<f32> data(ITEMS, 1.0f);
+        std::printf("parallel_for scaling: %u items of sqrt/sin work\n", ITEMS);
+
+        f64 baseline = 0.0;
+        for (u32 workers = 1; workers <= max_workers; workers *= 2) {
+            JobSystem::init(workers);
+
+            std::vector<f64> ms;
+            for (u32 r = 0; r < rounds; ++r) {
+                const auto start = std::chrono::steady_clock::now();
+                JobSystem::parallel_for(ITEMS, 0, [&](u32 begin, u32 end) {
+                    for (u32 i = begin; i < end; ++i) {
+                        data[i] = std::sqrt(data[i] + std::sin(static_cast<f32>(i)));
+                    }
+                });
+                ms.push_back(elapsed_ms(start));
+            }
+            JobSystem::shutdown();
+
+            const BenchStats stats = summarize(ms);
+            if (workers == 1) baseline = stats.p50;
+
+            char label[64];
+            std::snprintf(label, sizeof(label), "%2u workers (x%.2f)", workers,
+                          stats.p50 > 0.0 ? baseline / stats.p50 : 0.0);
+            print_stats(label, stats);
+        }
+
+        Logger::shutdown();
+        return 0;
+    }
+}
@@ -0,0 +1,114 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/logger.h"
+#include <spdlog/sinks/basic_file_sink.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    enum class Message { Numbers, String, LongString };
+
+    // Longer than a queue slot holds, like a validation layer message
+    static const char* LONG_TEXT =
+        "vkCmdDrawIndexed(): the VkPipeline bound to VK_PIPELINE_BIND_POINT_GRAPHICS expects descriptor set 1 "
+        "binding 0 to be a VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, but the descriptor set bound there was "
+        "never updated; see the Vulkan specification section on descriptor set validity";
+
+    // Per-call cost seen by the logging thread. The message mix is what the engine logs per frame:
+    // numbers only (deferred formatting), messages carrying a string (formatted at the call site) and
+    // the odd message too long for a queue slot.
+    static void run_case(const char* label, u32 messages, Message message) {
+        std::vector<f64> call_ns;
+        call_ns.reserve(messages);
+        const char* name = "swapchain";
+        const u64 dropped_start = Logger::get_dropped_count();
+
+        for (u32 i = 0; i < messages; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            switch (message) {
+                case Message::Numbers:
+                    SPA_LOG_INFO("Frame {} took {:.3f} ms ({} draws)", i, 16.6 + (i % 10) * 0.01, i % 500);
+                    break;
+                case Message::String:
+                    SPA_LOG_INFO("Recreated {} at {}x{} after {} frames", name, 1280 + i % 7, 720, i);
+                    break;
+                case Message::LongString:
+                    SPA_LOG_WARN("Validation: {} ({})", LONG_TEXT, i);
+                    break;
+            }
+            const auto end = std::chrono::steady_clock::now();
+            call_ns.push_back(std::chrono::duration<f64, std::nano>(end - start).count());
+        }
+
+        const auto flush_start = std::chrono::steady_clock::now();
+        Logger::flush();
+        const auto flush_end = std::chrono::steady_clock::now();
+
+        print_stats(label, summarize(call_ns), "ns/call");
+        std::printf("%-24s flush %.3f ms, %llu dropped\n", "",
+                    std::chrono::duration<f64, std::milli>(flush_end - flush_start).count(),
+                    static_cast<unsigned long long>(Logger::get_dropped_count() - dropped_start));
+    }
+
+    // Every long message that made it to the file must have made it whole
+    static bool check_long_messages(const char* path) {
+        std::ifstream file(path);
+        std::string line;
+        u64 found = 0, cut = 0;
+        while (std::getline(file, line)) {
+            if (line.find("Validation: ") == std::string::npos) continue;
+            found++;
+            if (line.find(LONG_TEXT) == std::string::npos || line.back() != ')') cut++;
+        }
+        std::printf("long messages: %llu written, %llu cut short\n", static_cast<unsigned long long>(found),
+                    static_cast<unsigned long long>(cut));
+        return found > 0 && cut == 0;
+    }
+
+    int bench_log(int argc, char** argv) {
+        const u32 messages = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 100000;
+        const u32 capacity = argc > 1 ? static_cast<u32>(std::atoi(argv[1])) : 8192;
+        const char* path = argc > 2 ? argv[2] : "sparkle_bench_log.txt";
+
+        // Log to a file so the console stays readable and the sink cost is a real write
+        Logger::init();
+        Logger::get_logger()->sinks().clear();
+        Logger::get_logger()->sinks().push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(path, true));
+
+        std::printf("log bench: %u messages, queue capacity %u, writing to %s\n", messages, capacity, path);
+
+        const struct {
+            const char* label;
+            bool async;
+            LogOverflowPolicy overflow;
+        } modes[] = {
+            {"sync", false, LogOverflowPolicy::Block},
+            {"async block", true, LogOverflowPolicy::Block},
+            {"async drop", true, LogOverflowPolicy::Drop},
+            {"async overwrite", true, LogOverflowPolicy::Overwrite},
+        };
+
+        for (const auto& mode : modes) {
+            LogConfig config;
+            config.async = mode.async;
+            config.queue_capacity = capacity;
+            config.overflow = mode.overflow;
+            Logger::configure(config);
+
+            std::printf("-- %s\n", mode.label);
+            run_case("numbers (deferred)", messages, Message::Numbers);
+            run_case("string (preformatted)", messages, Message::String);
+            run_case("long string (heap)", messages / 10, Message::LongString);
+        }
+
+        Logger::configure(LogConfig{});
+        Logger::shutdown();
+        return check_long_messages(path) ? 0 : 1;
+    }
+}
@@ -0,0 +1,91 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/application.h"
+#include "renderer/renderer.h"
+#include "renderer/render_thread.h"
+#include <cstdlib>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    class PipelineBenchGame : public Game {
+    public:
+        PipelineBenchGame() {
+            config.title = "sparkle_bench";
+            config.width = 1280;
+            config.height = 720;
+            engine_config.headless = true;
+        }
+
+        bool init() override { return true; }
+        bool render() override { return true; }
+        bool update(float) override { return true; }
+        void on_resize(int, int) override {}
+    };
+
+    // Stand-in for game simulation: burn the CPU for a fixed time
+    static void simulate(f64 ms) {
+        const u64 end = SDL_GetTicksNS() + static_cast<u64>(ms * 1'000'000.0);
+        while (SDL_GetTicksNS() < end) {}
+    }
+
+    // Runs the same update/draw loop Application::Run does, serial or pipelined
+    static void run_mode(bool pipelined, u32 frames, u32 warmup, f64 update_ms) {
+        std::vector<f64> frame_ms;
+        std::vector<f64> latency_ms;
+        frame_ms.reserve(frames);
+        latency_ms.reserve(frames);
+
+        if (pipelined) RenderThread::start();
+
+        RenderPacket packet = {.clearColor = {0.0f, 0.0f, 1.0f, 1.0f}};
+        for (u32 i = 0; i < frames + warmup; ++i) {
+            const u64 start = SDL_GetTicksNS();
+            packet.simStartNs = start;
+            simulate(update_ms);
+
+            if (pipelined) {
+                *RenderThread::get_write_packet() = packet;
+                if (!RenderThread::submit()) break;
+            } else if (!Renderer::draw_frame(&packet)) {
+                break;
+            }
+            const u64 end = SDL_GetTicksNS();
+
+            if (i < warmup) continue;
+            frame_ms.push_back(static_cast<f64>(end - start) / 1'000'000.0);
+            latency_ms.push_back(Renderer::get_frame_latency_ms());
+        }
+
+        if (pipelined) RenderThread::stop();
+
+        const char* name = pipelined ? "pipelined" : "serial";
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s frame", name);
+        print_stats(label, summarize(frame_ms));
+        std::snprintf(label, sizeof(label), "%s latency", name);
+        print_stats(label, summarize(latency_ms));
+    }
+
+    int bench_pipeline(int argc, char** argv) {
+        const u32 frames = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 500;
+        const f64 update_ms = argc > 1 ? std::atof(argv[1]) : 2.0;
+        const u32 warmup = std::min<u32>(frames / 10 + 3, 50);
+
+        PipelineBenchGame game;
+        Application::SetGameInst(&game);
+        if (!Application::Init()) {
+            std::printf("engine failed to initialize\n");
+            return 1;
+        }
+
+        std::printf("pipeline bench: %u frames, %.2f ms simulated update (headless)\n", frames, update_ms);
+        run_mode(false, frames, warmup, update_ms);
+        run_mode(true, frames, warmup, update_ms);
+
+        Application::Shutdown();
+        return 0;
+    }
+}
@@ -0,0 +1,91 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/application.h"
+#include "renderer/renderer.h"
+#include "renderer/vulkan/vulkan_backend.h"
+#include <cstdlib>
+#include <thread>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    class RecordBenchGame : public Game {
+    public:
+        RecordBenchGame() {
+            config.title = "sparkle_bench";
+            config.width = 256;
+            config.height = 256;
+            engine_config.headless = true;
+        }
+
+        bool init() override { return true; }
+        bool render() override { return true; }
+        bool update(float) override { return true; }
+        void on_resize(int, int) override {}
+    };
+
+    // Stand-in for a draw call until pipelines exist: one tiny clear per item,
+    // which is legal inside a render pass and in RENDER_PASS_CONTINUE secondaries
+    static void record_clears(VkCommandBuffer cmd, uint32_t first, uint32_t count) {
+        VkClearAttachment clear{};
+        clear.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        clear.colorAttachment = 0;
+
+        for (uint32_t i = first; i < first + count; ++i) {
+            clear.clearValue.color.float32[0] = static_cast<float>(i & 0xff) / 255.0f;
+            clear.clearValue.color.float32[3] = 1.0f;
+
+            VkClearRect rect{};
+            rect.rect.offset = { static_cast<int32_t>(i % 256), static_cast<int32_t>((i / 256) % 256) };
+            rect.rect.extent = { 1, 1 };
+            rect.layerCount = 1;
+            vkCmdClearAttachments(cmd, 1, &clear, 1, &rect);
+        }
+    }
+
+    int bench_record(int argc, char** argv) {
+        const u32 max_draws = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 100'000;
+        const u32 max_threads = argc > 1 ? static_cast<u32>(std::atoi(argv[1]))
+                                         : std::max(1u, std::thread::hardware_concurrency());
+        const u32 frames = argc > 2 ? static_cast<u32>(std::atoi(argv[2])) : 100;
+        const u32 warmup = 5;
+
+        RecordBenchGame game;
+        Application::SetGameInst(&game);
+        if (!Application::Init()) {
+            std::printf("engine failed to initialize\n");
+            return 1;
+        }
+        auto* backend = static_cast<VulkanBackend*>(Renderer::get_backend());
+
+        RenderPacket packet = {.clearColor = {0.0f, 0.0f, 0.0f, 1.0f}};
+        std::printf("record bench: draws x threads, %u frames each (headless)\n", frames);
+
+        for (u32 draws = 1000; draws <= max_draws; draws *= 10) {
+            backend->set_draw_work(draws, record_clears);
+
+            for (u32 threads = 1; threads <= max_threads; threads *= 2) {
+                backend->set_record_threads(threads);
+
+                std::vector<f64> cpu_ms;
+                cpu_ms.reserve(frames);
+                for (u32 i = 0; i < frames + warmup; ++i) {
+                    const u64 start = SDL_GetTicksNS();
+                    Renderer::draw_frame(&packet);
+                    const u64 end = SDL_GetTicksNS();
+                    if (i >= warmup) cpu_ms.push_back(static_cast<f64>(end - start) / 1'000'000.0);
+                }
+
+                char label[64];
+                std::snprintf(label, sizeof(label), "%7u draws %2u thr", draws, threads);
+                print_stats(label, summarize(cpu_ms));
+            }
+        }
+
+        backend->set_draw_work(0, nullptr);
+        Application::Shutdown();
+        return 0;
+    }
+}
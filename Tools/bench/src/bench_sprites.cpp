@@ -0,0 +1,109 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/application.h"
+#include "renderer/renderer.h"
+#include "renderer/vulkan/vulkan_backend.h"
+#include <cstdlib>
+#include <random>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    class SpriteBenchGame : public Game {
+    public:
+        SpriteBenchGame() {
+            config.title = "sparkle_bench";
+            config.width = 1280;
+            config.height = 720;
+            engine_config.headless = true;
+        }
+
+        bool init() override { return true; }
+        bool render() override { return true; }
+        bool update(float) override { return true; }
+        void on_resize(int, int) override {}
+    };
+
+    // Scattered over the screen in random texture / layer order, so every frame pays for a full sort
+    static std::vector<Quad> make_quads(u32 count, u32 textures, u32 layers) {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<f32> x(0.0f, 1280.0f);
+        std::uniform_real_distribution<f32> y(0.0f, 720.0f);
+        std::uniform_real_distribution<f32> size(2.0f, 16.0f);
+
+        std::vector<Quad> quads(count);
+        for (Quad& quad : quads) {
+            quad.position[0] = x(rng);
+            quad.position[1] = y(rng);
+            quad.size[0] = quad.size[1] = size(rng);
+            quad.color = rng() | 0xff000000u;
+            quad.texture = static_cast<u16>(rng() % textures);
+            quad.layer = static_cast<u8>(rng() % layers);
+        }
+        return quads;
+    }
+
+    int bench_sprites(int argc, char** argv) {
+        const u32 max_quads = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 1'000'000;
+        const u32 frames = argc > 1 ? static_cast<u32>(std::atoi(argv[1])) : 200;
+        const u32 textures = std::max(1, argc > 2 ? std::atoi(argv[2]) : 16);
+        const u32 layers = std::clamp(argc > 3 ? std::atoi(argv[3]) : 4, 1, 256);
+        const u32 warmup = 5;
+
+        SpriteBenchGame game;
+        Application::SetGameInst(&game);
+        if (!Application::Init()) {
+            std::printf("engine failed to initialize\n");
+            return 1;
+        }
+        auto* backend = static_cast<VulkanBackend*>(Renderer::get_backend());
+        VulkanSpriteRenderer& sprites = backend->get_sprites();
+        if (!sprites.is_created()) {
+            std::printf("sprite renderer unavailable (were the shaders compiled?)\n");
+            Application::Shutdown();
+            return 1;
+        }
+        sprites.wait_ready();
+
+        RenderPacket packet = {.clearColor = {0.0f, 0.0f, 0.0f, 1.0f}};
+        std::printf("sprites bench: %u textures, %u layers, %u frames each (headless)\n", textures, layers, frames);
+
+        for (u32 count = 1000; count <= max_quads; count *= 10) {
+            const std::vector<Quad> quads = make_quads(count, textures, layers);
+
+            std::vector<f64> submit_ms, cpu_ms, sort_ms, write_ms, gpu_ms;
+            u32 batches = 0;
+            for (u32 i = 0; i < frames + warmup; ++i) {
+                const u64 start = SDL_GetTicksNS();
+                for (const Quad& quad : quads) {
+                    Renderer::submit_quad(quad);
+                }
+                Renderer::flush_quads(&packet);
+                const u64 submitted = SDL_GetTicksNS();
+                Renderer::draw_frame(&packet);
+                const u64 end = SDL_GetTicksNS();
+
+                if (i < warmup) continue;
+                const SpriteBatchStats& stats = sprites.get_stats();
+                submit_ms.push_back(static_cast<f64>(submitted - start) / 1'000'000.0);
+                cpu_ms.push_back(static_cast<f64>(end - submitted) / 1'000'000.0);
+                sort_ms.push_back(stats.sort_ms);
+                write_ms.push_back(stats.write_ms);
+                gpu_ms.push_back(backend->get_gpu_frame_time_ms());
+                batches = stats.batches;
+            }
+
+            std::printf("%u quads -> %u instanced draws\n", count, batches);
+            print_stats("  submit_quad", summarize(submit_ms));
+            print_stats("  cpu draw_frame", summarize(cpu_ms));
+            print_stats("    radix sort", summarize(sort_ms));
+            print_stats("    instance write", summarize(write_ms));
+            print_stats("  gpu frame", summarize(gpu_ms));
+        }
+
+        Application::Shutdown();
+        return 0;
+    }
+}
@@ -0,0 +1,193 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/application.h"
+#include "core/assets.h"
+#include "renderer/renderer.h"
+#include "renderer/vulkan/vulkan_backend.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    static const char* TEXTURE_ARCHIVE = "sparkle_bench_textures.spak";
+
+    class TextureBenchGame : public Game {
+    public:
+        TextureBenchGame(u64 budget) {
+            config.title = "sparkle_bench";
+            config.width = 1280;
+            config.height = 720;
+            engine_config.headless = true;
+            engine_config.assets.archive = TEXTURE_ARCHIVE;
+            engine_config.assets.verify = false;
+            engine_config.assets.texture_budget = budget;
+        }
+
+        bool init() override { return true; }
+        bool render() override { return true; }
+        bool update(float) override { return true; }
+        void on_resize(int, int) override {}
+    };
+
+    static std::string texture_name(u32 index) {
+        return "bench/texture_" + std::to_string(index) + ".tex";
+    }
+
+    // RGBA8 chains in the layout sparkle_cook writes (TextureHeader, TextureMip table, mips largest first)
+    static std::vector<u8> make_texture(u32 size, u32 seed) {
+        u32 mip_count = 1;
+        while ((size >> (mip_count - 1)) > 1) mip_count++;
+
+        TextureHeader header;
+        header.width = size;
+        header.height = size;
+        header.mip_count = mip_count;
+        header.format = TextureFormat::RGBA8;
+        header.flags = TEXTURE_SRGB;
+
+        std::vector<TextureMip> mips(mip_count);
+        u64 offset = (sizeof(TextureHeader) + mip_count * sizeof(TextureMip) + 15) & ~u64(15);
+        for (u32 i = 0; i < mip_count; ++i) {
+            mips[i].width = std::max(size >> i, 1u);
+            mips[i].height = mips[i].width;
+            mips[i].offset = offset;
+            mips[i].size = static_cast<u64>(mips[i].width) * mips[i].height * 4;
+            offset = (offset + mips[i].size + 15) & ~u64(15);
+        }
+
+        std::vector<u8> blob(offset, 0);
+        std::memcpy(blob.data(), &header, sizeof(header));
+        std::memcpy(blob.data() + sizeof(header), mips.data(), mip_count * sizeof(TextureMip));
+        for (u32 i = 0; i < mip_count; ++i) {
+            std::memset(blob.data() + mips[i].offset, static_cast<int>((seed * 31 + i) & 0xff), mips[i].size);
+        }
+        return blob;
+    }
+
+    static bool write_archive(u32 count, u32 size) {
+        std::vector<std::vector<u8>> blobs(count);
+        std::vector<ArchiveEntry> entries(count);
+        for (u32 i = 0; i < count; ++i) {
+            blobs[i] = make_texture(size, i);
+            entries[i].name_hash = hash_name(texture_name(i));
+            entries[i].content_hash = hash_content(blobs[i].data(), blobs[i].size());
+            entries[i].size = blobs[i].size();
+            entries[i].type = AssetType::Texture;
+            entries[i].flags = i; // Which blob, until the index is sorted
+        }
+        std::sort(entries.begin(), entries.end(), [](const ArchiveEntry& a, const ArchiveEntry& b) {
+            return a.name_hash < b.name_hash;
+        });
+
+        u64 offset = sizeof(ArchiveHeader) + count * sizeof(ArchiveEntry);
+        for (ArchiveEntry& entry : entries) {
+            offset = (offset + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+            entry.offset = offset;
+            offset += entry.size;
+        }
+        ArchiveHeader header;
+        header.entry_count = count;
+        header.file_size = offset;
+
+        FILE* file = std::fopen(TEXTURE_ARCHIVE, "wb");
+        if (!file) return false;
+        std::vector<ArchiveEntry> index = entries;
+        for (ArchiveEntry& entry : index) entry.flags = 0;
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fwrite(index.data(), sizeof(ArchiveEntry), count, file);
+        const u8 zeros[ARCHIVE_ALIGNMENT] = {};
+        u64 written = sizeof(ArchiveHeader) + count * sizeof(ArchiveEntry);
+        for (const ArchiveEntry& entry : entries) {
+            std::fwrite(zeros, 1, entry.offset - written, file);
+            std::fwrite(blobs[entry.flags].data(), 1, entry.size, file);
+            written = entry.offset + entry.size;
+        }
+        return std::fclose(file) == 0;
+    }
+
+    int bench_textures(int argc, char** argv) {
+        const u32 count = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 256;
+        const u32 size = argc > 1 ? static_cast<u32>(std::atoi(argv[1])) : 1024;
+        const u64 budget = (argc > 2 ? static_cast<u64>(std::atoi(argv[2])) : 64) * 1024 * 1024;
+        const u32 frames = argc > 3 ? static_cast<u32>(std::atoi(argv[3])) : 600;
+        constexpr u32 VISIBLE = 24; // Textures on screen at once
+
+        if (!write_archive(count, size)) {
+            std::printf("failed to write %s\n", TEXTURE_ARCHIVE);
+            return 1;
+        }
+
+        TextureBenchGame game(budget);
+        Application::SetGameInst(&game);
+        if (!Application::Init()) {
+            std::printf("engine failed to initialize\n");
+            std::remove(TEXTURE_ARCHIVE);
+            return 1;
+        }
+        auto* backend = static_cast<VulkanBackend*>(Renderer::get_backend());
+        VulkanTextureStreamer& streamer = backend->get_textures();
+        if (!streamer.is_created()) {
+            std::printf("texture streamer unavailable on this device\n");
+            Application::Shutdown();
+            std::remove(TEXTURE_ARCHIVE);
+            return 1;
+        }
+
+        std::vector<u32> ids(count);
+        for (u32 i = 0; i < count; ++i) {
+            ids[i] = streamer.add(Assets::find(texture_name(i)));
+        }
+
+        std::printf("textures bench: %u textures of %u^2 RGBA8 (%.1f MiB full chains), %llu MiB budget, "
+                    "%u visible (headless)\n", count, size,
+                    static_cast<f64>(count) * size * size * 4 * 4 / 3 / (1024.0 * 1024.0),
+                    static_cast<unsigned long long>(budget / (1024 * 1024)), VISIBLE);
+
+        // A camera panning along a row of textures: the one in the middle of the view is seen up close,
+        // its neighbours progressively further away
+        RenderPacket packet = {.clearColor = {0.0f, 0.0f, 0.0f, 1.0f}};
+        std::vector<f64> frame_ms;
+        frame_ms.reserve(frames);
+        u64 loads = 0, evictions = 0, limited = 0, uploaded = 0;
+        VkDeviceSize peak_resident = 0;
+        for (u32 frame = 0; frame < frames; ++frame) {
+            const u64 start = SDL_GetTicksNS();
+            const f32 center = static_cast<f32>(frame) * 0.25f;
+            for (u32 v = 0; v < VISIBLE; ++v) {
+                const f32 position = std::floor(center) - VISIBLE / 2 + static_cast<f32>(v);
+                const u32 index = static_cast<u32>(static_cast<i64>(position) % count + count) % count;
+                const f32 distance = 1.0f + std::abs(position - center);
+                streamer.request_distance(ids[index], 1.0f, distance, 1.0f, static_cast<u32>(size * 2));
+            }
+            Assets::update();
+            Renderer::draw_frame(&packet);
+            frame_ms.push_back(static_cast<f64>(SDL_GetTicksNS() - start) / 1'000'000.0);
+
+            const VulkanTextureStreamStats& stats = streamer.get_stats();
+            loads += stats.loads_completed;
+            evictions += stats.evictions;
+            limited += stats.budget_limited;
+            uploaded += stats.uploaded_bytes;
+            peak_resident = std::max(peak_resident, stats.resident_bytes);
+        }
+
+        const VulkanTextureStreamStats& stats = streamer.get_stats();
+        print_stats("frame", summarize(frame_ms));
+        std::printf("%u/%u resident, %.1f MiB resident (peak %.1f), %.1f MiB committed\n", stats.resident,
+                    stats.textures, static_cast<f64>(stats.resident_bytes) / (1024.0 * 1024.0),
+                    static_cast<f64>(peak_resident) / (1024.0 * 1024.0),
+                    static_cast<f64>(stats.committed_bytes) / (1024.0 * 1024.0));
+        std::printf("%llu mip loads, %llu evictions, %llu budget-limited requests, %.1f MiB uploaded\n",
+                    static_cast<unsigned long long>(loads), static_cast<unsigned long long>(evictions),
+                    static_cast<unsigned long long>(limited), static_cast<f64>(uploaded) / (1024.0 * 1024.0));
+
+        Application::Shutdown();
+        std::remove(TEXTURE_ARCHIVE);
+        return 0;
+    }
+}
@@ -0,0 +1,99 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include "core/application.h"
+#include "renderer/renderer.h"
+#include "renderer/vulkan/vulkan_backend.h"
+#include <cstdlib>
+
+using namespace Sparkle;
+
+namespace SparkleBench {
+    class UploadBenchGame : public Game {
+    public:
+        UploadBenchGame() {
+            config.title = "sparkle_bench";
+            config.width = 1280;
+            config.height = 720;
+            engine_config.headless = true;
+        }
+
+        bool init() override { return true; }
+        bool render() override { return true; }
+        bool update(float) override { return true; }
+        void on_resize(int, int) override {}
+    };
+
+    int bench_upload(int argc, char** argv) {
+        const u32 max_mib = argc > 0 ? static_cast<u32>(std::atoi(argv[0])) : 8;
+        const u32 frames = argc > 1 ? static_cast<u32>(std::atoi(argv[1])) : 300;
+        const u32 warmup = 5;
+        constexpr VkDeviceSize CHUNK = 256 * 1024;
+
+        UploadBenchGame game;
+        Application::SetGameInst(&game);
+        if (!Application::Init()) {
+            std::printf("engine failed to initialize\n");
+            return 1;
+        }
+        auto* backend = static_cast<VulkanBackend*>(Renderer::get_backend());
+        VulkanStagingRing& staging = backend->get_staging_ring();
+        if (!staging.is_created()) {
+            std::printf("staging ring unavailable on this device\n");
+            Application::Shutdown();
+            return 1;
+        }
+
+        VulkanDevice& device = backend->get_device();
+        VulkanMemoryAllocator& memory = device.get_memory_allocator();
+
+        // Destination the uploads stream into, like a vertex buffer rebuilt every frame
+        VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        buffer_info.size = static_cast<VkDeviceSize>(max_mib) * 1024 * 1024;
+        buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkBuffer dst = VK_NULL_HANDLE;
+        VulkanAllocation dst_allocation;
+        if (memory.create_buffer(buffer_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dst, dst_allocation) != VK_SUCCESS) {
+            std::printf("failed to create destination buffer\n");
+            Application::Shutdown();
+            return 1;
+        }
+
+        std::vector<u8> source(CHUNK, 0xab);
+        RenderPacket packet = {.clearColor = {0.0f, 0.0f, 0.0f, 1.0f}};
+
+        std::printf("upload bench: %u frames per size, %s transfer queue, %llu KiB staging per frame (headless)\n",
+                    frames, device.has_dedicated_transfer_queue() ? "dedicated" : "shared graphics",
+                    static_cast<unsigned long long>(staging.get_region_size() / 1024));
+
+        for (u32 mib = 0; mib <= max_mib; mib = mib == 0 ? 1 : mib * 2) {
+            const VkDeviceSize bytes = static_cast<VkDeviceSize>(mib) * 1024 * 1024;
+            std::vector<f64> frame_ms;
+            frame_ms.reserve(frames);
+            u32 rejected = 0;
+
+            for (u32 i = 0; i < frames + warmup; ++i) {
+                const u64 start = SDL_GetTicksNS();
+                for (VkDeviceSize offset = 0; offset < bytes; offset += CHUNK) {
+                    if (!staging.upload_buffer(source.data(), CHUNK, dst, offset)) rejected++;
+                }
+                Renderer::draw_frame(&packet);
+                const u64 end = SDL_GetTicksNS();
+                if (i >= warmup) frame_ms.push_back(static_cast<f64>(end - start) / 1'000'000.0);
+            }
+
+            char label[64];
+            std::snprintf(label, sizeof(label), "%4u MiB/frame", mib);
+            print_stats(label, summarize(frame_ms));
+            if (rejected > 0) std::printf("%-24s %u chunks rejected (staging region full)\n", "", rejected);
+        }
+
+        vkDeviceWaitIdle(device.get_logical_device());
+        memory.destroy_buffer(dst, dst_allocation);
+        Application::Shutdown();
+        return 0;
+    }
+}
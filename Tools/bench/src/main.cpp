@@ -0,0 +1,51 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "bench.h"
+#include <cstring>
+
+using namespace SparkleBench;
+
+struct BenchEntry {
+    const char* name;
+    const char* usage;
+    int (*run)(int argc, char** argv);
+};
+
+static const BenchEntry s_benches[] = {
+    {"frame", "frame [frames=1000] [width=1280] [height=720] [dynamic_rendering=1]", bench_frame},
+    {"record", "record [max_draws=100000] [max_threads=hw] [frames=100]", bench_record},
+    {"jobs", "jobs [max_workers=hw] [rounds=50]", bench_jobs},
+    {"pipeline", "pipeline [frames=500] [update_ms=2.0]", bench_pipeline},
+    {"arena", "arena [frames=1000] [items=10000]", bench_arena},
+    {"upload", "upload [max_mib_per_frame=8] [frames=300]", bench_upload},
+    {"log", "log [messages=100000] [queue_capacity=8192] [path=sparkle_bench_log.txt]", bench_log},
+    {"sprites", "sprites [max_quads=1000000] [frames=200] [textures=16] [layers=4]", bench_sprites},
+    {"ecs", "ecs [entities=1000000] [iterations=50] [workers=hw]", bench_ecs},
+    {"assets", "assets [assets=2000] [size_kib=256] [io_threads=2]", bench_assets},
+    {"textures", "textures [textures=256] [size=1024] [budget_mib=64] [frames=600]", bench_textures},
+};
+
+static void print_usage() {
+    std::printf("usage: sparkle_bench <bench> [args...]\n");
+    for (const BenchEntry& entry : s_benches) {
+        std::printf("  %s\n", entry.usage);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    for (const BenchEntry& entry : s_benches) {
+        if (std::strcmp(argv[1], entry.name) == 0) {
+            return entry.run(argc - 2, argv + 2);
+        }
+    }
+
+    std::printf("unknown bench '%s'\n", argv[1]);
+    print_usage();
+    return 1;
+}
@@ -0,0 +1,49 @@
+//
+// Created by overlord on 10/17/26.
+//
+#pragma once
+
+#include "defines.h"
+#include "core/asset_format.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace SparkleCook {
+    // Bump whenever any cooker's output changes, so stale cache entries are cooked again
+    static constexpr u32 COOK_VERSION = 1;
+
+    struct CookOptions {
+        bool compress = true;     // Block-compress textures; RGBA8 otherwise
+        std::string glslc;        // Shader compiler; shaders fail to cook without one
+        std::string scratch_dir;  // Where tools that need files write them
+    };
+
+    struct CookResult {
+        Sparkle::AssetType type = Sparkle::AssetType::Raw;
+        u32 flags = 0;
+        std::vector<u8> blob;
+        std::string error; // Set when cooking failed
+    };
+
+    struct CookInput {
+        std::string name;       // Path relative to the source root with '/' separators; the asset's name
+        std::string path;       // Path on disk
+        std::vector<u8> source; // The file's bytes
+    };
+
+    // Each fills result in the layout asset_format.h describes for its type
+    bool cook_texture(const CookInput& input, const CookOptions& options, CookResult& result);
+    bool cook_mesh(const CookInput& input, const CookOptions& options, CookResult& result);
+    bool cook_shader(const CookInput& input, const CookOptions& options, CookResult& result);
+
+    template<typename T>
+    void append(std::vector<u8>& blob, const T* data, size_t count = 1) {
+        const u8* bytes = reinterpret_cast<const u8*>(data);
+        blob.insert(blob.end(), bytes, bytes + sizeof(T) * count);
+    }
+
+    inline void align_to(std::vector<u8>& blob, size_t alignment) {
+        blob.resize((blob.size() + alignment - 1) / alignment * alignment, 0);
+    }
+}
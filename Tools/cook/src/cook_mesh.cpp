@@ -0,0 +1,272 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "cook.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+using namespace Sparkle;
+
+namespace SparkleCook {
+    // Post-transform cache size the index order is tuned for; close to what current GPUs keep
+    static constexpr i32 VERTEX_CACHE_SIZE = 16;
+
+    struct VertexKey {
+        MeshVertex vertex;
+
+        bool operator==(const VertexKey& other) const {
+            return std::memcmp(&vertex, &other.vertex, sizeof(MeshVertex)) == 0;
+        }
+    };
+
+    struct VertexKeyHash {
+        size_t operator()(const VertexKey& key) const {
+            return static_cast<size_t>(hash_content(&key.vertex, sizeof(MeshVertex)));
+        }
+    };
+
+    // OBJ corners index positions / uvs / normals separately; -1 when absent
+    struct Corner {
+        i32 position = -1;
+        i32 uv = -1;
+        i32 normal = -1;
+    };
+
+    static i32 resolve_index(const char* text, size_t count) {
+        const long value = std::strtol(text, nullptr, 10);
+        return value < 0 ? static_cast<i32>(count) + static_cast<i32>(value) : static_cast<i32>(value) - 1;
+    }
+
+    static bool parse_obj(const std::vector<u8>& source, std::vector<f32>& positions, std::vector<f32>& uvs,
+                          std::vector<f32>& normals, std::vector<Corner>& corners, std::string& error) {
+        const std::string text(source.begin(), source.end());
+        size_t line_start = 0;
+        std::vector<Corner> face;
+        while (line_start < text.size()) {
+            size_t line_end = text.find('\n', line_start);
+            if (line_end == std::string::npos) line_end = text.size();
+            const std::string line = text.substr(line_start, line_end - line_start);
+            line_start = line_end + 1;
+
+            const char* s = line.c_str();
+            if (std::strncmp(s, "v ", 2) == 0) {
+                f32 x = 0, y = 0, z = 0;
+                std::sscanf(s + 2, "%f %f %f", &x, &y, &z);
+                positions.insert(positions.end(), {x, y, z});
+            } else if (std::strncmp(s, "vt ", 3) == 0) {
+                f32 u = 0, v = 0;
+                std::sscanf(s + 3, "%f %f", &u, &v);
+                uvs.insert(uvs.end(), {u, 1.0f - v}); // OBJ puts v = 0 at the bottom; Vulkan at the top
+            } else if (std::strncmp(s, "vn ", 3) == 0) {
+                f32 x = 0, y = 0, z = 0;
+                std::sscanf(s + 3, "%f %f %f", &x, &y, &z);
+                normals.insert(normals.end(), {x, y, z});
+            } else if (std::strncmp(s, "f ", 2) == 0) {
+                face.clear();
+                const char* p = s + 2;
+                while (*p) {
+                    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+                    if (!*p) break;
+                    Corner corner;
+                    corner.position = resolve_index(p, positions.size() / 3);
+                    while (*p && *p != '/' && *p != ' ') p++;
+                    if (*p == '/') {
+                        p++;
+                        if (*p != '/') corner.uv = resolve_index(p, uvs.size() / 2);
+                        while (*p && *p != '/' && *p != ' ') p++;
+                        if (*p == '/') {
+                            p++;
+                            corner.normal = resolve_index(p, normals.size() / 3);
+                            while (*p && *p != ' ') p++;
+                        }
+                    }
+                    if (corner.position < 0 || corner.position >= static_cast<i32>(positions.size() / 3) ||
+                        corner.uv >= static_cast<i32>(uvs.size() / 2) ||
+                        corner.normal >= static_cast<i32>(normals.size() / 3)) {
+                        error = "face references a missing vertex: " + line;
+                        return false;
+                    }
+                    face.push_back(corner);
+                }
+                // Polygons as triangle fans
+                for (size_t i = 2; i < face.size(); ++i) {
+                    corners.insert(corners.end(), {face[0], face[i - 1], face[i]});
+                }
+            }
+        }
+        if (corners.empty()) {
+            error = "no faces";
+            return false;
+        }
+        return true;
+    }
+
+    // Tipsify (Sander, Nehab, Barczak 2007): emit triangles fanning around one vertex at a time,
+    // moving to the next vertex still likely to be in the post-transform cache
+    static std::vector<u32> optimize_vertex_cache(const std::vector<u32>& indices, u32 vertex_count) {
+        const u32 triangle_count = static_cast<u32>(indices.size() / 3);
+        std::vector<u32> live(vertex_count, 0);
+        for (u32 index : indices) live[index]++;
+        std::vector<u32> adjacency_start(vertex_count + 1, 0);
+        for (u32 v = 0; v < vertex_count; ++v) adjacency_start[v + 1] = adjacency_start[v] + live[v];
+        std::vector<u32> adjacency(indices.size());
+        std::vector<u32> fill(adjacency_start.begin(), adjacency_start.end() - 1);
+        for (u32 i = 0; i < indices.size(); ++i) adjacency[fill[indices[i]]++] = i / 3;
+
+        std::vector<i32> cache_time(vertex_count, 0);
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<u32> dead_end;
+        std::vector<u32> candidates;
+        std::vector<u32> output;
+        output.reserve(indices.size());
+
+        i32 time = VERTEX_CACHE_SIZE + 1;
+        u32 cursor = 0;
+        i64 fanning = 0;
+        while (fanning >= 0) {
+            candidates.clear();
+            const u32 v = static_cast<u32>(fanning);
+            for (u32 a = adjacency_start[v]; a < adjacency_start[v + 1]; ++a) {
+                const u32 triangle = adjacency[a];
+                if (emitted[triangle]) continue;
+                emitted[triangle] = true;
+                for (u32 corner = 0; corner < 3; ++corner) {
+                    const u32 index = indices[triangle * 3 + corner];
+                    output.push_back(index);
+                    dead_end.push_back(index);
+                    candidates.push_back(index);
+                    live[index]--;
+                    if (time - cache_time[index] > VERTEX_CACHE_SIZE) {
+                        cache_time[index] = time++;
+                    }
+                }
+            }
+
+            // The candidate that will still be cached after its remaining triangles are emitted
+            fanning = -1;
+            i32 best = -1;
+            for (u32 candidate : candidates) {
+                if (live[candidate] == 0) continue;
+                i32 priority = 0;
+                if (time - cache_time[candidate] + 2 * static_cast<i32>(live[candidate]) <= VERTEX_CACHE_SIZE) {
+                    priority = time - cache_time[candidate];
+                }
+                if (priority > best) {
+                    best = priority;
+                    fanning = candidate;
+                }
+            }
+            if (fanning >= 0) continue;
+
+            // Dead end: back up to a recently used vertex with triangles left, else scan forward
+            while (!dead_end.empty() && fanning < 0) {
+                const u32 d = dead_end.back();
+                dead_end.pop_back();
+                if (live[d] > 0) fanning = d;
+            }
+            while (fanning < 0 && cursor < vertex_count) {
+                if (live[cursor] > 0) fanning = cursor;
+                cursor++;
+            }
+        }
+        return output;
+    }
+
+    bool cook_mesh(const CookInput& input, const CookOptions&, CookResult& result) {
+        std::vector<f32> positions, uvs, normals;
+        std::vector<Corner> corners;
+        if (!parse_obj(input.source, positions, uvs, normals, corners, result.error)) return false;
+
+        // Missing normals: area-weighted average of the faces sharing each position
+        std::vector<f32> smooth;
+        const bool generate_normals = std::any_of(corners.begin(), corners.end(),
+                                                  [](const Corner& c) { return c.normal < 0; });
+        if (generate_normals) {
+            smooth.assign(positions.size(), 0.0f);
+            for (size_t t = 0; t < corners.size(); t += 3) {
+                const f32* a = &positions[corners[t].position * 3];
+                const f32* b = &positions[corners[t + 1].position * 3];
+                const f32* c = &positions[corners[t + 2].position * 3];
+                const f32 e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                const f32 e1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+                const f32 n[3] = {e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2],
+                                  e0[0] * e1[1] - e0[1] * e1[0]};
+                for (u32 k = 0; k < 3; ++k) {
+                    for (u32 axis = 0; axis < 3; ++axis) smooth[corners[t + k].position * 3 + axis] += n[axis];
+                }
+            }
+            for (size_t i = 0; i < smooth.size(); i += 3) {
+                const f32 length = std::sqrt(smooth[i] * smooth[i] + smooth[i + 1] * smooth[i + 1] +
+                                             smooth[i + 2] * smooth[i + 2]);
+                if (length > 0.0f) {
+                    for (u32 axis = 0; axis < 3; ++axis) smooth[i + axis] /= length;
+                }
+            }
+        }
+
+        // Interleave and weld identical corners into one vertex
+        std::vector<MeshVertex> vertices;
+        std::vector<u32> indices;
+        indices.reserve(corners.size());
+        std::unordered_map<VertexKey, u32, VertexKeyHash> welded;
+        for (const Corner& corner : corners) {
+            VertexKey key = {};
+            std::memcpy(key.vertex.position, &positions[corner.position * 3], sizeof(f32) * 3);
+            const f32* normal = corner.normal >= 0 ? &normals[corner.normal * 3] : &smooth[corner.position * 3];
+            std::memcpy(key.vertex.normal, normal, sizeof(f32) * 3);
+            if (corner.uv >= 0) std::memcpy(key.vertex.uv, &uvs[corner.uv * 2], sizeof(f32) * 2);
+
+            auto [it, inserted] = welded.try_emplace(key, static_cast<u32>(vertices.size()));
+            if (inserted) vertices.push_back(key.vertex);
+            indices.push_back(it->second);
+        }
+
+        indices = optimize_vertex_cache(indices, static_cast<u32>(vertices.size()));
+
+        // Lay vertices out in the order the indices first use them, so fetches walk memory forward
+        std::vector<u32> remap(vertices.size(), UINT32_MAX);
+        std::vector<MeshVertex> ordered;
+        ordered.reserve(vertices.size());
+        for (u32& index : indices) {
+            if (remap[index] == UINT32_MAX) {
+                remap[index] = static_cast<u32>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        MeshHeader header;
+        header.vertex_count = static_cast<u32>(ordered.size());
+        header.index_count = static_cast<u32>(indices.size());
+        header.index_size = header.vertex_count <= UINT16_MAX ? 2 : 4;
+        for (u32 axis = 0; axis < 3; ++axis) {
+            header.bounds_min[axis] = ordered[0].position[axis];
+            header.bounds_max[axis] = ordered[0].position[axis];
+        }
+        for (const MeshVertex& vertex : ordered) {
+            for (u32 axis = 0; axis < 3; ++axis) {
+                header.bounds_min[axis] = std::min(header.bounds_min[axis], vertex.position[axis]);
+                header.bounds_max[axis] = std::max(header.bounds_max[axis], vertex.position[axis]);
+            }
+        }
+
+        result.type = AssetType::Mesh;
+        result.blob.clear();
+        result.blob.resize(sizeof(MeshHeader));
+        align_to(result.blob, 16);
+        header.vertex_offset = result.blob.size();
+        append(result.blob, ordered.data(), ordered.size());
+        align_to(result.blob, 16);
+        header.index_offset = result.blob.size();
+        if (header.index_size == 2) {
+            std::vector<u16> narrow(indices.begin(), indices.end());
+            append(result.blob, narrow.data(), narrow.size());
+        } else {
+            append(result.blob, indices.data(), indices.size());
+        }
+        std::memcpy(result.blob.data(), &header, sizeof(header));
+        return true;
+    }
+}
@@ -0,0 +1,54 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "cook.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace Sparkle;
+
+namespace SparkleCook {
+    static constexpr u32 SPIRV_MAGIC = 0x07230203;
+
+    bool cook_shader(const CookInput& input, const CookOptions& options, CookResult& result) {
+        if (options.glslc.empty()) {
+            result.error = "no shader compiler (pass --glslc)";
+            return false;
+        }
+
+        const std::string extension = std::filesystem::path(input.path).extension().string();
+        ShaderStage stage = ShaderStage::Vertex;
+        if (extension == ".frag") stage = ShaderStage::Fragment;
+        else if (extension == ".comp") stage = ShaderStage::Compute;
+
+        // glslc reads the file itself so #include resolves relative to the source
+        char output[64];
+        std::snprintf(output, sizeof(output), "%016llx.spv",
+                      static_cast<unsigned long long>(hash_name(input.name)));
+        const std::filesystem::path spirv_path = std::filesystem::path(options.scratch_dir) / output;
+        const std::string command = "\"" + options.glslc + "\" -O \"" + input.path + "\" -o \"" +
+                                    spirv_path.string() + "\"";
+        if (std::system(command.c_str()) != 0) {
+            result.error = "glslc failed";
+            return false;
+        }
+
+        std::ifstream file(spirv_path, std::ios::binary);
+        result.blob.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        file.close();
+        std::filesystem::remove(spirv_path);
+
+        u32 magic = 0;
+        if (result.blob.size() >= 4) std::memcpy(&magic, result.blob.data(), 4);
+        if (magic != SPIRV_MAGIC || result.blob.size() % 4 != 0) {
+            result.error = "glslc produced no valid SPIR-V";
+            return false;
+        }
+        result.type = AssetType::Shader;
+        result.flags = static_cast<u32>(stage);
+        return true;
+    }
+}
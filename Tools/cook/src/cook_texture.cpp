@@ -0,0 +1,367 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "cook.h"
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <cstring>
+
+using namespace Sparkle;
+
+namespace SparkleCook {
+    struct Image {
+        u32 width = 0;
+        u32 height = 0;
+        std::vector<u8> rgba;
+    };
+
+    static bool decode_bmp(const std::vector<u8>& source, Image& image, std::string& error) {
+        SDL_IOStream* io = SDL_IOFromConstMem(source.data(), source.size());
+        SDL_Surface* loaded = io ? SDL_LoadBMP_IO(io, true) : nullptr;
+        SDL_Surface* surface = loaded ? SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32) : nullptr;
+        if (loaded) SDL_DestroySurface(loaded);
+        if (!surface) {
+            error = SDL_GetError();
+            return false;
+        }
+        image.width = static_cast<u32>(surface->w);
+        image.height = static_cast<u32>(surface->h);
+        image.rgba.resize(static_cast<size_t>(image.width) * image.height * 4);
+        for (u32 y = 0; y < image.height; ++y) {
+            std::memcpy(&image.rgba[static_cast<size_t>(y) * image.width * 4],
+                        static_cast<const u8*>(surface->pixels) + static_cast<size_t>(y) * surface->pitch,
+                        static_cast<size_t>(image.width) * 4);
+        }
+        SDL_DestroySurface(surface);
+        return true;
+    }
+
+    // Uncompressed and RLE true-color / grayscale TGA
+    static bool decode_tga(const std::vector<u8>& source, Image& image, std::string& error) {
+        if (source.size() < 18) {
+            error = "truncated header";
+            return false;
+        }
+        const u8* header = source.data();
+        const u8 type = header[2];
+        const u32 bpp = header[16];
+        const bool rle = type == 10 || type == 11;
+        const bool gray = type == 3 || type == 11;
+        if (header[1] != 0 || !(type == 2 || type == 3 || rle) ||
+            (gray ? bpp != 8 : (bpp != 24 && bpp != 32))) {
+            error = "unsupported TGA type (only true-color and grayscale)";
+            return false;
+        }
+        image.width = header[12] | header[13] << 8;
+        image.height = header[14] | header[15] << 8;
+        const bool top_down = (header[17] & 0x20) != 0;
+        const u32 bytes = bpp / 8;
+        const size_t pixels = static_cast<size_t>(image.width) * image.height;
+        image.rgba.assign(pixels * 4, 255);
+
+        size_t pos = 18 + header[0];
+        auto read_pixel = [&](size_t index) {
+            u8* out = &image.rgba[index * 4];
+            const u8* in = &source[pos];
+            if (gray) {
+                out[0] = out[1] = out[2] = in[0];
+            } else {
+                out[0] = in[2];
+                out[1] = in[1];
+                out[2] = in[0];
+                if (bytes == 4) out[3] = in[3];
+            }
+        };
+
+        size_t i = 0;
+        bool truncated = false;
+        while (i < pixels && !truncated) {
+            u32 run = 1;
+            bool repeat = false;
+            if (rle) {
+                if (pos >= source.size()) break;
+                run = (source[pos] & 0x7f) + 1u;
+                repeat = (source[pos] & 0x80) != 0;
+                pos++;
+            }
+            // A repeat packet holds one pixel for the whole run
+            for (u32 r = 0; r < run && i < pixels; ++r, ++i) {
+                if (pos + bytes > source.size()) {
+                    truncated = true;
+                    break;
+                }
+                read_pixel(i);
+                if (!repeat || r + 1 == run) pos += bytes;
+            }
+        }
+        if (i < pixels) {
+            error = "truncated pixel data";
+            return false;
+        }
+
+        if (!top_down) {
+            const size_t row = static_cast<size_t>(image.width) * 4;
+            for (u32 y = 0; y < image.height / 2; ++y) {
+                std::swap_ranges(image.rgba.begin() + y * row, image.rgba.begin() + (y + 1) * row,
+                                 image.rgba.begin() + (image.height - 1 - y) * row);
+            }
+        }
+        return true;
+    }
+
+    static f32 srgb_to_linear(f32 c) {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static f32 linear_to_srgb(f32 c) {
+        return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // Box filter over each 2x2 footprint; color is averaged in linear space so sRGB mips don't darken
+    static Image downsample(const Image& src, bool srgb, const f32* to_linear) {
+        Image dst;
+        dst.width = std::max(src.width / 2, 1u);
+        dst.height = std::max(src.height / 2, 1u);
+        dst.rgba.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+        for (u32 y = 0; y < dst.height; ++y) {
+            for (u32 x = 0; x < dst.width; ++x) {
+                f32 sum[4] = {};
+                for (u32 dy = 0; dy < 2; ++dy) {
+                    for (u32 dx = 0; dx < 2; ++dx) {
+                        const u32 sx = std::min(x * 2 + dx, src.width - 1);
+                        const u32 sy = std::min(y * 2 + dy, src.height - 1);
+                        const u8* p = &src.rgba[(static_cast<size_t>(sy) * src.width + sx) * 4];
+                        for (u32 c = 0; c < 3; ++c) {
+                            sum[c] += srgb ? to_linear[p[c]] : p[c] / 255.0f;
+                        }
+                        sum[3] += p[3] / 255.0f;
+                    }
+                }
+                u8* out = &dst.rgba[(static_cast<size_t>(y) * dst.width + x) * 4];
+                for (u32 c = 0; c < 4; ++c) {
+                    const f32 v = sum[c] * 0.25f;
+                    out[c] = static_cast<u8>(std::lround((srgb && c < 3 ? linear_to_srgb(v) : v) * 255.0f));
+                }
+            }
+        }
+        return dst;
+    }
+
+    static u16 pack_565(const f32 color[3]) {
+        const auto quantize = [](f32 v, u32 max) {
+            return static_cast<u32>(std::lround(std::clamp(v, 0.0f, 255.0f) * static_cast<f32>(max) / 255.0f));
+        };
+        return static_cast<u16>(quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 |
+                                quantize(color[2], 31));
+    }
+
+    static void unpack_565(u16 packed, i32 color[3]) {
+        const i32 r = packed >> 11 & 31, g = packed >> 5 & 63, b = packed & 31;
+        color[0] = r << 3 | r >> 2;
+        color[1] = g << 2 | g >> 4;
+        color[2] = b << 3 | b >> 2;
+    }
+
+    // Endpoints along the block's principal color axis, inset slightly, then the nearest of the
+    // four palette entries per pixel. Always 4-color mode (c0 > c1), which BC3 requires anyway.
+    static void encode_bc1_color(const u8 pixels[16][4], u8 out[8]) {
+        f32 mean[3] = {};
+        for (u32 i = 0; i < 16; ++i) {
+            for (u32 c = 0; c < 3; ++c) mean[c] += pixels[i][c] / 16.0f;
+        }
+        f32 cov[6] = {}; // rr rg rb gg gb bb
+        for (u32 i = 0; i < 16; ++i) {
+            const f32 r = pixels[i][0] - mean[0], g = pixels[i][1] - mean[1], b = pixels[i][2] - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+        f32 axis[3] = {1.0f, 1.0f, 1.0f};
+        for (u32 iteration = 0; iteration < 8; ++iteration) {
+            const f32 x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+            const f32 y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+            const f32 z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+            const f32 length = std::max({std::abs(x), std::abs(y), std::abs(z)});
+            if (length < 1e-6f) break;
+            axis[0] = x / length;
+            axis[1] = y / length;
+            axis[2] = z / length;
+        }
+        const f32 norm = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        for (f32& a : axis) a /= norm;
+
+        f32 t_min = 0.0f, t_max = 0.0f;
+        for (u32 i = 0; i < 16; ++i) {
+            const f32 t = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] +
+                          (pixels[i][2] - mean[2]) * axis[2];
+            t_min = std::min(t_min, t);
+            t_max = std::max(t_max, t);
+        }
+        const f32 inset = (t_max - t_min) / 16.0f;
+        f32 e0[3], e1[3];
+        for (u32 c = 0; c < 3; ++c) {
+            e0[c] = mean[c] + axis[c] * (t_max - inset);
+            e1[c] = mean[c] + axis[c] * (t_min + inset);
+        }
+        u16 c0 = pack_565(e0), c1 = pack_565(e1);
+        if (c0 < c1) std::swap(c0, c1);
+
+        u32 indices = 0;
+        if (c0 != c1) {
+            i32 palette[4][3];
+            unpack_565(c0, palette[0]);
+            unpack_565(c1, palette[1]);
+            for (u32 c = 0; c < 3; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (u32 i = 0; i < 16; ++i) {
+                u32 best = 0;
+                i32 best_distance = INT32_MAX;
+                for (u32 p = 0; p < 4; ++p) {
+                    i32 distance = 0;
+                    for (u32 c = 0; c < 3; ++c) {
+                        const i32 d = pixels[i][c] - palette[p][c];
+                        distance += d * d;
+                    }
+                    if (distance < best_distance) {
+                        best_distance = distance;
+                        best = p;
+                    }
+                }
+                indices |= best << (i * 2);
+            }
+        }
+        std::memcpy(out, &c0, 2);
+        std::memcpy(out + 2, &c1, 2);
+        std::memcpy(out + 4, &indices, 4);
+    }
+
+    // BC4-style alpha block in 8-value mode (a0 > a1)
+    static void encode_bc3_alpha(const u8 pixels[16][4], u8 out[8]) {
+        u8 a0 = 0, a1 = 255;
+        for (u32 i = 0; i < 16; ++i) {
+            a0 = std::max(a0, pixels[i][3]);
+            a1 = std::min(a1, pixels[i][3]);
+        }
+        out[0] = a0;
+        out[1] = a1;
+        u64 indices = 0;
+        if (a0 != a1) {
+            i32 palette[8] = {a0, a1};
+            for (i32 p = 2; p < 8; ++p) {
+                palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+            }
+            for (u32 i = 0; i < 16; ++i) {
+                u64 best = 0;
+                i32 best_distance = INT32_MAX;
+                for (u32 p = 0; p < 8; ++p) {
+                    const i32 distance = std::abs(pixels[i][3] - palette[p]);
+                    if (distance < best_distance) {
+                        best_distance = distance;
+                        best = p;
+                    }
+                }
+                indices |= best << (i * 3);
+            }
+        }
+        for (u32 b = 0; b < 6; ++b) {
+            out[2 + b] = static_cast<u8>(indices >> (b * 8));
+        }
+    }
+
+    static void encode_blocks(const Image& image, TextureFormat format, std::vector<u8>& out) {
+        const u32 blocks_x = (image.width + 3) / 4;
+        const u32 blocks_y = (image.height + 3) / 4;
+        for (u32 by = 0; by < blocks_y; ++by) {
+            for (u32 bx = 0; bx < blocks_x; ++bx) {
+                // Edge blocks repeat the last row / column
+                u8 pixels[16][4];
+                for (u32 i = 0; i < 16; ++i) {
+                    const u32 x = std::min(bx * 4 + i % 4, image.width - 1);
+                    const u32 y = std::min(by * 4 + i / 4, image.height - 1);
+                    std::memcpy(pixels[i], &image.rgba[(static_cast<size_t>(y) * image.width + x) * 4], 4);
+                }
+                u8 block[16];
+                if (format == TextureFormat::BC3) {
+                    encode_bc3_alpha(pixels, block);
+                    encode_bc1_color(pixels, block + 8);
+                    out.insert(out.end(), block, block + 16);
+                } else {
+                    encode_bc1_color(pixels, block);
+                    out.insert(out.end(), block, block + 8);
+                }
+            }
+        }
+    }
+
+    // Textures named *_n.* or *_normal.* (normal maps) and *_linear.* hold data, not color
+    static bool is_linear(const std::string& name) {
+        const size_t dot = name.rfind('.');
+        const std::string stem = name.substr(0, dot);
+        for (const char* suffix : {"_n", "_normal", "_linear"}) {
+            const size_t length = std::strlen(suffix);
+            if (stem.size() >= length && stem.compare(stem.size() - length, length, suffix) == 0) return true;
+        }
+        return false;
+    }
+
+    bool cook_texture(const CookInput& input, const CookOptions& options, CookResult& result) {
+        const std::string& name = input.name;
+        const std::vector<u8>& source = input.source;
+        Image image;
+        const bool tga = name.size() >= 4 && name.compare(name.size() - 4, 4, ".tga") == 0;
+        if (!(tga ? decode_tga(source, image, result.error) : decode_bmp(source, image, result.error))) {
+            return false;
+        }
+        if (image.width == 0 || image.height == 0) {
+            result.error = "empty image";
+            return false;
+        }
+
+        bool opaque = true;
+        for (size_t i = 3; i < image.rgba.size(); i += 4) {
+            opaque &= image.rgba[i] == 255;
+        }
+
+        TextureHeader header;
+        header.width = image.width;
+        header.height = image.height;
+        header.mip_count = 1 + static_cast<u32>(std::floor(std::log2(std::max(image.width, image.height))));
+        header.format = !options.compress ? TextureFormat::RGBA8 : opaque ? TextureFormat::BC1 : TextureFormat::BC3;
+        header.flags = is_linear(name) ? 0 : TEXTURE_SRGB;
+        const bool srgb = (header.flags & TEXTURE_SRGB) != 0;
+
+        f32 to_linear[256];
+        for (u32 i = 0; i < 256; ++i) {
+            to_linear[i] = srgb_to_linear(static_cast<f32>(i) / 255.0f);
+        }
+
+        std::vector<TextureMip> mips(header.mip_count);
+        std::vector<u8> data;
+        for (u32 level = 0; level < header.mip_count; ++level) {
+            if (level > 0) image = downsample(image, srgb, to_linear);
+            align_to(data, 16);
+            mips[level].width = image.width;
+            mips[level].height = image.height;
+            mips[level].offset = data.size();
+            if (header.format == TextureFormat::RGBA8) {
+                data.insert(data.end(), image.rgba.begin(), image.rgba.end());
+            } else {
+                encode_blocks(image, header.format, data);
+            }
+            mips[level].size = data.size() - mips[level].offset;
+        }
+
+        // Mip offsets are relative to the blob, which starts with the header and mip table
+        const u64 data_start = (sizeof(TextureHeader) + sizeof(TextureMip) * mips.size() + 15) & ~u64{15};
+        for (TextureMip& mip : mips) mip.offset += data_start;
+
+        result.type = AssetType::Texture;
+        result.blob.clear();
+        append(result.blob, &header);
+        append(result.blob, mips.data(), mips.size());
+        align_to(result.blob, 16);
+        result.blob.insert(result.blob.end(), data.begin(), data.end());
+        return true;
+    }
+}
@@ -0,0 +1,308 @@
+//
+// Created by overlord on 10/17/26.
+//
+#include "cook.h"
+#include "core/job_system.h"
+#include "core/logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace Sparkle;
+using namespace SparkleCook;
+namespace fs = std::filesystem;
+
+#ifndef SPA_GLSLC
+#define SPA_GLSLC ""
+#endif
+
+// Header of a cache file; the cooked blob follows
+struct CacheHeader {
+    u32 magic = 0x4B435053; // "SPCK"
+    u32 version = COOK_VERSION;
+    AssetType type = AssetType::Raw;
+    u32 flags = 0;
+};
+
+struct CookJob {
+    CookInput input;
+    CookResult result;
+    u64 content_hash = 0;
+    bool from_cache = false;
+    bool ok = false;
+};
+
+static bool read_file(const fs::path& path, std::vector<u8>& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static bool ends_with(const std::string& name, const char* suffix) {
+    const size_t length = std::strlen(suffix);
+    return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+}
+
+using CookFn = bool (*)(const CookInput&, const CookOptions&, CookResult&);
+
+// nullptr: copied into the archive as is
+static CookFn cooker_for(const std::string& name) {
+    if (ends_with(name, ".bmp") || ends_with(name, ".tga")) return cook_texture;
+    if (ends_with(name, ".obj")) return cook_mesh;
+    if (ends_with(name, ".vert") || ends_with(name, ".frag") || ends_with(name, ".comp")) return cook_shader;
+    return nullptr;
+}
+
+// Everything that decides a cooker's output: the source bytes, the name (texture color space, shader
+// stage), the cooker version and the options
+static u64 cache_key(const CookJob& job, const CookOptions& options) {
+    struct {
+        u64 source;
+        u64 name;
+        u32 version;
+        u32 compress;
+    } key = {hash_content(job.input.source.data(), job.input.source.size()), hash_name(job.input.name),
+             COOK_VERSION, options.compress ? 1u : 0u};
+    return hash_content(&key, sizeof(key));
+}
+
+static void cook(CookJob& job, const CookOptions& options, const fs::path& cache_dir) {
+    if (!read_file(job.input.path, job.input.source)) {
+        job.result.error = "cannot read file";
+        return;
+    }
+
+    const CookFn cooker = cooker_for(job.input.name);
+    if (!cooker) {
+        job.result.blob = std::move(job.input.source);
+        job.content_hash = hash_content(job.result.blob.data(), job.result.blob.size());
+        job.ok = true;
+        return;
+    }
+
+    char file_name[32];
+    std::snprintf(file_name, sizeof(file_name), "%016llx.blob",
+                  static_cast<unsigned long long>(cache_key(job, options)));
+    const fs::path cache_path = cache_dir / file_name;
+
+    std::vector<u8> cached;
+    CacheHeader header;
+    if (read_file(cache_path, cached) && cached.size() >= sizeof(CacheHeader)) {
+        std::memcpy(&header, cached.data(), sizeof(header));
+        if (header.magic == CacheHeader{}.magic && header.version == COOK_VERSION) {
+            job.result.type = header.type;
+            job.result.flags = header.flags;
+            job.result.blob.assign(cached.begin() + sizeof(CacheHeader), cached.end());
+            job.from_cache = true;
+        }
+    }
+
+    if (!job.from_cache) {
+        if (!cooker(job.input, options, job.result)) return;
+
+        // Written under a temporary name, so a cook interrupted mid-write never leaves a torn entry
+        header.type = job.result.type;
+        header.flags = job.result.flags;
+        const fs::path temp_path =
+            cache_path.string() + ".tmp" + std::to_string(JobSystem::get_worker_index());
+        {
+            std::ofstream file(temp_path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(job.result.blob.data()),
+                       static_cast<std::streamsize>(job.result.blob.size()));
+        }
+        std::error_code error;
+        fs::rename(temp_path, cache_path, error);
+    }
+
+    job.input.source = {};
+    job.content_hash = hash_content(job.result.blob.data(), job.result.blob.size());
+    job.ok = true;
+}
+
+// True when path already holds exactly these entries, so the archive need not be rewritten
+static bool is_up_to_date(const fs::path& path, const std::vector<ArchiveEntry>& entries) {
+    std::ifstream file(path, std::ios::binary);
+    ArchiveHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (header.magic != ARCHIVE_MAGIC || header.version != ARCHIVE_VERSION ||
+        header.entry_count != entries.size()) {
+        return false;
+    }
+    std::error_code error;
+    if (fs::file_size(path, error) != header.file_size) return false;
+
+    std::vector<ArchiveEntry> existing(entries.size());
+    if (!file.read(reinterpret_cast<char*>(existing.data()),
+                   static_cast<std::streamsize>(existing.size() * sizeof(ArchiveEntry)))) {
+        return false;
+    }
+    return std::memcmp(existing.data(), entries.data(), entries.size() * sizeof(ArchiveEntry)) == 0;
+}
+
+static bool write_archive(const fs::path& path, const std::vector<ArchiveEntry>& entries,
+                          const std::vector<const std::vector<u8>*>& blobs, u64 file_size) {
+    const fs::path temp_path = path.string() + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary);
+        ArchiveHeader header;
+        header.entry_count = static_cast<u32>(entries.size());
+        header.file_size = file_size;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() * sizeof(ArchiveEntry)));
+
+        static const char padding[ARCHIVE_ALIGNMENT] = {};
+        u64 offset = sizeof(header) + entries.size() * sizeof(ArchiveEntry);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            file.write(padding, static_cast<std::streamsize>(entries[i].offset - offset));
+            file.write(reinterpret_cast<const char*>(blobs[i]->data()),
+                       static_cast<std::streamsize>(blobs[i]->size()));
+            offset = entries[i].offset + entries[i].size;
+        }
+        file.write(padding, static_cast<std::streamsize>(file_size - offset));
+        if (!file) return false;
+    }
+    std::error_code error;
+    fs::rename(temp_path, path, error);
+    return !error;
+}
+
+static void print_usage() {
+    std::printf("usage: sparkle_cook <source_dir> <output.spak> [options]\n"
+                "  --cache <dir>     cooked blobs cache (default: <output>.cache)\n"
+                "  --jobs <n>        worker threads (default: one per hardware thread)\n"
+                "  --glslc <path>    shader compiler (default: %s)\n"
+                "  --uncompressed    keep textures RGBA8 instead of BC1 / BC3\n"
+                "Textures: .bmp .tga  Meshes: .obj  Shaders: .vert .frag .comp  Anything else is copied.\n"
+                "Shader #includes are not part of the cache key; delete the cache after editing an\n"
+                "included file.\n",
+                SPA_GLSLC[0] ? SPA_GLSLC : "none");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+
+    const fs::path source_dir = argv[1];
+    const fs::path output = argv[2];
+    fs::path cache_dir = output.string() + ".cache";
+    u32 jobs = 0;
+    CookOptions options;
+    options.glslc = SPA_GLSLC;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = static_cast<u32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--glslc") == 0 && i + 1 < argc) {
+            options.glslc = argv[++i];
+        } else if (std::strcmp(argv[i], "--uncompressed") == 0) {
+            options.compress = false;
+        } else {
+            std::printf("unknown option '%s'\n", argv[i]);
+            print_usage();
+            return 1;
+        }
+    }
+
+    std::error_code error;
+    if (!fs::is_directory(source_dir, error)) {
+        std::printf("%s is not a directory\n", source_dir.string().c_str());
+        return 1;
+    }
+    fs::create_directories(cache_dir, error);
+    options.scratch_dir = cache_dir.string();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<CookJob> cook_jobs;
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(source_dir)) {
+        if (!entry.is_regular_file() || entry.path().filename().string()[0] == '.') continue;
+        CookJob job;
+        job.input.path = entry.path().string();
+        job.input.name = fs::relative(entry.path(), source_dir).generic_string();
+        cook_jobs.push_back(std::move(job));
+    }
+    // Sorted so the same sources always produce the same archive
+    std::sort(cook_jobs.begin(), cook_jobs.end(),
+              [](const CookJob& a, const CookJob& b) { return a.input.name < b.input.name; });
+
+    Logger::init();
+    Logger::get_logger()->set_level(spdlog::level::warn);
+    JobSystem::init(jobs);
+
+    // One file per job: files vary too much in cost for larger grains to balance
+    CookJob* job_data = cook_jobs.data();
+    JobSystem::parallel_for(static_cast<u32>(cook_jobs.size()), 1,
+                            [job_data, &options, &cache_dir](u32 begin, u32 end) {
+                                for (u32 i = begin; i < end; ++i) {
+                                    cook(job_data[i], options, cache_dir);
+                                }
+                            });
+    const u32 workers = JobSystem::get_worker_count();
+    JobSystem::shutdown();
+    Logger::shutdown();
+
+    u32 failed = 0, cached = 0, copied = 0;
+    for (const CookJob& job : cook_jobs) {
+        if (!job.ok) {
+            std::printf("error: %s: %s\n", job.input.name.c_str(), job.result.error.c_str());
+            failed++;
+        }
+        cached += job.from_cache ? 1 : 0;
+        copied += cooker_for(job.input.name) ? 0 : 1;
+    }
+    if (failed > 0) {
+        std::printf("%u of %zu assets failed to cook; %s not written\n", failed, cook_jobs.size(),
+                    output.string().c_str());
+        return 1;
+    }
+
+    // The index is sorted by name hash for the runtime's binary search; a collision would make one
+    // asset unreachable, so it is an error rather than a silent shadowing
+    std::vector<u32> order(cook_jobs.size());
+    for (u32 i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&cook_jobs](u32 a, u32 b) {
+        return hash_name(cook_jobs[a].input.name) < hash_name(cook_jobs[b].input.name);
+    });
+
+    std::vector<ArchiveEntry> entries(order.size());
+    std::vector<const std::vector<u8>*> blobs(order.size());
+    u64 offset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry);
+    for (u32 i = 0; i < order.size(); ++i) {
+        const CookJob& job = cook_jobs[order[i]];
+        ArchiveEntry& entry = entries[i];
+        entry.name_hash = hash_name(job.input.name);
+        if (i > 0 && entries[i - 1].name_hash == entry.name_hash) {
+            std::printf("error: %s and %s have the same name hash; rename one\n",
+                        cook_jobs[order[i - 1]].input.name.c_str(), job.input.name.c_str());
+            return 1;
+        }
+        offset = (offset + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+        entry.content_hash = job.content_hash;
+        entry.offset = offset;
+        entry.size = job.result.blob.size();
+        entry.type = job.result.type;
+        entry.flags = job.result.flags;
+        blobs[i] = &job.result.blob;
+        offset += entry.size;
+    }
+    const u64 file_size = (offset + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+
+    const bool up_to_date = is_up_to_date(output, entries);
+    if (!up_to_date && !write_archive(output, entries, blobs, file_size)) {
+        std::printf("failed to write %s\n", output.string().c_str());
+        return 1;
+    }
+
+    const f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%s: %zu assets (%zu cooked, %u cached, %u copied), %.1f MiB, %u workers, %.1f ms%s\n",
+                output.string().c_str(), cook_jobs.size(), cook_jobs.size() - cached - copied, cached, copied,
+                static_cast<f64>(file_size) / (1024.0 * 1024.0), workers, ms, up_to_date ? ", up to date" : "");
+    return 0;
+}